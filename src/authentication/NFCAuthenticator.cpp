@@ -1,7 +1,8 @@
 #include "NFCAuthenticator.h"
+#include "../utils/TokenLog.h"
 
-NFCAuthenticator::NFCAuthenticator(NFCManager* manager, CardDatabase* db)
-    : nfcManager(manager), cardDatabase(db), lastCardTime(0), lastCardUID("") {
+NFCAuthenticator::NFCAuthenticator(NFCManager* manager, CardDatabase* db, const char* name, bool sharedReader)
+    : nfcManager(manager), cardDatabase(db), name(name), sharedReader(sharedReader), lastUidLength(0) {
 }
 
 bool NFCAuthenticator::initialize() {
@@ -23,38 +24,75 @@ void NFCAuthenticator::startNFCListening() {
 }
 
 bool NFCAuthenticator::handleCardAuthentication(uint8_t* uid, uint8_t uidLength) {
-    String uidString = Utils::uidToString(uid, uidLength);
-    
-    // 检查是否在冷却期内（同一张卡连续认证）
-    if (uidString == lastCardUID && (millis() - lastCardTime) < CARD_COOLDOWN_MS) {
-        Serial.println("NFC: Card in cooldown, ignored.");
+    unsigned long now = millis();
+
+    // 同一张卡的冷却和失败锁定（不同卡片互不影响）
+    RecentUIDTable::Verdict verdict = recentCards.check(uid, uidLength, now);
+    if (verdict == RecentUIDTable::VERDICT_COOLDOWN) {
+        LOGF("NFC: Card in cooldown, ignored.");
         return false;
     }
-    
-    Serial.print("NFC: Card detected: ");
-    Serial.println(uidString);
+    if (verdict == RecentUIDTable::VERDICT_LOCKED) {
+        LOGF("NFC: Card locked out, %lu ms remaining", recentCards.getLockRemaining(uid, uidLength, now));
+        return false;
+    }
+    if (verdict == RecentUIDTable::VERDICT_UNTRACKED) {
+        // 无法记录失败次数：未注册的卡片在下面查数据库时被拒绝，已注册的卡片照常认证
+        LOGF("NFC: Lockout table full for this card, only registered cards accepted");
+    }
+
+    // 吊销检查在查找数据库之前，未吊销的卡片只需检查一位过滤位图
+    if (cardDatabase->isRevoked(uid, uidLength)) {
+        LOGF("NFC: Card revoked");
+        recordFailure(uid, uidLength, now);
+        return false;
+    }
+
+    String uidString = Utils::uidToString(uid, uidLength);
+    LOGF("NFC: Card detected: %s", uidString.c_str());
     
     // 在数据库中查找卡片
     String keyHex;
     if (!cardDatabase->findCardByUID(uidString, keyHex)) {
-        Serial.println("NFC: Card not registered");
+        LOGF("NFC: Card not registered");
+        recordFailure(uid, uidLength, now);
         return false;
     }
     
-    // 获取存储的密钥并认证
+    // 获取存储的密钥或分散密钥并认证
     uint8_t key[Utils::KEY_SIZE];
-    Utils::hexStringToKey(keyHex, key);
+    if (keyHex.length() > 0) {
+        Utils::hexStringToKey(keyHex, key);
+    } else if (!cardDatabase->deriveCardKey(uidString, key)) {
+        LOGF("NFC: Failed to derive card key");
+        return false;
+    }
     
     if (authenticateBlock(uid, uidLength, AUTH_BLOCK, key)) {
-        Serial.println("NFC: Authentication successful");
-        
-        // 更新最后认证的卡片和时间
-        lastCardUID = uidString;
-        lastCardTime = millis();
+        LOGF("NFC: Authentication successful");
+        recentCards.recordSuccess(uid, uidLength, now);
+        return true;
+    }
+
+    // 迁移在写入分散密钥之后、校验之前中断时，卡片已经是分散密钥而数据库仍保存旧密钥
+    if (keyHex.length() > 0 &&
+        cardDatabase->adoptDiversifiedKey(uidString, [&](const uint8_t* derivedKey) {
+            memcpy(key, derivedKey, sizeof(key));
+            return nfcManager->reselectCard() && authenticateBlock(uid, uidLength, AUTH_BLOCK, key);
+        })) {
+        LOGF("NFC: Authentication successful with diversified key, stored key cleared");
+        recentCards.recordSuccess(uid, uidLength, now);
         return true;
-    } else {
-        Serial.println("NFC: Authentication failed");
-        return false;
+    }
+
+    LOGF("NFC: Authentication failed");
+    recordFailure(uid, uidLength, now);
+    return false;
+}
+
+void NFCAuthenticator::recordFailure(uint8_t* uid, uint8_t uidLength, unsigned long now) {
+    if (recentCards.recordFailure(uid, uidLength, now)) {
+        LOGF("NFC: Too many failed attempts, card locked for %lu ms", (unsigned long)RecentUIDTable::LOCKOUT_MS);
     }
 }
 
@@ -62,16 +100,29 @@ bool NFCAuthenticator::hasAuthenticationRequest() {
     // 使用新的NFCManager检测卡片
     NFCManager::CardDetectionResult result = nfcManager->detectCard();
 
-    // 只有检测到新卡片时才返回true
+    if (result == NFCManager::CARD_REMOVED) {
+        // 卡片已离开，移开后再刷不再受同卡冷却限制
+        uint8_t uid[7];
+        uint8_t uidLength = 0;
+        if (nfcManager->getLastCardUID(uid, &uidLength)) {
+            recentCards.clearCooldown(uid, uidLength, millis());
+        }
+        return false;
+    }
+
+    // 只有检测到新卡片时才返回true（留在读卡器上的卡片只触发一次）
     return result == NFCManager::CARD_DETECTED;
 }
 
 bool NFCAuthenticator::authenticate() {
     uint8_t uid[7] = {0};
     uint8_t uidLength = 0;
+    lastUidLength = 0;
 
-    // 读取卡片UID
+    // 读取卡片UID（认证失败时也保留，用于审计日志）
     if (nfcManager->readCardUID(uid, &uidLength)) {
+        memcpy(lastUid, uid, uidLength);
+        lastUidLength = uidLength;
         return handleCardAuthentication(uid, uidLength);
     }
 
@@ -79,10 +130,26 @@ bool NFCAuthenticator::authenticate() {
 }
 
 const char* NFCAuthenticator::getName() const {
-    return "NFC Authenticator";
+    return name;
 }
 
 void NFCAuthenticator::reset() {
-    lastCardTime = 0;
-    lastCardUID = "";
+    recentCards.clear();
+}
+
+bool NFCAuthenticator::usesSharedReader() const {
+    return sharedReader;
+}
+
+bool NFCAuthenticator::hasCredentialCooldown() const {
+    return true;
+}
+
+bool NFCAuthenticator::getLastCredentialId(uint8_t* id, uint8_t* length) const {
+    if (lastUidLength == 0) {
+        return false;
+    }
+    memcpy(id, lastUid, lastUidLength);
+    *length = lastUidLength;
+    return true;
 }
@@ -5,6 +5,7 @@
 #include "../data/CardDatabase.h"
 #include "../utils/Utils.h"
 #include "../nfc/NFCManager.h"
+#include "../security/RecentUIDTable.h"
 
 /**
  * NFC认证器
@@ -14,18 +15,20 @@ class NFCAuthenticator : public IAuthenticator {
 private:
     NFCManager* nfcManager;
     CardDatabase* cardDatabase;
+    const char* name;
+    bool sharedReader;
     
     // MIFARE Classic 配置
     static const uint8_t SECTOR_TRAILER_BLOCK = 7;
     static const uint8_t AUTH_BLOCK = 4;
     static const uint8_t TRAILER_SIZE = 16;
 
-    // 冷却机制
-    unsigned long lastCardTime;
-    String lastCardUID;
+    // 最近刷卡表：同卡冷却和失败锁定
+    RecentUIDTable recentCards;
 
-    // 防重放时间（毫秒）
-    static const unsigned long CARD_COOLDOWN_MS = 1000;
+    // 最近一次读到的卡片UID（供访问策略判断和审计日志）
+    uint8_t lastUid[7];
+    uint8_t lastUidLength;
     
     /**
      * 读取卡片UID
@@ -47,13 +50,21 @@ private:
      */
     bool handleCardAuthentication(uint8_t* uid, uint8_t uidLength);
 
+    /**
+     * 记录认证失败，达到次数上限时锁定该卡
+     */
+    void recordFailure(uint8_t* uid, uint8_t uidLength, unsigned long now);
+
 public:
     /**
      * 构造函数
      * @param manager NFC管理器指针
      * @param db 卡片数据库指针
+     * @param name 认证器名称
+     * @param sharedReader 读卡器是否与卡片管理共享（共享时租约期间暂停认证）
      */
-    NFCAuthenticator(NFCManager* manager, CardDatabase* db);
+    NFCAuthenticator(NFCManager* manager, CardDatabase* db, const char* name = "NFC Authenticator",
+                     bool sharedReader = true);
     
     /**
      * 初始化NFC认证器
@@ -83,6 +94,26 @@ public:
      * 重置认证器状态
      */
     void reset() override;
+
+    /**
+     * 检查读卡器是否与卡片管理器共享
+     * @return 构造时指定的共享标志
+     */
+    bool usesSharedReader() const override;
+
+    /**
+     * NFC认证器按卡片UID处理冷却
+     * @return 总是true
+     */
+    bool hasCredentialCooldown() const override;
+
+    /**
+     * 获取最近一次认证成功的卡片UID
+     * @param id 输出的UID字节
+     * @param length 输出的UID长度
+     * @return 最近一次认证是否成功
+     */
+    bool getLastCredentialId(uint8_t* id, uint8_t* length) const override;
 };
 
 #endif // NFCAUTHENTICATOR_H
@@ -0,0 +1,53 @@
+#ifdef ENABLE_BENCHMARKS
+
+#include "Benchmark.h"
+#include "../utils/Utils.h"
+
+const size_t Benchmark::FLEET_SIZES[] = {10, 1000, 10000, 100000};
+const size_t Benchmark::FLEET_SIZE_COUNT = sizeof(FLEET_SIZES) / sizeof(FLEET_SIZES[0]);
+
+void Benchmark::report(const char* suite, const char* op, size_t n, unsigned long iterations, unsigned long elapsedUs) {
+    unsigned long nsPerOp = iterations > 0 ? (unsigned long)((uint64_t)elapsedUs * 1000 / iterations) : 0;
+    Serial.printf("BENCH {\"suite\":\"%s\",\"op\":\"%s\",\"n\":%u,\"iters\":%lu,\"ns_per_op\":%lu,\"free_heap\":%u}\n",
+                  suite, op, (unsigned)n, iterations, nsPerOp, (unsigned)ESP.getFreeHeap());
+}
+
+void Benchmark::skip(const char* suite, const char* op, size_t n, const char* reason) {
+    Serial.printf("BENCH {\"suite\":\"%s\",\"op\":\"%s\",\"n\":%u,\"skipped\":\"%s\"}\n",
+                  suite, op, (unsigned)n, reason);
+}
+
+unsigned long Benchmark::iterationsFor(size_t n, unsigned long budget, unsigned long maxIterations) {
+    unsigned long iterations = n > 0 ? budget / n : maxIterations;
+    if (iterations > maxIterations) {
+        iterations = maxIterations;
+    }
+    return iterations > 0 ? iterations : 1;
+}
+
+bool Benchmark::fitsInHeap(size_t n, size_t bytesPerItem) {
+    // 保留一半空闲内存给系统和测试本身
+    return (uint64_t)n * bytesPerItem < ESP.getFreeHeap() / 2;
+}
+
+String Benchmark::syntheticUID(uint32_t index) {
+    // NXP厂商前缀 + 打散的序号，避免相邻UID前缀相同
+    uint32_t mixed = index * 2654435761u;
+    uint8_t uid[7] = {
+        0x04,
+        (uint8_t)(mixed >> 24), (uint8_t)(mixed >> 16), (uint8_t)(mixed >> 8), (uint8_t)mixed,
+        (uint8_t)(index >> 8), (uint8_t)index
+    };
+    return Utils::uidToString(uid, sizeof(uid));
+}
+
+String Benchmark::syntheticKey(uint32_t index) {
+    uint32_t mixed = (index + 1) * 2246822519u;
+    uint8_t key[Utils::KEY_SIZE] = {
+        (uint8_t)(mixed >> 24), (uint8_t)(mixed >> 16), (uint8_t)(mixed >> 8), (uint8_t)mixed,
+        (uint8_t)(index >> 8), (uint8_t)index
+    };
+    return Utils::keyToHexString(key);
+}
+
+#endif // ENABLE_BENCHMARKS
@@ -0,0 +1,69 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <Arduino.h>
+
+/**
+ * 基准测试工具
+ * 计时并以机器可读的JSON行输出结果，每行以"BENCH "开头，便于从串口日志中提取：
+ *   BENCH {"suite":"card_db","op":"find_hit","n":1000,"iters":200,"ns_per_op":12345,"free_heap":123456}
+ * 仅在定义ENABLE_BENCHMARKS时编译（见platformio.ini中的bench环境）
+ */
+class Benchmark {
+public:
+    // 标准的卡片规模
+    static const size_t FLEET_SIZES[];
+    static const size_t FLEET_SIZE_COUNT;
+
+    /**
+     * 输出一条结果
+     * @param suite 测试套件名
+     * @param op 操作名
+     * @param n 数据规模
+     * @param iterations 迭代次数
+     * @param elapsedUs 总耗时（微秒）
+     */
+    static void report(const char* suite, const char* op, size_t n, unsigned long iterations, unsigned long elapsedUs);
+
+    /**
+     * 输出一条跳过记录（如内存不足）
+     * @param suite 测试套件名
+     * @param op 操作名
+     * @param n 数据规模
+     * @param reason 原因
+     */
+    static void skip(const char* suite, const char* op, size_t n, const char* reason);
+
+    /**
+     * 根据数据规模选择迭代次数，使线性操作的总耗时大致相同
+     * @param n 数据规模
+     * @param budget 总工作量（n * 迭代次数）
+     * @param maxIterations 最大迭代次数
+     * @return 迭代次数（至少为1）
+     */
+    static unsigned long iterationsFor(size_t n, unsigned long budget, unsigned long maxIterations);
+
+    /**
+     * 检查可用内存是否足以容纳指定规模的数据
+     * @param n 数据规模
+     * @param bytesPerItem 每项估计字节数
+     * @return 是否足够
+     */
+    static bool fitsInHeap(size_t n, size_t bytesPerItem);
+
+    /**
+     * 生成确定性的测试UID（7字节，与真实MIFARE UID格式一致）
+     * @param index 序号
+     * @return UID字符串
+     */
+    static String syntheticUID(uint32_t index);
+
+    /**
+     * 生成确定性的测试密钥
+     * @param index 序号
+     * @return 密钥十六进制字符串
+     */
+    static String syntheticKey(uint32_t index);
+};
+
+#endif // BENCHMARK_H
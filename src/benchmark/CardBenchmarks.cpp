@@ -0,0 +1,160 @@
+#ifdef ENABLE_BENCHMARKS
+
+#include "CardBenchmarks.h"
+#include "Benchmark.h"
+#include "../utils/Utils.h"
+
+namespace {
+const char* SUITE_DB = "card_db";
+const char* SUITE_FS = "card_fs";
+const char* SUITE_UTILS = "utils";
+
+// 查找目标轮换使用，避免在计时循环中生成字符串
+const size_t TARGET_COUNT = 32;
+}
+
+const size_t CardBenchmarks::JSON_CARD_COUNTS[] = {10, 100, 1000};
+const size_t CardBenchmarks::JSON_CARD_COUNT_COUNT = sizeof(JSON_CARD_COUNTS) / sizeof(JSON_CARD_COUNTS[0]);
+
+void CardBenchmarks::runAll() {
+    Serial.println("BENCH begin card benchmarks");
+    for (size_t i = 0; i < JSON_CARD_COUNT_COUNT; i++) {
+        runCardDatabase(JSON_CARD_COUNTS[i]);
+        runFileSystem(JSON_CARD_COUNTS[i]);
+    }
+    runUtils();
+    Serial.println("BENCH end card benchmarks");
+}
+
+bool CardBenchmarks::populate(CardDatabase& db, size_t n) {
+    db.initialize();
+    JsonArray cards = db.getDatabase().as<JsonArray>();
+    for (size_t i = 0; i < n; i++) {
+        JsonObject card = cards.add<JsonObject>();
+        card["uid"] = Benchmark::syntheticUID(i);
+        card["key"] = Benchmark::syntheticKey(i);
+    }
+    return !db.getDatabase().overflowed();
+}
+
+void CardBenchmarks::runCardDatabase(size_t n) {
+    if (!Benchmark::fitsInHeap(n, JSON_BYTES_PER_CARD)) {
+        Benchmark::skip(SUITE_DB, "all", n, "insufficient heap");
+        return;
+    }
+
+    CardDatabase db;
+    if (!populate(db, n)) {
+        Benchmark::skip(SUITE_DB, "all", n, "allocation failed");
+        return;
+    }
+
+    String hits[TARGET_COUNT];
+    String misses[TARGET_COUNT];
+    for (size_t i = 0; i < TARGET_COUNT; i++) {
+        hits[i] = Benchmark::syntheticUID((i * 7919) % n);
+        misses[i] = Benchmark::syntheticUID(n + i);
+    }
+
+    String keyHex;
+    unsigned long iterations = Benchmark::iterationsFor(n, 200000, 2000);
+
+    unsigned long start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        db.findCardByUID(hits[i % TARGET_COUNT], keyHex);
+    }
+    Benchmark::report(SUITE_DB, "find_hit", n, iterations, micros() - start);
+
+    start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        db.findCardByUID(misses[i % TARGET_COUNT], keyHex);
+    }
+    Benchmark::report(SUITE_DB, "find_miss", n, iterations, micros() - start);
+
+    // 添加新卡片，然后删除以恢复规模
+    unsigned long mutations = iterations < TARGET_COUNT ? iterations : TARGET_COUNT;
+    if (mutations > n) {
+        mutations = n;
+    }
+    String newKey = Benchmark::syntheticKey(n);
+    start = micros();
+    for (unsigned long i = 0; i < mutations; i++) {
+        db.addCard(misses[i], newKey);
+    }
+    Benchmark::report(SUITE_DB, "add", n, mutations, micros() - start);
+
+    for (unsigned long i = 0; i < mutations; i++) {
+        db.removeCard(misses[i]);
+    }
+
+    // 删除已有卡片（分布在数组各处）
+    start = micros();
+    for (unsigned long i = 0; i < mutations; i++) {
+        db.removeCard(hits[i]);
+    }
+    Benchmark::report(SUITE_DB, "remove", n, mutations, micros() - start);
+}
+
+void CardBenchmarks::runFileSystem(size_t n) {
+    if (!Benchmark::fitsInHeap(n, JSON_BYTES_PER_CARD * 2)) {
+        Benchmark::skip(SUITE_FS, "all", n, "insufficient heap");
+        return;
+    }
+
+    CardDatabase db;
+    if (!populate(db, n)) {
+        Benchmark::skip(SUITE_FS, "all", n, "allocation failed");
+        return;
+    }
+
+    // 内存中的序列化/反序列化，不含flash访问
+    size_t jsonSize = measureJson(db.getDatabase());
+    unsigned long iterations = Benchmark::iterationsFor(n, 20000, 20);
+    String buffer;
+    if (buffer.reserve(jsonSize + 1)) {
+        unsigned long start = micros();
+        for (unsigned long i = 0; i < iterations; i++) {
+            buffer = "";
+            serializeJson(db.getDatabase(), buffer);
+        }
+        Benchmark::report(SUITE_FS, "serialize_ram", n, iterations, micros() - start);
+
+        start = micros();
+        for (unsigned long i = 0; i < iterations; i++) {
+            JsonDocument doc;
+            deserializeJson(doc, buffer);
+        }
+        Benchmark::report(SUITE_FS, "deserialize_ram", n, iterations, micros() - start);
+    } else {
+        Benchmark::skip(SUITE_FS, "serialize_ram", n, "insufficient heap");
+    }
+}
+
+void CardBenchmarks::runUtils() {
+    const unsigned long iterations = 10000;
+    uint8_t uid[7] = {0x04, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6};
+    uint8_t key[Utils::KEY_SIZE] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC};
+    String keyHex = Utils::keyToHexString(key);
+
+    unsigned long start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        uid[6] = (uint8_t)i;
+        String s = Utils::uidToString(uid, sizeof(uid));
+    }
+    Benchmark::report(SUITE_UTILS, "uidToString", 0, iterations, micros() - start);
+
+    start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        key[5] = (uint8_t)i;
+        String s = Utils::keyToHexString(key);
+    }
+    Benchmark::report(SUITE_UTILS, "keyToHexString", 0, iterations, micros() - start);
+
+    start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        Utils::hexStringToKey(keyHex, key);
+    }
+    Benchmark::report(SUITE_UTILS, "hexStringToKey", 0, iterations, micros() - start);
+}
+
+#endif // ENABLE_BENCHMARKS
@@ -0,0 +1,56 @@
+#ifndef CARDBENCHMARKS_H
+#define CARDBENCHMARKS_H
+
+#include <Arduino.h>
+#include "../data/CardDatabase.h"
+
+/**
+ * 卡片存储基准测试
+ * 覆盖CardDatabase查找（命中/未命中）、添加、删除，内存中的JSON序列化/反序列化，
+ * 以及Utils的十六进制转换（存储后端的读写见StorageBenchmarks），在10、100、1k张卡的规模下运行
+ * 内存不足以容纳的规模输出skipped记录
+ *
+ * 10k和100k张卡不在范围内：JSON数据库整个放在内存中，约需1.1 MB和11 MB，
+ * 设备上永远放不下；大规模卡片使用按卡片存储模式，见StorageBenchmarks的card_mode套件
+ */
+class CardBenchmarks {
+public:
+    /**
+     * 运行全部卡片相关基准测试
+     */
+    static void runAll();
+
+    /**
+     * CardDatabase查找、添加、删除
+     * @param n 卡片数量
+     */
+    static void runCardDatabase(size_t n);
+
+    /**
+     * 内存中的序列化/反序列化（不含flash访问）
+     * @param n 卡片数量
+     */
+    static void runFileSystem(size_t n);
+
+    /**
+     * Utils十六进制转换
+     */
+    static void runUtils();
+
+    /**
+     * 用合成卡片填充数据库（不经过addCard的重复检查）
+     * @param db 数据库
+     * @param n 卡片数量
+     * @return 是否成功（内存不足时返回false）
+     */
+    static bool populate(CardDatabase& db, size_t n);
+
+    // JSON模式下每张卡片估计占用的内存
+    static const size_t JSON_BYTES_PER_CARD = 112;
+
+    // JSON数据库的卡片规模（只包括设备内存可能容纳的规模）
+    static const size_t JSON_CARD_COUNTS[];
+    static const size_t JSON_CARD_COUNT_COUNT;
+};
+
+#endif // CARDBENCHMARKS_H
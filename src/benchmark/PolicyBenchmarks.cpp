@@ -0,0 +1,120 @@
+#ifdef ENABLE_BENCHMARKS
+
+#include "PolicyBenchmarks.h"
+#include "Benchmark.h"
+
+namespace {
+const char* SUITE_POLICY = "policy";
+const size_t RULE_COUNTS[] = {32, 256, 2048};
+const size_t DECISION_CARDS = 1000;
+const unsigned long DECISION_ITERATIONS = 20000;
+const char* DOOR_NAME = "Main";
+}
+
+void PolicyBenchmarks::runAll() {
+    Serial.println("BENCH begin policy benchmarks");
+    for (size_t i = 0; i < sizeof(RULE_COUNTS) / sizeof(RULE_COUNTS[0]); i++) {
+        runRules(RULE_COUNTS[i]);
+    }
+    for (size_t i = 0; i < Benchmark::FLEET_SIZE_COUNT; i++) {
+        runCards(Benchmark::FLEET_SIZES[i]);
+    }
+    Serial.println("BENCH end policy benchmarks");
+}
+
+void PolicyBenchmarks::syntheticUID(uint32_t index, uint8_t* uid) {
+    uid[0] = 0x04;
+    uid[1] = 0x00;
+    uid[2] = 0x00;
+    uid[3] = (uint8_t)(index >> 24);
+    uid[4] = (uint8_t)(index >> 16);
+    uid[5] = (uint8_t)(index >> 8);
+    uid[6] = (uint8_t)index;
+}
+
+void PolicyBenchmarks::populateRules(AccessPolicy& policy, size_t rules) {
+    for (size_t g = 0; g < AccessPolicy::MAX_GROUPS; g++) {
+        policy.addGroup("g" + String(g));
+    }
+    // 每条规则一个1-8小时的窗口，分布在一周的不同时段；部分组限制到指定的门
+    for (size_t r = 0; r < rules; r++) {
+        int group = r % AccessPolicy::MAX_GROUPS;
+        int day = (r / AccessPolicy::MAX_GROUPS) % 7;
+        int from = (r * 5 + group) % 24;
+        int to = (from + 1 + r % 8) % 24;
+        policy.addWindow(group, day, from, to);
+    }
+    for (size_t g = 0; g < AccessPolicy::MAX_GROUPS; g += 4) {
+        policy.addDoor(g, DOOR_NAME);
+    }
+}
+
+void PolicyBenchmarks::runRules(size_t rules) {
+    AccessPolicy policy;
+
+    unsigned long start = micros();
+    populateRules(policy, rules);
+    Benchmark::report(SUITE_POLICY, "compile_rules", rules, 1, micros() - start);
+
+    uint8_t uid[7];
+    for (size_t i = 0; i < DECISION_CARDS; i++) {
+        syntheticUID(i, uid);
+        policy.setCardGroups(uid, sizeof(uid), (1u << (i % 32)) | (1u << ((i * 7) % 32)));
+    }
+
+    // 决策时间应与规则数无关
+    volatile int allowed = 0;
+    start = micros();
+    for (unsigned long i = 0; i < DECISION_ITERATIONS; i++) {
+        syntheticUID(i % DECISION_CARDS, uid);
+        allowed += policy.evaluate(uid, sizeof(uid), DOOR_NAME, i % AccessPolicy::HOURS_PER_WEEK) ==
+                   AccessPolicy::DECISION_ALLOW;
+    }
+    Benchmark::report(SUITE_POLICY, "evaluate_rules", rules, DECISION_ITERATIONS, micros() - start);
+}
+
+void PolicyBenchmarks::runCards(size_t n) {
+    if (!Benchmark::fitsInHeap(n, BYTES_PER_CARD)) {
+        Benchmark::skip(SUITE_POLICY, "all", n, "insufficient heap");
+        return;
+    }
+
+    AccessPolicy policy;
+    populateRules(policy, 256);
+
+    uint8_t uid[7];
+    unsigned long start = micros();
+    for (size_t i = 0; i < n; i++) {
+        syntheticUID(i, uid);
+        policy.setCardGroups(uid, sizeof(uid), (1u << (i % 32)) | (1u << ((i * 7) % 32)));
+    }
+    Benchmark::report(SUITE_POLICY, "load_cards", n, n, micros() - start);
+
+    volatile int allowed = 0;
+    start = micros();
+    for (unsigned long i = 0; i < DECISION_ITERATIONS; i++) {
+        syntheticUID((i * 7919) % n, uid);
+        allowed += policy.evaluate(uid, sizeof(uid), DOOR_NAME, i % AccessPolicy::HOURS_PER_WEEK) ==
+                   AccessPolicy::DECISION_ALLOW;
+    }
+    Benchmark::report(SUITE_POLICY, "evaluate_hit", n, DECISION_ITERATIONS, micros() - start);
+
+    // 不受限制的卡片（查找未命中）
+    start = micros();
+    for (unsigned long i = 0; i < DECISION_ITERATIONS; i++) {
+        syntheticUID(n + i, uid);
+        allowed += policy.evaluate(uid, sizeof(uid), DOOR_NAME, i % AccessPolicy::HOURS_PER_WEEK) ==
+                   AccessPolicy::DECISION_ALLOW;
+    }
+    Benchmark::report(SUITE_POLICY, "evaluate_unrestricted", n, DECISION_ITERATIONS, micros() - start);
+
+    start = micros();
+    for (unsigned long i = 0; i < DECISION_ITERATIONS; i++) {
+        syntheticUID((i * 7919) % n, uid);
+        allowed += policy.evaluate(uid, sizeof(uid), DOOR_NAME, AccessPolicy::HOUR_UNKNOWN) ==
+                   AccessPolicy::DECISION_ALLOW;
+    }
+    Benchmark::report(SUITE_POLICY, "evaluate_time_unknown", n, DECISION_ITERATIONS, micros() - start);
+}
+
+#endif // ENABLE_BENCHMARKS
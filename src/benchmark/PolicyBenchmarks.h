@@ -0,0 +1,50 @@
+#ifndef POLICYBENCHMARKS_H
+#define POLICYBENCHMARKS_H
+
+#include <Arduino.h>
+#include "../security/AccessPolicy.h"
+
+/**
+ * 访问策略基准测试
+ * 在32、256、2048条时间窗口规则下测量编译时间和刷卡决策时间，
+ * 并在10、1k、10k、100k张受限卡片的规模下测量决策时间（命中/不受限制/时间未知）
+ */
+class PolicyBenchmarks {
+public:
+    /**
+     * 运行全部访问策略基准测试
+     */
+    static void runAll();
+
+    /**
+     * 编译指定数量的规则，并测量决策时间
+     * @param rules 时间窗口规则数（平均分配到所有组）
+     */
+    static void runRules(size_t rules);
+
+    /**
+     * 在指定数量的受限卡片下测量决策时间
+     * @param n 受限卡片数量
+     */
+    static void runCards(size_t n);
+
+private:
+    /**
+     * 用合成规则填充策略
+     * @param policy 访问策略
+     * @param rules 规则数
+     */
+    static void populateRules(AccessPolicy& policy, size_t rules);
+
+    /**
+     * 生成按序号递增的UID（按顺序插入时无需移动已有条目）
+     * @param index 序号
+     * @param uid 输出的7字节UID
+     */
+    static void syntheticUID(uint32_t index, uint8_t* uid);
+
+    // 每张受限卡片估计占用的内存
+    static const size_t BYTES_PER_CARD = 16;
+};
+
+#endif // POLICYBENCHMARKS_H
@@ -0,0 +1,123 @@
+#ifdef ENABLE_BENCHMARKS
+
+#include "SimulatedAuthenticator.h"
+#include "../utils/Clock.h"
+#include "../utils/Utils.h"
+
+SimulatedAuthenticator::SimulatedAuthenticator(Kind kind, CardDatabase* db, const char* name)
+    : kind(kind), cardDatabase(db), name(name), pending(false), pendingArrival(0),
+      hasLastTap(false), lastTapArrival(0),
+      offeredCount(0), droppedCount(0), cooldownCount(0), lockedCount(0) {
+}
+
+bool SimulatedAuthenticator::offer(const String& uid) {
+    offeredCount++;
+    if (pending) {
+        droppedCount++;
+        return false;
+    }
+    pending = true;
+    pendingUID = uid;
+    pendingArrival = Clock::now();
+    return true;
+}
+
+unsigned long SimulatedAuthenticator::getOfferedCount() const {
+    return offeredCount;
+}
+
+unsigned long SimulatedAuthenticator::getDroppedCount() const {
+    return droppedCount;
+}
+
+unsigned long SimulatedAuthenticator::getCooldownCount() const {
+    return cooldownCount;
+}
+
+unsigned long SimulatedAuthenticator::getLockedCount() const {
+    return lockedCount;
+}
+
+std::vector<unsigned long>& SimulatedAuthenticator::getLatencies() {
+    return latencies;
+}
+
+bool SimulatedAuthenticator::initialize() {
+    return true;
+}
+
+bool SimulatedAuthenticator::hasAuthenticationRequest() {
+    return pending;
+}
+
+bool SimulatedAuthenticator::authenticate() {
+    if (!pending) {
+        return false;
+    }
+    pending = false;
+
+    unsigned long now = Clock::now();
+    latencies.push_back(now - pendingArrival);
+
+    if (kind == KIND_EXIT_BUTTON) {
+        return true;
+    }
+
+    // 与NFCAuthenticator相同的同卡冷却和失败锁定规则
+    uint8_t uid[Utils::MAX_UID_SIZE];
+    uint8_t uidLength = 0;
+    Utils::stringToUid(pendingUID, uid, &uidLength);
+
+    // 换卡或间隔足够长时，之前的卡片已离开读卡器（NFCManager报告CARD_REMOVED）；
+    // 同一张卡的短间隔重复刷卡保留冷却，由同卡冷却抑制
+    if (!hasLastTap || pendingUID != lastUID || pendingArrival - lastTapArrival > REMOVAL_GAP_MS) {
+        recentCards.clearCooldown(uid, uidLength, now);
+    }
+    hasLastTap = true;
+    lastUID = pendingUID;
+    lastTapArrival = pendingArrival;
+
+    RecentUIDTable::Verdict verdict = recentCards.check(uid, uidLength, now);
+    if (verdict == RecentUIDTable::VERDICT_COOLDOWN) {
+        cooldownCount++;
+        return false;
+    }
+    if (verdict == RecentUIDTable::VERDICT_LOCKED) {
+        lockedCount++;
+        return false;
+    }
+
+    String keyHex;
+    if (!cardDatabase->findCardByUID(pendingUID, keyHex)) {
+        recentCards.recordFailure(uid, uidLength, now);
+        return false;
+    }
+
+    recentCards.recordSuccess(uid, uidLength, now);
+    return true;
+}
+
+const char* SimulatedAuthenticator::getName() const {
+    return name;
+}
+
+void SimulatedAuthenticator::reset() {
+    pending = false;
+    hasLastTap = false;
+    recentCards.clear();
+    offeredCount = 0;
+    droppedCount = 0;
+    cooldownCount = 0;
+    lockedCount = 0;
+    latencies.clear();
+}
+
+bool SimulatedAuthenticator::usesSharedReader() const {
+    return kind == KIND_CARD_READER;
+}
+
+bool SimulatedAuthenticator::hasCredentialCooldown() const {
+    return kind == KIND_CARD_READER;
+}
+
+#endif // ENABLE_BENCHMARKS
@@ -0,0 +1,105 @@
+#ifndef SIMULATEDAUTHENTICATOR_H
+#define SIMULATEDAUTHENTICATOR_H
+
+#include "../interfaces/IAuthenticator.h"
+#include "../data/CardDatabase.h"
+#include "../security/RecentUIDTable.h"
+#include <vector>
+
+/**
+ * 仿真认证器
+ * 由负载生成器注入刷卡或按钮事件，按NFCAuthenticator的规则做出决策：
+ * - 卡片：最近刷卡表（同卡冷却、失败锁定）+ 数据库查找（不访问真实读卡器）
+ * - 按钮：总是成功
+ * 与真实读卡器一样一次只能容纳一个待处理事件，处理前到达的新事件被丢弃
+ * 同一张卡在 REMOVAL_GAP_MS 内重复刷卡视为卡片没有离开读卡器（抖动），受同卡冷却限制；
+ * 换卡或间隔更长时视为卡片已离开，清除冷却
+ * 时间全部取自Clock，可在虚拟时间中运行
+ */
+class SimulatedAuthenticator : public IAuthenticator {
+public:
+    // 同一张卡两次刷卡的间隔超过此时间视为中间已移开（毫秒）
+    static const unsigned long REMOVAL_GAP_MS = 2000;
+
+    enum Kind {
+        KIND_CARD_READER,
+        KIND_EXIT_BUTTON
+    };
+
+private:
+    Kind kind;
+    CardDatabase* cardDatabase;
+    const char* name;
+
+    // 待处理事件
+    bool pending;
+    String pendingUID;
+    unsigned long pendingArrival;
+
+    // 上一次刷卡（判断卡片是否离开过读卡器）
+    bool hasLastTap;
+    String lastUID;
+    unsigned long lastTapArrival;
+
+    // 同卡冷却和失败锁定
+    RecentUIDTable recentCards;
+
+    // 统计
+    unsigned long offeredCount;
+    unsigned long droppedCount;
+    unsigned long cooldownCount;
+    unsigned long lockedCount;
+    std::vector<unsigned long> latencies;
+
+public:
+    /**
+     * 构造函数
+     * @param kind 认证器类型
+     * @param db 卡片数据库（按钮类型可为nullptr）
+     * @param name 认证器名称
+     */
+    SimulatedAuthenticator(Kind kind, CardDatabase* db, const char* name);
+
+    /**
+     * 注入一个事件
+     * @param uid 卡片UID（按钮事件忽略）
+     * @return 是否被接收（false表示上一个事件尚未处理，本事件被丢弃）
+     */
+    bool offer(const String& uid);
+
+    /**
+     * 获取注入的事件数
+     */
+    unsigned long getOfferedCount() const;
+
+    /**
+     * 获取被丢弃的事件数
+     */
+    unsigned long getDroppedCount() const;
+
+    /**
+     * 获取同卡冷却忽略的次数
+     */
+    unsigned long getCooldownCount() const;
+
+    /**
+     * 获取锁定期间被拒绝的次数
+     */
+    unsigned long getLockedCount() const;
+
+    /**
+     * 获取每个已决策事件从到达到决策的延迟（毫秒，虚拟时间）
+     */
+    std::vector<unsigned long>& getLatencies();
+
+    // IAuthenticator接口实现
+    bool initialize() override;
+    bool hasAuthenticationRequest() override;
+    bool authenticate() override;
+    const char* getName() const override;
+    void reset() override;
+    bool usesSharedReader() const override;
+    bool hasCredentialCooldown() const override;
+};
+
+#endif // SIMULATEDAUTHENTICATOR_H
@@ -0,0 +1,203 @@
+#ifdef ENABLE_BENCHMARKS
+
+#include "StorageBenchmarks.h"
+#include "Benchmark.h"
+#include "CardBenchmarks.h"
+#include "../data/CardDatabase.h"
+#include "../data/FileSystemManager.h"
+#include "../data/FileStorageBackend.h"
+#include "../data/NvsStorageBackend.h"
+#include "../data/NvsCardStore.h"
+
+namespace {
+const char* BENCH_FILE = "/bench_cards.json";
+const char* BENCH_NAMESPACE = "benchcards";
+const char* BENCH_KV_NAMESPACE = "benchkv";
+const char* SUITE_MODE = "card_mode";
+const size_t CARD_COUNTS[] = {10, 100, 1000, 10000};
+const size_t MODE_CARD_COUNTS[] = {10, 100, 1000, 5000};
+
+// 查找目标轮换使用，数量大于热卡缓存，轮换查找时缓存不会命中
+const size_t TARGET_COUNT = NvsCardStore::HOT_CACHE_SIZE * 2;
+}
+
+void StorageBenchmarks::runAll() {
+    Serial.println("BENCH begin storage benchmarks");
+
+    FileStorageBackend fileBackend(FileSystemManager::fileSystem(), FileSystemManager::fileSystemName(), BENCH_FILE);
+    NvsStorageBackend nvsBackend(BENCH_NAMESPACE);
+    IStorageBackend* backends[] = {&fileBackend, &nvsBackend};
+    // NVS没有可用空间查询，以首次写入是否成功判断
+    size_t freeBytes[] = {FileSystemManager::freeBytes(), 0};
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        if (!backends[b]->begin()) {
+            Benchmark::skip((String("storage_") + backends[b]->getName()).c_str(), "all", 0, "open failed");
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(CARD_COUNTS) / sizeof(CARD_COUNTS[0]); i++) {
+            runBackend(*backends[b], CARD_COUNTS[i], freeBytes[b]);
+        }
+        backends[b]->erase();
+    }
+
+    for (size_t i = 0; i < sizeof(MODE_CARD_COUNTS) / sizeof(MODE_CARD_COUNTS[0]); i++) {
+        runCardModes(MODE_CARD_COUNTS[i]);
+    }
+
+    Serial.println("BENCH end storage benchmarks");
+}
+
+void StorageBenchmarks::runBackend(IStorageBackend& backend, size_t n, size_t freeBytes) {
+    String suiteName = String("storage_") + backend.getName();
+    const char* suite = suiteName.c_str();
+
+    // 数据库和加载结果同时存在
+    if (!Benchmark::fitsInHeap(n, CardBenchmarks::JSON_BYTES_PER_CARD * 2)) {
+        Benchmark::skip(suite, "all", n, "insufficient heap");
+        return;
+    }
+
+    CardDatabase db;
+    if (!CardBenchmarks::populate(db, n)) {
+        Benchmark::skip(suite, "all", n, "allocation failed");
+        return;
+    }
+    JsonDocument& cards = db.getDatabase();
+
+    // 文件后端保存两个副本（A/B槽）
+    if (freeBytes > 0 && measureJson(cards) * 2 > freeBytes) {
+        Benchmark::skip(suite, "all", n, "insufficient flash");
+        return;
+    }
+
+    // 先写一次，确认容量足够（NVS分区较小）
+    if (!backend.saveCards(cards)) {
+        Benchmark::skip(suite, "all", n, "write failed");
+        backend.erase();
+        return;
+    }
+
+    unsigned long iterations = Benchmark::iterationsFor(n, 20000, 20);
+
+    unsigned long start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        backend.saveCards(cards);
+    }
+    Benchmark::report(suite, "save", n, iterations, micros() - start);
+
+    start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        JsonDocument loaded;
+        backend.loadCards(loaded);
+    }
+    Benchmark::report(suite, "load", n, iterations, micros() - start);
+
+    // 修改一张卡片的访问组后持久化（注册、删除、设置组等管理操作的写入方式）
+    JsonArray cardArray = cards.as<JsonArray>();
+    start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        JsonObject card = cardArray[(i * 7919) % n];
+        JsonArray groups = card["groups"].to<JsonArray>();
+        groups.add(i & 1 ? "staff" : "admin");
+        backend.updateCard(card["uid"].as<String>(), cards);
+    }
+    Benchmark::report(suite, "update", n, iterations, micros() - start);
+
+    backend.erase();
+}
+
+void StorageBenchmarks::runCardModes(size_t n) {
+    String hits[TARGET_COUNT];
+    String misses[TARGET_COUNT];
+    for (size_t i = 0; i < TARGET_COUNT; i++) {
+        hits[i] = Benchmark::syntheticUID((i * 7919) % n);
+        misses[i] = Benchmark::syntheticUID(n + i);
+    }
+    String keyHex;
+    unsigned long iterations = Benchmark::iterationsFor(n, 20000, 2000);
+
+    // JSON模式：启动时读取并解析整个文件，刷卡时线性查找内存中的数组
+    if (!Benchmark::fitsInHeap(n, CardBenchmarks::JSON_BYTES_PER_CARD * 2)) {
+        Benchmark::skip(SUITE_MODE, "json", n, "insufficient heap");
+    } else {
+        CardDatabase db;
+        FileStorageBackend backend(FileSystemManager::fileSystem(), FileSystemManager::fileSystemName(), BENCH_FILE);
+        if (!CardBenchmarks::populate(db, n) || !backend.begin() || !backend.saveCards(db.getDatabase())) {
+            Benchmark::skip(SUITE_MODE, "json", n, "setup failed");
+        } else {
+            unsigned long boots = Benchmark::iterationsFor(n, 2000, 10);
+            unsigned long start = micros();
+            for (unsigned long i = 0; i < boots; i++) {
+                JsonDocument loaded;
+                backend.loadCards(loaded);
+                db.loadFromJson(loaded);
+            }
+            Benchmark::report(SUITE_MODE, "json_boot", n, boots, micros() - start);
+
+            start = micros();
+            for (unsigned long i = 0; i < iterations; i++) {
+                db.findCardByUID(hits[i % TARGET_COUNT], keyHex);
+            }
+            Benchmark::report(SUITE_MODE, "json_tap_hit", n, iterations, micros() - start);
+
+            start = micros();
+            for (unsigned long i = 0; i < iterations; i++) {
+                db.findCardByUID(misses[i % TARGET_COUNT], keyHex);
+            }
+            Benchmark::report(SUITE_MODE, "json_tap_miss", n, iterations, micros() - start);
+        }
+        backend.erase();
+    }
+
+    // NVS模式：启动时只打开命名空间（不含分区挂载，挂载耗时由begin()打印），刷卡时查找一个条目
+    NvsCardStore store(BENCH_KV_NAMESPACE);
+    if (!store.begin()) {
+        Benchmark::skip(SUITE_MODE, "nvs", n, "open failed");
+        return;
+    }
+    store.eraseAll();
+    for (size_t i = 0; i < n; i++) {
+        uint8_t key[Utils::KEY_SIZE];
+        Utils::hexStringToKey(Benchmark::syntheticKey(i), key);
+        if (!store.put(Benchmark::syntheticUID(i), key)) {
+            Benchmark::skip(SUITE_MODE, "nvs", n, "write failed");
+            store.eraseAll();
+            return;
+        }
+    }
+
+    unsigned long boots = Benchmark::iterationsFor(n, 2000, 10);
+    unsigned long start = micros();
+    for (unsigned long i = 0; i < boots; i++) {
+        NvsCardStore reopened(BENCH_KV_NAMESPACE);
+        reopened.begin();
+    }
+    Benchmark::report(SUITE_MODE, "nvs_boot", n, boots, micros() - start);
+
+    CardDatabase db;
+    db.setCardStore(&store);
+
+    start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        db.findCardByUID(hits[i % TARGET_COUNT], keyHex);
+    }
+    Benchmark::report(SUITE_MODE, "nvs_tap_cold", n, iterations, micros() - start);
+
+    // 同一张卡片重复刷卡（热卡缓存命中）
+    start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        db.findCardByUID(hits[0], keyHex);
+    }
+    Benchmark::report(SUITE_MODE, "nvs_tap_hot", n, iterations, micros() - start);
+
+    start = micros();
+    for (unsigned long i = 0; i < iterations; i++) {
+        db.findCardByUID(misses[i % TARGET_COUNT], keyHex);
+    }
+    Benchmark::report(SUITE_MODE, "nvs_tap_miss", n, iterations, micros() - start);
+
+    store.eraseAll();
+}
+
+#endif // ENABLE_BENCHMARKS
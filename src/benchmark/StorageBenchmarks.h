@@ -0,0 +1,39 @@
+#ifndef STORAGEBENCHMARKS_H
+#define STORAGEBENCHMARKS_H
+
+#include <Arduino.h>
+#include "../interfaces/IStorageBackend.h"
+
+/**
+ * 卡片存储后端基准测试
+ * 对每个可用的后端测量全部加载、全部保存和单张卡片更新的延迟，
+ * 在10、100、1k、10k张卡的规模下运行，结果的suite为"storage_<后端名称>"
+ * 文件后端使用当前编译选择的文件系统（SPIFFS和LittleFS共用分区，需分别编译bench环境比较），
+ * NVS后端在任何编译选项下都会测试，使用独立的命名空间；超出容量的规模输出skipped记录
+ *
+ * 另外比较CardDatabase的两种模式（suite为"card_mode"）：
+ * JSON模式的启动加载和刷卡查找，与NVS按卡片存储模式的打开、冷/热缓存查找和未注册卡片查找
+ */
+class StorageBenchmarks {
+public:
+    /**
+     * 运行全部存储后端基准测试
+     */
+    static void runAll();
+
+    /**
+     * 测量一个后端在指定规模下的加载、保存和单卡更新
+     * @param backend 存储后端（已打开）
+     * @param n 卡片数量
+     * @param freeBytes 后端可用空间，0表示未知
+     */
+    static void runBackend(IStorageBackend& backend, size_t n, size_t freeBytes);
+
+    /**
+     * 比较JSON模式和NVS按卡片存储模式的启动时间和刷卡查找延迟
+     * @param n 卡片数量
+     */
+    static void runCardModes(size_t n);
+};
+
+#endif // STORAGEBENCHMARKS_H
@@ -0,0 +1,333 @@
+#ifdef ENABLE_BENCHMARKS
+
+#include "TapStormSimulator.h"
+#include "SimulatedAuthenticator.h"
+#include "Benchmark.h"
+#include "CardBenchmarks.h"
+#include "../system/SystemCoordinator.h"
+#include "../data/CardDatabase.h"
+#include "../utils/Clock.h"
+#include <algorithm>
+#include <math.h>
+
+namespace {
+const char* SUITE = "tap_storm";
+
+// 虚拟时间起点（非零，与设备启动后的millis()相近）
+const unsigned long SIM_START_MS = 60000;
+
+// 全部事件结束后继续运行的时间，保证最后的事件被处理
+const unsigned long DRAIN_MS = 2000;
+
+const char* READER_NAMES[TapStormSimulator::MAX_READERS] = {
+    "Simulated NFC 1", "Simulated NFC 2", "Simulated NFC 3", "Simulated NFC 4"
+};
+
+/**
+ * 计数执行器
+ * 只统计协调器的开门/拒绝决策，不驱动任何硬件
+ */
+class CountingExecutor : public IActionExecutor {
+public:
+    unsigned long successCount;
+    unsigned long failureCount;
+
+    CountingExecutor() : successCount(0), failureCount(0) {}
+
+    bool initialize() override { return true; }
+    void executeSuccessAction() override { successCount++; }
+    void executeFailureAction() override { failureCount++; }
+    bool isExecuting() const override { return false; }
+    void stopExecution() override {}
+    const char* getName() const override { return "Counting Executor"; }
+};
+
+// xorshift32，保证相同种子得到相同刷卡流
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+unsigned long percentile(const std::vector<unsigned long>& sorted, unsigned percent) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[(sorted.size() - 1) * percent / 100];
+}
+
+bool earlier(const TapStormSimulator::Event& a, const TapStormSimulator::Event& b) {
+    return a.time < b.time;
+}
+}
+
+std::vector<TapStormSimulator::Event> TapStormSimulator::randomStream(uint32_t tapsPerMinute, uint32_t durationSec, uint32_t seed,
+                                                                uint8_t readers) {
+    std::vector<Event> events;
+    if (tapsPerMinute == 0) {
+        return events;
+    }
+
+    uint32_t state = seed ? seed : 1;
+    double meanGapMs = 60000.0 / tapsPerMinute;
+    unsigned long duration = (unsigned long)durationSec * 1000;
+    double time = 0;
+
+    while (true) {
+        // 指数分布的到达间隔（泊松过程）
+        double u = (nextRandom(state) + 1.0) / 4294967297.0;
+        time += -log(u) * meanGapMs;
+        if (time >= duration) {
+            break;
+        }
+
+        Event event;
+        event.time = (unsigned long)time;
+        event.card = nextRandom(state) % CARD_COUNT;
+        event.reader = readers > 1 ? nextRandom(state) % readers : 0;
+
+        uint32_t roll = nextRandom(state) % 100;
+        if (roll < BUTTON_PERCENT) {
+            event.kind = EVENT_BUTTON;
+        } else if (roll < BUTTON_PERCENT + UNREGISTERED_PERCENT) {
+            event.kind = EVENT_UNREGISTERED;
+        } else {
+            event.kind = EVENT_REGISTERED;
+        }
+        events.push_back(event);
+
+        // 没听到提示音的人会再刷一次
+        if (event.kind != EVENT_BUTTON && nextRandom(state) % 100 < BOUNCE_PERCENT) {
+            Event bounce = event;
+            bounce.time += BOUNCE_MIN_MS + nextRandom(state) % (BOUNCE_MAX_MS - BOUNCE_MIN_MS + 1);
+            events.push_back(bounce);
+        }
+    }
+
+    std::stable_sort(events.begin(), events.end(), earlier);
+    return events;
+}
+
+bool TapStormSimulator::parseScript(const String& script, std::vector<Event>& events) {
+    events.clear();
+    int start = 0;
+    while (start < (int)script.length()) {
+        int end = script.indexOf(',', start);
+        if (end == -1) {
+            end = script.length();
+        }
+        String item = script.substring(start, end);
+        item.trim();
+        start = end + 1;
+
+        int at = item.indexOf('@');
+        if (at <= 0 || at + 1 >= (int)item.length()) {
+            return false;
+        }
+
+        Event event;
+        event.time = item.substring(0, at).toInt();
+        event.card = item.substring(at + 2).toInt();
+        event.reader = 0;
+
+        int slash = item.indexOf('/', at);
+        if (slash != -1) {
+            long reader = item.substring(slash + 1).toInt();
+            if (reader < 0 || reader >= MAX_READERS) {
+                return false;
+            }
+            event.reader = reader;
+        }
+
+        char kind = toupper(item.charAt(at + 1));
+        if (kind == 'R') {
+            event.kind = EVENT_REGISTERED;
+            if (event.card >= CARD_COUNT) {
+                return false;
+            }
+        } else if (kind == 'U') {
+            event.kind = EVENT_UNREGISTERED;
+        } else if (kind == 'B') {
+            event.kind = EVENT_BUTTON;
+        } else {
+            return false;
+        }
+        events.push_back(event);
+    }
+
+    std::stable_sort(events.begin(), events.end(), earlier);
+    return !events.empty();
+}
+
+bool TapStormSimulator::run(const char* label, const std::vector<Event>& events, uint8_t readers) {
+    if (readers == 0 || readers > MAX_READERS) {
+        return false;
+    }
+    if (!Benchmark::fitsInHeap(CARD_COUNT, CardBenchmarks::JSON_BYTES_PER_CARD)) {
+        Benchmark::skip(SUITE, label, events.size(), "insufficient heap");
+        return false;
+    }
+
+    CardDatabase db;
+    if (!CardBenchmarks::populate(db, CARD_COUNT)) {
+        Benchmark::skip(SUITE, label, events.size(), "allocation failed");
+        return false;
+    }
+
+    // 未注册卡片使用注册范围之外的序号
+    std::vector<String> unregistered;
+    for (size_t i = 0; i < events.size(); i++) {
+        if (events[i].kind == EVENT_UNREGISTERED) {
+            unregistered.push_back(Benchmark::syntheticUID(CARD_COUNT + events[i].card));
+        }
+    }
+
+    // 每个读卡器绑定自己的执行器组，按钮使用第一组
+    CountingExecutor executors[MAX_READERS];
+    std::vector<SimulatedAuthenticator*> cardReaders;
+    SimulatedAuthenticator button(SimulatedAuthenticator::KIND_EXIT_BUTTON, nullptr, "Simulated Button");
+    SystemCoordinator coordinator(&executors[0]);
+    for (uint8_t r = 0; r < readers; r++) {
+        cardReaders.push_back(new SimulatedAuthenticator(SimulatedAuthenticator::KIND_CARD_READER, &db, READER_NAMES[r]));
+        coordinator.addAuthenticator(cardReaders[r], &executors[r]);
+    }
+    coordinator.addAuthenticator(&button);
+    coordinator.initialize();
+
+    Clock::useVirtualTime(SIM_START_MS);
+
+    unsigned long endTime = SIM_START_MS + (events.empty() ? 0 : events.back().time) + DRAIN_MS;
+    size_t next = 0;
+    size_t nextUnregistered = 0;
+    unsigned long loops = 0;
+    unsigned long cpuUs = 0;
+    unsigned long maxLoopUs = 0;
+
+    for (unsigned long now = SIM_START_MS; now <= endTime; now += LOOP_PERIOD_MS) {
+        Clock::setVirtualTime(now);
+
+        // 投递所有已到达的事件
+        while (next < events.size() && SIM_START_MS + events[next].time <= now) {
+            const Event& event = events[next++];
+            SimulatedAuthenticator* reader = cardReaders[event.reader < readers ? event.reader : 0];
+            if (event.kind == EVENT_BUTTON) {
+                button.offer("");
+            } else if (event.kind == EVENT_UNREGISTERED) {
+                reader->offer(unregistered[nextUnregistered++]);
+            } else {
+                reader->offer(Benchmark::syntheticUID(event.card));
+            }
+        }
+
+        unsigned long start = micros();
+        coordinator.handleLoop();
+        unsigned long elapsed = micros() - start;
+
+        cpuUs += elapsed;
+        if (elapsed > maxLoopUs) {
+            maxLoopUs = elapsed;
+        }
+        loops++;
+    }
+
+    Clock::useRealTime();
+
+    // 合并所有认证器的统计和决策延迟
+    std::vector<unsigned long> latencies = button.getLatencies();
+    unsigned long dropped = button.getDroppedCount();
+    unsigned long sameCardCooldown = 0;
+    unsigned long lockedOut = 0;
+    for (size_t r = 0; r < cardReaders.size(); r++) {
+        SimulatedAuthenticator* reader = cardReaders[r];
+        latencies.insert(latencies.end(), reader->getLatencies().begin(), reader->getLatencies().end());
+        dropped += reader->getDroppedCount();
+        sameCardCooldown += reader->getCooldownCount();
+        lockedOut += reader->getLockedCount();
+        delete reader;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    SystemCoordinator::Stats stats = coordinator.getStats();
+    unsigned long decisions = stats.granted + stats.denied + stats.cooldownSuppressed + stats.policyDenied +
+                              stats.passbackDenied;
+    unsigned long simulatedMs = endTime - SIM_START_MS;
+    unsigned long decisionsPerMin = simulatedMs > 0 ? (unsigned long)((uint64_t)decisions * 60000 / simulatedMs) : 0;
+    unsigned long nsPerLoop = loops > 0 ? (unsigned long)((uint64_t)cpuUs * 1000 / loops) : 0;
+
+    Serial.printf("BENCH {\"suite\":\"%s\",\"op\":\"%s\",\"n\":%u,\"iters\":%lu,\"ns_per_op\":%lu,\"readers\":%u,"
+                  "\"sim_ms\":%lu,\"decisions\":%lu,\"decisions_per_min\":%lu,\"granted\":%lu,\"denied\":%lu,"
+                  "\"dropped\":%lu,\"cooldown_coordinator\":%lu,\"cooldown_same_card\":%lu,\"locked_out\":%lu,"
+                  "\"latency_ms\":{\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu},\"max_loop_us\":%lu}\n",
+                  SUITE, label, (unsigned)events.size(), loops, nsPerLoop, (unsigned)readers,
+                  simulatedMs, decisions, decisionsPerMin, stats.granted, stats.denied,
+                  dropped, stats.cooldownSuppressed, sameCardCooldown, lockedOut,
+                  percentile(latencies, 50), percentile(latencies, 90), percentile(latencies, 99),
+                  latencies.empty() ? 0UL : latencies.back(), maxLoopUs);
+    return true;
+}
+
+void TapStormSimulator::runDefault() {
+    static const uint32_t RATES[] = {30, 60, 120};
+    Serial.println("BENCH begin tap storm simulation");
+    for (size_t i = 0; i < sizeof(RATES) / sizeof(RATES[0]); i++) {
+        String label = "random_" + String(RATES[i]) + "pm";
+        run(label.c_str(), randomStream(RATES[i], 300, 42 + i));
+    }
+
+    // 每个读卡器保持每分钟120次，总吞吐量应随读卡器数线性增长
+    for (uint8_t readers = 2; readers <= MAX_READERS; readers *= 2) {
+        uint32_t rate = 120 * readers;
+        String label = "random_" + String(rate) + "pm_" + String(readers) + "r";
+        run(label.c_str(), randomStream(rate, 300, 42, readers), readers);
+    }
+    Serial.println("BENCH end tap storm simulation");
+}
+
+bool TapStormSimulator::handleCommand(const String& command) {
+    if (command.equalsIgnoreCase("sim")) {
+        runDefault();
+        return true;
+    }
+    if (!command.startsWith("sim:")) {
+        return false;
+    }
+
+    String args = command.substring(4);
+    if (args.startsWith("script:")) {
+        std::vector<Event> events;
+        if (!parseScript(args.substring(7), events)) {
+            Serial.println("Tap Storm: Invalid script, expected e.g. 0@R1,300@R1/1,2000@U0,2100@B");
+            return false;
+        }
+        uint8_t readers = 1;
+        for (size_t i = 0; i < events.size(); i++) {
+            if (events[i].reader + 1 > readers) {
+                readers = events[i].reader + 1;
+            }
+        }
+        run("script", events, readers);
+        return true;
+    }
+
+    int separator = args.indexOf(':');
+    if (separator == -1) {
+        return false;
+    }
+    int second = args.indexOf(':', separator + 1);
+    long tapsPerMinute = args.substring(0, separator).toInt();
+    long seconds = args.substring(separator + 1, second == -1 ? args.length() : second).toInt();
+    long readers = second == -1 ? 1 : args.substring(second + 1).toInt();
+    if (tapsPerMinute <= 0 || seconds <= 0 || readers <= 0 || readers > MAX_READERS) {
+        return false;
+    }
+
+    String label = "random_" + String(tapsPerMinute) + "pm";
+    if (readers > 1) {
+        label += "_" + String(readers) + "r";
+    }
+    run(label.c_str(), randomStream(tapsPerMinute, seconds, 42, readers), readers);
+    return true;
+}
+
+#endif // ENABLE_BENCHMARKS
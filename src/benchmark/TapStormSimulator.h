@@ -0,0 +1,101 @@
+#ifndef TAPSTORMSIMULATOR_H
+#define TAPSTORMSIMULATOR_H
+
+#include <Arduino.h>
+#include <vector>
+
+/**
+ * 刷卡风暴负载生成器
+ * 在虚拟时间中驱动一个完整的SystemCoordinator（仿真认证器 + 计数执行器），
+ * 模拟交接班高峰的刷卡流：已注册卡、未注册卡、重复刷卡（抖动）以及出门按钮
+ * 主循环按 LOOP_PERIOD_MS 步进，与真实loop()节奏一致
+ *
+ * 输出BENCH行（suite为"tap_storm"）：
+ * - 吞吐量（每虚拟分钟的决策数）
+ * - 丢弃的刷卡（上一次刷卡尚未处理时到达）
+ * - 冷却抑制（协调器冷却期和同卡冷却）及失败锁定
+ * - 决策延迟分布（p50/p90/p99/max，虚拟毫秒）及每次循环的实际CPU耗时
+ */
+class TapStormSimulator {
+public:
+    // 事件类型
+    enum EventKind {
+        EVENT_REGISTERED,   // 已注册卡片
+        EVENT_UNREGISTERED, // 未注册卡片
+        EVENT_BUTTON        // 出门按钮
+    };
+
+    // 单个事件
+    struct Event {
+        unsigned long time; // 虚拟时间（毫秒）
+        EventKind kind;
+        uint32_t card;      // 卡片序号
+        uint8_t reader;     // 读卡器序号（按钮事件忽略）
+    };
+
+    // 仿真主循环周期（毫秒）
+    static const unsigned long LOOP_PERIOD_MS = 50;
+
+    // 仿真使用的已注册卡片数
+    static const size_t CARD_COUNT = 1000;
+
+    // 最多仿真的读卡器数（每个读卡器绑定独立的执行器组）
+    static const uint8_t MAX_READERS = 4;
+
+    // 随机流中的事件比例（百分比），其余为已注册卡片
+    static const uint8_t UNREGISTERED_PERCENT = 15;
+    static const uint8_t BOUNCE_PERCENT = 10;
+    static const uint8_t BUTTON_PERCENT = 5;
+
+    // 重复刷卡的间隔范围（毫秒）
+    static const unsigned long BOUNCE_MIN_MS = 300;
+    static const unsigned long BOUNCE_MAX_MS = 1500;
+
+    /**
+     * 生成随机刷卡流（泊松到达）
+     * @param tapsPerMinute 平均每分钟刷卡次数
+     * @param durationSec 持续时间（秒）
+     * @param seed 随机种子，相同种子生成相同的刷卡流
+     * @param readers 读卡器数，刷卡随机分布到各读卡器
+     * @return 按时间排序的事件
+     */
+    static std::vector<Event> randomStream(uint32_t tapsPerMinute, uint32_t durationSec, uint32_t seed,
+                                           uint8_t readers = 1);
+
+    /**
+     * 解析脚本化刷卡流
+     * 格式：<ms>@<事件>[,<ms>@<事件>...]，事件为 R<序号>（已注册卡）、U<序号>（未注册卡）或 B（按钮）
+     * 卡片事件可加 /<读卡器序号> 指定读卡器，例如：0@R1,300@R1/1,2000@U0,2100@B
+     * @param script 脚本
+     * @param events 输出：按时间排序的事件
+     * @return 解析是否成功
+     */
+    static bool parseScript(const String& script, std::vector<Event>& events);
+
+    /**
+     * 运行仿真并输出报告
+     * @param label 报告中的场景名
+     * @param events 事件流
+     * @param readers 读卡器数
+     * @return 运行是否成功（内存不足时返回false）
+     */
+    static bool run(const char* label, const std::vector<Event>& events, uint8_t readers = 1);
+
+    /**
+     * 运行默认场景（交接班高峰：单读卡器每分钟30/60/120次刷卡，
+     * 以及2/4个读卡器按读卡器数等比增加刷卡率，各5分钟）
+     */
+    static void runDefault();
+
+    /**
+     * 处理仿真命令
+     * sim                      - 默认场景
+     * sim:<每分钟次数>:<秒数>[:<读卡器数>] - 随机刷卡流
+     * sim:script:<脚本>        - 脚本化刷卡流
+     * @param command 命令字符串
+     * @return 命令格式是否正确
+     */
+    static bool handleCommand(const String& command);
+};
+
+#endif // TAPSTORMSIMULATOR_H
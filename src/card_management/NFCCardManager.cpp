@@ -2,10 +2,16 @@
 #include "../interfaces/IActionExecutor.h"
 
 NFCCardManager::NFCCardManager(NFCManager* manager, CardDatabase* db, FileSystemManager* fsManager)
-    : nfcManager(manager), cardDatabase(db), fileSystemManager(fsManager),
+    : nfcManager(manager), cardDatabase(db), fileSystemManager(fsManager), keyPool(nullptr), accessPolicy(nullptr), revocationList(nullptr),
       currentState(NFC_IDLE), currentOperation(OP_NONE),
       operationCompleted(false), operationSuccess(false), operationJustCompleted(false),
-      operationStartTime(0), lastOperationTime(0) {
+      operationStartTime(0), lastOperationTime(0),
+      batchStartTime(0), batchEnrolledCount(0), batchSkippedCount(0), batchFailedCount(0),
+      nextKeyReady(false),
+      importActive(false), importStartTime(0), importLastTime(0), importApplyTime(0), importNextChunk(0),
+      importAddedCount(0), importUpdatedCount(0), importInvalidCount(0),
+      listActive(false), listOffset(0), listCount(0), listMatched(0), listShown(0),
+      exportActive(false), exportChunkRecords(0), exportNextChunk(0), exportTotal(0), exportStartTime(0) {
 }
 
 void NFCCardManager::addFeedbackExecutor(IActionExecutor* executor) {
@@ -16,6 +22,29 @@ void NFCCardManager::addFeedbackExecutor(IActionExecutor* executor) {
     }
 }
 
+void NFCCardManager::setKeyPool(KeyPool* pool) {
+    keyPool = pool;
+}
+
+void NFCCardManager::setAccessPolicy(AccessPolicy* policy) {
+    accessPolicy = policy;
+}
+
+void NFCCardManager::setRevocationList(RevocationList* list) {
+    revocationList = list;
+}
+
+bool NFCCardManager::reloadPolicy() {
+    if (accessPolicy == nullptr) {
+        Serial.println("Card Manager: Access policy not configured");
+        return false;
+    }
+    JsonDocument policy;
+    bool loaded = fileSystemManager->loadPolicy(policy);
+    bool compiled = accessPolicy->compile(policy, cardDatabase);
+    return loaded && compiled;
+}
+
 void NFCCardManager::executeSuccessFeedback() {
     Serial.println("NFCCardManager: Executing success feedback");
     for (auto* executor : feedbackExecutors) {
@@ -42,8 +71,8 @@ bool NFCCardManager::registerNew() {
 
     Serial.println("Card Manager: Tap new card to register (10s timeout)");
 
-    // 注意：新架构中管理模式由SystemCoordinator控制
-    // 这里不需要请求管理模式，因为调用此函数时已经在管理状态
+    // 注意：读卡器租约由SystemCoordinator管理
+    // 调用此函数时已经持有读卡器租约
 
     // 首先进入检测状态，等待卡片
     currentState = NFC_DETECTING;
@@ -60,7 +89,10 @@ bool NFCCardManager::deleteItem(const String& uid) {
     }
 
     if (cardDatabase->removeCard(uid)) {
-        if (fileSystemManager->saveCards()) {
+        if (accessPolicy != nullptr) {
+            accessPolicy->updateCard(uid, JsonArrayConst());
+        }
+        if (fileSystemManager->saveCard(uid)) {
             Serial.println("Deleted " + uid);
             // 删除成功只需要LED和蜂鸣器反馈，不需要开门
             executeSuccessFeedback();
@@ -98,8 +130,8 @@ bool NFCCardManager::eraseAndDeleteItem(const String& uid) {
 
     Serial.println("Card Manager: Tap card " + uid + " to erase (10s timeout)");
 
-    // 注意：新架构中管理模式由SystemCoordinator控制
-    // 这里不需要请求管理模式，因为调用此函数时已经在管理状态
+    // 注意：读卡器租约由SystemCoordinator管理
+    // 调用此函数时已经持有读卡器租约
 
     // 首先进入检测状态，等待卡片
     currentState = NFC_DETECTING;
@@ -110,27 +142,191 @@ bool NFCCardManager::eraseAndDeleteItem(const String& uid) {
     return true;
 }
 
-void NFCCardManager::listRegisteredItems() {
+void NFCCardManager::listRegisteredItems(const String& param) {
+    // 参数格式：[<偏移>[:<数量>[:<UID前缀>]]] 或 after:<UID>[:<数量>[:<UID前缀>]]
+    // 偏移每次从头数起；UID游标直接从该卡片之后继续，翻页不用重新扫描前面的卡片
+    String after;
+    String rest = param;
+    if (param.startsWith("after:")) {
+        int colon = param.indexOf(':', 6);
+        after = param.substring(6, colon == -1 ? param.length() : colon);
+        after.trim();
+        after.toUpperCase();
+        rest = colon == -1 ? String() : String("0") + param.substring(colon);
+    }
+
+    String fields[3];
+    int start = 0;
+    for (int i = 0; i < 3 && start <= (int)rest.length(); i++) {
+        int colon = i < 2 ? rest.indexOf(':', start) : -1;
+        if (colon == -1) {
+            colon = rest.length();
+        }
+        fields[i] = rest.substring(start, colon);
+        fields[i].trim();
+        start = colon + 1;
+    }
+
+    bool valid = !param.startsWith("after:") || after.length() > 0;
+    for (unsigned int j = 0; j < after.length(); j++) {
+        if (!isxdigit((unsigned char)after[j])) {
+            valid = false;
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        for (unsigned int j = 0; j < fields[i].length(); j++) {
+            char c = fields[i][j];
+            if (i < 2 ? !isdigit((unsigned char)c) : !isxdigit((unsigned char)c)) {
+                valid = false;
+            }
+        }
+    }
+    if (!valid) {
+        Serial.println("Usage: card:list[:<offset>[:<count>[:<UID prefix>]]]");
+        Serial.println("       card:list:after:<UID>[:<count>[:<UID prefix>]]");
+        return;
+    }
+
+    if (listActive) {
+        Serial.println("Card Manager: Previous listing interrupted");
+    }
+    listActive = true;
+    listCursor = CardDatabase::CardCursor(after);
+    listAfter = after;
+    listPrefix = fields[2];
+    listPrefix.toUpperCase();
+    listOffset = fields[0].toInt();
+    listCount = fields[1].toInt();
+    listMatched = 0;
+    listShown = 0;
+
     Serial.println("=== Registered Cards ===");
-    JsonArray cards = cardDatabase->getCards();
+    continueListing();
+}
 
-    if (cards.size() == 0) {
-        Serial.println("No cards registered");
-    } else {
-        for (size_t i = 0; i < cards.size(); i++) {
-            JsonObject card = cards[i];
-            Serial.print(i + 1);
-            Serial.print(". ");
-            Serial.println(card["uid"].as<String>());
+void NFCCardManager::continueListing() {
+    // 每轮只检查有限数量的卡片，串口发送缓冲不足时停下，下一轮从游标处继续，
+    // 避免输出阻塞主循环
+    size_t scanned = 0;
+    bool paused = false;
+    bool hasMore = false;
+    cardDatabase->forEachUid(listCursor, [&](const String& uid) {
+        if (scanned == LIST_SCAN_PER_LOOP) {
+            paused = true;
+            return false;
+        }
+        if (listPrefix.length() == 0 || uid.startsWith(listPrefix)) {
+            if (listCount > 0 && listShown == listCount) {
+                // 本页已满，且后面还有匹配的卡片
+                hasMore = true;
+                return false;
+            }
+            if (listMatched >= listOffset) {
+                if (Serial.availableForWrite() < LIST_LINE_BYTES) {
+                    paused = true;
+                    return false;
+                }
+                Serial.printf("%u. %s\n", (unsigned)(listMatched + 1), uid.c_str());
+                listShown++;
+            }
+            listMatched++;
+        }
+        scanned++;
+        return true;
+    });
+
+    if (!paused) {
+        finishListing(hasMore);
+    }
+}
+
+void NFCCardManager::finishListing(bool hasMore) {
+    listActive = false;
+    if (listShown == 0) {
+        if (listAfter.length() > 0 && listMatched == 0) {
+            Serial.println("No more cards after " + listAfter);
+        } else if (listMatched > 0) {
+            Serial.printf("No cards at offset %u (%u matching)\n", (unsigned)listOffset, (unsigned)listMatched);
+        } else {
+            Serial.println(listPrefix.length() > 0 ? "No matching cards" : "No cards registered");
         }
     }
     Serial.println("========================");
+    if (hasMore) {
+        // 给出UID游标：下一页从本页最后检查的卡片之后继续
+        Serial.printf("More: card:list:after:%s:%u", listCursor.lastUid.c_str(), (unsigned)listCount);
+        if (listPrefix.length() > 0) {
+            Serial.print(":");
+            Serial.print(listPrefix);
+        }
+        Serial.println();
+    } else if (listPrefix.length() > 0 && listShown > 0) {
+        Serial.printf("%u matching cards\n", (unsigned)listMatched);
+    }
 }
 
 bool NFCCardManager::hasOngoingOperation() {
     return currentState != NFC_IDLE;
 }
 
+bool NFCCardManager::requiresReader(const String& action) const {
+    // 只有需要卡片在场的动作（注册、擦除、批量注册、迁移）租用读卡器，其余只访问数据库
+    return action == "register" || action == "erase" || action == "enroll" || action == "migrate";
+}
+
+unsigned long NFCCardManager::getReaderLeaseTimeout() const {
+    // 批量注册会话自己管理空闲超时，读卡器租约覆盖整个会话
+    return currentOperation == OP_BATCH_ENROLL ? BATCH_SESSION_TIMEOUT : 0;
+}
+
+bool NFCCardManager::hasCustomAction(const String& action) const {
+    return action == "enroll" || action == "stop" || action == "migrate" || action == "pool" ||
+           action == "groups" || action == "policy" ||
+           action == "revoke" || action == "unrevoke" || action == "revoked" ||
+           action == "import" || action == "export";
+}
+
+bool NFCCardManager::executeCustomAction(const String& action, const String& param) {
+    if (action == "enroll") {
+        return startBatchEnrollment();
+    } else if (action == "stop") {
+        return stopBatchEnrollment();
+    } else if (action == "migrate") {
+        return startMigration(param);
+    } else if (action == "pool") {
+        if (keyPool == nullptr) {
+            Serial.println("Card Manager: Key pool not configured");
+            return false;
+        }
+        keyPool->printStats();
+        return true;
+    } else if (action == "groups") {
+        return setCardGroups(param);
+    } else if (action == "revoke") {
+        return revokeCards(param);
+    } else if (action == "unrevoke") {
+        return restoreCard(param);
+    } else if (action == "revoked") {
+        if (revocationList == nullptr) {
+            Serial.println("Card Manager: Revocation list not configured");
+            return false;
+        }
+        revocationList->printList();
+        return true;
+    } else if (action == "import") {
+        return handleImport(param);
+    } else if (action == "export") {
+        return exportCards(param);
+    } else if (action == "policy") {
+        if (!reloadPolicy()) {
+            return false;
+        }
+        accessPolicy->printSummary();
+        return true;
+    }
+    return false;
+}
+
 bool NFCCardManager::hasCompletedOperation() {
     if (operationJustCompleted) {
         operationJustCompleted = false; // 清除标志，确保只返回一次true
@@ -140,10 +336,28 @@ bool NFCCardManager::hasCompletedOperation() {
 }
 
 void NFCCardManager::handleOperations() {
+    if (listActive) {
+        continueListing();
+    }
+
+    if (exportActive) {
+        continueExport();
+    }
+
+    if (importActive && millis() - importLastTime > IMPORT_IDLE_TIMEOUT) {
+        Serial.println("Card Manager: Import idle timeout");
+        finishImport();
+    }
+
     if (currentState == NFC_IDLE) {
         return;
     }
 
+    if (currentOperation == OP_BATCH_ENROLL) {
+        handleBatchEnrollment();
+        return;
+    }
+
     // 检查超时
     if (millis() - operationStartTime > OPERATION_TIMEOUT) {
         handleOperationTimeout();
@@ -159,6 +373,8 @@ void NFCCardManager::handleOperations() {
             processRegistration();
         } else if (currentOperation == OP_ERASE) {
             processErasure();
+        } else if (currentOperation == OP_MIGRATE) {
+            processMigration();
         }
     }
 
@@ -174,11 +390,17 @@ void NFCCardManager::handleOperations() {
                 } else if (currentOperation == OP_ERASE) {
                     // 从数据库删除卡片
                     if (cardDatabase->removeCard(targetUID)) {
+                        if (accessPolicy != nullptr) {
+                            accessPolicy->updateCard(targetUID, JsonArrayConst());
+                        }
                         Serial.println("Card " + targetUID + " deleted from database");
                     }
                     Serial.println("Card erase completed successfully");
                     // 擦除成功只需要LED和蜂鸣器反馈，不需要开门
                     executeSuccessFeedback();
+                } else if (currentOperation == OP_MIGRATE) {
+                    Serial.println("Card migration completed successfully");
+                    executeSuccessFeedback();
                 }
             } else {
                 Serial.println("Failed to save changes to file system");
@@ -199,6 +421,16 @@ void NFCCardManager::handleOperations() {
 }
 
 void NFCCardManager::reset() {
+    if (currentOperation == OP_BATCH_ENROLL) {
+        // 保存已注册的卡片，避免丢失会话中的注册结果
+        finishBatchEnrollment();
+    }
+    if (importActive) {
+        // 保存已导入的卡片
+        finishImport();
+    }
+    listActive = false;
+    exportActive = false;
     resetOperationState();
     operationJustCompleted = false; // 完全重置时清除此标志
     lastOperationTime = 0;
@@ -254,9 +486,15 @@ void NFCCardManager::processRegistration() {
         return;
     }
 
-    // 生成新密钥
-    uint8_t newKey[6];
-    generateRandomKey(newKey);
+    // 生成新密钥（随机密钥或分散密钥）
+    uint8_t newKey[Utils::KEY_SIZE];
+    String keyHex;
+    if (!prepareCardKey(uidString, newKey, keyHex)) {
+        Serial.println("Card Manager: Failed to prepare card key");
+        operationCompleted = true;
+        operationSuccess = false;
+        return;
+    }
 
     // 写入密钥到卡片
     if (!writeKeyToCard(uid, uidLength, newKey)) {
@@ -267,7 +505,6 @@ void NFCCardManager::processRegistration() {
     }
 
     // 添加到数据库
-    String keyHex = Utils::keyToHexString(newKey);
     if (cardDatabase->addCard(uidString, keyHex)) {
         Serial.println("Card Manager: Card registered successfully");
         operationCompleted = true;
@@ -317,6 +554,282 @@ void NFCCardManager::processErasure() {
     }
 }
 
+bool NFCCardManager::startBatchEnrollment() {
+    if (currentState != NFC_IDLE) {
+        Serial.println("Card Manager: Operation already in progress");
+        return false;
+    }
+
+    Serial.println("Card Manager: Batch enrollment started. Tap cards one after another, 'card:stop' to finish");
+
+    currentState = NFC_DETECTING;
+    currentOperation = OP_BATCH_ENROLL;
+    operationStartTime = millis();
+    batchStartTime = operationStartTime;
+    lastOperationTime = operationStartTime;
+    lastCardUID = "";
+    batchEnrolledCount = 0;
+    batchSkippedCount = 0;
+    batchFailedCount = 0;
+    nextKeyReady = false;
+
+    return true;
+}
+
+bool NFCCardManager::stopBatchEnrollment() {
+    if (currentOperation != OP_BATCH_ENROLL) {
+        Serial.println("Card Manager: No batch enrollment in progress");
+        return false;
+    }
+
+    bool saved = finishBatchEnrollment();
+    if (saved) {
+        executeSuccessFeedback();
+    } else {
+        executeFailureFeedback();
+    }
+
+    operationJustCompleted = true;
+    resetOperationState();
+    return saved;
+}
+
+void NFCCardManager::handleBatchEnrollment() {
+    if (millis() - lastOperationTime > BATCH_IDLE_TIMEOUT) {
+        Serial.println("Card Manager: Batch enrollment idle timeout");
+        stopBatchEnrollment();
+        return;
+    }
+
+    // 等待卡片期间生成下一张卡的密钥，刷卡时直接写入
+    // 分散密钥依赖UID，只能在刷卡后派生
+    if (!nextKeyReady && !cardDatabase->usesDiversifiedKeys()) {
+        generateRandomKey(nextKey);
+        nextKeyReady = true;
+    }
+
+    handleCardDetection();
+
+    if (currentState == NFC_CARD_PRESENT) {
+        processBatchCard();
+        // 无论结果如何都继续等待下一张卡
+        currentState = NFC_DETECTING;
+    }
+}
+
+void NFCCardManager::processBatchCard() {
+    uint8_t uid[7];
+    uint8_t uidLength;
+
+    if (!nfcManager->readCardUID(uid, &uidLength)) {
+        return;
+    }
+
+    String uidString = Utils::uidToString(uid, uidLength);
+
+    // 刚处理过的卡片仍在读卡器上
+    if (uidString == lastCardUID) {
+        return;
+    }
+    lastCardUID = uidString;
+    lastOperationTime = millis();
+
+    if (cardDatabase->isCardRegistered(uidString)) {
+        Serial.println("Card Manager: Card " + uidString + " already registered, skipped");
+        batchSkippedCount++;
+        executeFailureFeedback();
+        return;
+    }
+
+    String keyHex;
+    if (cardDatabase->usesDiversifiedKeys()) {
+        if (!cardDatabase->deriveCardKey(uidString, nextKey)) {
+            Serial.println("Card Manager: Failed to derive key for card " + uidString);
+            batchFailedCount++;
+            executeFailureFeedback();
+            return;
+        }
+    } else {
+        keyHex = Utils::keyToHexString(nextKey);
+    }
+
+    if (!writeKeyToCard(uid, uidLength, nextKey)) {
+        Serial.println("Card Manager: Failed to write key to card " + uidString);
+        batchFailedCount++;
+        executeFailureFeedback();
+        return;
+    }
+
+    // 无论校验结果如何，密钥已写入卡片，必须记录到数据库以便之后擦除
+    bool verified = authenticateCard(uid, uidLength, nextKey);
+    nextKeyReady = false;
+
+    if (!cardDatabase->addCard(uidString, keyHex)) {
+        Serial.println("Card Manager: Failed to add card " + uidString + " to database");
+        batchFailedCount++;
+        executeFailureFeedback();
+        return;
+    }
+
+    if (!verified) {
+        Serial.println("Card Manager: Card " + uidString + " failed key verification (kept in database)");
+        batchFailedCount++;
+        executeFailureFeedback();
+        return;
+    }
+
+    batchEnrolledCount++;
+    unsigned long elapsed = millis() - batchStartTime;
+    Serial.print("Card Manager: Enrolled #");
+    Serial.print(batchEnrolledCount);
+    Serial.print(" ");
+    Serial.print(uidString);
+    Serial.print(" (");
+    Serial.print(elapsed > 0 ? batchEnrolledCount * 60000.0 / elapsed : 0.0, 1);
+    Serial.println(" cards/min)");
+    executeSuccessFeedback();
+}
+
+bool NFCCardManager::finishBatchEnrollment() {
+    unsigned long elapsed = millis() - batchStartTime;
+    size_t changed = batchEnrolledCount + batchFailedCount;
+
+    // 整个会话只写一次存储
+    bool saved = true;
+    if (changed > 0) {
+        saved = fileSystemManager->saveCards();
+    }
+
+    Serial.println("=== Batch Enrollment Summary ===");
+    Serial.print("Enrolled: ");
+    Serial.println(batchEnrolledCount);
+    Serial.print("Skipped (already registered): ");
+    Serial.println(batchSkippedCount);
+    Serial.print("Failed: ");
+    Serial.println(batchFailedCount);
+    Serial.print("Duration: ");
+    Serial.print(elapsed / 1000.0, 1);
+    Serial.println(" s");
+    Serial.print("Throughput: ");
+    Serial.print(elapsed > 0 ? batchEnrolledCount * 60000.0 / elapsed : 0.0, 1);
+    Serial.println(" cards/min");
+    Serial.println(saved ? "Database saved" : "Failed to save changes to file system");
+    Serial.println("================================");
+
+    return saved;
+}
+
+bool NFCCardManager::startMigration(const String& uid) {
+    if (currentState != NFC_IDLE) {
+        Serial.println("Card Manager: Operation already in progress");
+        return false;
+    }
+
+    if (!cardDatabase->hasKeyDiversifier()) {
+        Serial.println("Card Manager: Key diversification not available");
+        return false;
+    }
+
+    if (uid.length() > 0 && !cardDatabase->hasStoredKey(uid)) {
+        Serial.println("Card Manager: Card " + uid + " not found or already uses a diversified key");
+        return false;
+    }
+
+    if (uid.length() > 0) {
+        Serial.println("Card Manager: Tap card " + uid + " to migrate to diversified key (10s timeout)");
+    } else {
+        Serial.println("Card Manager: Tap a card to migrate to diversified key (10s timeout)");
+    }
+
+    currentState = NFC_DETECTING;
+    operationStartTime = millis();
+    targetUID = uid;
+    currentOperation = OP_MIGRATE;
+
+    return true;
+}
+
+void NFCCardManager::processMigration() {
+    if (currentState != NFC_CARD_PRESENT) {
+        return;
+    }
+
+    uint8_t uid[7];
+    uint8_t uidLength;
+
+    if (!nfcManager->readCardUID(uid, &uidLength)) {
+        Serial.println("Card Manager: Failed to read card UID");
+        resetOperationState();
+        return;
+    }
+
+    String uidString = Utils::uidToString(uid, uidLength);
+
+    if (targetUID.length() > 0 && uidString != targetUID) {
+        Serial.println("Card Manager: Wrong card. Expected: " + targetUID + ", Got: " + uidString);
+        resetOperationState();
+        return;
+    }
+
+    // 只有保存了独立密钥的卡片需要迁移
+    String keyHex;
+    if (!cardDatabase->findCardByUID(uidString, keyHex) || keyHex.length() == 0) {
+        Serial.println("Card Manager: Card " + uidString + " not found or already uses a diversified key");
+        operationCompleted = true;
+        operationSuccess = false;
+        return;
+    }
+
+    Serial.println("Card Manager: Migrating card: " + uidString);
+
+    uint8_t storedKey[Utils::KEY_SIZE];
+    uint8_t derivedKey[Utils::KEY_SIZE];
+    Utils::hexStringToKey(keyHex, storedKey);
+
+    if (!cardDatabase->deriveCardKey(uidString, derivedKey)) {
+        Serial.println("Card Manager: Failed to derive diversified key");
+        operationCompleted = true;
+        operationSuccess = false;
+        return;
+    }
+
+    if (!authenticateCard(uid, uidLength, storedKey)) {
+        // 上次迁移写入分散密钥后校验失败（卡片被拿开、应答丢失）：卡片已经是分散密钥
+        if (cardDatabase->adoptDiversifiedKey(uidString, [&](const uint8_t*) {
+                return nfcManager->reselectCard() && authenticateCard(uid, uidLength, derivedKey);
+            })) {
+            Serial.println("Card Manager: Card already carries its diversified key, stored key cleared");
+            operationCompleted = true;
+            operationSuccess = true;
+            return;
+        }
+        Serial.println("Card Manager: Card rejected both stored and diversified keys");
+        operationCompleted = true;
+        operationSuccess = false;
+        return;
+    }
+
+    if (!writeSectorTrailer(derivedKey)) {
+        Serial.println("Card Manager: Failed to write diversified key");
+        operationCompleted = true;
+        operationSuccess = false;
+        return;
+    }
+
+    // 校验通过后才删除保存的密钥，否则保留：卡片可能已经写入分散密钥，
+    // 刷卡认证和再次迁移时保存的密钥失败后会改用分散密钥并删除保存的密钥
+    if (!authenticateCard(uid, uidLength, derivedKey)) {
+        Serial.println("Card Manager: Diversified key verification failed, run card:migrate again");
+        operationCompleted = true;
+        operationSuccess = false;
+        return;
+    }
+
+    cardDatabase->clearStoredKey(uidString);
+    operationCompleted = true;
+    operationSuccess = true;
+}
+
 bool NFCCardManager::authenticateCard(uint8_t* uid, uint8_t uidLength, uint8_t* key) {
     // 使用密钥认证扇区
     if (!nfcManager->authenticateBlock(uid, uidLength, AUTH_BLOCK, key)) {
@@ -334,17 +847,8 @@ bool NFCCardManager::writeKeyToCard(uint8_t* uid, uint8_t uidLength, uint8_t* ne
         return false;
     }
 
-    // 准备扇区尾部数据
-    uint8_t trailerData[TRAILER_SIZE];
-    memcpy(trailerData, newKey, 6);      // Key A
-    trailerData[6] = 0xFF;               // Access bits byte 1
-    trailerData[7] = 0x07;               // Access bits byte 2
-    trailerData[8] = 0x80;               // Access bits byte 3
-    trailerData[9] = 0x69;               // GPB
-    memcpy(trailerData + 10, newKey, 6); // Key B
-
     // 写入扇区尾部
-    if (!nfcManager->writeDataBlock(SECTOR_TRAILER_BLOCK, trailerData)) {
+    if (!writeSectorTrailer(newKey)) {
         Serial.println("Card Manager: Failed to write sector trailer");
         return false;
     }
@@ -352,18 +856,40 @@ bool NFCCardManager::writeKeyToCard(uint8_t* uid, uint8_t uidLength, uint8_t* ne
     return true;
 }
 
+bool NFCCardManager::writeSectorTrailer(const uint8_t* key) {
+    // 准备扇区尾部数据
+    uint8_t trailerData[TRAILER_SIZE];
+    memcpy(trailerData, key, 6);      // Key A
+    trailerData[6] = 0xFF;            // Access bits byte 1
+    trailerData[7] = 0x07;            // Access bits byte 2
+    trailerData[8] = 0x80;            // Access bits byte 3
+    trailerData[9] = 0x69;            // GPB
+    memcpy(trailerData + 10, key, 6); // Key B
+
+    return nfcManager->writeDataBlock(SECTOR_TRAILER_BLOCK, trailerData);
+}
+
+bool NFCCardManager::prepareCardKey(const String& uidString, uint8_t* key, String& keyHex) {
+    if (cardDatabase->usesDiversifiedKeys()) {
+        // 分散密钥不保存到数据库
+        keyHex = "";
+        return cardDatabase->deriveCardKey(uidString, key);
+    }
+
+    generateRandomKey(key);
+    keyHex = Utils::keyToHexString(key);
+    return true;
+}
+
 bool NFCCardManager::eraseKeyFromCard(uint8_t* uid, uint8_t uidLength) {
-    // 获取卡片的当前密钥
+    // 获取卡片的当前密钥（保存的密钥或分散密钥）
     String uidString = Utils::uidToString(uid, uidLength);
-    String keyHex;
-    if (!cardDatabase->findCardByUID(uidString, keyHex)) {
+    uint8_t currentKey[Utils::KEY_SIZE];
+    if (!cardDatabase->getCardKey(uidString, currentKey)) {
         Serial.println("Card Manager: Card not found in database");
         return false;
     }
 
-    uint8_t currentKey[6];
-    Utils::hexStringToKey(keyHex, currentKey);
-
     if (!authenticateCard(uid, uidLength, currentKey)) {
         Serial.println("Card Manager: Failed to authenticate with stored key");
         return false;
@@ -371,16 +897,7 @@ bool NFCCardManager::eraseKeyFromCard(uint8_t* uid, uint8_t uidLength) {
 
     // 恢复为默认密钥
     uint8_t defaultKey[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-    uint8_t trailerData[TRAILER_SIZE];
-    memcpy(trailerData, defaultKey, 6);   // Key A
-    trailerData[6] = 0xFF;                // Access bits byte 1
-    trailerData[7] = 0x07;                // Access bits byte 2
-    trailerData[8] = 0x80;                // Access bits byte 3
-    trailerData[9] = 0x69;                // GPB
-    memcpy(trailerData + 10, defaultKey, 6); // Key B
-
-    // 写入扇区尾部
-    if (!nfcManager->writeDataBlock(SECTOR_TRAILER_BLOCK, trailerData)) {
+    if (!writeSectorTrailer(defaultKey)) {
         Serial.println("Card Manager: Failed to restore default key");
         return false;
     }
@@ -389,8 +906,11 @@ bool NFCCardManager::eraseKeyFromCard(uint8_t* uid, uint8_t uidLength) {
 }
 
 void NFCCardManager::generateRandomKey(uint8_t* key) {
-    for (int i = 0; i < 6; i++) {
-        key[i] = random(0, 256);
+    // 优先使用预生成的密钥池
+    if (keyPool != nullptr) {
+        keyPool->take(key);
+    } else {
+        Utils::generateRandomKey(key);
     }
 }
 
@@ -403,10 +923,370 @@ void NFCCardManager::resetOperationState() {
     operationStartTime = 0;
     targetUID = "";
 
-    // 注意：新架构中管理模式由SystemCoordinator控制
-    // 这里不需要退出管理模式
+    // 注意：SystemCoordinator检测到操作结束后会归还读卡器租约
 }
 
 const char* NFCCardManager::getName() const {
     return "NFC Card Manager";
 }
+
+bool NFCCardManager::setCardGroups(const String& param) {
+    // 参数格式：<UID>[:<组1,组2>|*]
+    int colon = param.indexOf(':');
+    String uid = colon == -1 ? param : param.substring(0, colon);
+    uid.trim();
+    if (uid.length() == 0) {
+        Serial.println("Usage: card:groups:<UID>[:<group1,group2>|*]");
+        return false;
+    }
+
+    if (colon == -1) {
+        if (!cardDatabase->isCardRegistered(uid)) {
+            Serial.println("Card not found: " + uid);
+            return false;
+        }
+        JsonArrayConst groups = cardDatabase->getCardGroups(uid);
+        String list;
+        serializeJson(groups, list);
+        Serial.println("Card " + uid + " groups: " + (groups.isNull() ? String("(unrestricted)") : list));
+        return true;
+    }
+
+    String groupList = param.substring(colon + 1);
+    groupList.trim();
+    if (!cardDatabase->setCardGroups(uid, groupList)) {
+        Serial.println("Card not found: " + uid);
+        return false;
+    }
+    if (accessPolicy != nullptr) {
+        accessPolicy->updateCard(uid, cardDatabase->getCardGroups(uid));
+    }
+    if (!fileSystemManager->saveCard(uid)) {
+        Serial.println("Failed to save changes to file system");
+        return false;
+    }
+    Serial.println("Card " + uid + " groups set to: " + (groupList == "*" ? String("(unrestricted)") : groupList));
+    return true;
+}
+
+bool NFCCardManager::revokeCards(const String& param) {
+    // 参数格式：<UID>[,<UID>...]，整批一次追加写入
+    if (revocationList == nullptr) {
+        Serial.println("Card Manager: Revocation list not configured");
+        return false;
+    }
+
+    std::vector<String> uids;
+    int start = 0;
+    while (start < (int)param.length()) {
+        int comma = param.indexOf(',', start);
+        if (comma == -1) {
+            comma = param.length();
+        }
+        String uid = param.substring(start, comma);
+        uid.trim();
+        uid.toUpperCase();
+        if (uid.length() > 0) {
+            uids.push_back(uid);
+        }
+        start = comma + 1;
+    }
+    if (uids.empty()) {
+        Serial.println("Usage: card:revoke:<UID>[,<UID>...]");
+        return false;
+    }
+
+    size_t added = 0;
+    size_t invalid = 0;
+    if (!revocationList->revoke(uids, added, invalid)) {
+        Serial.println("Failed to save revocation list");
+        return false;
+    }
+
+    Serial.printf("Revoked %u cards (%u already revoked, %u invalid), %u total\n",
+                  (unsigned)added, (unsigned)(uids.size() - added - invalid), (unsigned)invalid,
+                  (unsigned)revocationList->getCount());
+    return invalid == 0;
+}
+
+bool NFCCardManager::restoreCard(const String& uid) {
+    if (revocationList == nullptr) {
+        Serial.println("Card Manager: Revocation list not configured");
+        return false;
+    }
+    String normalized = uid;
+    normalized.trim();
+    normalized.toUpperCase();
+    if (!revocationList->restore(normalized)) {
+        Serial.println("Card not revoked: " + normalized);
+        return false;
+    }
+    Serial.println("Revocation lifted: " + normalized);
+    return true;
+}
+
+bool NFCCardManager::handleImport(const String& param) {
+    if (param == "begin") {
+        return startImport();
+    } else if (param == "end") {
+        return finishImport();
+    } else if (param.length() == 0) {
+        Serial.println("Usage: card:import:begin | card:import:<seq>:<crc32>:<records> | card:import:end");
+        return false;
+    }
+    return importChunk(param);
+}
+
+bool NFCCardManager::startImport() {
+    if (importActive) {
+        Serial.println("Card Manager: Import already in progress");
+        return false;
+    }
+
+    importActive = true;
+    importStartTime = millis();
+    importLastTime = importStartTime;
+    importApplyTime = 0;
+    importNextChunk = 0;
+    importAddedCount = 0;
+    importUpdatedCount = 0;
+    importInvalidCount = 0;
+    // 整个会话只持久化一次
+    cardDatabase->beginBatch();
+
+    Serial.println("Card Manager: Import started, send chunks then 'card:import:end'");
+    Serial.println("IMPORT READY");
+    return true;
+}
+
+bool NFCCardManager::importChunk(const String& param) {
+    // 参数格式：<序号>:<CRC>:<记录>|<记录>...
+    int firstColon = param.indexOf(':');
+    int secondColon = param.indexOf(':', firstColon + 1);
+    if (firstColon <= 0 || secondColon == -1) {
+        Serial.println("IMPORT ERR - format");
+        return false;
+    }
+    uint32_t sequence = strtoul(param.substring(0, firstColon).c_str(), nullptr, 10);
+    uint32_t expectedCrc = strtoul(param.substring(firstColon + 1, secondColon).c_str(), nullptr, 16);
+    const char* payload = param.c_str() + secondColon + 1;
+    size_t payloadLength = param.length() - secondColon - 1;
+
+    if (!importActive) {
+        Serial.printf("IMPORT ERR %u no session\n", (unsigned)sequence);
+        return false;
+    }
+    if (Utils::crc32((const uint8_t*)payload, payloadLength) != expectedCrc) {
+        Serial.printf("IMPORT ERR %u checksum\n", (unsigned)sequence);
+        return false;
+    }
+    if (sequence + 1 == importNextChunk) {
+        // 应答丢失后重发的数据块，已经应用过
+        Serial.printf("IMPORT OK %u 0 0\n", (unsigned)sequence);
+        return true;
+    }
+    if (sequence != importNextChunk) {
+        Serial.printf("IMPORT ERR %u expected %u\n", (unsigned)sequence, (unsigned)importNextChunk);
+        return false;
+    }
+
+    size_t recordCount = 1;
+    for (size_t i = 0; i < payloadLength; i++) {
+        if (payload[i] == '|') {
+            recordCount++;
+        }
+    }
+    if (recordCount > IMPORT_MAX_RECORDS) {
+        Serial.printf("IMPORT ERR %u too many records (max %u)\n", (unsigned)sequence, (unsigned)IMPORT_MAX_RECORDS);
+        return false;
+    }
+
+    unsigned long start = micros();
+    size_t applied = 0;
+    size_t invalid = 0;
+    String records(payload);
+    int recordStart = 0;
+    while (recordStart <= (int)records.length()) {
+        int separator = records.indexOf('|', recordStart);
+        if (separator == -1) {
+            separator = records.length();
+        }
+        String record = records.substring(recordStart, separator);
+        record.trim();
+        if (record.length() > 0) {
+            if (importRecord(record)) {
+                applied++;
+            } else {
+                invalid++;
+            }
+        }
+        recordStart = separator + 1;
+    }
+    importApplyTime += micros() - start;
+    importInvalidCount += invalid;
+    importNextChunk++;
+    importLastTime = millis();
+
+    Serial.printf("IMPORT OK %u %u %u\n", (unsigned)sequence, (unsigned)applied, (unsigned)invalid);
+    return true;
+}
+
+bool NFCCardManager::importRecord(const String& record) {
+    // 记录格式：<UID>,<密钥>[,<组1;组2>|*]
+    int firstComma = record.indexOf(',');
+    int secondComma = firstComma == -1 ? -1 : record.indexOf(',', firstComma + 1);
+    String uid = firstComma == -1 ? record : record.substring(0, firstComma);
+    String keyHex;
+    String groupList = "*";
+    if (firstComma != -1) {
+        keyHex = secondComma == -1 ? record.substring(firstComma + 1) : record.substring(firstComma + 1, secondComma);
+    }
+    if (secondComma != -1) {
+        groupList = record.substring(secondComma + 1);
+        groupList.replace(';', ',');
+        groupList.trim();
+    }
+    uid.trim();
+    uid.toUpperCase();
+    keyHex.trim();
+    keyHex.toUpperCase();
+
+    uint8_t uidBytes[Utils::MAX_UID_SIZE];
+    uint8_t uidLength = 0;
+    bool valid = Utils::stringToUid(uid, uidBytes, &uidLength) &&
+                 (keyHex.length() == 0 || keyHex.length() == Utils::KEY_SIZE * 2);
+    for (size_t i = 0; valid && i < keyHex.length(); i++) {
+        valid = isxdigit((unsigned char)keyHex[i]);
+    }
+    bool replaced = false;
+    if (!valid || !cardDatabase->importCard(uid, keyHex, groupList, replaced)) {
+        Serial.println("Card Manager: Invalid import record: " + record);
+        return false;
+    }
+
+    if (accessPolicy != nullptr) {
+        accessPolicy->updateCard(uid, cardDatabase->getCardGroups(uid));
+    }
+    if (replaced) {
+        importUpdatedCount++;
+    } else {
+        importAddedCount++;
+    }
+    return true;
+}
+
+bool NFCCardManager::finishImport() {
+    if (!importActive) {
+        Serial.println("Card Manager: No import in progress");
+        return false;
+    }
+    importActive = false;
+
+    // 按卡片存储模式下一次写入存储，JSON模式下一次写入卡片文件
+    unsigned long flushStart = millis();
+    size_t applied = importAddedCount + importUpdatedCount;
+    bool saved = cardDatabase->endBatch();
+    if (applied > 0) {
+        saved = fileSystemManager->saveCards() && saved;
+    }
+    unsigned long flushTime = millis() - flushStart;
+    unsigned long elapsed = millis() - importStartTime;
+
+    Serial.println("=== Import Summary ===");
+    Serial.printf("Imported: %u (%u new, %u updated), invalid: %u, chunks: %u\n", (unsigned)applied,
+                  (unsigned)importAddedCount, (unsigned)importUpdatedCount, (unsigned)importInvalidCount,
+                  (unsigned)importNextChunk);
+    Serial.printf("Duration: %lu ms (apply %lu ms, flush %lu ms)\n", elapsed, importApplyTime / 1000, flushTime);
+    Serial.printf("Throughput: %.0f records/s (apply only %.0f records/s)\n",
+                  elapsed > 0 ? applied * 1000.0 / elapsed : 0.0,
+                  importApplyTime > 0 ? applied * 1000000.0 / importApplyTime : 0.0);
+    Serial.println(saved ? "Database saved" : "Failed to save changes to storage");
+    Serial.println("======================");
+    Serial.printf("IMPORT DONE %u %s\n", (unsigned)applied, saved ? "saved" : "failed");
+
+    if (saved) {
+        executeSuccessFeedback();
+    } else {
+        executeFailureFeedback();
+    }
+    return saved;
+}
+
+bool NFCCardManager::exportCards(const String& param) {
+    size_t chunkRecords = param.length() > 0 ? (size_t)param.toInt() : EXPORT_CHUNK_RECORDS;
+    if (chunkRecords == 0 || chunkRecords > IMPORT_MAX_RECORDS) {
+        Serial.printf("Usage: card:export[:<records per chunk, 1-%u>]\n", (unsigned)IMPORT_MAX_RECORDS);
+        return false;
+    }
+
+    if (exportActive) {
+        Serial.println("Card Manager: Previous export interrupted");
+    }
+    exportActive = true;
+    exportCursor = CardDatabase::CardCursor();
+    exportChunkRecords = chunkRecords;
+    exportNextChunk = 0;
+    exportTotal = 0;
+    exportStartTime = millis();
+    Serial.printf("EXPORT BEGIN %u\n", (unsigned)cardDatabase->getCardCount());
+    continueExport();
+    return true;
+}
+
+void NFCCardManager::continueExport() {
+    // 每轮只输出一个数据块，上一个数据块还在发送时等下一轮；
+    // 每轮最多等待一个数据块超出发送缓冲的部分（默认16条记录约50 ms）
+    if (Serial.availableForWrite() < EXPORT_MIN_ROOM) {
+        return;
+    }
+
+    String payload;
+    size_t inChunk = 0;
+    cardDatabase->forEachCard(exportCursor, [&](JsonObjectConst card) {
+        if (inChunk == exportChunkRecords) {
+            return false;
+        }
+        if (inChunk > 0) {
+            payload += '|';
+        }
+        payload += card["uid"] | "";
+        payload += ',';
+        payload += card["key"] | "";
+        payload += ',';
+        JsonArrayConst groups = card["groups"];
+        if (groups.isNull()) {
+            payload += '*';
+        } else {
+            bool first = true;
+            for (const char* name : groups) {
+                if (!first) {
+                    payload += ';';
+                }
+                payload += name;
+                first = false;
+            }
+        }
+        inChunk++;
+        return true;
+    });
+
+    if (inChunk > 0) {
+        uint32_t crc = Utils::crc32((const uint8_t*)payload.c_str(), payload.length());
+        Serial.printf("EXPORT %u:%08X:", (unsigned)exportNextChunk, (unsigned)crc);
+        Serial.println(payload);
+        exportNextChunk++;
+        exportTotal += inChunk;
+    }
+    // 不足一个数据块说明已经遍历到末尾
+    if (inChunk < exportChunkRecords) {
+        finishExport();
+    }
+}
+
+void NFCCardManager::finishExport() {
+    exportActive = false;
+    unsigned long elapsed = millis() - exportStartTime;
+    Serial.printf("EXPORT END %u %u\n", (unsigned)exportNextChunk, (unsigned)exportTotal);
+    Serial.printf("Card Manager: Exported %u cards in %lu ms (%.0f records/s)\n", (unsigned)exportTotal, elapsed,
+                  elapsed > 0 ? exportTotal * 1000.0 / elapsed : 0.0);
+}
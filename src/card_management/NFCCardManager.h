@@ -6,6 +6,9 @@
 #include "../data/FileSystemManager.h"
 #include "../utils/Utils.h"
 #include "../nfc/NFCManager.h"
+#include "../security/KeyPool.h"
+#include "../security/AccessPolicy.h"
+#include "../security/RevocationList.h"
 #include <vector>
 
 // 前向声明
@@ -22,13 +25,18 @@ public:
     enum OperationType {
         OP_NONE,
         OP_REGISTER,
-        OP_ERASE
+        OP_ERASE,
+        OP_BATCH_ENROLL,
+        OP_MIGRATE
     };
 
 private:
     NFCManager* nfcManager;
     CardDatabase* cardDatabase;
     FileSystemManager* fileSystemManager;
+    KeyPool* keyPool;
+    AccessPolicy* accessPolicy;
+    RevocationList* revocationList;
 
     // 执行器集合（模仿认证器的方式）
     std::vector<IActionExecutor*> feedbackExecutors;
@@ -64,14 +72,127 @@ private:
     static const unsigned long COOLDOWN_TIME = 1000; // 1秒冷却时间
     static const unsigned long SAME_CARD_DELAY = 100; // 同卡片延迟
 
+    // 批量注册会话
+    static const unsigned long BATCH_IDLE_TIMEOUT = 60000;      // 60秒无刷卡自动结束
+    static const unsigned long BATCH_SESSION_TIMEOUT = 3600000; // 会话最长1小时
+    unsigned long batchStartTime;
+    size_t batchEnrolledCount;
+    size_t batchSkippedCount;
+    size_t batchFailedCount;
+    uint8_t nextKey[Utils::KEY_SIZE]; // 等待卡片期间预先生成的下一张卡的密钥
+    bool nextKeyReady;
+
+    // 批量导入会话（不占用读卡器，数据块之间认证照常进行）
+    static const unsigned long IMPORT_IDLE_TIMEOUT = 30000;  // 30秒没有收到数据块自动结束
+    static const size_t IMPORT_MAX_RECORDS = 32;             // 每个数据块最多的记录数
+    static const size_t EXPORT_CHUNK_RECORDS = 16;           // 导出时每个数据块默认的记录数
+    bool importActive;
+    unsigned long importStartTime;
+    unsigned long importLastTime;
+    unsigned long importApplyTime;  // 应用记录所用的时间（微秒）
+    uint32_t importNextChunk;
+    size_t importAddedCount;
+    size_t importUpdatedCount;
+    size_t importInvalidCount;
+
+    // 分页列表（分多轮主循环输出，期间认证照常进行）
+    static const size_t LIST_SCAN_PER_LOOP = 128;  // 每轮最多检查的卡片数
+    static const int LIST_LINE_BYTES = 32;         // 一行输出的最大字节数，串口发送缓冲不足时等下一轮
+    bool listActive;
+    CardDatabase::CardCursor listCursor;
+    String listAfter;       // 起始UID游标，空字符串从头开始
+    String listPrefix;      // UID前缀过滤，空字符串不过滤
+    size_t listOffset;
+    size_t listCount;       // 本页最多输出的卡片数，0表示不限
+    size_t listMatched;     // 已匹配的卡片数（包括偏移之前跳过的）
+    size_t listShown;
+
+    // 分段导出（每轮主循环输出一个数据块，期间认证照常进行）
+    static const int EXPORT_MIN_ROOM = 64;         // 串口发送缓冲空余不足时等下一轮，上一个数据块发送完再输出
+    bool exportActive;
+    CardDatabase::CardCursor exportCursor;
+    size_t exportChunkRecords;
+    uint32_t exportNextChunk;
+    size_t exportTotal;
+    unsigned long exportStartTime;
+
     // 内部方法
     bool startOperationListening();
     void handleOperationTimeout();
     void handleCardDetection();
     void processRegistration();
     void processErasure();
+    bool startBatchEnrollment();
+    bool stopBatchEnrollment();
+    void handleBatchEnrollment();
+    void processBatchCard();
+    bool finishBatchEnrollment();
     bool authenticateCard(uint8_t* uid, uint8_t uidLength, uint8_t* key);
     bool writeKeyToCard(uint8_t* uid, uint8_t uidLength, uint8_t* newKey);
+    bool writeSectorTrailer(const uint8_t* key);
+    bool prepareCardKey(const String& uidString, uint8_t* key, String& keyHex);
+    bool startMigration(const String& uid);
+    bool setCardGroups(const String& param);
+    bool revokeCards(const String& param);
+    bool restoreCard(const String& uid);
+
+    /**
+     * 处理导入命令
+     * 协议（每行一条命令，每个数据块收到应答后再发送下一个）：
+     *   card:import:begin                          开始导入会话
+     *   card:import:<序号>:<CRC>:<记录>|<记录>...   数据块，序号从0开始，CRC为记录部分的CRC-32（8位十六进制）
+     *   card:import:end                            结束导入，修改一次持久化
+     * 记录格式：<UID>,<密钥>[,<组1;组2>]，密钥为空表示使用分散密钥；
+     * 组为*或省略表示不受限制，为空表示不属于任何组
+     * 应答：IMPORT OK <序号> <应用数> <无效数> / IMPORT ERR <序号> <原因>（校验失败时重发同一序号）
+     * @param param begin、end或数据块
+     * @return 是否成功
+     */
+    bool handleImport(const String& param);
+    bool startImport();
+    bool importChunk(const String& param);
+
+    /**
+     * 导入一条记录
+     * @return 记录是否有效并已应用
+     */
+    bool importRecord(const String& record);
+
+    /**
+     * 结束导入会话，持久化修改并报告吞吐量
+     * @return 是否保存成功
+     */
+    bool finishImport();
+
+    /**
+     * 按导入的数据块格式输出所有卡片（包括密钥），输出行去掉"EXPORT "前缀后
+     * 可以直接作为card:import:的参数；分多轮主循环输出，期间认证照常进行
+     * @param param 每个数据块的记录数（可选）
+     * @return 是否成功
+     */
+    bool exportCards(const String& param);
+
+    /**
+     * 输出下一个导出数据块，每轮主循环调用一次，直到所有卡片输出完毕
+     */
+    void continueExport();
+
+    /**
+     * 结束导出，输出结束行和吞吐量
+     */
+    void finishExport();
+
+    /**
+     * 输出一段列表，每轮主循环调用一次，直到本页输出完毕
+     */
+    void continueListing();
+
+    /**
+     * 结束列表并输出汇总
+     * @param hasMore 本页之后是否还有匹配的卡片
+     */
+    void finishListing(bool hasMore);
+    void processMigration();
     bool eraseKeyFromCard(uint8_t* uid, uint8_t uidLength);
     void generateRandomKey(uint8_t* key);
     void resetOperationState();
@@ -91,6 +212,30 @@ public:
      */
     void addFeedbackExecutor(IActionExecutor* executor);
 
+    /**
+     * 设置预生成密钥池（未设置时直接生成随机密钥）
+     * @param pool 密钥池指针
+     */
+    void setKeyPool(KeyPool* pool);
+
+    /**
+     * 设置访问策略（修改卡片的组或重新加载策略文件后重新编译）
+     * @param policy 访问策略指针
+     */
+    void setAccessPolicy(AccessPolicy* policy);
+
+    /**
+     * 重新加载策略文件并编译
+     * @return 是否成功
+     */
+    bool reloadPolicy();
+
+    /**
+     * 设置吊销列表
+     * @param list 吊销列表指针
+     */
+    void setRevocationList(RevocationList* list);
+
     /**
      * 执行成功反馈
      */
@@ -105,8 +250,17 @@ public:
     bool registerNew() override;
     bool deleteItem(const String& id) override;
     bool eraseAndDeleteItem(const String& id) override;
-    void listRegisteredItems() override;
+
+    /**
+     * 列出已注册的卡片，分多轮主循环输出
+     * @param param [<偏移>[:<数量>[:<UID前缀>]]]，数量为0或省略表示不限
+     */
+    void listRegisteredItems(const String& param) override;
     bool hasOngoingOperation() override;
+    bool requiresReader(const String& action) const override;
+    unsigned long getReaderLeaseTimeout() const override;
+    bool hasCustomAction(const String& action) const override;
+    bool executeCustomAction(const String& action, const String& param) override;
     bool hasCompletedOperation() override;
     void handleOperations() override;
     void reset() override;
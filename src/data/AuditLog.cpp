@@ -0,0 +1,645 @@
+#include "AuditLog.h"
+#include "../utils/Utils.h"
+#include "../utils/Clock.h"
+
+static_assert(sizeof(AuditLog::Record) == AuditLog::RECORD_SIZE, "Audit record must be 32 bytes");
+static_assert(sizeof(AuditLog::SectorFooter) == AuditLog::FLASH_PAGE_SIZE, "Sector footer must fill one flash page");
+
+const char* AuditLog::PARTITION_LABEL = "audit";
+
+// 空槽的序号（flash擦除后为全1）
+static const uint32_t ERASED_SEQUENCE = 0xFFFFFFFF;
+
+// 校验覆盖的字节数（crc之前的部分）
+static const size_t CRC_COVERED = AuditLog::RECORD_SIZE - sizeof(uint16_t);
+static const size_t FOOTER_CRC_COVERED = sizeof(AuditLog::SectorFooter) - sizeof(uint16_t);
+
+// 扇区摘要页在扇区内的偏移
+static const size_t FOOTER_OFFSET = AuditLog::PAGES_PER_SECTOR * AuditLog::FLASH_PAGE_SIZE;
+
+AuditLog::AuditLog()
+    : partition(nullptr), slotCount(0), writeSlot(0), nextSequence(1),
+      bufferHead(0), bufferCount(0), writerTaskHandle(nullptr), stats(),
+      queryActive(false), query(), querySketch(0), querySector(0), querySectorsLeft(0), queryStats() {
+    bufferMux = portMUX_INITIALIZER_UNLOCKED;
+    memset(buffer, 0, sizeof(buffer));
+    clearSummaries(openPages);
+}
+
+bool AuditLog::initialize() {
+    if (writerTaskHandle != nullptr) {
+        return true;
+    }
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                         (esp_partition_subtype_t)PARTITION_SUBTYPE,
+                                         PARTITION_LABEL);
+    if (partition == nullptr) {
+        Serial.println("Audit Log: Partition 'audit' not found, logging disabled");
+        return false;
+    }
+
+    slotCount = (partition->size / SECTOR_SIZE) * RECORDS_PER_SECTOR;
+    if (slotCount < 2 * RECORDS_PER_SECTOR) {
+        Serial.println("Audit Log: Partition too small (need at least 2 sectors)");
+        partition = nullptr;
+        slotCount = 0;
+        return false;
+    }
+
+    recover();
+
+    BaseType_t result = xTaskCreate(
+        writerTaskFunction,
+        "AuditWriter",
+        3072,
+        this,
+        1,
+        &writerTaskHandle
+    );
+
+    if (result != pdPASS) {
+        Serial.println("Audit Log: Failed to start writer task");
+        writerTaskHandle = nullptr;
+        partition = nullptr;
+        return false;
+    }
+
+    Serial.print("Audit Log: ");
+    Serial.print(slotCount);
+    Serial.print(" slots, next slot ");
+    Serial.print(writeSlot);
+    Serial.print(", next sequence ");
+    Serial.println(nextSequence);
+    return true;
+}
+
+void AuditLog::recover() {
+    // 每个扇区从第一个槽位开始顺序写入，只需比较各扇区第一条记录的序号
+    size_t sectorCount = slotCount / RECORDS_PER_SECTOR;
+    uint32_t newestSequence = 0;
+    size_t newestSector = 0;
+    bool found = false;
+
+    for (size_t sector = 0; sector < sectorCount; sector++) {
+        uint32_t sequence = ERASED_SEQUENCE;
+        if (esp_partition_read(partition, sector * SECTOR_SIZE, &sequence, sizeof(sequence)) != ESP_OK) {
+            stats.flashErrors++;
+            continue;
+        }
+        if (sequence != ERASED_SEQUENCE && (!found || sequence > newestSequence)) {
+            newestSequence = sequence;
+            newestSector = sector;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        writeSlot = 0;
+        nextSequence = 1;
+        return;
+    }
+
+    // 在最新的扇区中找到第一个空槽（整条记录为全1，写入中断的记录视为已占用），同时重建页摘要
+    size_t first = newestSector * RECORDS_PER_SECTOR;
+    size_t slot = first;
+    uint32_t lastSequence = newestSequence;
+    for (; slot < first + RECORDS_PER_SECTOR; slot++) {
+        uint8_t raw[RECORD_SIZE];
+        if (esp_partition_read(partition, slotOffset(slot), raw, RECORD_SIZE) != ESP_OK) {
+            stats.flashErrors++;
+            continue;
+        }
+        bool erased = true;
+        for (size_t i = 0; i < RECORD_SIZE && erased; i++) {
+            erased = raw[i] == 0xFF;
+        }
+        if (erased) {
+            break;
+        }
+        Record record;
+        memcpy(&record, raw, RECORD_SIZE);
+        if (record.sequence != ERASED_SEQUENCE && record.sequence > lastSequence) {
+            lastSequence = record.sequence;
+        }
+        if (record.crc == Utils::crc16(raw, CRC_COVERED)) {
+            addToSummary(openPages[(slot - first) / RECORDS_PER_FLASH_PAGE], record);
+        }
+    }
+
+    // 扇区已写满时从下一个扇区开始（写入时擦除）
+    writeSlot = slot % slotCount;
+    nextSequence = lastSequence + 1;
+    if (writeSlot % RECORDS_PER_SECTOR == 0) {
+        clearSummaries(openPages);
+    }
+}
+
+size_t AuditLog::slotOffset(size_t slot) {
+    return (slot / RECORDS_PER_SECTOR) * SECTOR_SIZE + (slot % RECORDS_PER_SECTOR) * RECORD_SIZE;
+}
+
+uint64_t AuditLog::uidSketchBits(const uint8_t* uid, uint8_t uidLength) {
+    // 与吊销列表相同的乘法散列，取高位作为两个位序号
+    uint64_t key = (uint64_t)uidLength << 56;
+    for (uint8_t i = 0; i < uidLength && i < 7; i++) {
+        key |= (uint64_t)uid[i] << (8 * (6 - i));
+    }
+    uint64_t hash = key * 0x9E3779B97F4A7C15ULL;
+    return (1ULL << (hash >> 58)) | (1ULL << ((hash >> 52) & 63));
+}
+
+void AuditLog::clearSummaries(PageSummary* pages) {
+    for (size_t i = 0; i < PAGES_PER_SECTOR; i++) {
+        pages[i].minTime = 0xFFFFFFFF;
+        pages[i].maxTime = 0;
+        pages[i].uidSketch = 0;
+    }
+}
+
+void AuditLog::addToSummary(PageSummary& page, const Record& record) {
+    if (record.timestamp != 0) {
+        if (record.timestamp < page.minTime) {
+            page.minTime = record.timestamp;
+        }
+        if (record.timestamp > page.maxTime) {
+            page.maxTime = record.timestamp;
+        }
+    }
+    if (record.uidLength > 0) {
+        page.uidSketch |= uidSketchBits(record.uid, record.uidLength);
+    }
+}
+
+void AuditLog::append(const uint8_t* uid, uint8_t uidLength, uint8_t door, uint8_t authenticator,
+                      Decision decision, unsigned long latencyMs) {
+    bool wake = false;
+    // 时间在临界区外读取（time()会获取newlib的锁）
+    uint32_t timestamp = (uint32_t)Clock::wallTime();
+    uint32_t uptimeMs = millis();
+
+    portENTER_CRITICAL(&bufferMux);
+    if (partition == nullptr || bufferCount >= RAM_CAPACITY) {
+        stats.dropped++;
+    } else {
+        Record& record = buffer[(bufferHead + bufferCount) % RAM_CAPACITY];
+        memset(&record, 0, sizeof(record));
+        record.timestamp = timestamp;
+        record.uptimeMs = uptimeMs;
+        if (uid != nullptr && uidLength > 0) {
+            record.uidLength = uidLength > sizeof(record.uid) ? sizeof(record.uid) : uidLength;
+            memcpy(record.uid, uid, record.uidLength);
+        }
+        record.door = door;
+        record.authenticator = authenticator;
+        record.decision = (uint8_t)decision;
+        record.latencyMs = latencyMs > 0xFFFF ? 0xFFFF : (uint16_t)latencyMs;
+        bufferCount++;
+        stats.appended++;
+        wake = bufferCount >= RECORDS_PER_FLASH_PAGE;
+    }
+    portEXIT_CRITICAL(&bufferMux);
+
+    // 积累满一个编程页才唤醒写入任务，其余由定时写入
+    if (wake && writerTaskHandle != nullptr) {
+        xTaskNotifyGive(writerTaskHandle);
+    }
+}
+
+void AuditLog::requestFlush() {
+    if (writerTaskHandle != nullptr) {
+        xTaskNotifyGive(writerTaskHandle);
+    }
+}
+
+bool AuditLog::writeRecords(const Record* records, size_t count) {
+    size_t offset = slotOffset(writeSlot);
+
+    // 进入新扇区时擦除（环形覆盖最旧的扇区及其摘要页）
+    if (writeSlot % RECORDS_PER_SECTOR == 0) {
+        if (esp_partition_erase_range(partition, offset, SECTOR_SIZE) != ESP_OK) {
+            stats.flashErrors++;
+            return false;
+        }
+        stats.erases++;
+    }
+
+    if (esp_partition_write(partition, offset, records, count * RECORD_SIZE) != ESP_OK) {
+        stats.flashErrors++;
+        return false;
+    }
+    return true;
+}
+
+void AuditLog::flushPending() {
+    Record chunk[RECORDS_PER_FLASH_PAGE];
+
+    while (true) {
+        // 复制一批待写记录（不超过一个编程页，不跨扇区），flash操作在临界区外进行
+        size_t sectorRemaining = RECORDS_PER_SECTOR - writeSlot % RECORDS_PER_SECTOR;
+        size_t count;
+        portENTER_CRITICAL(&bufferMux);
+        count = bufferCount;
+        if (count > RECORDS_PER_FLASH_PAGE) {
+            count = RECORDS_PER_FLASH_PAGE;
+        }
+        if (count > sectorRemaining) {
+            count = sectorRemaining;
+        }
+        for (size_t i = 0; i < count; i++) {
+            chunk[i] = buffer[(bufferHead + i) % RAM_CAPACITY];
+        }
+        portEXIT_CRITICAL(&bufferMux);
+
+        if (count == 0) {
+            return;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            chunk[i].sequence = nextSequence + i;
+            chunk[i].crc = Utils::crc16(reinterpret_cast<const uint8_t*>(&chunk[i]), CRC_COVERED);
+        }
+
+        bool ok = writeRecords(chunk, count);
+
+        // 写入失败时也移出这些记录并跳过对应槽位，避免反复写同一个坏位置
+        SectorFooter footer;
+        size_t sealedSector = 0;
+        bool sealed = false;
+        portENTER_CRITICAL(&bufferMux);
+        size_t firstInSector = writeSlot - writeSlot % RECORDS_PER_SECTOR;
+        if (ok) {
+            for (size_t i = 0; i < count; i++) {
+                addToSummary(openPages[(writeSlot + i - firstInSector) / RECORDS_PER_FLASH_PAGE], chunk[i]);
+            }
+        }
+        bufferHead = (bufferHead + count) % RAM_CAPACITY;
+        bufferCount -= count;
+        writeSlot = (writeSlot + count) % slotCount;
+        if (ok) {
+            stats.written += count;
+            stats.flushes++;
+        } else {
+            stats.dropped += count;
+        }
+        // 扇区写满：取出页摘要准备写入摘要页，新扇区从空摘要开始
+        if (writeSlot % RECORDS_PER_SECTOR == 0) {
+            memcpy(footer.pages, openPages, sizeof(footer.pages));
+            clearSummaries(openPages);
+            sealedSector = firstInSector / RECORDS_PER_SECTOR;
+            sealed = true;
+        }
+        portEXIT_CRITICAL(&bufferMux);
+        nextSequence += count;
+
+        if (sealed) {
+            footer.magic = FOOTER_MAGIC;
+            footer.firstSequence = nextSequence - RECORDS_PER_SECTOR;
+            memset(footer.reserved, 0xFF, sizeof(footer.reserved));
+            footer.crc = Utils::crc16(reinterpret_cast<const uint8_t*>(&footer), FOOTER_CRC_COVERED);
+            if (esp_partition_write(partition, sealedSector * SECTOR_SIZE + FOOTER_OFFSET,
+                                    &footer, sizeof(footer)) != ESP_OK) {
+                stats.flashErrors++;
+            }
+        }
+    }
+}
+
+bool AuditLog::readSlot(size_t slot, Record& record) const {
+    if (partition == nullptr || slot >= slotCount) {
+        return false;
+    }
+    if (esp_partition_read(partition, slotOffset(slot), &record, RECORD_SIZE) != ESP_OK) {
+        return false;
+    }
+    if (record.sequence == ERASED_SEQUENCE) {
+        return false;
+    }
+    return record.crc == Utils::crc16(reinterpret_cast<const uint8_t*>(&record), CRC_COVERED);
+}
+
+void AuditLog::printTail(size_t count) const {
+    if (partition == nullptr) {
+        Serial.println("Audit Log: Not available");
+        return;
+    }
+    if (count > slotCount) {
+        count = slotCount;
+    }
+
+    size_t end = writeSlot;
+    size_t printed = 0;
+    Serial.println("=== Audit Log ===");
+    for (size_t i = count; i > 0; i--) {
+        Record record;
+        if (!readSlot((end + slotCount - i) % slotCount, record)) {
+            continue;
+        }
+        printRecord(record);
+        printed++;
+    }
+    if (printed == 0) {
+        Serial.println("(empty)");
+    }
+    Serial.println("=================");
+}
+
+void AuditLog::printRecord(Record& record) {
+    Serial.print("#");
+    Serial.print(record.sequence);
+    Serial.print(" ");
+    if (record.timestamp != 0) {
+        Serial.print(record.timestamp);
+    } else {
+        Serial.print("+");
+        Serial.print(record.uptimeMs);
+        Serial.print("ms");
+    }
+    Serial.print(" door ");
+    Serial.print(record.door);
+    Serial.print(" auth ");
+    Serial.print(record.authenticator);
+    Serial.print(" ");
+    Serial.print(record.uidLength > 0 ? Utils::uidToString(record.uid, record.uidLength) : String("-"));
+    Serial.print(" ");
+    Serial.print(decisionName(record.decision));
+    Serial.print(" ");
+    Serial.print(record.latencyMs);
+    Serial.println("ms");
+}
+
+bool AuditLog::matches(const Query& query, const Record& record) {
+    if (query.uidLength > 0 &&
+        (record.uidLength != query.uidLength || memcmp(record.uid, query.uid, query.uidLength) != 0)) {
+        return false;
+    }
+    if (query.fromTime != 0 || query.toTime != 0) {
+        // 没有墙上时间的记录不参与按时间的查询
+        if (record.timestamp == 0) {
+            return false;
+        }
+        if (query.fromTime != 0 && record.timestamp < query.fromTime) {
+            return false;
+        }
+        if (query.toTime != 0 && record.timestamp > query.toTime) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AuditLog::pageMayMatch(const Query& query, uint64_t sketch, const PageSummary& page) {
+    if (query.uidLength > 0 && (page.uidSketch & sketch) != sketch) {
+        return false;
+    }
+    if (query.fromTime != 0 || query.toTime != 0) {
+        if (page.minTime > page.maxTime) {
+            return false;
+        }
+        if (query.fromTime != 0 && page.maxTime < query.fromTime) {
+            return false;
+        }
+        if (query.toTime != 0 && page.minTime > query.toTime) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AuditLog::loadSummaries(size_t sector, PageSummary* pages) {
+    bool open;
+    // 写入位置在扇区起点时该扇区还没有擦除，仍是已写满的旧扇区
+    portENTER_CRITICAL(&bufferMux);
+    open = writeSlot / RECORDS_PER_SECTOR == sector && writeSlot % RECORDS_PER_SECTOR != 0;
+    if (open) {
+        memcpy(pages, openPages, sizeof(openPages));
+    }
+    portEXIT_CRITICAL(&bufferMux);
+    if (open) {
+        return true;
+    }
+
+    SectorFooter footer;
+    if (esp_partition_read(partition, sector * SECTOR_SIZE + FOOTER_OFFSET, &footer, sizeof(footer)) != ESP_OK ||
+        footer.magic != FOOTER_MAGIC ||
+        footer.crc != Utils::crc16(reinterpret_cast<const uint8_t*>(&footer), FOOTER_CRC_COVERED)) {
+        return false;
+    }
+    memcpy(pages, footer.pages, sizeof(footer.pages));
+    return true;
+}
+
+bool AuditLog::startQuery(const Query& newQuery) {
+    if (partition == nullptr) {
+        Serial.println("Audit Log: Not available");
+        return false;
+    }
+
+    query = newQuery;
+    querySketch = query.uidLength > 0 ? uidSketchBits(query.uid, query.uidLength) : 0;
+    memset(&queryStats, 0, sizeof(queryStats));
+
+    // 从最旧的扇区开始：正在写入的扇区的下一个，写入位置在扇区起点时为该扇区本身
+    size_t sectorCount = slotCount / RECORDS_PER_SECTOR;
+    portENTER_CRITICAL(&bufferMux);
+    querySector = writeSlot / RECORDS_PER_SECTOR;
+    if (writeSlot % RECORDS_PER_SECTOR != 0) {
+        querySector = (querySector + 1) % sectorCount;
+    }
+    portEXIT_CRITICAL(&bufferMux);
+    querySectorsLeft = sectorCount;
+    queryActive = true;
+
+    Serial.println("=== Audit Query ===");
+    return true;
+}
+
+void AuditLog::processQuery() {
+    if (!queryActive) {
+        return;
+    }
+
+    size_t sector = querySector;
+    PageSummary pages[PAGES_PER_SECTOR];
+    bool indexed = loadSummaries(sector, pages);
+
+    // 没有摘要且第一个槽位为空：扇区从未写入或已擦除
+    uint32_t firstSequence = ERASED_SEQUENCE;
+    if (!indexed &&
+        (esp_partition_read(partition, sector * SECTOR_SIZE, &firstSequence, sizeof(firstSequence)) != ESP_OK ||
+         firstSequence == ERASED_SEQUENCE)) {
+        queryStats.pagesSkipped += PAGES_PER_SECTOR;
+    } else {
+        for (size_t page = 0; page < PAGES_PER_SECTOR; page++) {
+            if (indexed && !pageMayMatch(query, querySketch, pages[page])) {
+                queryStats.pagesSkipped++;
+                continue;
+            }
+
+            Record records[RECORDS_PER_FLASH_PAGE];
+            if (esp_partition_read(partition, sector * SECTOR_SIZE + page * FLASH_PAGE_SIZE,
+                                   records, sizeof(records)) != ESP_OK) {
+                continue;
+            }
+            queryStats.pagesRead++;
+
+            for (size_t i = 0; i < RECORDS_PER_FLASH_PAGE; i++) {
+                Record& record = records[i];
+                if (record.sequence == ERASED_SEQUENCE ||
+                    record.crc != Utils::crc16(reinterpret_cast<const uint8_t*>(&record), CRC_COVERED) ||
+                    !matches(query, record)) {
+                    continue;
+                }
+                printRecord(record);
+                queryStats.matches++;
+            }
+        }
+    }
+
+    queryStats.sectors++;
+    querySector = (sector + 1) % (slotCount / RECORDS_PER_SECTOR);
+    if (--querySectorsLeft == 0) {
+        queryActive = false;
+        Serial.print("Audit Query: ");
+        Serial.print(queryStats.matches);
+        Serial.print(" matches, ");
+        Serial.print(queryStats.pagesRead);
+        Serial.print(" pages read, ");
+        Serial.print(queryStats.pagesSkipped);
+        Serial.println(" pages skipped");
+        Serial.println("===================");
+    }
+}
+
+bool AuditLog::isQueryActive() const {
+    return queryActive;
+}
+
+AuditLog::Stats AuditLog::getStats() {
+    Stats result;
+    portENTER_CRITICAL(&bufferMux);
+    result = stats;
+    result.pending = bufferCount;
+    portEXIT_CRITICAL(&bufferMux);
+    result.capacity = slotCount;
+    return result;
+}
+
+void AuditLog::printStats() {
+    Stats current = getStats();
+    Serial.println("=== Audit Log ===");
+    Serial.print("Partition: ");
+    Serial.println(partition != nullptr ? "audit" : "not available");
+    Serial.print("Capacity: ");
+    Serial.print(current.capacity);
+    Serial.println(" records");
+    Serial.print("Next slot: ");
+    Serial.println(writeSlot);
+    Serial.print("Appended: ");
+    Serial.println(current.appended);
+    Serial.print("Written: ");
+    Serial.println(current.written);
+    Serial.print("Pending: ");
+    Serial.print(current.pending);
+    Serial.print("/");
+    Serial.println(RAM_CAPACITY);
+    Serial.print("Dropped: ");
+    Serial.println(current.dropped);
+    Serial.print("Flushes: ");
+    Serial.println(current.flushes);
+    Serial.print("Sector erases: ");
+    Serial.println(current.erases);
+    Serial.print("Flash errors: ");
+    Serial.println(current.flashErrors);
+    Serial.println("=================");
+}
+
+bool AuditLog::handleCommand(const String& command) {
+    if (command == "log") {
+        printStats();
+        return true;
+    }
+    if (command == "log:flush") {
+        requestFlush();
+        Serial.println("Audit Log: Flush requested");
+        return true;
+    }
+    if (command.startsWith("log:query:")) {
+        // log:query:<开始>:<结束>[:<UID>]
+        String params = command.substring(10);
+        int first = params.indexOf(':');
+        if (first < 0) {
+            return false;
+        }
+        int second = params.indexOf(':', first + 1);
+        String fromText = params.substring(0, first);
+        String toText = second < 0 ? params.substring(first + 1) : params.substring(first + 1, second);
+
+        Query newQuery;
+        memset(&newQuery, 0, sizeof(newQuery));
+        if (!parseTime(fromText, newQuery.fromTime) || !parseTime(toText, newQuery.toTime)) {
+            Serial.println("Audit Log: Invalid time, use unix seconds or *");
+            return false;
+        }
+        if (second >= 0) {
+            uint8_t uid[Utils::MAX_UID_SIZE];
+            uint8_t uidLength = 0;
+            if (!Utils::stringToUid(params.substring(second + 1), uid, &uidLength) ||
+                uidLength > sizeof(newQuery.uid)) {
+                Serial.println("Audit Log: Invalid UID");
+                return false;
+            }
+            memcpy(newQuery.uid, uid, uidLength);
+            newQuery.uidLength = uidLength;
+        }
+        return startQuery(newQuery);
+    }
+    if (command == "log:tail" || command.startsWith("log:tail:")) {
+        long count = 16;
+        if (command.length() > 9) {
+            count = command.substring(9).toInt();
+            if (count <= 0) {
+                Serial.println("Audit Log: Invalid count");
+                return false;
+            }
+        }
+        printTail((size_t)count);
+        return true;
+    }
+    return false;
+}
+
+bool AuditLog::parseTime(const String& text, uint32_t& time) {
+    if (text.length() == 0 || text == "*") {
+        time = 0;
+        return true;
+    }
+    long value = text.toInt();
+    if (value <= 0) {
+        return false;
+    }
+    time = (uint32_t)value;
+    return true;
+}
+
+const char* AuditLog::decisionName(uint8_t decision) {
+    switch (decision) {
+        case DECISION_GRANTED: return "GRANTED";
+        case DECISION_DENIED: return "DENIED";
+        case DECISION_COOLDOWN: return "COOLDOWN";
+        case DECISION_POLICY: return "POLICY";
+        case DECISION_PASSBACK: return "PASSBACK";
+        default: return "UNKNOWN";
+    }
+}
+
+// 静态任务函数 - 批量写入flash
+void AuditLog::writerTaskFunction(void* parameter) {
+    AuditLog* log = static_cast<AuditLog*>(parameter);
+
+    while (true) {
+        // 满一页时被唤醒，否则定时写入不满一页的记录
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FLUSH_INTERVAL_MS));
+        log->flushPending();
+    }
+}
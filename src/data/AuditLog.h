@@ -0,0 +1,306 @@
+#ifndef AUDITLOG_H
+#define AUDITLOG_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <esp_partition.h>
+
+/**
+ * 访问审计日志
+ * 每次认证决策记录一条32字节的定长二进制记录，保存在专用的flash分区（partitions.csv中的audit）中，
+ * 整个分区作为环形缓冲区使用，写满后擦除最旧的扇区继续写入
+ *
+ * 写入路径：
+ * - append()只在临界区内把记录拷贝到内存环形缓冲区，不访问flash、不分配内存，不会延迟开锁
+ * - 后台低优先级任务在积累满一个flash编程页（8条记录，256字节）或 FLUSH_INTERVAL_MS 到期时批量写入
+ * - 内存缓冲区满时丢弃新记录并计数
+ *
+ * 启动时读取每个扇区的第一条记录找到最新的扇区，再在扇区内找到第一个空槽作为写入位置
+ *
+ * 查询索引：每个扇区的前15页存放记录，最后一页是扇区摘要，扇区写满时写入。
+ * 摘要为每页记录的时间范围和UID草图（64位布隆过滤器），查询时不可能匹配的页不读取；
+ * 正在写入的扇区的摘要保存在内存中。查询在主循环中每次处理一个扇区，结果逐条输出
+ */
+class AuditLog {
+public:
+    // 决策结果
+    enum Decision {
+        DECISION_GRANTED = 0,   // 开门
+        DECISION_DENIED,        // 认证失败（未注册、吊销、锁定、密钥错误）
+        DECISION_COOLDOWN,      // 认证成功但处于认证器冷却期
+        DECISION_POLICY,        // 访问策略拒绝
+        DECISION_PASSBACK       // 防反传拒绝
+    };
+
+    // flash中的记录（小端，32字节）
+    struct Record {
+        uint32_t sequence;       // 从1开始递增，0xFFFFFFFF表示空槽
+        uint32_t timestamp;      // 墙上时间（Unix秒），未设置时为0
+        uint32_t uptimeMs;       // 开机后的毫秒数
+        uint8_t uid[7];          // 凭证UID（按钮等没有凭证时全0）
+        uint8_t uidLength;
+        uint8_t door;            // 门序号（0为默认门）
+        uint8_t authenticator;   // 认证器在门内的序号
+        uint8_t decision;        // Decision
+        uint8_t reserved0;
+        uint16_t latencyMs;      // 从开始处理到做出决策的耗时
+        uint8_t reserved[4];
+        uint16_t crc;            // 前30字节的CRC-16
+    } __attribute__((packed));
+
+    static const size_t RECORD_SIZE = 32;
+
+    // flash扇区（擦除单位）和编程页大小
+    static const size_t SECTOR_SIZE = 4096;
+    static const size_t FLASH_PAGE_SIZE = 256;
+    static const size_t RECORDS_PER_FLASH_PAGE = FLASH_PAGE_SIZE / RECORD_SIZE;
+
+    // 每个扇区的记录页数（最后一页为扇区摘要）和记录数
+    static const size_t PAGES_PER_SECTOR = SECTOR_SIZE / FLASH_PAGE_SIZE - 1;
+    static const size_t RECORDS_PER_SECTOR = PAGES_PER_SECTOR * RECORDS_PER_FLASH_PAGE;
+
+    // 页摘要（16字节）
+    struct PageSummary {
+        uint32_t minTime;        // 页内有墙上时间的记录的最早时间，没有时为0xFFFFFFFF
+        uint32_t maxTime;        // 最晚时间，没有时为0
+        uint64_t uidSketch;      // 页内UID的布隆过滤器（每个UID置2位）
+    } __attribute__((packed));
+
+    // 扇区摘要（占扇区最后一页）
+    struct SectorFooter {
+        uint32_t magic;
+        uint32_t firstSequence;  // 扇区第一条记录的序号
+        PageSummary pages[PAGES_PER_SECTOR];
+        uint8_t reserved[6];
+        uint16_t crc;            // 前254字节的CRC-16
+    } __attribute__((packed));
+
+    static const uint32_t FOOTER_MAGIC = 0x41554458; // "AUDX"
+
+    // 查询条件
+    struct Query {
+        uint32_t fromTime;       // 0表示不限
+        uint32_t toTime;         // 0表示不限
+        uint8_t uid[7];
+        uint8_t uidLength;       // 0表示不限UID
+    };
+
+    // 内存缓冲区容量（记录数）
+    static const size_t RAM_CAPACITY = 64;
+
+    // 不满一页时的最长等待时间
+    static const unsigned long FLUSH_INTERVAL_MS = 10000;
+
+    // 分区标签和子类型（自定义数据分区）
+    static const char* PARTITION_LABEL;
+    static const uint8_t PARTITION_SUBTYPE = 0x40;
+
+    // 统计信息
+    struct Stats {
+        unsigned long appended;     // 进入内存缓冲区的记录数
+        unsigned long written;      // 写入flash的记录数
+        unsigned long dropped;      // 缓冲区满或分区不可用时丢弃的记录数
+        unsigned long flushes;      // 批量写入次数
+        unsigned long erases;       // 扇区擦除次数
+        unsigned long flashErrors;  // flash读写错误次数
+        size_t pending;             // 内存中等待写入的记录数
+        size_t capacity;            // 分区可容纳的记录数
+    };
+
+    // 查询进度统计
+    struct QueryStats {
+        size_t sectors;             // 已处理的扇区数
+        size_t pagesRead;           // 读取的页数
+        size_t pagesSkipped;        // 按摘要跳过的页数
+        size_t matches;             // 匹配的记录数
+    };
+
+private:
+    const esp_partition_t* partition;
+    size_t slotCount;           // 分区中的记录槽数
+    size_t writeSlot;           // 下一条记录写入的槽位
+    uint32_t nextSequence;
+
+    // 内存环形缓冲区
+    Record buffer[RAM_CAPACITY];
+    size_t bufferHead;          // 最旧的待写记录
+    size_t bufferCount;
+    portMUX_TYPE bufferMux;
+
+    // 正在写入的扇区的页摘要
+    PageSummary openPages[PAGES_PER_SECTOR];
+
+    TaskHandle_t writerTaskHandle;
+    Stats stats;
+
+    // 进行中的查询（在主循环中逐个扇区处理）
+    bool queryActive;
+    Query query;
+    uint64_t querySketch;
+    size_t querySector;
+    size_t querySectorsLeft;
+    QueryStats queryStats;
+
+    // 静态任务函数
+    static void writerTaskFunction(void* parameter);
+
+    /**
+     * 启动时定位写入位置和下一个序号，并重建正在写入的扇区的页摘要
+     */
+    void recover();
+
+    /**
+     * 槽位在分区中的偏移（跳过每个扇区的摘要页）
+     * @param slot 槽位
+     * @return 字节偏移
+     */
+    static size_t slotOffset(size_t slot);
+
+    /**
+     * 计算UID在草图中的位
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @return 置2位的掩码
+     */
+    static uint64_t uidSketchBits(const uint8_t* uid, uint8_t uidLength);
+
+    /**
+     * 清空页摘要
+     */
+    static void clearSummaries(PageSummary* pages);
+
+    /**
+     * 把一条记录加入页摘要
+     */
+    static void addToSummary(PageSummary& page, const Record& record);
+
+    /**
+     * 检查记录是否符合条件
+     */
+    static bool matches(const Query& query, const Record& record);
+
+    /**
+     * 按摘要判断页中是否可能有符合条件的记录
+     */
+    static bool pageMayMatch(const Query& query, uint64_t sketch, const PageSummary& page);
+
+    /**
+     * 获取扇区的页摘要（已写满的扇区从摘要页读取，正在写入的扇区取内存副本）
+     * @param sector 扇区
+     * @param pages 输出的页摘要
+     * @return 是否有可用的摘要（摘要缺失或损坏时返回false，需要读取全部页）
+     */
+    bool loadSummaries(size_t sector, PageSummary* pages);
+
+    /**
+     * 打印一条记录
+     */
+    static void printRecord(Record& record);
+
+    /**
+     * 解析查询时间（Unix秒，空或*表示不限）
+     * @return 是否有效
+     */
+    static bool parseTime(const String& text, uint32_t& time);
+
+    /**
+     * 把内存中的待写记录写入flash
+     */
+    void flushPending();
+
+    /**
+     * 写入一段连续的记录（不跨扇区），写入扇区第一个槽位前先擦除该扇区
+     * @return 是否成功
+     */
+    bool writeRecords(const Record* records, size_t count);
+
+public:
+    /**
+     * 构造函数
+     */
+    AuditLog();
+
+    /**
+     * 查找audit分区、恢复写入位置并启动写入任务
+     * @return 是否成功（分区不存在时返回false，之后的记录被丢弃）
+     */
+    bool initialize();
+
+    /**
+     * 追加一条记录（只拷贝到内存，可在开锁路径中调用）
+     * @param uid 凭证UID，没有凭证时为nullptr
+     * @param uidLength UID长度
+     * @param door 门序号
+     * @param authenticator 认证器序号
+     * @param decision 决策结果
+     * @param latencyMs 决策耗时
+     */
+    void append(const uint8_t* uid, uint8_t uidLength, uint8_t door, uint8_t authenticator,
+                Decision decision, unsigned long latencyMs);
+
+    /**
+     * 唤醒写入任务，立即写入内存中的记录
+     */
+    void requestFlush();
+
+    /**
+     * 读取flash中的一条记录
+     * @param slot 槽位
+     * @param record 输出的记录
+     * @return 是否为有效记录（非空且校验正确）
+     */
+    bool readSlot(size_t slot, Record& record) const;
+
+    /**
+     * 打印最新的若干条记录（仅flash中已写入的部分）
+     * @param count 条数
+     */
+    void printTail(size_t count) const;
+
+    /**
+     * 开始一次查询，结果由processQuery()逐个扇区输出（从最旧到最新）
+     * @param query 查询条件
+     * @return 是否开始（分区不可用时返回false）
+     */
+    bool startQuery(const Query& query);
+
+    /**
+     * 处理进行中的查询的一个扇区（在主循环中调用，没有查询时立即返回）
+     */
+    void processQuery();
+
+    /**
+     * 是否有进行中的查询
+     * @return 是否进行中
+     */
+    bool isQueryActive() const;
+
+    /**
+     * 获取统计信息
+     * @return 统计信息
+     */
+    Stats getStats();
+
+    /**
+     * 打印统计信息
+     */
+    void printStats();
+
+    /**
+     * 处理log命令：log | log:tail[:<条数>] | log:flush | log:query:<开始>:<结束>[:<UID>]
+     * 开始/结束为Unix时间戳，*表示不限
+     * @param command 命令字符串
+     * @return 是否成功处理
+     */
+    bool handleCommand(const String& command);
+
+    /**
+     * 获取决策结果名称
+     * @param decision 决策结果
+     * @return 名称
+     */
+    static const char* decisionName(uint8_t decision);
+};
+
+#endif // AUDITLOG_H
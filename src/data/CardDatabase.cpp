@@ -1,11 +1,47 @@
 #include "CardDatabase.h"
+#include "../security/KeyDiversifier.h"
+#include "../security/RevocationList.h"
+#include "../interfaces/ICardStore.h"
+#include "../utils/Utils.h"
+
+CardDatabase::CardDatabase()
+    : keyDiversifier(nullptr), diversifyNewCards(false), revocationList(nullptr), cardStore(nullptr) {
+}
 
 void CardDatabase::initialize() {
     database.to<JsonArray>();
 }
 
 void CardDatabase::loadFromJson(const JsonDocument& data) {
-    database.set(data);
+    if (cardStore == nullptr) {
+        database.set(data);
+        return;
+    }
+
+    // 按卡片存储模式：逐条导入（已存在的卡片被覆盖）
+    for (JsonObjectConst card : data.as<JsonArrayConst>()) {
+        String uid = card["uid"] | "";
+        String keyHex = card["key"] | "";
+        uint8_t key[Utils::KEY_SIZE];
+        if (keyHex.length() > 0) {
+            Utils::hexStringToKey(keyHex, key);
+        }
+        if (!cardStore->put(uid, keyHex.length() > 0 ? key : nullptr)) {
+            Serial.println("Card Database: Failed to import card " + uid);
+            continue;
+        }
+        JsonArrayConst groups = card["groups"];
+        if (!groups.isNull()) {
+            String groupList;
+            for (const char* name : groups) {
+                if (groupList.length() > 0) {
+                    groupList += ',';
+                }
+                groupList += name;
+            }
+            cardStore->setGroups(uid, groupList.c_str());
+        }
+    }
 }
 
 JsonDocument& CardDatabase::getDatabase() {
@@ -13,10 +49,20 @@ JsonDocument& CardDatabase::getDatabase() {
 }
 
 bool CardDatabase::findCardByUID(const String& uid, String& keyHex) {
+    if (cardStore != nullptr) {
+        uint8_t key[Utils::KEY_SIZE];
+        bool hasKey = false;
+        if (!cardStore->find(uid, key, hasKey)) {
+            return false;
+        }
+        keyHex = hasKey ? Utils::keyToHexString(key) : "";
+        return true;
+    }
+
     JsonArray cards = database.as<JsonArray>();
     for (JsonObject card : cards) {
         if (card["uid"] == uid) {
-            keyHex = card["key"].as<String>();
+            keyHex = card["key"] | "";
             return true;
         }
     }
@@ -24,6 +70,10 @@ bool CardDatabase::findCardByUID(const String& uid, String& keyHex) {
 }
 
 bool CardDatabase::isCardRegistered(const String& uid) {
+    if (cardStore != nullptr) {
+        return cardStore->contains(uid);
+    }
+
     JsonArray cards = database.as<JsonArray>();
     for (JsonObject card : cards) {
         if (card["uid"] == uid) {
@@ -34,6 +84,17 @@ bool CardDatabase::isCardRegistered(const String& uid) {
 }
 
 bool CardDatabase::addCard(const String& uid, const String& keyHex) {
+    if (cardStore != nullptr) {
+        if (cardStore->contains(uid)) {
+            return false;
+        }
+        uint8_t key[Utils::KEY_SIZE];
+        if (keyHex.length() > 0) {
+            Utils::hexStringToKey(keyHex, key);
+        }
+        return cardStore->put(uid, keyHex.length() > 0 ? key : nullptr);
+    }
+
     JsonArray cards = database.as<JsonArray>();
     
     // 检查卡片是否已存在
@@ -46,11 +107,17 @@ bool CardDatabase::addCard(const String& uid, const String& keyHex) {
     // 添加新卡片
     JsonObject newCard = cards.add<JsonObject>();
     newCard["uid"] = uid;
-    newCard["key"] = keyHex;
+    if (keyHex.length() > 0) {
+        newCard["key"] = keyHex;
+    }
     return true;
 }
 
 bool CardDatabase::removeCard(const String& uid) {
+    if (cardStore != nullptr) {
+        return cardStore->remove(uid);
+    }
+
     JsonArray cards = database.as<JsonArray>();
     for (size_t i = 0; i < cards.size(); i++) {
         if (cards[i]["uid"] == uid) {
@@ -61,10 +128,301 @@ bool CardDatabase::removeCard(const String& uid) {
     return false;
 }
 
+void CardDatabase::parseGroups(const String& groupList, JsonArray groups) {
+    int start = 0;
+    while (start <= (int)groupList.length()) {
+        int comma = groupList.indexOf(',', start);
+        if (comma == -1) {
+            comma = groupList.length();
+        }
+        String name = groupList.substring(start, comma);
+        name.trim();
+        if (name.length() > 0) {
+            groups.add(name);
+        }
+        start = comma + 1;
+    }
+}
+
+bool CardDatabase::setCardGroups(const String& uid, const String& groupList) {
+    if (cardStore != nullptr) {
+        if (!cardStore->contains(uid)) {
+            return false;
+        }
+        if (groupList == "*") {
+            return cardStore->setGroups(uid, nullptr);
+        }
+        // 保存规范化后的名称列表
+        JsonArray groups = groupsScratch.to<JsonArray>();
+        parseGroups(groupList, groups);
+        String normalized;
+        for (const char* name : groups) {
+            if (normalized.length() > 0) {
+                normalized += ',';
+            }
+            normalized += name;
+        }
+        return cardStore->setGroups(uid, normalized.c_str());
+    }
+
+    JsonArray cards = database.as<JsonArray>();
+    for (JsonObject card : cards) {
+        if (card["uid"] == uid) {
+            card.remove("groups");
+            if (groupList == "*") {
+                return true;
+            }
+            parseGroups(groupList, card["groups"].to<JsonArray>());
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CardDatabase::importCard(const String& uid, const String& keyHex, const String& groupList, bool& replaced) {
+    if (cardStore != nullptr) {
+        replaced = cardStore->contains(uid);
+        uint8_t key[Utils::KEY_SIZE];
+        if (keyHex.length() > 0) {
+            Utils::hexStringToKey(keyHex, key);
+        }
+        return cardStore->put(uid, keyHex.length() > 0 ? key : nullptr) && setCardGroups(uid, groupList);
+    }
+
+    JsonArray cards = database.as<JsonArray>();
+    JsonObject card;
+    for (JsonObject existing : cards) {
+        if (existing["uid"] == uid) {
+            card = existing;
+            break;
+        }
+    }
+    replaced = !card.isNull();
+    if (card.isNull()) {
+        card = cards.add<JsonObject>();
+        card["uid"] = uid;
+    }
+    card.remove("key");
+    if (keyHex.length() > 0) {
+        card["key"] = keyHex;
+    }
+    return setCardGroups(uid, groupList);
+}
+
+void CardDatabase::beginBatch() {
+    if (cardStore != nullptr) {
+        cardStore->beginBatch();
+    }
+}
+
+bool CardDatabase::endBatch() {
+    return cardStore == nullptr || cardStore->endBatch();
+}
+
+JsonArrayConst CardDatabase::getCardGroups(const String& uid) {
+    if (cardStore != nullptr) {
+        String groupList;
+        if (!cardStore->contains(uid) || !cardStore->getGroups(uid, groupList)) {
+            return JsonArrayConst();
+        }
+        JsonArray groups = groupsScratch.to<JsonArray>();
+        parseGroups(groupList, groups);
+        return groups;
+    }
+
+    JsonArray cards = database.as<JsonArray>();
+    for (JsonObject card : cards) {
+        if (card["uid"] == uid) {
+            return card["groups"];
+        }
+    }
+    return JsonArrayConst();
+}
+
 JsonArray CardDatabase::getCards() {
     return database.as<JsonArray>();
 }
 
+void CardDatabase::forEachCard(const CardVisitor& visitor) {
+    if (cardStore == nullptr) {
+        for (JsonObjectConst card : database.as<JsonArrayConst>()) {
+            if (!visitor(card)) {
+                return;
+            }
+        }
+        return;
+    }
+
+    // 按卡片存储模式：每张卡片临时构造一个条目
+    JsonDocument entry;
+    cardStore->forEach([&](const String& uid, const uint8_t* key, bool hasKey) {
+        entry.clear();
+        entry["uid"] = uid;
+        if (hasKey) {
+            uint8_t keyCopy[Utils::KEY_SIZE];
+            memcpy(keyCopy, key, sizeof(keyCopy));
+            entry["key"] = Utils::keyToHexString(keyCopy);
+        }
+        String groupList;
+        if (cardStore->getGroups(uid, groupList)) {
+            parseGroups(groupList, entry["groups"].to<JsonArray>());
+        }
+        return visitor(entry.as<JsonObjectConst>());
+    });
+}
+
+void CardDatabase::forEachCard(CardCursor& cursor, const CardVisitor& visitor) {
+    if (cardStore == nullptr) {
+        // 只有UID的游标：先在内存中定位到该卡片之后（卡片已删除时不再遍历）
+        bool seeking = cursor.position == 0 && cursor.lastUid.length() > 0;
+        size_t index = 0;
+        for (JsonObjectConst card : database.as<JsonArrayConst>()) {
+            if (seeking) {
+                seeking = cursor.lastUid != (card["uid"] | "");
+                cursor.position = ++index;
+                continue;
+            }
+            if (index++ < cursor.position) {
+                continue;
+            }
+            if (!visitor(card)) {
+                return;
+            }
+            cursor.position++;
+            cursor.lastUid = card["uid"] | "";
+        }
+        return;
+    }
+
+    // 按卡片存储模式：从上次的UID之后继续，每张卡片临时构造一个条目
+    JsonDocument entry;
+    cardStore->forEachAfter(cursor.lastUid, [&](const String& uid, const uint8_t* key, bool hasKey) {
+        entry.clear();
+        entry["uid"] = uid;
+        if (hasKey) {
+            uint8_t keyCopy[Utils::KEY_SIZE];
+            memcpy(keyCopy, key, sizeof(keyCopy));
+            entry["key"] = Utils::keyToHexString(keyCopy);
+        }
+        String groupList;
+        if (cardStore->getGroups(uid, groupList)) {
+            parseGroups(groupList, entry["groups"].to<JsonArray>());
+        }
+        if (!visitor(entry.as<JsonObjectConst>())) {
+            return false;
+        }
+        cursor.position++;
+        cursor.lastUid = uid;
+        return true;
+    });
+}
+
+void CardDatabase::forEachUid(CardCursor& cursor, const UidVisitor& visitor) {
+    if (cardStore == nullptr) {
+        forEachCard(cursor, [&](JsonObjectConst card) {
+            return visitor(card["uid"] | "");
+        });
+        return;
+    }
+
+    // 按卡片存储模式：从上次的UID之后继续，不读取访问组
+    cardStore->forEachAfter(cursor.lastUid, [&](const String& uid, const uint8_t*, bool) {
+        if (!visitor(uid)) {
+            return false;
+        }
+        cursor.position++;
+        cursor.lastUid = uid;
+        return true;
+    });
+}
+
 size_t CardDatabase::getCardCount() {
+    if (cardStore != nullptr) {
+        return cardStore->getCount();
+    }
     return database.as<JsonArray>().size();
 }
+
+void CardDatabase::setKeyDiversifier(KeyDiversifier* diversifier, bool diversifyNew) {
+    keyDiversifier = diversifier;
+    diversifyNewCards = diversifyNew && diversifier != nullptr;
+}
+
+void CardDatabase::setRevocationList(const RevocationList* list) {
+    revocationList = list;
+}
+
+void CardDatabase::setCardStore(ICardStore* store) {
+    cardStore = store;
+}
+
+bool CardDatabase::usesCardStore() const {
+    return cardStore != nullptr;
+}
+
+bool CardDatabase::isRevoked(const uint8_t* uid, uint8_t uidLength) const {
+    return revocationList != nullptr && revocationList->isRevoked(uid, uidLength);
+}
+
+bool CardDatabase::hasKeyDiversifier() const {
+    return keyDiversifier != nullptr && keyDiversifier->isReady();
+}
+
+bool CardDatabase::usesDiversifiedKeys() const {
+    return diversifyNewCards;
+}
+
+bool CardDatabase::getCardKey(const String& uid, uint8_t* key) {
+    String keyHex;
+    if (!findCardByUID(uid, keyHex)) {
+        return false;
+    }
+    if (keyHex.length() > 0) {
+        Utils::hexStringToKey(keyHex, key);
+        return true;
+    }
+    return deriveCardKey(uid, key);
+}
+
+bool CardDatabase::deriveCardKey(const String& uid, uint8_t* key) {
+    if (keyDiversifier == nullptr) {
+        return false;
+    }
+    uint8_t uidBytes[Utils::MAX_UID_SIZE];
+    uint8_t uidLength = 0;
+    if (!Utils::stringToUid(uid, uidBytes, &uidLength)) {
+        return false;
+    }
+    return keyDiversifier->deriveKey(uidBytes, uidLength, KEY_SECTOR, key);
+}
+
+bool CardDatabase::hasStoredKey(const String& uid) {
+    String keyHex;
+    return findCardByUID(uid, keyHex) && keyHex.length() > 0;
+}
+
+bool CardDatabase::clearStoredKey(const String& uid) {
+    if (cardStore != nullptr) {
+        return cardStore->contains(uid) && cardStore->put(uid, nullptr);
+    }
+
+    JsonArray cards = database.as<JsonArray>();
+    for (JsonObject card : cards) {
+        if (card["uid"] == uid) {
+            card.remove("key");
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CardDatabase::adoptDiversifiedKey(const String& uid, const KeyProbe& probe) {
+    uint8_t key[Utils::KEY_SIZE];
+    if (!hasStoredKey(uid) || !deriveCardKey(uid, key) || !probe(key)) {
+        return false;
+    }
+    if (!clearStoredKey(uid)) {
+        Serial.println("Card Database: Failed to clear stored key of " + uid);
+    }
+    return true;
+}
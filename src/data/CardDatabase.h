@@ -3,15 +3,74 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <functional>
+
+class KeyDiversifier;
+class RevocationList;
+class ICardStore;
 
 /**
  * 卡片数据库管理类
  * 负责卡片信息的存储、查询、添加和删除
+ * 卡片条目有两种形式：
+ * - {uid, key}：注册时随机生成并保存的密钥
+ * - {uid}：分散密钥，由KeyDiversifier根据UID实时派生，数据库不保存密钥
+ * 条目可以带有groups字段（访问组名称数组），由AccessPolicy编译为组位图
+ *
+ * 默认所有卡片以JSON数组保存在内存中；设置按卡片存储（ICardStore）后，
+ * 卡片逐条保存在存储中，查找不再需要加载整个数据库，修改立即持久化
  */
 class CardDatabase {
+public:
+    // 卡片密钥所在扇区
+    static const uint8_t KEY_SECTOR = 1;
+
 private:
     JsonDocument database;
-    
+    KeyDiversifier* keyDiversifier;
+    bool diversifyNewCards;
+    const RevocationList* revocationList;
+    ICardStore* cardStore;
+
+    // 按卡片存储模式下getCardGroups返回的组数组
+    JsonDocument groupsScratch;
+
+    /**
+     * 把逗号分隔的组名称解析到数组（去除空白和空名称）
+     */
+    static void parseGroups(const String& groupList, JsonArray groups);
+
+public:
+    /**
+     * 卡片遍历回调
+     * @param card 卡片条目（uid、key、groups），只在回调期间有效
+     * @return 是否继续遍历
+     */
+    typedef std::function<bool(JsonObjectConst card)> CardVisitor;
+
+    /**
+     * 卡片UID遍历回调
+     * @param uid 卡片UID
+     * @return 是否继续遍历（返回false的卡片不计入游标，下次从它开始）
+     */
+    typedef std::function<bool(const String& uid)> UidVisitor;
+
+    /**
+     * 分段遍历的游标
+     * 只设置lastUid的游标（如用户给出的UID）从该卡片之后开始
+     */
+    struct CardCursor {
+        size_t position;  // 已遍历的卡片数（JSON模式按位置定位）
+        String lastUid;   // 最后遍历的UID（按卡片存储模式按UID定位）
+        CardCursor() : position(0) {}
+        explicit CardCursor(const String& after) : position(0), lastUid(after) {}
+    };
+
+    /**
+     * 构造函数
+     */
+    CardDatabase();
+
 public:
     /**
      * 初始化数据库
@@ -19,13 +78,13 @@ public:
     void initialize();
     
     /**
-     * 从文件加载数据库
+     * 从文件加载数据库（按卡片存储模式下把卡片导入存储）
      * @param data JSON数据
      */
     void loadFromJson(const JsonDocument& data);
     
     /**
-     * 获取数据库JSON对象
+     * 获取数据库JSON对象（按卡片存储模式下为空数组）
      * @return JSON文档引用
      */
     JsonDocument& getDatabase();
@@ -33,7 +92,7 @@ public:
     /**
      * 根据UID查找卡片
      * @param uid 卡片UID
-     * @param keyHex 输出的密钥十六进制字符串
+     * @param keyHex 输出的密钥十六进制字符串（分散密钥卡片为空字符串）
      * @return 是否找到卡片
      */
     bool findCardByUID(const String& uid, String& keyHex);
@@ -48,11 +107,139 @@ public:
     /**
      * 添加卡片到数据库
      * @param uid 卡片UID
-     * @param keyHex 密钥十六进制字符串
+     * @param keyHex 密钥十六进制字符串，空字符串表示使用分散密钥
      * @return 是否添加成功
      */
     bool addCard(const String& uid, const String& keyHex);
+
+    /**
+     * 设置密钥分散器
+     * @param diversifier 密钥分散器
+     * @param diversifyNew 新注册的卡片是否使用分散密钥
+     */
+    void setKeyDiversifier(KeyDiversifier* diversifier, bool diversifyNew);
+
+    /**
+     * 设置吊销列表
+     * @param list 吊销列表，nullptr表示不检查吊销
+     */
+    void setRevocationList(const RevocationList* list);
+
+    /**
+     * 设置按卡片存储，之后所有卡片操作都在存储中进行（需在加载数据库之前调用）
+     * @param store 已打开的按卡片存储，nullptr表示使用JSON模式
+     */
+    void setCardStore(ICardStore* store);
+
+    /**
+     * 是否使用按卡片存储
+     * @return 是否为按卡片存储模式
+     */
+    bool usesCardStore() const;
+
+    /**
+     * 检查卡片是否已吊销（认证时在查找卡片之前调用）
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @return 是否已吊销
+     */
+    bool isRevoked(const uint8_t* uid, uint8_t uidLength) const;
+
+    /**
+     * 是否配置了可用的密钥分散器
+     * @return 是否可以派生分散密钥
+     */
+    bool hasKeyDiversifier() const;
+
+    /**
+     * 新注册的卡片是否使用分散密钥
+     * @return 是否使用分散密钥
+     */
+    bool usesDiversifiedKeys() const;
+
+    /**
+     * 获取卡片的扇区密钥（保存的密钥或分散密钥）
+     * @param uid 卡片UID
+     * @param key 输出的密钥
+     * @return 是否找到卡片并获得密钥
+     */
+    bool getCardKey(const String& uid, uint8_t* key);
+
+    /**
+     * 根据UID派生分散密钥（不检查卡片是否已注册）
+     * @param uid 卡片UID
+     * @param key 输出的密钥
+     * @return 派生是否成功
+     */
+    bool deriveCardKey(const String& uid, uint8_t* key);
+
+    /**
+     * 检查卡片是否保存了独立密钥（未迁移到分散密钥）
+     * @param uid 卡片UID
+     * @return 是否保存了密钥
+     */
+    bool hasStoredKey(const String& uid);
+
+    /**
+     * 删除卡片保存的独立密钥，之后使用分散密钥
+     * @param uid 卡片UID
+     * @return 是否成功
+     */
+    bool clearStoredKey(const String& uid);
+
+    /**
+     * 卡片密钥认证回调
+     * @param key 尝试的密钥
+     * @return 卡片是否接受该密钥
+     */
+    typedef std::function<bool(const uint8_t* key)> KeyProbe;
+
+    /**
+     * 保存的密钥认证失败后尝试分散密钥：迁移在写入分散密钥之后、校验之前中断时
+     * （卡片被拿开、应答丢失），卡片已经是分散密钥而数据库仍保存旧密钥。
+     * 分散密钥认证成功时删除保存的密钥，之后直接使用分散密钥
+     * @param uid 卡片UID
+     * @param probe 认证回调（调用者负责重新选择卡片）
+     * @return 卡片是否接受分散密钥；没有保存的密钥或主密钥未加载时为false，不调用回调
+     */
+    bool adoptDiversifiedKey(const String& uid, const KeyProbe& probe);
     
+    /**
+     * 设置卡片的访问组
+     * @param uid 卡片UID
+     * @param groupList 逗号分隔的组名称，"*"表示删除groups字段（不受限制）
+     * @return 是否找到卡片
+     */
+    bool setCardGroups(const String& uid, const String& groupList);
+
+    /**
+     * 导入卡片：添加或替换卡片的密钥和访问组
+     * @param uid 卡片UID
+     * @param keyHex 密钥（十六进制），空字符串表示使用分散密钥
+     * @param groupList 逗号分隔的组名称，"*"表示不受限制
+     * @param replaced 输出卡片是否已存在
+     * @return 是否成功
+     */
+    bool importCard(const String& uid, const String& keyHex, const String& groupList, bool& replaced);
+
+    /**
+     * 开始批量修改（按卡片存储模式下修改先累积在内存中）
+     */
+    void beginBatch();
+
+    /**
+     * 结束批量修改，持久化按卡片存储中累积的修改（JSON模式仍需调用FileSystemManager::saveCards）
+     * @return 是否成功
+     */
+    bool endBatch();
+
+    /**
+     * 获取卡片的访问组
+     * @param uid 卡片UID
+     * @return 组名称数组，卡片不存在或不受限制时为null（按卡片存储模式下只在下次调用前有效）
+     */
+    JsonArrayConst getCardGroups(const String& uid);
+
     /**
      * 从数据库删除卡片
      * @param uid 卡片UID
@@ -61,10 +248,32 @@ public:
     bool removeCard(const String& uid);
     
     /**
-     * 获取所有已注册的卡片
+     * 获取所有已注册的卡片（只适用于JSON模式，按卡片存储模式下为空数组）
      * @return 卡片数组
      */
     JsonArray getCards();
+
+    /**
+     * 遍历所有已注册的卡片（两种模式都适用，遍历期间不能修改数据库）
+     * @param visitor 回调，返回false时停止
+     */
+    void forEachCard(const CardVisitor& visitor);
+
+    /**
+     * 从游标处继续遍历卡片（分多次导出卡片时使用）
+     * 两次遍历之间可以修改数据库；JSON模式下此时可能跳过或重复个别卡片
+     * @param cursor 游标，遍历后更新到最后一张计入的卡片
+     * @param visitor 回调，返回false时停止（该卡片不计入游标）
+     */
+    void forEachCard(CardCursor& cursor, const CardVisitor& visitor);
+
+    /**
+     * 从游标处继续遍历卡片UID，不构造卡片条目（分多次列出卡片时使用）
+     * 两次遍历之间可以修改数据库；JSON模式下此时可能跳过或重复个别卡片
+     * @param cursor 游标，遍历后更新到最后一张计入的卡片
+     * @param visitor 回调，返回false时停止
+     */
+    void forEachUid(CardCursor& cursor, const UidVisitor& visitor);
     
     /**
      * 获取已注册卡片数量
@@ -0,0 +1,49 @@
+#ifndef CARDFILEFORMAT_H
+#define CARDFILEFORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * 卡片文件槽格式
+ * 固件（FileStorageBackend）和主机工具共用此头文件，只依赖C标准库
+ *
+ * 卡片数据库保存为A/B两个槽文件（<路径>.a和<路径>.b），每个文件为SlotHeader + JSON正文，
+ * 正文为卡片数组 [{"uid":"04A1B2C3","key":"...","groups":["staff"]}, ...]
+ * 序号较大且头有效（魔数正确、正文长度与文件大小一致）的槽为当前副本，正文CRC-32与zlib相同
+ * 所有多字节字段为小端序
+ */
+namespace CardFileFormat {
+
+// 卡片文件路径（槽文件名前缀）
+const char* const CARD_FILE_PATH = "/cards.json";
+
+// 槽文件头魔数（"CDB1"）
+const uint32_t SLOT_MAGIC = 0x43444231;
+
+// 槽数量
+const int SLOT_COUNT = 2;
+
+// UID最长10字节（与Utils::MAX_UID_SIZE一致，FileStorageBackend.cpp中有静态检查）
+const size_t MAX_UID_SIZE = 10;
+
+struct SlotHeader {
+    uint32_t magic;
+    uint32_t sequence;  // 每次保存加1，较大的为较新的副本
+    uint32_t length;    // JSON正文长度
+    uint32_t crc;       // JSON正文的CRC-32
+};
+
+static_assert(sizeof(SlotHeader) == 16, "SlotHeader must be 16 bytes");
+
+/**
+ * 槽文件名后缀
+ * @param slot 槽编号（0或1）
+ */
+inline const char* slotSuffix(int slot) {
+    return slot == 0 ? ".a" : ".b";
+}
+
+} // namespace CardFileFormat
+
+#endif // CARDFILEFORMAT_H
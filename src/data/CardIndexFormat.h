@@ -0,0 +1,256 @@
+#ifndef CARDINDEXFORMAT_H
+#define CARDINDEXFORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * 卡片索引映像的闪存格式
+ * 固件（FlashCardIndex）和主机工具共用此头文件，只依赖C标准库
+ *
+ * 分区布局（cardidx分区）：
+ *   [0, DELTA_REGION_SIZE)            变更日志，每条DeltaRecord 128字节，追加写入
+ *   [DELTA_REGION_SIZE, +slotSize)    映像槽A
+ *   [DELTA_REGION_SIZE + slotSize, +slotSize)  映像槽B
+ *
+ * 映像：ImageHeader + 按UID排序的IndexRecord数组 + 访问组字符串区（以'\0'结尾的逗号分隔名称）
+ * 两个槽交替写入，文件头最后写入，序号较大的有效映像为当前映像；
+ * 变更日志中baseSequence等于当前映像序号的记录按顺序叠加在映像之上，重写映像后清空
+ * 所有多字节字段为小端序
+ */
+namespace CardIndexFormat {
+
+// 分区子类型和标签
+const uint8_t PARTITION_SUBTYPE = 0x41;
+const char* const PARTITION_LABEL = "cardidx";
+
+// 闪存扇区大小（擦除单位）
+const uint32_t SECTOR_SIZE = 4096;
+
+// 映像文件头魔数（"CIDX"）和格式版本
+const uint32_t IMAGE_MAGIC = 0x43494458;
+const uint16_t IMAGE_VERSION = 1;
+
+// 变更记录魔数（"CDLT"），擦除后为0xFFFFFFFF
+const uint32_t DELTA_MAGIC = 0x43444C54;
+const uint32_t ERASED_WORD = 0xFFFFFFFF;
+
+// 变更日志区域大小和容量
+const uint32_t DELTA_REGION_SIZE = 0x8000;
+const size_t DELTA_RECORD_SIZE = 128;
+const size_t DELTA_CAPACITY = DELTA_REGION_SIZE / DELTA_RECORD_SIZE;
+
+// UID最长7字节
+const size_t MAX_UID_LENGTH = 7;
+const size_t KEY_SIZE = 6;
+
+// 记录标志位
+const uint8_t FLAG_HAS_KEY = 0x01;
+
+// 不受限制（没有访问组）的组偏移
+const uint32_t NO_GROUPS = 0xFFFFFFFF;
+
+// 变更记录中组名称的最大长度（不含'\0'）
+const size_t MAX_DELTA_GROUPS_LENGTH = 99;
+
+// 变更操作
+enum DeltaOp : uint8_t {
+    DELTA_UPSERT = 1,   // 添加或替换卡片的完整状态
+    DELTA_REMOVE = 2    // 删除卡片
+};
+
+#pragma pack(push, 1)
+struct ImageHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;      // sizeof(ImageHeader)
+    uint16_t recordSize;      // sizeof(IndexRecord)
+    uint16_t reserved0;
+    uint32_t sequence;        // 每次重写映像加1
+    uint32_t recordCount;
+    uint32_t recordsOffset;   // 相对槽起始位置
+    uint32_t stringsOffset;   // 相对槽起始位置
+    uint32_t stringsSize;
+    uint32_t recordsCrc;      // 记录数组的CRC-32
+    uint32_t stringsCrc;      // 字符串区的CRC-32
+    uint8_t reserved[20];
+    uint32_t headerCrc;       // 前面所有字段的CRC-32
+};
+
+struct IndexRecord {
+    uint8_t uid[MAX_UID_LENGTH];   // 不足7字节时后面补0
+    uint8_t uidLength;
+    uint8_t key[KEY_SIZE];
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t groupsOffset;         // 相对字符串区，NO_GROUPS表示不受限制
+};
+
+struct DeltaRecord {
+    uint32_t magic;
+    uint32_t baseSequence;         // 所基于的映像序号
+    uint8_t op;                    // DeltaOp
+    uint8_t uid[MAX_UID_LENGTH];
+    uint8_t uidLength;
+    uint8_t key[KEY_SIZE];
+    uint8_t flags;
+    uint8_t groupsLength;          // 0xFF表示不受限制
+    char groups[MAX_DELTA_GROUPS_LENGTH];
+    uint32_t crc;                  // 前面所有字段的CRC-32
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ImageHeader) == 64, "ImageHeader must be 64 bytes");
+static_assert(sizeof(IndexRecord) == 20, "IndexRecord must be 20 bytes");
+static_assert(sizeof(DeltaRecord) == DELTA_RECORD_SIZE, "DeltaRecord must be 128 bytes");
+
+/**
+ * 计算CRC-32（与zlib相同，多项式0xEDB88320）
+ * @param data 数据
+ * @param length 数据长度
+ * @param crc 初值（分段计算时传入上一段的结果）
+ * @return 校验值
+ */
+inline uint32_t crc32(const void* data, size_t length, uint32_t crc = 0) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * 计算映像槽大小（扇区对齐）
+ * @param partitionSize 分区大小
+ * @return 每个槽的大小，分区太小时为0
+ */
+inline uint32_t slotSize(uint32_t partitionSize) {
+    if (partitionSize <= DELTA_REGION_SIZE + 2 * SECTOR_SIZE) {
+        return 0;
+    }
+    return ((partitionSize - DELTA_REGION_SIZE) / 2) & ~(SECTOR_SIZE - 1);
+}
+
+/**
+ * 映像槽在分区中的偏移
+ * @param slot 槽编号（0或1）
+ * @param partitionSize 分区大小
+ * @return 偏移
+ */
+inline uint32_t slotOffset(int slot, uint32_t partitionSize) {
+    return DELTA_REGION_SIZE + slot * slotSize(partitionSize);
+}
+
+/**
+ * 比较两个UID的排序顺序（先按字节，再按长度）
+ * 与UID十六进制字符串的字典序一致
+ * @return 负数、0或正数
+ */
+inline int compareUid(const uint8_t* a, uint8_t aLength, const uint8_t* b, uint8_t bLength) {
+    size_t common = aLength < bLength ? aLength : bLength;
+    int result = memcmp(a, b, common);
+    if (result != 0) {
+        return result;
+    }
+    return (int)aLength - (int)bLength;
+}
+
+/**
+ * 计算文件头的CRC（不含headerCrc字段）
+ */
+inline uint32_t headerCrc(const ImageHeader& header) {
+    return crc32(&header, offsetof(ImageHeader, headerCrc));
+}
+
+/**
+ * 计算变更记录的CRC（不含crc字段）
+ */
+inline uint32_t deltaCrc(const DeltaRecord& record) {
+    return crc32(&record, offsetof(DeltaRecord, crc));
+}
+
+/**
+ * 计算映像中各区域的位置（记录数组紧跟文件头，字符串区紧跟记录数组）
+ * @param header 文件头
+ * @param recordCount 记录数
+ * @param stringsSize 字符串区大小
+ * @return 映像总大小
+ */
+inline uint32_t layoutImage(ImageHeader& header, uint32_t recordCount, uint32_t stringsSize) {
+    header.recordCount = recordCount;
+    header.recordsOffset = sizeof(ImageHeader);
+    header.stringsOffset = header.recordsOffset + recordCount * sizeof(IndexRecord);
+    header.stringsSize = stringsSize;
+    return header.stringsOffset + stringsSize;
+}
+
+/**
+ * 填写文件头的固定字段、序号和文件头CRC（recordsCrc和stringsCrc须已填好）
+ * @param header 文件头
+ * @param sequence 映像序号
+ */
+inline void sealHeader(ImageHeader& header, uint32_t sequence) {
+    header.magic = IMAGE_MAGIC;
+    header.version = IMAGE_VERSION;
+    header.headerSize = sizeof(ImageHeader);
+    header.recordSize = sizeof(IndexRecord);
+    header.sequence = sequence;
+    header.headerCrc = headerCrc(header);
+}
+
+/**
+ * 解析十六进制UID字符串
+ * @param hex UID字符串（每字节两个十六进制字符）
+ * @param length 字符串长度
+ * @param record 输出记录（清零后填写uid和uidLength）
+ * @return UID是否有效
+ */
+inline bool parseUid(const char* hex, size_t length, IndexRecord& record) {
+    memset(&record, 0, sizeof(record));
+    if (length == 0 || length % 2 != 0 || length / 2 > MAX_UID_LENGTH) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char c = hex[i];
+        uint8_t nibble;
+        if (c >= '0' && c <= '9') {
+            nibble = c - '0';
+        } else if (c >= 'A' && c <= 'F') {
+            nibble = c - 'A' + 10;
+        } else if (c >= 'a' && c <= 'f') {
+            nibble = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        record.uid[i / 2] = (record.uid[i / 2] << 4) | nibble;
+    }
+    record.uidLength = length / 2;
+    return true;
+}
+
+/**
+ * 检查映像文件头是否有效（魔数、版本、CRC和各区域是否在槽内）
+ * @param header 文件头
+ * @param slotSize 槽大小
+ * @return 是否有效
+ */
+inline bool isValidHeader(const ImageHeader& header, uint32_t slotSize) {
+    if (header.magic != IMAGE_MAGIC || header.version != IMAGE_VERSION ||
+        header.headerSize != sizeof(ImageHeader) || header.recordSize != sizeof(IndexRecord) ||
+        header.headerCrc != headerCrc(header)) {
+        return false;
+    }
+    uint64_t recordsEnd = (uint64_t)header.recordsOffset + (uint64_t)header.recordCount * sizeof(IndexRecord);
+    uint64_t stringsEnd = (uint64_t)header.stringsOffset + header.stringsSize;
+    return header.recordsOffset >= sizeof(ImageHeader) && recordsEnd <= header.stringsOffset &&
+           stringsEnd <= slotSize;
+}
+
+}
+
+#endif // CARDINDEXFORMAT_H
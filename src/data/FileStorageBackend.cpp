@@ -0,0 +1,250 @@
+#include "FileStorageBackend.h"
+#include "../utils/Utils.h"
+
+static_assert(CardFileFormat::MAX_UID_SIZE == Utils::MAX_UID_SIZE, "CardFileFormat::MAX_UID_SIZE out of date");
+
+namespace {
+/**
+ * 写入文件并计算CRC-32和长度
+ */
+class CrcFileWriter : public Print {
+public:
+    File& file;
+    uint32_t crc;
+    size_t length;
+    bool failed;
+
+    explicit CrcFileWriter(File& file) : file(file), crc(0), length(0), failed(false) {}
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        size_t written = file.write(buffer, size);
+        if (written != size) {
+            failed = true;
+        }
+        crc = Utils::crc32(buffer, written, crc);
+        length += written;
+        return written;
+    }
+};
+
+/**
+ * 分块读取文件正文并计算CRC-32，最多读取limit字节
+ */
+class CrcFileReader : public Stream {
+public:
+    File& file;
+    uint32_t crc;
+    size_t remaining;
+    uint8_t buffer[128];
+    size_t bufferLength;
+    size_t bufferPos;
+
+    CrcFileReader(File& file, size_t limit)
+        : file(file), crc(0), remaining(limit), bufferLength(0), bufferPos(0) {}
+
+    bool fill() {
+        if (bufferPos < bufferLength) {
+            return true;
+        }
+        size_t chunk = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
+        bufferLength = chunk > 0 ? file.read(buffer, chunk) : 0;
+        bufferPos = 0;
+        remaining -= bufferLength;
+        crc = Utils::crc32(buffer, bufferLength, crc);
+        return bufferLength > 0;
+    }
+
+    int available() override {
+        return (bufferLength - bufferPos) + remaining;
+    }
+
+    int read() override {
+        return fill() ? buffer[bufferPos++] : -1;
+    }
+
+    int peek() override {
+        return fill() ? buffer[bufferPos] : -1;
+    }
+
+    size_t write(uint8_t) override {
+        return 0;
+    }
+
+    /**
+     * 读完剩余正文（JSON之后不应有数据，读完才能得到完整的CRC）
+     * @return 是否读满了文件头声明的长度
+     */
+    bool drain() {
+        bufferPos = bufferLength;
+        while (remaining > 0 && fill()) {
+            bufferPos = bufferLength;
+        }
+        return remaining == 0;
+    }
+};
+}
+
+FileStorageBackend::FileStorageBackend(fs::FS& fileSystem, const char* name, const char* path)
+    : fileSystem(fileSystem), name(name), path(path), activeSlot(-1), sequence(0) {
+}
+
+String FileStorageBackend::slotPath(int slot) const {
+    return String(path) + CardFileFormat::slotSuffix(slot);
+}
+
+bool FileStorageBackend::readHeader(int slot, SlotHeader& header) {
+    String file = slotPath(slot);
+    if (!fileSystem.exists(file)) {
+        return false;
+    }
+    File handle = fileSystem.open(file, FILE_READ);
+    if (!handle) {
+        return false;
+    }
+    size_t size = handle.size();
+    bool valid = size >= sizeof(header) &&
+                 handle.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                 header.magic == CardFileFormat::SLOT_MAGIC && header.length == size - sizeof(header);
+    handle.close();
+    return valid;
+}
+
+bool FileStorageBackend::begin() {
+    activeSlot = -1;
+    sequence = 0;
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        SlotHeader header;
+        if (readHeader(slot, header) && (activeSlot < 0 || (int32_t)(header.sequence - sequence) > 0)) {
+            activeSlot = slot;
+            sequence = header.sequence;
+        }
+    }
+    return true;
+}
+
+IStorageBackend::LoadResult FileStorageBackend::loadSlot(int slot, const SlotHeader& header, JsonDocument& cards) {
+    File file = fileSystem.open(slotPath(slot), FILE_READ);
+    if (!file || !file.seek(sizeof(SlotHeader))) {
+        return LOAD_ERROR;
+    }
+    CrcFileReader reader(file, header.length);
+    // 读到末尾时不等待（Stream默认超时1秒）
+    reader.setTimeout(0);
+    DeserializationError err = deserializeJson(cards, reader);
+    bool complete = reader.drain();
+    file.close();
+    if (err || !complete || reader.crc != header.crc) {
+        cards.clear();
+        return LOAD_CORRUPT;
+    }
+    return LOAD_OK;
+}
+
+IStorageBackend::LoadResult FileStorageBackend::loadCards(JsonDocument& cards) {
+    // 按序号从新到旧尝试
+    SlotHeader headers[SLOT_COUNT];
+    bool valid[SLOT_COUNT];
+    bool anySlotFile = false;
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        valid[slot] = readHeader(slot, headers[slot]);
+        anySlotFile = anySlotFile || fileSystem.exists(slotPath(slot));
+    }
+    int order[SLOT_COUNT] = {0, 1};
+    if (valid[0] && valid[1] && (int32_t)(headers[1].sequence - headers[0].sequence) > 0) {
+        order[0] = 1;
+        order[1] = 0;
+    }
+
+    LoadResult result = LOAD_NOT_FOUND;
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        int slot = order[i];
+        if (!valid[slot]) {
+            continue;
+        }
+        result = loadSlot(slot, headers[slot], cards);
+        if (result == LOAD_OK) {
+            activeSlot = slot;
+            sequence = headers[slot].sequence;
+            return LOAD_OK;
+        }
+        Serial.println("Card file " + slotPath(slot) + " invalid, trying older copy");
+    }
+
+    if (result != LOAD_NOT_FOUND || anySlotFile) {
+        // 有槽文件但没有可用副本
+        return result == LOAD_ERROR ? LOAD_ERROR : LOAD_CORRUPT;
+    }
+
+    // 旧版本的单文件
+    if (!fileSystem.exists(path)) {
+        return LOAD_NOT_FOUND;
+    }
+    File file = fileSystem.open(path, FILE_READ);
+    if (!file) {
+        return LOAD_ERROR;
+    }
+    DeserializationError err = deserializeJson(cards, file);
+    file.close();
+    return err ? LOAD_CORRUPT : LOAD_OK;
+}
+
+bool FileStorageBackend::saveCards(const JsonDocument& cards) {
+    int slot = activeSlot == 0 ? 1 : 0;
+    File file = fileSystem.open(slotPath(slot), FILE_WRITE);
+    if (!file) {
+        Serial.println("Failed to open card file for writing");
+        return false;
+    }
+
+    // 先写全零的文件头占位，正文写完后再写真正的文件头
+    SlotHeader header = {0, 0, 0, 0};
+    bool success = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    CrcFileWriter writer(file);
+    if (success) {
+        serializeJson(cards, writer);
+        success = !writer.failed && writer.length > 0;
+    }
+    if (success) {
+        file.flush();
+        header.magic = CardFileFormat::SLOT_MAGIC;
+        header.sequence = sequence + 1;
+        header.length = writer.length;
+        header.crc = writer.crc;
+        success = file.seek(0) && file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    }
+    file.close();
+
+    if (!success) {
+        Serial.println("Failed to write card file, previous copy kept");
+        return false;
+    }
+    activeSlot = slot;
+    sequence = header.sequence;
+
+    // 已迁移到槽文件，删除旧版本的单文件
+    if (fileSystem.exists(path)) {
+        fileSystem.remove(path);
+    }
+    return true;
+}
+
+bool FileStorageBackend::erase() {
+    bool success = true;
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        String file = slotPath(slot);
+        if (fileSystem.exists(file) && !fileSystem.remove(file)) {
+            success = false;
+        }
+    }
+    activeSlot = -1;
+    sequence = 0;
+    return success && (!fileSystem.exists(path) || fileSystem.remove(path));
+}
+
+const char* FileStorageBackend::getName() const {
+    return name;
+}
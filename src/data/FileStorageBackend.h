@@ -0,0 +1,79 @@
+#ifndef FILESTORAGEBACKEND_H
+#define FILESTORAGEBACKEND_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "CardFileFormat.h"
+#include "../interfaces/IStorageBackend.h"
+
+/**
+ * 文件存储后端
+ * 卡片数据库保存为文件系统上的JSON文件，SPIFFS和LittleFS共用此实现，
+ * 文件系统由FileSystemManager按编译选项挂载
+ *
+ * 使用A/B两个槽文件（<path>.a和<path>.b）交替写入，每个文件以16字节头开始：
+ * 魔数、序号、正文长度、正文CRC-32（格式见CardFileFormat.h，与主机工具共用）。保存时写入较旧的槽，头最后写入，
+ * 写入中途复位只会损坏正在写的槽，加载时退回另一个槽（上一次成功保存的数据）
+ * 选择槽只读取文件头（魔数、长度与文件大小一致、序号最大），CRC在解析时顺带计算，不需要额外读取
+ * 单张卡片变化时重写整个文件
+ */
+class FileStorageBackend : public IStorageBackend {
+private:
+    typedef CardFileFormat::SlotHeader SlotHeader;
+
+    static const int SLOT_COUNT = CardFileFormat::SLOT_COUNT;
+
+    fs::FS& fileSystem;
+    const char* name;
+    const char* path;
+    int activeSlot;         // 最新有效副本所在的槽，-1表示没有
+    uint32_t sequence;      // 最新有效副本的序号
+
+    /**
+     * 获取槽文件路径
+     */
+    String slotPath(int slot) const;
+
+    /**
+     * 读取并检查槽文件头（魔数、正文长度与文件大小一致）
+     * @return 文件头是否有效
+     */
+    bool readHeader(int slot, SlotHeader& header);
+
+    /**
+     * 加载一个槽的JSON并校验CRC
+     * @return 加载结果
+     */
+    LoadResult loadSlot(int slot, const SlotHeader& header, JsonDocument& cards);
+
+public:
+    /**
+     * 构造函数
+     * @param fileSystem 已挂载（或稍后挂载）的文件系统
+     * @param name 后端名称（如"spiffs"）
+     * @param path 卡片文件路径（旧版本的单文件路径，同时作为槽文件名前缀）
+     */
+    FileStorageBackend(fs::FS& fileSystem, const char* name, const char* path);
+
+    /**
+     * 打开后端，读取两个槽的文件头确定最新副本
+     * @return 是否成功
+     */
+    bool begin() override;
+
+    /**
+     * 加载最新的有效副本，CRC或解析失败时退回另一个槽；
+     * 两个槽都不存在时读取旧版本的单文件（下次保存后删除）
+     */
+    LoadResult loadCards(JsonDocument& cards) override;
+
+    /**
+     * 把卡片写入较旧的槽，成功后该槽成为最新副本
+     */
+    bool saveCards(const JsonDocument& cards) override;
+
+    bool erase() override;
+    const char* getName() const override;
+};
+
+#endif // FILESTORAGEBACKEND_H
@@ -1,48 +1,178 @@
 #include "FileSystemManager.h"
+#include "CardFileFormat.h"
+#ifdef STORAGE_LITTLEFS
+#include <LittleFS.h>
+#else
+#include <SPIFFS.h>
+#endif
 
-const char* FileSystemManager::CARD_FILE = "/cards.json";
+const char* FileSystemManager::CARD_FILE = CardFileFormat::CARD_FILE_PATH;
+const char* FileSystemManager::POLICY_FILE = "/policy.json";
 
-FileSystemManager::FileSystemManager(CardDatabase* db) : cardDatabase(db) {
+FileSystemManager::FileSystemManager(CardDatabase* db, IStorageBackend* storage)
+    : cardDatabase(db), storage(storage) {
 }
 
-bool FileSystemManager::initialize() {
+bool FileSystemManager::mount() {
+#ifdef STORAGE_LITTLEFS
+    if (!LittleFS.begin(true)) {
+        Serial.println("LittleFS Mount Failed");
+        return false;
+    }
+#else
     if (!SPIFFS.begin(true)) {
         Serial.println("SPIFFS Mount Failed");
         return false;
     }
-    return loadCards();
+#endif
+    return true;
 }
 
-bool FileSystemManager::saveCards() {
-    File file = SPIFFS.open(CARD_FILE, FILE_WRITE);
-    if (!file) {
-        Serial.println("Failed to open card file for writing");
+fs::FS& FileSystemManager::fileSystem() {
+#ifdef STORAGE_LITTLEFS
+    return LittleFS;
+#else
+    return SPIFFS;
+#endif
+}
+
+const char* FileSystemManager::fileSystemName() {
+#ifdef STORAGE_LITTLEFS
+    return "littlefs";
+#else
+    return "spiffs";
+#endif
+}
+
+size_t FileSystemManager::freeBytes() {
+#ifdef STORAGE_LITTLEFS
+    return LittleFS.totalBytes() - LittleFS.usedBytes();
+#else
+    return SPIFFS.totalBytes() - SPIFFS.usedBytes();
+#endif
+}
+
+String FileSystemManager::tempFilePath(const char* path) {
+    return String(path) + ".tmp";
+}
+
+bool FileSystemManager::replaceFile(const char* path) {
+    fs::FS& fs = fileSystem();
+    String tempPath = tempFilePath(path);
+#ifdef STORAGE_LITTLEFS
+    bool success = fs.rename(tempPath, path);
+#else
+    bool success = (!fs.exists(path) || fs.remove(path)) && fs.rename(tempPath, path);
+#endif
+    if (!success && fs.exists(path)) {
+        fs.remove(tempPath);
+    }
+    return success;
+}
+
+bool FileSystemManager::recoverFile(const char* path) {
+    fs::FS& fs = fileSystem();
+    String tempPath = tempFilePath(path);
+    if (!fs.exists(tempPath)) {
         return false;
     }
-    serializeJsonPretty(cardDatabase->getDatabase(), file);
-    file.close();
+    if (fs.exists(path)) {
+        fs.remove(tempPath);
+        return false;
+    }
+    if (!fs.rename(tempPath, path)) {
+        Serial.print("Failed to recover ");
+        Serial.println(path);
+        return false;
+    }
+    Serial.print("Recovered ");
+    Serial.print(path);
+    Serial.println(" from interrupted rewrite");
     return true;
 }
 
+bool FileSystemManager::initialize() {
+    if (!mount()) {
+        return false;
+    }
+    if (!storage->begin()) {
+        Serial.print("Failed to open card storage: ");
+        Serial.println(storage->getName());
+        return false;
+    }
+    Serial.print("Card storage: ");
+    Serial.println(storage->getName());
+    return loadCards();
+}
+
+bool FileSystemManager::saveCards() {
+    // 按卡片存储模式下卡片修改时已经持久化
+    if (cardDatabase->usesCardStore()) {
+        return true;
+    }
+    return storage->saveCards(cardDatabase->getDatabase());
+}
+
+bool FileSystemManager::saveCard(const String& uid) {
+    if (cardDatabase->usesCardStore()) {
+        return true;
+    }
+    return storage->updateCard(uid, cardDatabase->getDatabase());
+}
+
 bool FileSystemManager::loadCards() {
-    if (SPIFFS.exists(CARD_FILE)) {
-        File file = SPIFFS.open(CARD_FILE, FILE_READ);
-        if (file) {
-            JsonDocument tempDoc;
-            DeserializationError err = deserializeJson(tempDoc, file);
-            if (err) {
-                Serial.println("Card database corrupt, resetting...");
-                cardDatabase->initialize();
-                file.close();
-                return saveCards();
-            }
+    // 按卡片存储模式不加载JSON数据库，只在存储为空时从存储后端迁移一次（原数据保留作为备份）
+    bool migrate = cardDatabase->usesCardStore();
+    if (migrate && cardDatabase->getCardCount() > 0) {
+        return true;
+    }
+
+    JsonDocument tempDoc;
+    switch (storage->loadCards(tempDoc)) {
+        case IStorageBackend::LOAD_OK:
             cardDatabase->loadFromJson(tempDoc);
-            file.close();
+            if (migrate) {
+                Serial.printf("Migrated %u cards to card store\n", (unsigned)cardDatabase->getCardCount());
+            }
             return true;
-        }
+        case IStorageBackend::LOAD_CORRUPT:
+            Serial.println("Card database corrupt (no valid copy), resetting...");
+            break;
+        case IStorageBackend::LOAD_ERROR:
+            // 读取失败时不覆盖已保存的数据
+            Serial.println("Failed to read card database");
+            cardDatabase->initialize();
+            return false;
+        default:
+            // 不存在，创建新数据库
+            break;
     }
-    
-    // 文件不存在或打开失败，创建新数据库
+
     cardDatabase->initialize();
     return saveCards();
 }
+
+bool FileSystemManager::loadPolicy(JsonDocument& policy) {
+    policy.clear();
+    fs::FS& fileSystem = FileSystemManager::fileSystem();
+    if (!fileSystem.exists(POLICY_FILE)) {
+        return true;
+    }
+    File file = fileSystem.open(POLICY_FILE, FILE_READ);
+    if (!file) {
+        Serial.println("Failed to open policy file");
+        return false;
+    }
+    DeserializationError err = deserializeJson(policy, file);
+    file.close();
+    if (err) {
+        Serial.println("Policy file corrupt, ignored");
+        policy.clear();
+        return false;
+    }
+    return true;
+}
+
+IStorageBackend* FileSystemManager::getStorage() {
+    return storage;
+}
@@ -2,43 +2,121 @@
 #define FILESYSTEMMANAGER_H
 
 #include <Arduino.h>
-#include <SPIFFS.h>
+#include <FS.h>
 #include <ArduinoJson.h>
 #include "CardDatabase.h"
+#include "../interfaces/IStorageBackend.h"
 
 /**
  * 文件系统管理类
- * 负责文件系统的初始化和数据的持久化存储
+ * 负责挂载文件系统，并通过存储后端持久化卡片数据库
+ * 文件系统在编译时选择：默认SPIFFS，定义STORAGE_LITTLEFS时为LittleFS（两者使用同一个分区，
+ * 切换后首次启动会格式化分区）。策略、吊销列表、在场状态等文件都保存在该文件系统上，
+ * 卡片数据库的存放位置由存储后端决定
  */
 class FileSystemManager {
 private:
-    static const char* CARD_FILE;
+    static const char* POLICY_FILE;
     CardDatabase* cardDatabase;
-    
+    IStorageBackend* storage;
+
 public:
+    // 默认卡片文件路径
+    static const char* CARD_FILE;
+
     /**
      * 构造函数
      * @param db 卡片数据库指针
+     * @param storage 卡片数据存储后端
      */
-    FileSystemManager(CardDatabase* db);
-    
+    FileSystemManager(CardDatabase* db, IStorageBackend* storage);
+
     /**
-     * 初始化文件系统
+     * 挂载文件系统，打开存储后端并加载卡片数据库
      * @return 初始化是否成功
      */
     bool initialize();
-    
+
     /**
-     * 保存卡片数据库到文件
+     * 保存全部卡片
      * @return 保存是否成功
      */
     bool saveCards();
-    
+
     /**
-     * 从文件加载卡片数据库
+     * 单张卡片添加、修改或删除后保存（由存储后端决定是否只写这一张）
+     * @param uid 变化的卡片UID
+     * @return 保存是否成功
+     */
+    bool saveCard(const String& uid);
+
+    /**
+     * 从存储后端加载卡片数据库（不存在或损坏时创建空数据库）
      * @return 加载是否成功
      */
     bool loadCards();
+
+    /**
+     * 加载访问策略文件（/policy.json）
+     * @param policy 输出的策略JSON，文件不存在时为空文档
+     * @return 是否成功（文件不存在也视为成功）
+     */
+    bool loadPolicy(JsonDocument& policy);
+
+    /**
+     * 获取卡片数据存储后端
+     * @return 存储后端
+     */
+    IStorageBackend* getStorage();
+
+    /**
+     * 挂载编译时选择的文件系统（失败时格式化）
+     * @return 是否成功
+     */
+    static bool mount();
+
+    /**
+     * 获取编译时选择的文件系统
+     * @return 文件系统
+     */
+    static fs::FS& fileSystem();
+
+    /**
+     * 获取文件系统名称
+     * @return "spiffs"或"littlefs"
+     */
+    static const char* fileSystemName();
+
+    /**
+     * 获取文件系统剩余空间
+     * @return 剩余字节数
+     */
+    static size_t freeBytes();
+
+    /**
+     * 获取替换文件时使用的临时文件路径
+     * @param path 目标文件路径
+     * @return 临时文件路径（path + ".tmp"）
+     */
+    static String tempFilePath(const char* path);
+
+    /**
+     * 用已写完并关闭的临时文件替换目标文件
+     * LittleFS上rename原子地覆盖目标文件；SPIFFS不能rename到已存在的文件，需要先删除目标文件，
+     * 两步之间复位时只剩临时文件，由recoverFile在启动时恢复
+     * 失败时只在目标文件仍然存在时删除临时文件，否则临时文件是唯一的副本
+     * @param path 目标文件路径
+     * @return 是否成功
+     */
+    static bool replaceFile(const char* path);
+
+    /**
+     * 启动时处理替换文件中断留下的临时文件：目标文件不存在时（删除之后、改名之前复位）
+     * 把临时文件改名为目标文件，否则删除临时文件（写入临时文件期间复位，目标文件完好）
+     * @param path 目标文件路径
+     * @return 是否从临时文件恢复了目标文件
+     */
+    static bool recoverFile(const char* path);
 };
 
 #endif // FILESYSTEMMANAGER_H
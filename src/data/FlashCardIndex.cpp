@@ -0,0 +1,622 @@
+#include "FlashCardIndex.h"
+#include "../utils/Utils.h"
+
+using namespace CardIndexFormat;
+
+namespace {
+// 重写映像时的写缓冲
+const size_t RECORD_BUFFER_COUNT = 32;
+const size_t STRING_BUFFER_SIZE = 256;
+
+// 批量修改期间覆盖表的最大条目数，超过时提前重写映像（限制内存占用）
+const size_t BATCH_OVERLAY_LIMIT = 1024;
+}
+
+FlashCardIndex::FlashCardIndex()
+    : partition(nullptr), slotSize(0), activeSlot(-1), nextSequence(1), mapped(nullptr), mapHandle(0),
+      deltaCount(0), cardCount(0), batching(false), unsavedCount(0), stats() {
+    memset(&header, 0, sizeof(header));
+}
+
+FlashCardIndex::~FlashCardIndex() {
+    unmap();
+}
+
+bool FlashCardIndex::parseUid(const String& uid, IndexRecord& record) {
+    return CardIndexFormat::parseUid(uid.c_str(), uid.length(), record);
+}
+
+String FlashCardIndex::uidString(const IndexRecord& record) {
+    uint8_t bytes[MAX_UID_LENGTH];
+    memcpy(bytes, record.uid, sizeof(bytes));
+    return Utils::uidToString(bytes, record.uidLength);
+}
+
+const IndexRecord* FlashCardIndex::imageRecords() const {
+    return mapped != nullptr ? (const IndexRecord*)(mapped + header.recordsOffset) : nullptr;
+}
+
+const char* FlashCardIndex::imageGroups(const IndexRecord& record) const {
+    if (record.groupsOffset == NO_GROUPS || record.groupsOffset >= header.stringsSize) {
+        return nullptr;
+    }
+    return (const char*)(mapped + header.stringsOffset + record.groupsOffset);
+}
+
+bool FlashCardIndex::mapSlot(int slot) {
+    unmap();
+    const void* pointer = nullptr;
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_err_t err = esp_partition_mmap(partition, slotOffset(slot, partition->size), slotSize,
+                                       ESP_PARTITION_MMAP_DATA, &pointer, &mapHandle);
+#else
+    esp_err_t err = esp_partition_mmap(partition, slotOffset(slot, partition->size), slotSize,
+                                       SPI_FLASH_MMAP_DATA, &pointer, &mapHandle);
+#endif
+    if (err != ESP_OK) {
+        Serial.println("Card Index: Failed to map image slot");
+        return false;
+    }
+    mapped = (const uint8_t*)pointer;
+    return true;
+}
+
+void FlashCardIndex::unmap() {
+    if (mapped != nullptr) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+        esp_partition_munmap(mapHandle);
+#else
+        spi_flash_munmap(mapHandle);
+#endif
+        mapped = nullptr;
+    }
+}
+
+void FlashCardIndex::loadImage() {
+    ImageHeader headers[2];
+    bool valid[2];
+    for (int slot = 0; slot < 2; slot++) {
+        valid[slot] = esp_partition_read(partition, slotOffset(slot, partition->size),
+                                         &headers[slot], sizeof(ImageHeader)) == ESP_OK &&
+                      isValidHeader(headers[slot], slotSize);
+        if (valid[slot] && (int32_t)(headers[slot].sequence - nextSequence) >= 0) {
+            nextSequence = headers[slot].sequence + 1;
+        }
+    }
+
+    // 先尝试序号较大的槽，数据CRC错误时退回另一个
+    int order[2] = {0, 1};
+    if (valid[0] && valid[1] && (int32_t)(headers[1].sequence - headers[0].sequence) > 0) {
+        order[0] = 1;
+        order[1] = 0;
+    }
+    for (int i = 0; i < 2; i++) {
+        int slot = order[i];
+        if (!valid[slot] || !mapSlot(slot)) {
+            continue;
+        }
+        const ImageHeader& candidate = headers[slot];
+        if (crc32(mapped + candidate.recordsOffset, candidate.recordCount * sizeof(IndexRecord)) ==
+                candidate.recordsCrc &&
+            crc32(mapped + candidate.stringsOffset, candidate.stringsSize) == candidate.stringsCrc) {
+            activeSlot = slot;
+            header = candidate;
+            return;
+        }
+        Serial.printf("Card Index: Image in slot %d corrupt\n", slot);
+        unmap();
+    }
+
+    activeSlot = -1;
+    memset(&header, 0, sizeof(header));
+}
+
+void FlashCardIndex::replayDeltas() {
+    deltaCount = DELTA_CAPACITY;
+    for (size_t i = 0; i < DELTA_CAPACITY; i++) {
+        DeltaRecord delta;
+        if (esp_partition_read(partition, i * DELTA_RECORD_SIZE, &delta, sizeof(delta)) != ESP_OK) {
+            break;
+        }
+        if (delta.magic == ERASED_WORD) {
+            deltaCount = i;
+            break;
+        }
+        // 写入中断的记录和属于旧映像的记录（映像已重写但日志未清空）跳过
+        if (delta.magic == DELTA_MAGIC && delta.crc == deltaCrc(delta) && delta.baseSequence == header.sequence) {
+            applyDelta(delta);
+        }
+    }
+}
+
+bool FlashCardIndex::begin() {
+    if (partition != nullptr) {
+        return true;
+    }
+
+    unsigned long start = millis();
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)PARTITION_SUBTYPE,
+                                         PARTITION_LABEL);
+    if (partition == nullptr) {
+        Serial.println("Card Index: Partition 'cardidx' not found");
+        return false;
+    }
+    slotSize = CardIndexFormat::slotSize(partition->size);
+    if (slotSize == 0) {
+        Serial.println("Card Index: Partition too small");
+        partition = nullptr;
+        return false;
+    }
+
+    loadImage();
+    cardCount = header.recordCount;
+    replayDeltas();
+
+    Serial.printf("Card Index: %u cards (image %u + %u changes) in %lu ms\n", (unsigned)cardCount,
+                  (unsigned)header.recordCount, (unsigned)deltaCount, millis() - start);
+    return true;
+}
+
+const IndexRecord* FlashCardIndex::findInImage(const IndexRecord& key) {
+    const IndexRecord* records = imageRecords();
+    if (records == nullptr) {
+        return nullptr;
+    }
+    size_t low = 0;
+    size_t high = header.recordCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        const IndexRecord& record = records[middle];
+        stats.probes++;
+        int order = compareUid(record.uid, record.uidLength, key.uid, key.uidLength);
+        if (order == 0) {
+            return &record;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return nullptr;
+}
+
+FlashCardIndex::OverlayEntry* FlashCardIndex::findInOverlay(const IndexRecord& key, size_t& position) {
+    size_t low = 0;
+    size_t high = overlay.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        const IndexRecord& record = overlay[middle].record;
+        int order = compareUid(record.uid, record.uidLength, key.uid, key.uidLength);
+        if (order == 0) {
+            position = middle;
+            return &overlay[middle];
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    position = low;
+    return nullptr;
+}
+
+bool FlashCardIndex::lookup(IndexRecord& record, String* groups, bool& hasGroups) {
+    stats.lookups++;
+    size_t position;
+    OverlayEntry* entry = findInOverlay(record, position);
+    if (entry != nullptr) {
+        stats.overlayHits++;
+        if (entry->removed) {
+            return false;
+        }
+        record = entry->record;
+        hasGroups = entry->hasGroups;
+        if (groups != nullptr && hasGroups) {
+            *groups = entry->groups;
+        }
+        return true;
+    }
+
+    const IndexRecord* found = findInImage(record);
+    if (found == nullptr) {
+        return false;
+    }
+    record = *found;
+    const char* imageGroupList = imageGroups(*found);
+    hasGroups = imageGroupList != nullptr;
+    if (groups != nullptr && hasGroups) {
+        *groups = imageGroupList;
+    }
+    return true;
+}
+
+void FlashCardIndex::applyDelta(const DeltaRecord& delta) {
+    IndexRecord record;
+    memset(&record, 0, sizeof(record));
+    memcpy(record.uid, delta.uid, sizeof(record.uid));
+    record.uidLength = delta.uidLength;
+    memcpy(record.key, delta.key, sizeof(record.key));
+    record.flags = delta.flags;
+    record.groupsOffset = NO_GROUPS;
+    if (record.uidLength == 0 || record.uidLength > MAX_UID_LENGTH) {
+        return;
+    }
+
+    size_t position;
+    OverlayEntry* entry = findInOverlay(record, position);
+    bool existed = entry != nullptr ? !entry->removed : findInImage(record) != nullptr;
+    if (entry == nullptr) {
+        overlay.insert(overlay.begin() + position, OverlayEntry());
+        entry = &overlay[position];
+    }
+
+    entry->record = record;
+    entry->removed = delta.op == DELTA_REMOVE;
+    entry->hasGroups = !entry->removed && delta.groupsLength != 0xFF;
+    entry->groups = "";
+    if (entry->hasGroups) {
+        size_t length = delta.groupsLength < MAX_DELTA_GROUPS_LENGTH ? delta.groupsLength : MAX_DELTA_GROUPS_LENGTH;
+        char buffer[MAX_DELTA_GROUPS_LENGTH + 1];
+        memcpy(buffer, delta.groups, length);
+        buffer[length] = '\0';
+        entry->groups = buffer;
+    }
+
+    if (entry->removed && existed && cardCount > 0) {
+        cardCount--;
+    } else if (!entry->removed && !existed) {
+        cardCount++;
+    }
+}
+
+bool FlashCardIndex::appendDelta(DeltaRecord& delta) {
+    if (partition == nullptr) {
+        return false;
+    }
+    if (batching) {
+        // 批量修改只更新覆盖表，endBatch时一次写入映像
+        applyDelta(delta);
+        unsavedCount++;
+        return overlay.size() < BATCH_OVERLAY_LIMIT || compact();
+    }
+    if (deltaCount >= DELTA_CAPACITY && !compact()) {
+        return false;
+    }
+
+    delta.magic = DELTA_MAGIC;
+    delta.baseSequence = header.sequence;
+    delta.crc = deltaCrc(delta);
+    if (esp_partition_write(partition, deltaCount * DELTA_RECORD_SIZE, &delta, sizeof(delta)) != ESP_OK) {
+        Serial.println("Card Index: Failed to write change log");
+        return false;
+    }
+    deltaCount++;
+    applyDelta(delta);
+    return true;
+}
+
+bool FlashCardIndex::writeState(const IndexRecord& record, const char* groups) {
+    DeltaRecord delta;
+    memset(&delta, 0, sizeof(delta));
+    delta.op = DELTA_UPSERT;
+    memcpy(delta.uid, record.uid, sizeof(delta.uid));
+    delta.uidLength = record.uidLength;
+    memcpy(delta.key, record.key, sizeof(delta.key));
+    delta.flags = record.flags;
+    delta.groupsLength = 0xFF;
+    if (groups != nullptr) {
+        size_t length = strlen(groups);
+        if (length > MAX_DELTA_GROUPS_LENGTH) {
+            Serial.println("Card Index: Group list too long");
+            return false;
+        }
+        delta.groupsLength = length;
+        memcpy(delta.groups, groups, length);
+    }
+    return appendDelta(delta);
+}
+
+void FlashCardIndex::merge(const std::function<bool(const IndexRecord& record, const char* groups)>& callback,
+                           const IndexRecord* after) {
+    const IndexRecord* records = imageRecords();
+    size_t imageCount = records != nullptr ? header.recordCount : 0;
+    size_t i = 0;
+    size_t j = 0;
+    if (after != nullptr) {
+        // 两边都定位到第一个大于after的记录
+        size_t high = imageCount;
+        while (i < high) {
+            size_t middle = i + (high - i) / 2;
+            if (compareUid(records[middle].uid, records[middle].uidLength, after->uid, after->uidLength) <= 0) {
+                i = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (findInOverlay(*after, j) != nullptr) {
+            j++;
+        }
+    }
+    while (i < imageCount || j < overlay.size()) {
+        int order;
+        if (i >= imageCount) {
+            order = 1;
+        } else if (j >= overlay.size()) {
+            order = -1;
+        } else {
+            order = compareUid(records[i].uid, records[i].uidLength,
+                               overlay[j].record.uid, overlay[j].record.uidLength);
+        }
+
+        if (order < 0) {
+            if (!callback(records[i], imageGroups(records[i]))) {
+                return;
+            }
+            i++;
+            continue;
+        }
+
+        // 覆盖表中的状态替代映像中的同一张卡片
+        const OverlayEntry& entry = overlay[j];
+        if (order == 0) {
+            i++;
+        }
+        j++;
+        if (!entry.removed && !callback(entry.record, entry.hasGroups ? entry.groups.c_str() : nullptr)) {
+            return;
+        }
+    }
+}
+
+bool FlashCardIndex::compact(bool empty) {
+    unsigned long start = millis();
+    int target = activeSlot == 0 ? 1 : 0;
+    uint32_t base = slotOffset(target, partition->size);
+
+    // 第一遍统计记录数和字符串区大小
+    ImageHeader next;
+    memset(&next, 0, sizeof(next));
+    uint32_t stringsSize = 0;
+    if (!empty) {
+        merge([&](const IndexRecord&, const char* groups) {
+            next.recordCount++;
+            if (groups != nullptr) {
+                stringsSize += strlen(groups) + 1;
+            }
+            return true;
+        });
+    }
+    uint32_t imageSize = layoutImage(next, next.recordCount, stringsSize);
+    if (imageSize > slotSize) {
+        Serial.println("Card Index: Image does not fit in partition");
+        return false;
+    }
+
+    uint32_t eraseSize = (imageSize + SECTOR_SIZE - 1) & ~(SECTOR_SIZE - 1);
+    if (esp_partition_erase_range(partition, base, eraseSize) != ESP_OK) {
+        Serial.println("Card Index: Failed to erase image slot");
+        return false;
+    }
+
+    // 第二遍顺序写入记录和字符串，文件头最后写入
+    IndexRecord recordBuffer[RECORD_BUFFER_COUNT];
+    char stringBuffer[STRING_BUFFER_SIZE];
+    size_t recordBuffered = 0;
+    size_t stringBuffered = 0;
+    uint32_t recordsWritten = 0;
+    uint32_t stringsWritten = 0;
+    bool success = true;
+
+    auto flushRecords = [&]() {
+        if (recordBuffered > 0) {
+            size_t bytes = recordBuffered * sizeof(IndexRecord);
+            success = success && esp_partition_write(partition, base + next.recordsOffset + recordsWritten,
+                                                     recordBuffer, bytes) == ESP_OK;
+            next.recordsCrc = crc32(recordBuffer, bytes, next.recordsCrc);
+            recordsWritten += bytes;
+            recordBuffered = 0;
+        }
+    };
+    auto flushStrings = [&]() {
+        if (stringBuffered > 0) {
+            success = success && esp_partition_write(partition, base + next.stringsOffset + stringsWritten,
+                                                     stringBuffer, stringBuffered) == ESP_OK;
+            next.stringsCrc = crc32(stringBuffer, stringBuffered, next.stringsCrc);
+            stringsWritten += stringBuffered;
+            stringBuffered = 0;
+        }
+    };
+
+    if (!empty) {
+        uint32_t stringOffset = 0;
+        merge([&](const IndexRecord& record, const char* groups) {
+            IndexRecord& out = recordBuffer[recordBuffered++];
+            out = record;
+            out.reserved = 0;
+            out.groupsOffset = NO_GROUPS;
+            if (groups != nullptr) {
+                out.groupsOffset = stringOffset;
+                size_t length = strlen(groups) + 1;
+                for (size_t k = 0; k < length; k++) {
+                    stringBuffer[stringBuffered++] = groups[k];
+                    if (stringBuffered == STRING_BUFFER_SIZE) {
+                        flushStrings();
+                    }
+                }
+                stringOffset += length;
+            }
+            if (recordBuffered == RECORD_BUFFER_COUNT) {
+                flushRecords();
+            }
+            return success;
+        });
+        flushRecords();
+        flushStrings();
+    }
+
+    if (success) {
+        sealHeader(next, nextSequence);
+        success = esp_partition_write(partition, base, &next, sizeof(next)) == ESP_OK;
+    }
+    if (!success) {
+        Serial.println("Card Index: Failed to write image, previous image kept");
+        return false;
+    }
+
+    // 新映像生效后清空变更日志（中途复位时旧记录的序号不匹配，会被跳过）
+    nextSequence++;
+    esp_partition_erase_range(partition, 0, DELTA_REGION_SIZE);
+    deltaCount = 0;
+    unsavedCount = 0;
+    overlay.clear();
+    overlay.shrink_to_fit();
+    if (!mapSlot(target)) {
+        activeSlot = -1;
+        memset(&header, 0, sizeof(header));
+        return false;
+    }
+    activeSlot = target;
+    header = next;
+    cardCount = next.recordCount;
+    stats.compactions++;
+
+    Serial.printf("Card Index: Wrote image with %u cards to slot %d in %lu ms\n",
+                  (unsigned)next.recordCount, target, millis() - start);
+    return true;
+}
+
+bool FlashCardIndex::find(const String& uid, uint8_t* key, bool& hasKey) {
+    IndexRecord record;
+    bool hasGroups;
+    if (!parseUid(uid, record) || !lookup(record, nullptr, hasGroups)) {
+        return false;
+    }
+    hasKey = (record.flags & FLAG_HAS_KEY) != 0;
+    if (hasKey && key != nullptr) {
+        memcpy(key, record.key, KEY_SIZE);
+    }
+    return true;
+}
+
+bool FlashCardIndex::contains(const String& uid) {
+    IndexRecord record;
+    bool hasGroups;
+    return parseUid(uid, record) && lookup(record, nullptr, hasGroups);
+}
+
+bool FlashCardIndex::put(const String& uid, const uint8_t* key) {
+    IndexRecord record;
+    if (!parseUid(uid, record)) {
+        return false;
+    }
+    String groups;
+    bool hasGroups = false;
+    if (!lookup(record, &groups, hasGroups)) {
+        hasGroups = false;
+    }
+    record.flags = 0;
+    memset(record.key, 0, sizeof(record.key));
+    if (key != nullptr) {
+        record.flags |= FLAG_HAS_KEY;
+        memcpy(record.key, key, KEY_SIZE);
+    }
+    return writeState(record, hasGroups ? groups.c_str() : nullptr);
+}
+
+bool FlashCardIndex::remove(const String& uid) {
+    IndexRecord record;
+    bool hasGroups;
+    if (!parseUid(uid, record) || !lookup(record, nullptr, hasGroups)) {
+        return false;
+    }
+    DeltaRecord delta;
+    memset(&delta, 0, sizeof(delta));
+    delta.op = DELTA_REMOVE;
+    memcpy(delta.uid, record.uid, sizeof(delta.uid));
+    delta.uidLength = record.uidLength;
+    delta.groupsLength = 0xFF;
+    return appendDelta(delta);
+}
+
+bool FlashCardIndex::getGroups(const String& uid, String& groups) {
+    IndexRecord record;
+    bool hasGroups = false;
+    return parseUid(uid, record) && lookup(record, &groups, hasGroups) && hasGroups;
+}
+
+bool FlashCardIndex::setGroups(const String& uid, const char* groups) {
+    IndexRecord record;
+    bool hasGroups;
+    if (!parseUid(uid, record) || !lookup(record, nullptr, hasGroups)) {
+        return false;
+    }
+    return writeState(record, groups);
+}
+
+void FlashCardIndex::forEach(const Visitor& visitor) {
+    merge([&visitor](const IndexRecord& record, const char*) {
+        return visitor(uidString(record), record.key, (record.flags & FLAG_HAS_KEY) != 0);
+    });
+}
+
+void FlashCardIndex::forEachAfter(const String& after, const Visitor& visitor) {
+    IndexRecord key;
+    if (after.length() == 0 || !parseUid(after, key)) {
+        forEach(visitor);
+        return;
+    }
+    merge([&visitor](const IndexRecord& record, const char*) {
+        return visitor(uidString(record), record.key, (record.flags & FLAG_HAS_KEY) != 0);
+    }, &key);
+}
+
+bool FlashCardIndex::eraseAll() {
+    return partition != nullptr && compact(true);
+}
+
+bool FlashCardIndex::compactNow() {
+    if (partition == nullptr) {
+        return false;
+    }
+    return (deltaCount == 0 && unsavedCount == 0) || compact();
+}
+
+void FlashCardIndex::beginBatch() {
+    batching = true;
+}
+
+bool FlashCardIndex::endBatch() {
+    if (!batching) {
+        return true;
+    }
+    batching = false;
+    return partition == nullptr || unsavedCount == 0 || compact();
+}
+
+size_t FlashCardIndex::getCount() const {
+    return cardCount;
+}
+
+FlashCardIndex::Stats FlashCardIndex::getStats() const {
+    return stats;
+}
+
+void FlashCardIndex::printStats() const {
+    Serial.println("=== Card Store (flash index) ===");
+    Serial.printf("Cards: %u (image %u, slot %d, sequence %u)\n", (unsigned)cardCount,
+                  (unsigned)header.recordCount, activeSlot, (unsigned)header.sequence);
+    Serial.printf("Image size: %u of %u bytes\n",
+                  (unsigned)(header.stringsOffset + header.stringsSize), (unsigned)slotSize);
+    Serial.printf("Change log: %u of %u records, overlay %u entries (%u unsaved)\n",
+                  (unsigned)deltaCount, (unsigned)DELTA_CAPACITY, (unsigned)overlay.size(), (unsigned)unsavedCount);
+    Serial.printf("Lookups: %lu, overlay hits: %lu, image probes: %lu\n",
+                  stats.lookups, stats.overlayHits, stats.probes);
+    Serial.printf("Compactions: %lu\n", stats.compactions);
+    Serial.println("================================");
+}
+
+const char* FlashCardIndex::getName() const {
+    return "index";
+}
@@ -0,0 +1,191 @@
+#ifndef FLASHCARDINDEX_H
+#define FLASHCARDINDEX_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <esp_idf_version.h>
+#include <vector>
+#include <functional>
+#include "CardIndexFormat.h"
+#include "../interfaces/ICardStore.h"
+
+/**
+ * 闪存卡片索引
+ * 卡片保存为cardidx分区中预先排序的索引映像（格式见CardIndexFormat.h），
+ * 启动时只检查文件头和CRC，然后通过esp_partition_mmap把映像映射到地址空间，
+ * 查找直接在映射的闪存上二分查找，不需要解析，也不占用与卡片数量成正比的内存
+ *
+ * 管理操作（注册、删除、设置组）追加到变更日志，同时记录在内存中的小覆盖表里，
+ * 查找时先查覆盖表；变更日志写满时合并映像和覆盖表，写入另一个槽（增量重建，
+ * 只顺序读写一遍映像），之后清空变更日志
+ * 映像可以由主机工具生成后直接烧录（tools/cardindex.cpp）
+ */
+class FlashCardIndex : public ICardStore {
+public:
+    // 统计信息
+    struct Stats {
+        unsigned long lookups;      // 查找次数
+        unsigned long overlayHits;  // 在覆盖表中找到的次数
+        unsigned long probes;       // 映像二分查找的比较次数
+        unsigned long compactions;  // 映像重写次数
+    };
+
+private:
+    // 覆盖表条目：卡片的最新状态
+    struct OverlayEntry {
+        CardIndexFormat::IndexRecord record;
+        bool removed;
+        bool hasGroups;
+        String groups;
+    };
+
+    const esp_partition_t* partition;
+    uint32_t slotSize;
+    int activeSlot;                          // 当前映像槽，-1表示没有映像
+    CardIndexFormat::ImageHeader header;     // 当前映像文件头（没有映像时全零）
+    uint32_t nextSequence;                   // 下一个映像的序号（大于见过的所有有效文件头）
+    const uint8_t* mapped;                   // 映射的当前映像槽
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_partition_mmap_handle_t mapHandle;
+#else
+    spi_flash_mmap_handle_t mapHandle;
+#endif
+
+    std::vector<OverlayEntry> overlay;       // 按UID排序
+    size_t deltaCount;                       // 变更日志中已使用的记录数
+    size_t cardCount;
+    bool batching;                           // 批量修改期间不写变更日志
+    size_t unsavedCount;                     // 只在覆盖表中的修改数
+    Stats stats;
+
+    /**
+     * 把UID字符串转换为记录中的UID字段
+     * @return UID是否有效
+     */
+    static bool parseUid(const String& uid, CardIndexFormat::IndexRecord& record);
+
+    static String uidString(const CardIndexFormat::IndexRecord& record);
+
+    const CardIndexFormat::IndexRecord* imageRecords() const;
+    const char* imageGroups(const CardIndexFormat::IndexRecord& record) const;
+
+    /**
+     * 在映像中二分查找
+     * @return 记录指针，不存在为nullptr
+     */
+    const CardIndexFormat::IndexRecord* findInImage(const CardIndexFormat::IndexRecord& key);
+
+    /**
+     * 在覆盖表中查找
+     * @param position 输出条目位置或插入位置
+     * @return 条目指针，不存在为nullptr
+     */
+    OverlayEntry* findInOverlay(const CardIndexFormat::IndexRecord& key, size_t& position);
+
+    /**
+     * 按UID顺序合并映像和覆盖表（跳过已删除的卡片）
+     * @param callback 回调，groups为nullptr表示不受限制，返回false时停止
+     * @param after 从此UID之后开始（二分查找定位），nullptr从头开始
+     */
+    void merge(const std::function<bool(const CardIndexFormat::IndexRecord& record, const char* groups)>& callback,
+               const CardIndexFormat::IndexRecord* after = nullptr);
+
+    /**
+     * 查找卡片的当前状态
+     * @param record 输入UID，输出卡片记录
+     * @param groups 输出访问组（可以为nullptr）
+     * @param hasGroups 输出是否有访问组
+     * @return 是否已注册
+     */
+    bool lookup(CardIndexFormat::IndexRecord& record, String* groups, bool& hasGroups);
+
+    /**
+     * 映射映像槽
+     */
+    bool mapSlot(int slot);
+    void unmap();
+
+    /**
+     * 选择并映射有效的最新映像
+     */
+    void loadImage();
+
+    /**
+     * 重放变更日志到覆盖表
+     */
+    void replayDeltas();
+
+    /**
+     * 更新覆盖表中的条目（并维护卡片数量）
+     */
+    void applyDelta(const CardIndexFormat::DeltaRecord& delta);
+
+    /**
+     * 追加变更记录（日志满时先重写映像）
+     * @return 是否成功
+     */
+    bool appendDelta(CardIndexFormat::DeltaRecord& delta);
+
+    /**
+     * 合并映像和覆盖表，写入另一个槽并清空变更日志
+     * @param empty 是否写入空映像（删除所有卡片）
+     * @return 是否成功
+     */
+    bool compact(bool empty = false);
+
+    /**
+     * 写入卡片的完整状态
+     */
+    bool writeState(const CardIndexFormat::IndexRecord& record, const char* groups);
+
+public:
+    /**
+     * 构造函数
+     */
+    FlashCardIndex();
+
+    /**
+     * 析构函数
+     */
+    ~FlashCardIndex();
+
+    /**
+     * 查找分区，映射最新的有效映像并重放变更日志
+     * @return 是否成功（分区不存在时失败）
+     */
+    bool begin() override;
+
+    bool find(const String& uid, uint8_t* key, bool& hasKey) override;
+    bool contains(const String& uid) override;
+    bool put(const String& uid, const uint8_t* key) override;
+    bool remove(const String& uid) override;
+    bool getGroups(const String& uid, String& groups) override;
+    bool setGroups(const String& uid, const char* groups) override;
+    void forEach(const Visitor& visitor) override;
+    void forEachAfter(const String& after, const Visitor& visitor) override;
+    bool eraseAll() override;
+    size_t getCount() const override;
+    void printStats() const override;
+
+    /**
+     * 批量修改期间修改只记录在覆盖表中，结束时合并写入映像（一次顺序写入，
+     * 不逐条写变更日志）；覆盖表超过上限时提前重写
+     */
+    void beginBatch() override;
+    bool endBatch() override;
+    const char* getName() const override;
+
+    /**
+     * 立即把变更日志合并到映像
+     * @return 是否成功
+     */
+    bool compactNow();
+
+    /**
+     * 获取统计信息
+     * @return 统计信息
+     */
+    Stats getStats() const;
+};
+
+#endif // FLASHCARDINDEX_H
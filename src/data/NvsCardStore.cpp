@@ -0,0 +1,396 @@
+#include "NvsCardStore.h"
+#include <nvs_flash.h>
+#include <esp_idf_version.h>
+
+const char* NvsCardStore::PARTITION_LABEL = "cardkv";
+const char* NvsCardStore::NAMESPACE = "cards";
+const char* NvsCardStore::COUNT_KEY = "count";
+
+NvsCardStore::NvsCardStore(const char* nvsNamespace)
+    : nvsNamespace(nvsNamespace ? nvsNamespace : NAMESPACE), partition(PARTITION_LABEL),
+      handle(0), opened(false), cardCount(0), batching(false), countDirty(false), useCounter(0), stats(),
+      resumeIterator(nullptr) {
+    memset(cache, 0, sizeof(cache));
+}
+
+NvsCardStore::~NvsCardStore() {
+    releaseResume();
+    if (opened) {
+        nvs_close(handle);
+    }
+}
+
+bool NvsCardStore::begin() {
+    if (opened) {
+        return true;
+    }
+
+    unsigned long start = millis();
+
+    // 挂载专用分区（挂载时NVS在内存中建立条目索引，耗时与条目数成正比）
+    partition = PARTITION_LABEL;
+    esp_err_t err = nvs_flash_init_partition(PARTITION_LABEL);
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        Serial.println("Card Store: Partition format changed, erasing");
+        nvs_flash_erase_partition(PARTITION_LABEL);
+        err = nvs_flash_init_partition(PARTITION_LABEL);
+    }
+    if (err != ESP_OK) {
+        Serial.println("Card Store: Partition 'cardkv' not available, using default NVS partition");
+        partition = NVS_DEFAULT_PART_NAME;
+    }
+
+    if (nvs_open_from_partition(partition, nvsNamespace, NVS_READWRITE, &handle) != ESP_OK) {
+        Serial.println("Card Store: Failed to open namespace");
+        return false;
+    }
+    opened = true;
+
+    uint32_t count = 0;
+    if (nvs_get_u32(handle, COUNT_KEY, &count) == ESP_OK) {
+        cardCount = count;
+    } else {
+        cardCount = recount();
+        saveCount();
+    }
+
+    Serial.printf("Card Store: %u cards in '%s' (opened in %lu ms)\n",
+                  (unsigned)cardCount, partition, millis() - start);
+    return true;
+}
+
+bool NvsCardStore::isValidUid(const String& uid) {
+    // NVS键最长15个字符，组键为"g" + UID
+    return uid.length() > 0 && uid.length() <= MAX_UID_LENGTH * 2 && uid.length() % 2 == 0;
+}
+
+String NvsCardStore::groupsKey(const String& uid) {
+    return "g" + uid;
+}
+
+uint64_t NvsCardStore::encodeValue(const uint8_t* key) {
+    uint64_t value = VALUE_PRESENT;
+    if (key != nullptr) {
+        value |= VALUE_HAS_KEY;
+        for (int i = 0; i < Utils::KEY_SIZE; i++) {
+            value |= (uint64_t)key[i] << (8 * (Utils::KEY_SIZE - 1 - i));
+        }
+    }
+    return value;
+}
+
+void NvsCardStore::decodeKey(uint64_t value, uint8_t* key) {
+    for (int i = 0; i < Utils::KEY_SIZE; i++) {
+        key[i] = (uint8_t)(value >> (8 * (Utils::KEY_SIZE - 1 - i)));
+    }
+}
+
+uint64_t NvsCardStore::lookup(const String& uid) {
+    stats.lookups++;
+    for (size_t i = 0; i < HOT_CACHE_SIZE; i++) {
+        if (cache[i].valid && uid == cache[i].uid) {
+            cache[i].lastUse = ++useCounter;
+            stats.cacheHits++;
+            return cache[i].value;
+        }
+    }
+
+    uint64_t value = 0;
+    if (opened && isValidUid(uid)) {
+        stats.nvsReads++;
+        if (nvs_get_u64(handle, uid.c_str(), &value) != ESP_OK) {
+            value = 0;
+        }
+    }
+    cachePut(uid, value);
+    return value;
+}
+
+void NvsCardStore::cachePut(const String& uid, uint64_t value) {
+    if (!isValidUid(uid)) {
+        return;
+    }
+
+    // 已缓存的直接更新，否则替换最久未使用的条目
+    size_t slot = 0;
+    for (size_t i = 0; i < HOT_CACHE_SIZE; i++) {
+        if (cache[i].valid && uid == cache[i].uid) {
+            slot = i;
+            break;
+        }
+        if (!cache[i].valid || cache[i].lastUse < cache[slot].lastUse) {
+            slot = i;
+        }
+    }
+
+    CacheEntry& entry = cache[slot];
+    strncpy(entry.uid, uid.c_str(), sizeof(entry.uid) - 1);
+    entry.uid[sizeof(entry.uid) - 1] = '\0';
+    entry.value = value;
+    entry.lastUse = ++useCounter;
+    entry.valid = true;
+}
+
+size_t NvsCardStore::recount() {
+    size_t count = 0;
+    forEach([&count](const String&, const uint8_t*, bool) {
+        count++;
+        return true;
+    });
+    return count;
+}
+
+bool NvsCardStore::saveCount() {
+    return nvs_set_u32(handle, COUNT_KEY, (uint32_t)cardCount) == ESP_OK;
+}
+
+bool NvsCardStore::commit(bool countChanged) {
+    if (batching) {
+        countDirty = countDirty || countChanged;
+        return true;
+    }
+    return (!countChanged || saveCount()) && nvs_commit(handle) == ESP_OK;
+}
+
+bool NvsCardStore::find(const String& uid, uint8_t* key, bool& hasKey) {
+    uint64_t value = lookup(uid);
+    if (value == 0) {
+        return false;
+    }
+    hasKey = (value & VALUE_HAS_KEY) != 0;
+    if (hasKey && key != nullptr) {
+        decodeKey(value, key);
+    }
+    return true;
+}
+
+bool NvsCardStore::contains(const String& uid) {
+    return lookup(uid) != 0;
+}
+
+bool NvsCardStore::put(const String& uid, const uint8_t* key) {
+    if (!opened || !isValidUid(uid)) {
+        return false;
+    }
+
+    bool existed = lookup(uid) != 0;
+    uint64_t value = encodeValue(key);
+    stats.writes++;
+    if (nvs_set_u64(handle, uid.c_str(), value) != ESP_OK) {
+        Serial.println("Card Store: Write failed (partition full?)");
+        return false;
+    }
+    if (!existed) {
+        cardCount++;
+    }
+    cachePut(uid, value);
+    return commit(!existed);
+}
+
+bool NvsCardStore::remove(const String& uid) {
+    if (!opened || lookup(uid) == 0) {
+        return false;
+    }
+
+    stats.writes++;
+    if (nvs_erase_key(handle, uid.c_str()) != ESP_OK) {
+        return false;
+    }
+    nvs_erase_key(handle, groupsKey(uid).c_str());
+    if (cardCount > 0) {
+        cardCount--;
+    }
+    cachePut(uid, 0);
+    return commit(true);
+}
+
+bool NvsCardStore::getGroups(const String& uid, String& groups) {
+    if (!opened || !isValidUid(uid)) {
+        return false;
+    }
+
+    String key = groupsKey(uid);
+    size_t length = 0;
+    if (nvs_get_str(handle, key.c_str(), nullptr, &length) != ESP_OK) {
+        return false;
+    }
+    char* buffer = (char*)malloc(length);
+    if (buffer == nullptr) {
+        return false;
+    }
+    bool found = nvs_get_str(handle, key.c_str(), buffer, &length) == ESP_OK;
+    if (found) {
+        groups = buffer;
+    }
+    free(buffer);
+    return found;
+}
+
+bool NvsCardStore::setGroups(const String& uid, const char* groups) {
+    if (!opened || !isValidUid(uid)) {
+        return false;
+    }
+
+    String key = groupsKey(uid);
+    stats.writes++;
+    esp_err_t err;
+    if (groups == nullptr) {
+        err = nvs_erase_key(handle, key.c_str());
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    } else {
+        err = nvs_set_str(handle, key.c_str(), groups);
+    }
+    return err == ESP_OK && commit(false);
+}
+
+nvs_iterator_t NvsCardStore::firstEntry() const {
+    // 只遍历64位整数条目（卡片），跳过组和数量条目
+#if ESP_IDF_VERSION_MAJOR >= 5
+    nvs_iterator_t it = nullptr;
+    if (nvs_entry_find(partition, nvsNamespace, NVS_TYPE_U64, &it) != ESP_OK) {
+        nvs_release_iterator(it);
+        return nullptr;
+    }
+    return it;
+#else
+    return nvs_entry_find(partition, nvsNamespace, NVS_TYPE_U64);
+#endif
+}
+
+nvs_iterator_t NvsCardStore::nextEntry(nvs_iterator_t it) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    if (nvs_entry_next(&it) != ESP_OK) {
+        nvs_release_iterator(it);
+        return nullptr;
+    }
+    return it;
+#else
+    return nvs_entry_next(it);
+#endif
+}
+
+void NvsCardStore::visitFrom(nvs_iterator_t& it, const Visitor& visitor) {
+    while (it != nullptr) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        uint64_t value = 0;
+        // 条目在两段之间被删除时读取失败，直接跳过
+        if (nvs_get_u64(handle, info.key, &value) == ESP_OK) {
+            uint8_t key[Utils::KEY_SIZE];
+            decodeKey(value, key);
+            if (!visitor(String(info.key), key, (value & VALUE_HAS_KEY) != 0)) {
+                return;
+            }
+        }
+        it = nextEntry(it);
+    }
+}
+
+void NvsCardStore::releaseResume() {
+    if (resumeIterator != nullptr) {
+        nvs_release_iterator(resumeIterator);
+        resumeIterator = nullptr;
+    }
+    resumeAfter = "";
+}
+
+void NvsCardStore::forEach(const Visitor& visitor) {
+    if (!opened) {
+        return;
+    }
+
+    nvs_iterator_t it = firstEntry();
+    visitFrom(it, visitor);
+    if (it != nullptr) {
+        nvs_release_iterator(it);
+    }
+}
+
+void NvsCardStore::forEachAfter(const String& after, const Visitor& visitor) {
+    if (!opened) {
+        return;
+    }
+
+    if (resumeIterator == nullptr || after.length() == 0 || after != resumeAfter) {
+        // 不是上一段的延续：从头扫描条目名称定位（不读取值）
+        releaseResume();
+        resumeIterator = firstEntry();
+        bool found = after.length() == 0;
+        while (resumeIterator != nullptr && !found) {
+            nvs_entry_info_t info;
+            nvs_entry_info(resumeIterator, &info);
+            found = after == info.key;
+            resumeIterator = nextEntry(resumeIterator);
+        }
+    }
+
+    // 记录最后一个被接受的UID，调用者下一段会从它之后继续
+    String lastAccepted = after;
+    visitFrom(resumeIterator, [&](const String& uid, const uint8_t* key, bool hasKey) {
+        if (!visitor(uid, key, hasKey)) {
+            return false;
+        }
+        lastAccepted = uid;
+        return true;
+    });
+    resumeAfter = resumeIterator != nullptr ? lastAccepted : String();
+}
+
+bool NvsCardStore::eraseAll() {
+    if (!opened) {
+        return false;
+    }
+    stats.writes++;
+    memset(cache, 0, sizeof(cache));
+    releaseResume();
+    cardCount = 0;
+    return nvs_erase_all(handle) == ESP_OK && saveCount() && nvs_commit(handle) == ESP_OK;
+}
+
+void NvsCardStore::beginBatch() {
+    batching = true;
+}
+
+bool NvsCardStore::endBatch() {
+    if (!batching) {
+        return true;
+    }
+    // 条目已经写入，结束时只写一次卡片数量并提交
+    batching = false;
+    bool success = opened && (!countDirty || saveCount()) && nvs_commit(handle) == ESP_OK;
+    countDirty = false;
+    return success;
+}
+
+size_t NvsCardStore::getCount() const {
+    return cardCount;
+}
+
+NvsCardStore::Stats NvsCardStore::getStats() const {
+    Stats result = stats;
+    result.count = cardCount;
+    return result;
+}
+
+void NvsCardStore::printStats() const {
+    Serial.println("=== Card Store (NVS) ===");
+    Serial.print("Partition: ");
+    Serial.println(partition);
+    Serial.print("Cards: ");
+    Serial.println(cardCount);
+    Serial.print("Lookups: ");
+    Serial.println(stats.lookups);
+    Serial.print("Cache hits: ");
+    Serial.println(stats.cacheHits);
+    Serial.print("NVS reads: ");
+    Serial.println(stats.nvsReads);
+    Serial.print("Writes: ");
+    Serial.println(stats.writes);
+    Serial.println("========================");
+}
+
+const char* NvsCardStore::getName() const {
+    return "nvs";
+}
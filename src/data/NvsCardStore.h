@@ -0,0 +1,163 @@
+#ifndef NVSCARDSTORE_H
+#define NVSCARDSTORE_H
+
+#include <Arduino.h>
+#include <nvs.h>
+#include "../interfaces/ICardStore.h"
+#include "../utils/Utils.h"
+
+/**
+ * NVS按卡片存储
+ * 每张卡片一个NVS条目：键为UID十六进制字符串，值为64位整数（标志位 + 6字节密钥），
+ * 受限卡片另有一个"g<UID>"字符串条目保存访问组名称（逗号分隔）
+ * 查找卡片是一次NVS哈希查找，不需要把整个数据库加载到内存；
+ * 前面有一个小的最近使用卡片缓存（包括未注册的UID），重复刷卡不访问NVS
+ *
+ * 使用专用的cardkv分区（见partitions_nvskv.csv），分区不存在时退回默认nvs分区（容量有限）
+ * 所有修改立即提交，不需要FileSystemManager保存
+ */
+class NvsCardStore : public ICardStore {
+public:
+    // 专用分区标签和命名空间
+    static const char* PARTITION_LABEL;
+    static const char* NAMESPACE;
+
+    // 卡片数量键（不会与UID键冲突）
+    static const char* COUNT_KEY;
+
+    // UID最长7字节（NVS键最长15个字符，组键需要额外的前缀）
+    static const size_t MAX_UID_LENGTH = 7;
+
+    // 最近使用卡片缓存容量
+    static const size_t HOT_CACHE_SIZE = 16;
+
+    // 统计信息
+    struct Stats {
+        unsigned long lookups;      // 查找次数
+        unsigned long cacheHits;    // 缓存命中次数
+        unsigned long nvsReads;     // NVS读取次数
+        unsigned long writes;       // NVS写入次数
+        size_t count;               // 卡片数量
+    };
+
+private:
+    // 值的标志位
+    static const uint64_t VALUE_PRESENT = 1ULL << 63;
+    static const uint64_t VALUE_HAS_KEY = 1ULL << 62;
+
+    struct CacheEntry {
+        char uid[MAX_UID_LENGTH * 2 + 1];
+        uint64_t value;     // 0表示未注册
+        uint32_t lastUse;
+        bool valid;
+    };
+
+    const char* nvsNamespace;
+    const char* partition;
+    nvs_handle_t handle;
+    bool opened;
+    size_t cardCount;
+    bool batching;          // 批量修改期间不提交
+    bool countDirty;        // 批量修改期间卡片数量有变化
+
+    CacheEntry cache[HOT_CACHE_SIZE];
+    uint32_t useCounter;
+    Stats stats;
+
+    // 分段遍历的续接位置：停在下一段要访问的条目上，resumeAfter为调用者届时传入的UID
+    nvs_iterator_t resumeIterator;
+    String resumeAfter;
+
+    static bool isValidUid(const String& uid);
+    static String groupsKey(const String& uid);
+    static uint64_t encodeValue(const uint8_t* key);
+    static void decodeKey(uint64_t value, uint8_t* key);
+
+    /**
+     * 卡片条目（64位整数）迭代器，屏蔽IDF 4/5的接口差异
+     * @return 迭代器，没有条目时为nullptr
+     */
+    nvs_iterator_t firstEntry() const;
+    static nvs_iterator_t nextEntry(nvs_iterator_t it);
+
+    /**
+     * 从迭代器当前条目开始访问卡片
+     * @param it 迭代器，回调返回false时停在该条目上，遍历完时为nullptr
+     */
+    void visitFrom(nvs_iterator_t& it, const Visitor& visitor);
+
+    void releaseResume();
+
+    /**
+     * 查找卡片的值（先查缓存）
+     * @return 值，未注册为0
+     */
+    uint64_t lookup(const String& uid);
+
+    /**
+     * 更新缓存中的卡片
+     */
+    void cachePut(const String& uid, uint64_t value);
+
+    /**
+     * 遍历统计卡片数量（数量键缺失时使用）
+     */
+    size_t recount();
+
+    bool saveCount();
+
+    /**
+     * 提交修改（批量修改期间推迟到endBatch）
+     * @param countChanged 卡片数量是否变化
+     * @return 是否成功
+     */
+    bool commit(bool countChanged);
+
+public:
+    /**
+     * 构造函数
+     * @param nvsNamespace 命名空间，nullptr为默认命名空间
+     */
+    NvsCardStore(const char* nvsNamespace = nullptr);
+
+    /**
+     * 析构函数
+     */
+    ~NvsCardStore();
+
+    /**
+     * 初始化分区并打开命名空间
+     * @return 是否成功
+     */
+    bool begin() override;
+
+    bool find(const String& uid, uint8_t* key, bool& hasKey) override;
+    bool contains(const String& uid) override;
+    bool put(const String& uid, const uint8_t* key) override;
+    bool remove(const String& uid) override;
+    bool getGroups(const String& uid, String& groups) override;
+    bool setGroups(const String& uid, const char* groups) override;
+    void forEach(const Visitor& visitor) override;
+
+    /**
+     * 分段遍历：保留上一段的NVS迭代器直接续接，不用每段从头扫描命名空间，
+     * 上一段最后的卡片被删除也不影响续接；两段之间的修改可能使个别卡片被跳过或重复访问。
+     * after与上一段不衔接时退回从头扫描
+     */
+    void forEachAfter(const String& after, const Visitor& visitor) override;
+
+    bool eraseAll() override;
+    size_t getCount() const override;
+    void printStats() const override;
+    void beginBatch() override;
+    bool endBatch() override;
+    const char* getName() const override;
+
+    /**
+     * 获取统计信息
+     * @return 统计信息
+     */
+    Stats getStats() const;
+};
+
+#endif // NVSCARDSTORE_H
@@ -0,0 +1,82 @@
+#include "NvsStorageBackend.h"
+
+const char* NvsStorageBackend::DEFAULT_NAMESPACE = "cards";
+const char* NvsStorageBackend::CARDS_KEY = "db";
+
+NvsStorageBackend::NvsStorageBackend(const char* nvsNamespace)
+    : nvsNamespace(nvsNamespace ? nvsNamespace : DEFAULT_NAMESPACE), opened(false) {
+}
+
+NvsStorageBackend::~NvsStorageBackend() {
+    if (opened) {
+        prefs.end();
+    }
+}
+
+bool NvsStorageBackend::begin() {
+    if (opened) {
+        return true;
+    }
+    if (!prefs.begin(nvsNamespace, false)) {
+        Serial.println("NVS Storage: Failed to open namespace");
+        return false;
+    }
+    opened = true;
+    return true;
+}
+
+IStorageBackend::LoadResult NvsStorageBackend::loadCards(JsonDocument& cards) {
+    if (!opened) {
+        return LOAD_ERROR;
+    }
+    size_t length = prefs.getBytesLength(CARDS_KEY);
+    if (length == 0) {
+        return LOAD_NOT_FOUND;
+    }
+
+    char* buffer = (char*)malloc(length);
+    if (buffer == nullptr) {
+        Serial.println("NVS Storage: Out of memory");
+        return LOAD_ERROR;
+    }
+    if (prefs.getBytes(CARDS_KEY, buffer, length) != length) {
+        free(buffer);
+        return LOAD_ERROR;
+    }
+    DeserializationError err = deserializeJson(cards, buffer, length);
+    free(buffer);
+    return err ? LOAD_CORRUPT : LOAD_OK;
+}
+
+bool NvsStorageBackend::saveCards(const JsonDocument& cards) {
+    if (!opened) {
+        return false;
+    }
+
+    // NVS按值整体写入，先序列化到内存
+    size_t length = measureJson(cards);
+    char* buffer = (char*)malloc(length + 1);
+    if (buffer == nullptr) {
+        Serial.println("NVS Storage: Out of memory");
+        return false;
+    }
+    serializeJson(cards, buffer, length + 1);
+    bool success = prefs.putBytes(CARDS_KEY, buffer, length) == length;
+    free(buffer);
+
+    if (!success) {
+        Serial.println("NVS Storage: Write failed (partition full?)");
+    }
+    return success;
+}
+
+bool NvsStorageBackend::erase() {
+    if (!opened) {
+        return false;
+    }
+    return !prefs.isKey(CARDS_KEY) || prefs.remove(CARDS_KEY);
+}
+
+const char* NvsStorageBackend::getName() const {
+    return "nvs";
+}
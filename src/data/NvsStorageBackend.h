@@ -0,0 +1,44 @@
+#ifndef NVSSTORAGEBACKEND_H
+#define NVSSTORAGEBACKEND_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "../interfaces/IStorageBackend.h"
+
+/**
+ * NVS存储后端
+ * 卡片数据库序列化为紧凑JSON，作为一个二进制值保存在NVS（Preferences）中
+ * NVS自带磨损均衡和掉电保护，不受文件系统碎片影响，但容量受nvs分区大小限制
+ * （默认分区表中为20KB，与主密钥等共用），适合卡片较少的门
+ */
+class NvsStorageBackend : public IStorageBackend {
+public:
+    // 默认命名空间和键名
+    static const char* DEFAULT_NAMESPACE;
+    static const char* CARDS_KEY;
+
+private:
+    const char* nvsNamespace;
+    Preferences prefs;
+    bool opened;
+
+public:
+    /**
+     * 构造函数
+     * @param nvsNamespace NVS命名空间（最长15个字符）
+     */
+    NvsStorageBackend(const char* nvsNamespace = nullptr);
+
+    /**
+     * 析构函数
+     */
+    ~NvsStorageBackend();
+
+    bool begin() override;
+    LoadResult loadCards(JsonDocument& cards) override;
+    bool saveCards(const JsonDocument& cards) override;
+    bool erase() override;
+    const char* getName() const override;
+};
+
+#endif // NVSSTORAGEBACKEND_H
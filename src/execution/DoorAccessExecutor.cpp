@@ -2,6 +2,7 @@
 #include "LEDExecutor.h"
 #include "BuzzerExecutor.h"
 #include "ServoExecutor.h"
+#include "../utils/TokenLog.h"
 
 DoorAccessExecutor::DoorAccessExecutor(LEDExecutor* led, BuzzerExecutor* buzzer, ServoExecutor* servo)
     : ledExecutor(led), buzzerExecutor(buzzer), servoExecutor(servo),
@@ -36,7 +37,7 @@ bool DoorAccessExecutor::initialize() {
 }
 
 void DoorAccessExecutor::executeSuccessAction() {
-    Serial.println("Door Access Executor: Executing success action (OPEN DOOR)");
+    LOGF("Door Access Executor: Executing success action (OPEN DOOR)");
 
     // 停止之前的关门任务（如果存在）
     if (doorCloseTaskHandle != nullptr) {
@@ -72,7 +73,7 @@ void DoorAccessExecutor::executeSuccessAction() {
 }
 
 void DoorAccessExecutor::executeFailureAction() {
-    Serial.println("Door Access Executor: Executing failure action (ACCESS DENIED)");
+    LOGF("Door Access Executor: Executing failure action (ACCESS DENIED)");
 
     // 协调LED和蜂鸣器执行失败动作（不开门）
     if (ledExecutor) {
@@ -2,8 +2,8 @@
 #include <Arduino.h>
 #include "driver/ledc.h"
 
-ServoExecutor::ServoExecutor(int pin)
-    : servoPin(pin), isExecuting_(false), taskHandle(nullptr), doorIsOpen(false) {
+ServoExecutor::ServoExecutor(int pin, int channel)
+    : servoPin(pin), pwmChannel(channel), isExecuting_(false), taskHandle(nullptr), doorIsOpen(false) {
 }
 
 ServoExecutor::~ServoExecutor() {
@@ -25,7 +25,7 @@ bool ServoExecutor::initialize() {
     ledc_channel_config_t channel_config = {
         .gpio_num = servoPin,
         .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = static_cast<ledc_channel_t>(PWM_CHANNEL),
+        .channel = static_cast<ledc_channel_t>(pwmChannel),
         .intr_type = LEDC_INTR_DISABLE,
         .timer_sel = LEDC_TIMER_0,
         .duty = 0,
@@ -45,7 +45,7 @@ bool ServoExecutor::initialize() {
     Serial.print("Servo Executor initialized on pin ");
     Serial.print(servoPin);
     Serial.print(" with PWM channel ");
-    Serial.println(PWM_CHANNEL);
+    Serial.println(pwmChannel);
 
     return true;
 }
@@ -171,9 +171,9 @@ void ServoExecutor::setServoAngle(int angle) {
     }
 
     // 设置PWM占空比
-    esp_err_t result = ledc_set_duty(LEDC_LOW_SPEED_MODE, static_cast<ledc_channel_t>(PWM_CHANNEL), duty);
+    esp_err_t result = ledc_set_duty(LEDC_LOW_SPEED_MODE, static_cast<ledc_channel_t>(pwmChannel), duty);
     if (result == ESP_OK) {
-        ledc_update_duty(LEDC_LOW_SPEED_MODE, static_cast<ledc_channel_t>(PWM_CHANNEL));
+        ledc_update_duty(LEDC_LOW_SPEED_MODE, static_cast<ledc_channel_t>(pwmChannel));
     }
 
     Serial.print("Servo angle set to: ");
@@ -13,6 +13,7 @@
 class ServoExecutor : public IActionExecutor {
 private:
     int servoPin;
+    int pwmChannel;   // LEDC通道，多个门的舵机需使用不同通道
 
     // 异步执行状态
     bool isExecuting_;
@@ -20,7 +21,6 @@ private:
     bool doorIsOpen;
 
     // PWM配置常量（基于调试demo参数）
-    static constexpr int PWM_CHANNEL = 0;
     static constexpr int PWM_FREQ = 50;        // 50Hz → 20ms周期
     static constexpr int PWM_BIT = 12;         // 分辨率12位
     static constexpr int PWM_MAX = (1 << PWM_BIT); // 4096
@@ -49,8 +49,9 @@ public:
     /**
      * 构造函数
      * @param pin 舵机控制引脚
+     * @param channel LEDC通道
      */
-    ServoExecutor(int pin);
+    ServoExecutor(int pin, int channel = 0);
 
     /**
      * 析构函数
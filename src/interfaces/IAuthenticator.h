@@ -40,6 +40,29 @@ public:
      */
     virtual void reset() = 0;
 
+    /**
+     * 检查认证器是否使用与管理操作共享的读卡器
+     * 读卡器被管理操作租用期间，此类认证器暂停轮询
+     * @return 是否使用共享读卡器
+     */
+    virtual bool usesSharedReader() const { return false; }
+
+    /**
+     * 检查认证器是否自行按凭证（如卡片UID）处理冷却
+     * 返回true时协调器不再对该认证器施加统一的成功冷却，不同的人可以连续通过
+     * @return 是否按凭证处理冷却
+     */
+    virtual bool hasCredentialCooldown() const { return false; }
+
+    /**
+     * 获取最近一次认证出示的凭证标识（如卡片UID），用于访问策略判断和审计日志
+     * 认证失败时也可以返回凭证；没有凭证的认证方式（如按钮）返回false，不受访问策略限制
+     * @param id 输出的凭证字节（至少10字节）
+     * @param length 输出的凭证长度
+     * @return 是否有凭证
+     */
+    virtual bool getLastCredentialId(uint8_t* id, uint8_t* length) const { return false; }
+
     /**
      * 检查认证器是否支持异步操作
      * @return 是否支持异步操作
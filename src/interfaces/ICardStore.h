@@ -0,0 +1,141 @@
+#ifndef ICARDSTORE_H
+#define ICARDSTORE_H
+
+#include <Arduino.h>
+#include <functional>
+
+/**
+ * 按卡片存储接口
+ * CardDatabase设置了按卡片存储后，所有卡片操作直接在存储中进行，不再把整个数据库加载为JSON；
+ * 修改立即持久化。具体实现在编译时选择（见platformio.ini）：
+ * - NvsCardStore：每张卡片一个NVS条目
+ * - FlashCardIndex：原始分区中预先排序的索引映像，通过内存映射二分查找
+ */
+class ICardStore {
+public:
+    /**
+     * 遍历回调
+     * @param uid 卡片UID
+     * @param key 保存的密钥（hasKey为false时无效）
+     * @param hasKey 是否保存了独立密钥
+     * @return 是否继续遍历
+     */
+    typedef std::function<bool(const String& uid, const uint8_t* key, bool hasKey)> Visitor;
+
+    virtual ~ICardStore() = default;
+
+    /**
+     * 打开存储
+     * @return 是否成功
+     */
+    virtual bool begin() = 0;
+
+    /**
+     * 查找卡片
+     * @param uid 卡片UID
+     * @param key 输出的密钥（可以为nullptr）
+     * @param hasKey 输出是否保存了独立密钥
+     * @return 是否已注册
+     */
+    virtual bool find(const String& uid, uint8_t* key, bool& hasKey) = 0;
+
+    /**
+     * 检查卡片是否已注册
+     * @param uid 卡片UID
+     * @return 是否已注册
+     */
+    virtual bool contains(const String& uid) = 0;
+
+    /**
+     * 添加或更新卡片（已有的访问组保持不变）
+     * @param uid 卡片UID
+     * @param key 密钥，nullptr表示使用分散密钥
+     * @return 是否成功
+     */
+    virtual bool put(const String& uid, const uint8_t* key) = 0;
+
+    /**
+     * 删除卡片及其访问组
+     * @param uid 卡片UID
+     * @return 是否删除（卡片不存在时返回false）
+     */
+    virtual bool remove(const String& uid) = 0;
+
+    /**
+     * 获取卡片的访问组
+     * @param uid 卡片UID
+     * @param groups 输出的组名称（逗号分隔）
+     * @return 是否有访问组（不受限制时返回false）
+     */
+    virtual bool getGroups(const String& uid, String& groups) = 0;
+
+    /**
+     * 设置卡片的访问组
+     * @param uid 卡片UID
+     * @param groups 组名称（逗号分隔），nullptr表示删除（不受限制）
+     * @return 是否成功
+     */
+    virtual bool setGroups(const String& uid, const char* groups) = 0;
+
+    /**
+     * 遍历所有卡片（遍历期间不能修改）
+     * @param visitor 回调，返回false时停止
+     */
+    virtual void forEach(const Visitor& visitor) = 0;
+
+    /**
+     * 从指定卡片之后继续遍历（分段遍历使用，两段之间可以修改）
+     * 默认实现从头遍历并跳过该卡片及之前的卡片，要求遍历顺序稳定；
+     * 该卡片已被删除时不再遍历任何卡片。按UID排序的实现应直接定位，
+     * 其他实现应保留上一段的遍历位置续接
+     * @param after 上一段遍历的最后一个UID，空字符串从头开始
+     * @param visitor 回调，返回false时停止
+     */
+    virtual void forEachAfter(const String& after, const Visitor& visitor) {
+        bool found = after.length() == 0;
+        forEach([&](const String& uid, const uint8_t* key, bool hasKey) {
+            if (!found) {
+                found = uid == after;
+                return true;
+            }
+            return visitor(uid, key, hasKey);
+        });
+    }
+
+    /**
+     * 开始批量修改（如导入）：之后的修改可以只在内存中累积，endBatch时一次持久化
+     * 批量修改期间复位会丢失未持久化的修改
+     */
+    virtual void beginBatch() {}
+
+    /**
+     * 结束批量修改，持久化累积的修改
+     * @return 是否成功
+     */
+    virtual bool endBatch() { return true; }
+
+    /**
+     * 删除所有卡片
+     * @return 是否成功
+     */
+    virtual bool eraseAll() = 0;
+
+    /**
+     * 获取卡片数量
+     * @return 卡片数量
+     */
+    virtual size_t getCount() const = 0;
+
+    /**
+     * 打印统计信息
+     */
+    virtual void printStats() const = 0;
+
+    /**
+     * 获取存储名称
+     * @return 存储名称
+     */
+    virtual const char* getName() const = 0;
+};
+
+#endif // ICARDSTORE_H
@@ -32,9 +32,10 @@ public:
     virtual bool eraseAndDeleteItem(const String& id) = 0;
     
     /**
-     * 列出所有已注册的项目
+     * 列出已注册的项目
+     * @param param 列表参数（分页、过滤，格式由实现决定），空字符串列出全部
      */
-    virtual void listRegisteredItems() = 0;
+    virtual void listRegisteredItems(const String& param) = 0;
     
     /**
      * 检查是否有管理操作正在进行
@@ -48,6 +49,35 @@ public:
      */
     virtual bool hasCompletedOperation() = 0;
     
+    /**
+     * 检查指定动作是否需要独占读卡器
+     * 需要读卡器的动作会向协调器申请租约，期间NFC认证暂停；其余动作与认证并发执行
+     * @param action 动作名称
+     * @return 是否需要读卡器
+     */
+    virtual bool requiresReader(const String& action) const { return true; }
+
+    /**
+     * 获取当前操作允许持有读卡器租约的最长时间
+     * @return 租约时长（毫秒），0表示使用协调器默认值
+     */
+    virtual unsigned long getReaderLeaseTimeout() const { return 0; }
+
+    /**
+     * 检查是否支持扩展动作（register/delete/erase/list/reset之外的动作）
+     * @param action 动作名称
+     * @return 是否支持
+     */
+    virtual bool hasCustomAction(const String& action) const { return false; }
+
+    /**
+     * 执行扩展动作
+     * @param action 动作名称
+     * @param param 参数
+     * @return 执行是否成功
+     */
+    virtual bool executeCustomAction(const String& action, const String& param) { return false; }
+
     /**
      * 处理管理操作（在主循环中调用）
      */
@@ -0,0 +1,70 @@
+#ifndef ISTORAGEBACKEND_H
+#define ISTORAGEBACKEND_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * 卡片数据存储后端接口
+ * FileSystemManager通过该接口读写卡片数据库，具体后端在编译时选择（见platformio.ini）：
+ * - 文件后端：SPIFFS或LittleFS上的/cards.json
+ * - NVS后端：Preferences中的一个二进制值
+ * 卡片数据始终是CardDatabase的JSON数组，不同后端只决定其存放位置和方式
+ */
+class IStorageBackend {
+public:
+    // 加载结果
+    enum LoadResult {
+        LOAD_OK,         // 加载成功
+        LOAD_NOT_FOUND,  // 没有保存过数据
+        LOAD_CORRUPT,    // 数据损坏（无法解析）
+        LOAD_ERROR       // 存储访问失败
+    };
+
+    virtual ~IStorageBackend() = default;
+
+    /**
+     * 打开后端（文件后端要求文件系统已挂载）
+     * @return 是否成功
+     */
+    virtual bool begin() = 0;
+
+    /**
+     * 加载全部卡片
+     * @param cards 输出的卡片数据库JSON
+     * @return 加载结果
+     */
+    virtual LoadResult loadCards(JsonDocument& cards) = 0;
+
+    /**
+     * 保存全部卡片
+     * @param cards 卡片数据库JSON
+     * @return 是否成功
+     */
+    virtual bool saveCards(const JsonDocument& cards) = 0;
+
+    /**
+     * 单张卡片添加、修改或删除后持久化
+     * 默认保存全部卡片，支持按卡片存储的后端可以只写这一张
+     * @param uid 变化的卡片UID（在cards中不存在表示已删除）
+     * @param cards 变化后的卡片数据库JSON
+     * @return 是否成功
+     */
+    virtual bool updateCard(const String& uid, const JsonDocument& cards) {
+        return saveCards(cards);
+    }
+
+    /**
+     * 删除后端中保存的全部卡片数据
+     * @return 是否成功
+     */
+    virtual bool erase() = 0;
+
+    /**
+     * 获取后端名称
+     * @return 后端名称
+     */
+    virtual const char* getName() const = 0;
+};
+
+#endif // ISTORAGEBACKEND_H
@@ -1,12 +1,13 @@
 // Improved Door Access System using ESP32, PN532, and MIFARE Classic
 // Features improved OOP architecture with state machine coordinator
 // Key improvements:
-// 1. State machine coordinator ensures mutual exclusion between authentication and management
+// 1. Coordinator runs management alongside authentication, leasing the reader only when needed
 // 2. Improved NFC wrapper that handles startPassiveDetection() and IRQ logic properly
 // 3. Better separation of concerns following OOP principles
 
 #include <Arduino.h>
 #include <Wire.h>
+#include <bootloader_random.h>
 
 // 改进的模块化组件
 #include "system/SystemCoordinator.h"
@@ -20,7 +21,32 @@
 #include "nfc/NFCManager.h"
 #include "data/CardDatabase.h"
 #include "data/FileSystemManager.h"
+#ifdef STORAGE_NVS
+#include "data/NvsStorageBackend.h"
+#else
+#include "data/FileStorageBackend.h"
+#endif
+#include "data/AuditLog.h"
+#if defined(CARD_DB_NVS)
+#include "data/NvsCardStore.h"
+#elif defined(CARD_DB_INDEX)
+#include "data/FlashCardIndex.h"
+#endif
+#include "security/KeyDiversifier.h"
+#include "security/KeyPool.h"
+#include "security/AccessPolicy.h"
+#include "security/RevocationList.h"
+#include "security/PresenceTracker.h"
 #include "utils/Utils.h"
+#include "utils/AllocTracker.h"
+#include "utils/Clock.h"
+#include "utils/BootTimeline.h"
+#ifdef ENABLE_BENCHMARKS
+#include "benchmark/CardBenchmarks.h"
+#include "benchmark/PolicyBenchmarks.h"
+#include "benchmark/StorageBenchmarks.h"
+#include "benchmark/TapStormSimulator.h"
+#endif
 
 // =============================================================================
 // 硬件配置
@@ -41,25 +67,99 @@
 // 手动触发引脚
 #define MANUAL_TRIGGER_PIN 25
 
+// 出门读卡器（可选）：第二个PN532接在SPI总线上，使用独立的片选和IRQ引脚，
+// 并有自己的LED和蜂鸣器，与入口读卡器共用同一个门锁舵机
+#ifdef EXIT_READER
+#define EXIT_READER_SS   15
+#define EXIT_READER_IRQ  35   // 只能输入的引脚，没有内部上拉，依靠模块上的上拉电阻（与SIDE_READER_IRQ相同）
+#define EXIT_LED_PIN     27
+#define EXIT_BUZZER_PIN  17
+#endif
+
+// 第二扇门（可选）：独立的PN532（SPI）、LED、蜂鸣器和舵机，与主门共用卡片数据库，
+// 有自己的冷却、读卡器租约和决策统计
+#ifdef SECOND_DOOR
+#define SIDE_READER_SS    13
+#define SIDE_READER_IRQ   34
+#define SIDE_LED_PIN      32
+#define SIDE_BUZZER_PIN   26   // 不能用GPIO12：启动配置引脚，复位时被拉高会选择1.8V闪存电压，无法启动
+#define SIDE_SERVO_PIN    33
+#define SIDE_SERVO_CHANNEL 1
+#endif
+
+// 密钥模式：定义KEY_DIVERSIFICATION后新卡使用由主密钥和UID派生的分散密钥，
+// 数据库只保存UID；已有的独立密钥卡片可通过 card:migrate 迁移
+#ifdef KEY_DIVERSIFICATION
+#define DIVERSIFY_NEW_CARDS true
+#else
+#define DIVERSIFY_NEW_CARDS false
+#endif
+
 // =============================================================================
 // 全局对象
 // =============================================================================
 
 // 数据管理
 CardDatabase cardDatabase;
-FileSystemManager fileSystemManager(&cardDatabase);
-
-// NFC管理器（新的封装层）
-NFCManager nfcManager(PN532_IRQ, PN532_RESET);
+KeyDiversifier keyDiversifier;
+KeyPool keyPool;
+AccessPolicy accessPolicy;
+RevocationList revocationList;
+PresenceTracker presenceTracker;
+AuditLog auditLog;
+// 卡片数据存储后端（编译时选择，见platformio.ini）
+#ifdef STORAGE_NVS
+NvsStorageBackend cardStorage;
+#else
+FileStorageBackend cardStorage(FileSystemManager::fileSystem(), FileSystemManager::fileSystemName(),
+                               FileSystemManager::CARD_FILE);
+#endif
+FileSystemManager fileSystemManager(&cardDatabase, &cardStorage);
+// 按卡片存储（编译时选择），cardStorage只用于首次启动时迁移
+#if defined(CARD_DB_NVS)
+// 每张卡片一个NVS条目（cardkv分区）
+NvsCardStore cardStore;
+#elif defined(CARD_DB_INDEX)
+// 排序的索引映像（cardidx分区），映射后直接在闪存上二分查找
+FlashCardIndex cardStore;
+#endif
+
+// NFC管理器（新的封装层），入口读卡器同时用于卡片管理
+NFCManager nfcManager(PN532_IRQ, PN532_RESET, &Wire, "Entry");
+#ifdef EXIT_READER
+NFCManager exitNfcManager(EXIT_READER_SS, EXIT_READER_IRQ, &SPI, "Exit");
+#endif
+#ifdef SECOND_DOOR
+NFCManager sideNfcManager(SIDE_READER_SS, SIDE_READER_IRQ, &SPI, "Side");
+#endif
 
 // 执行器
 LEDExecutor ledExecutor(LED_PIN);
 BuzzerExecutor buzzerExecutor(BUZZER_PIN);
 ServoExecutor servoExecutor(SERVO_PIN);
 DoorAccessExecutor doorExecutor(&ledExecutor, &buzzerExecutor, &servoExecutor);
+#ifdef EXIT_READER
+LEDExecutor exitLedExecutor(EXIT_LED_PIN);
+BuzzerExecutor exitBuzzerExecutor(EXIT_BUZZER_PIN);
+DoorAccessExecutor exitDoorExecutor(&exitLedExecutor, &exitBuzzerExecutor, &servoExecutor);
+#endif
+#ifdef SECOND_DOOR
+LEDExecutor sideLedExecutor(SIDE_LED_PIN);
+BuzzerExecutor sideBuzzerExecutor(SIDE_BUZZER_PIN);
+ServoExecutor sideServoExecutor(SIDE_SERVO_PIN, SIDE_SERVO_CHANNEL);
+DoorAccessExecutor sideDoorExecutor(&sideLedExecutor, &sideBuzzerExecutor, &sideServoExecutor);
+#endif
 
 // 认证器（使用新的NFCManager）
-NFCAuthenticator nfcAuth(&nfcManager, &cardDatabase);
+NFCAuthenticator nfcAuth(&nfcManager, &cardDatabase, "NFC Entry");
+#ifdef EXIT_READER
+// 出门读卡器不参与卡片管理，租约期间继续认证
+NFCAuthenticator exitNfcAuth(&exitNfcManager, &cardDatabase, "NFC Exit", false);
+#endif
+#ifdef SECOND_DOOR
+// 第二扇门的读卡器不参与卡片管理
+NFCAuthenticator sideNfcAuth(&sideNfcManager, &cardDatabase, "NFC Side", false);
+#endif
 ManualTriggerAuthenticator manualAuth(MANUAL_TRIGGER_PIN);
 
 // 卡片管理器（使用新的NFCManager）
@@ -67,6 +167,9 @@ NFCCardManager cardManager(&nfcManager, &cardDatabase, &fileSystemManager);
 
 // 系统协调器（新的状态机协调器）
 SystemCoordinator systemCoordinator(&doorExecutor);
+#ifdef SECOND_DOOR
+DoorContext sideDoor("Side", &sideDoorExecutor);
+#endif
 
 // =============================================================================
 // 串口主界面
@@ -77,14 +180,54 @@ void printWelcomeMessage() {
     Serial.println("=================================");
     Serial.println("命令:");
     Serial.println("  card:register       - 注册新卡片");
-    Serial.println("  card:list           - 列出已注册卡片");
+    Serial.println("  card:enroll         - 批量注册（连续刷卡）");
+    Serial.println("  card:stop           - 结束批量注册并保存");
+    Serial.println("  card:list[:<偏移>[:<数量>[:<UID前缀>]]] - 分页列出已注册卡片（可按UID前缀过滤）");
+    Serial.println("  card:list:after:<UID>[:<数量>[:<UID前缀>]] - 从指定卡片之后继续列出（翻页使用）");
+    Serial.println("  card:pool           - 显示预生成密钥池状态");
     Serial.println("  card:delete:<UID>   - 删除储存的卡片信息");
     Serial.println("  card:erase:<UID>    - 擦除卡片并删除卡片信息");
+    Serial.println("  card:migrate[:<UID>]- 将卡片迁移到分散密钥");
+    Serial.println("  card:groups:<UID>[:<组1,组2>|*] - 查看/设置卡片的访问组（*为不受限制）");
+    Serial.println("  card:policy         - 重新加载/policy.json并显示访问组");
+    Serial.println("  card:revoke:<UID>[,<UID>...] - 吊销丢失的卡片（不需要卡片在场）");
+    Serial.println("  card:unrevoke:<UID> - 撤销吊销");
+    Serial.println("  card:revoked        - 列出已吊销的卡片");
+    Serial.println("  card:import:begin|<序号>:<CRC>:<记录>|end - 分块批量导入卡片（结束时一次保存）");
+    Serial.println("  card:export[:<每块记录数>] - 分块导出所有卡片（含密钥和访问组）");
+    Serial.println("  time[:set:<时间戳>] - 显示/设置本地时间（访问组时间窗口使用）");
+    Serial.println("  status              - 显示系统状态和读卡器租用统计");
+    Serial.println("  occupancy[:reset]   - 显示在场人数/清空在场状态（防反传）");
+    Serial.println("  boot                - 显示启动时间线（各阶段耗时、读卡器上线和第一次开门时间）");
+    Serial.println("  log                 - 显示审计日志状态");
+    Serial.println("  log:tail[:<条数>]   - 显示最近的审计记录");
+    Serial.println("  log:flush           - 立即写入缓冲中的审计记录");
+    Serial.println("  log:query:<开始>:<结束>[:<UID>] - 按时间（Unix秒，*为不限）和UID查询审计记录");
+#if defined(CARD_DB_NVS)
+    Serial.println("  store               - 显示NVS卡片存储和热卡缓存统计");
+#elif defined(CARD_DB_INDEX)
+    Serial.println("  store               - 显示闪存卡片索引和变更日志状态");
+    Serial.println("  store:compact       - 立即把变更日志合并到索引映像");
+#endif
     Serial.println("  reset               - 重置所有组件");
+#ifdef ENABLE_BENCHMARKS
+    Serial.println("  bench               - 运行基准测试（输出BENCH行）");
+    Serial.println("  sim[:<次/分>:<秒>[:<读卡器数>]] - 刷卡风暴仿真（虚拟时间）");
+    Serial.println("  sim:script:<脚本>   - 脚本化刷卡仿真，如 0@R1,300@R1,2000@U0,2100@B");
+#endif
+#ifdef ALLOC_TRACKING
+    Serial.println("  alloc[:reset]       - 显示/清空按操作统计的内存分配");
+#endif
     Serial.println("  help                - 显示帮助信息");
     Serial.println("=================================");
     Serial.println("当前可用的认证方式:");
     Serial.println("  - NFC 卡片认证");
+#ifdef EXIT_READER
+    Serial.println("  - NFC 出门读卡器 (SPI, SS pin " + String(EXIT_READER_SS) + ")");
+#endif
+#ifdef SECOND_DOOR
+    Serial.println("  - NFC 第二扇门读卡器 (SPI, SS pin " + String(SIDE_READER_SS) + ")");
+#endif
     Serial.println("  - 手动按钮 (pin " + String(MANUAL_TRIGGER_PIN) + ")");
     Serial.println("=================================");
 }
@@ -92,6 +235,32 @@ void printWelcomeMessage() {
 // =============================================================================
 // 串口命令处理
 // =============================================================================
+void handleTimeCommand(const String& command) {
+    if (command.startsWith("time:set:")) {
+        long epoch = command.substring(9).toInt();
+        if (epoch < Clock::MIN_VALID_EPOCH || !Clock::setWallTime(epoch)) {
+            Serial.println("Usage: time:set:<unix seconds, local time>");
+            return;
+        }
+    } else if (!command.equalsIgnoreCase("time")) {
+        Serial.println("Usage: time | time:set:<unix seconds, local time>");
+        return;
+    }
+
+    if (Clock::getWallTimeSource() == Clock::WALL_TIME_RESTORED) {
+        Serial.printf("Time: %ld - restored after power loss, behind by the outage\n", Clock::wallTime());
+        Serial.println("Only always-open access groups are allowed until time:set");
+        return;
+    }
+    int hour = Clock::hourOfWeek();
+    if (hour < 0) {
+        Serial.println("Time not set, only always-open access groups are allowed");
+        return;
+    }
+    Serial.printf("Time: %ld (day %d, hour %d, hour of week %d)\n",
+                  Clock::wallTime(), hour / 24 + 1, hour % 24, hour);
+}
+
 void processSerialCommand() {
     String command = Serial.readStringUntil('\n');
     command.trim();
@@ -99,6 +268,47 @@ void processSerialCommand() {
     if (command.equalsIgnoreCase("help")) {
         printWelcomeMessage();
     }
+    else if (command.equalsIgnoreCase("boot")) {
+        BootTimeline::print();
+    }
+    else if (command.equalsIgnoreCase("time") || command.startsWith("time:")) {
+        handleTimeCommand(command);
+    }
+    else if (command.equalsIgnoreCase("log") || command.startsWith("log:")) {
+        if (!auditLog.handleCommand(command)) {
+            Serial.println("Usage: log | log:tail[:<count>] | log:flush | log:query:<from|*>:<to|*>[:<UID>]");
+        }
+    }
+#if defined(CARD_DB_NVS) || defined(CARD_DB_INDEX)
+    else if (command.equalsIgnoreCase("store")) {
+        cardStore.printStats();
+    }
+#endif
+#ifdef CARD_DB_INDEX
+    else if (command.equalsIgnoreCase("store:compact")) {
+        if (!cardStore.compactNow()) {
+            Serial.println("Card index compaction failed");
+        }
+    }
+#endif
+#ifdef ALLOC_TRACKING
+    else if (AllocTracker::handleCommand(command)) {
+        // 已处理
+    }
+#endif
+#ifdef ENABLE_BENCHMARKS
+    else if (command.equalsIgnoreCase("bench")) {
+        // 同步运行，期间主循环暂停
+        CardBenchmarks::runAll();
+        PolicyBenchmarks::runAll();
+        StorageBenchmarks::runAll();
+    }
+    else if (command.equalsIgnoreCase("sim") || command.startsWith("sim:")) {
+        if (!TapStormSimulator::handleCommand(command)) {
+            Serial.println("Usage: sim | sim:<taps/min>:<seconds>[:<readers>] | sim:script:<script>");
+        }
+    }
+#endif
     else {
         if (!systemCoordinator.handleCommand(command)) {
             Serial.println("Command failed. Type 'help' for available commands.");
@@ -109,39 +319,220 @@ void processSerialCommand() {
 // =============================================================================
 // 初始化函数
 // =============================================================================
+// 存储初始化任务（核心0）的结果，完成后通知启动任务
+volatile bool storageInitResult = false;
+TaskHandle_t bootTaskHandle = nullptr;
+
+/**
+ * 初始化存储相关组件：挂载文件系统、加载卡片数据库、吊销列表、在场状态、审计日志和访问策略
+ * 只访问闪存，不访问读卡器和执行器，与读卡器初始化并行运行
+ * @return 卡片数据库和吊销列表是否可用
+ */
+bool initializeStorage() {
+    BootTimeline::Phase storagePhase("storage (total)");
+
+#if defined(CARD_DB_NVS) || defined(CARD_DB_INDEX)
+    // 卡片数据库使用按卡片存储，必须在加载数据库之前设置
+    {
+        BootTimeline::Phase phase("card store open");
+        if (!cardStore.begin()) {
+            Serial.println("Failed to open card store");
+            return false;
+        }
+        cardDatabase.setCardStore(&cardStore);
+    }
+#endif
+
+    // 初始化文件系统并加载卡片
+    {
+        BootTimeline::Phase phase("file system + cards");
+        if (!fileSystemManager.initialize()) {
+            Serial.println("Failed to initialize file system");
+            return false;
+        }
+        Serial.println("File system initialized");
+    }
+
+    // 加载吊销列表，认证时在查找卡片之前检查
+    {
+        BootTimeline::Phase phase("revocation list");
+        if (!revocationList.initialize()) {
+            Serial.println("Failed to load revocation list");
+            return false;
+        }
+    }
+
+    // 恢复在场状态（防反传）
+    {
+        BootTimeline::Phase phase("presence");
+        if (!presenceTracker.initialize()) {
+            Serial.println("Failed to restore presence state, starting empty");
+        }
+    }
+
+    // 审计日志写入专用分区，分区不存在时只禁用日志
+    {
+        BootTimeline::Phase phase("audit log recovery");
+        if (!auditLog.initialize()) {
+            Serial.println("Audit log disabled");
+        }
+    }
+
+    // 编译访问策略（组时间窗口和卡片组位图）
+    {
+        BootTimeline::Phase phase("access policy");
+        if (!cardManager.reloadPolicy()) {
+            Serial.println("Access policy has errors, check /policy.json");
+        }
+    }
+    return true;
+}
+
+void storageInitTask(void* parameter) {
+    storageInitResult = initializeStorage();
+    xTaskNotifyGive(bootTaskHandle);
+    vTaskDelete(nullptr);
+}
+
 bool initializeSystem() {
     Serial.println("Initializing Improved Door Access System...");
+    BootTimeline::Phase systemPhase("system (total)");
+
+    // 没有启用Wi-Fi/蓝牙时esp_fill_random只是伪随机数，而主密钥、密钥池和随机卡片密钥都依赖它；
+    // 开启SAR ADC熵源。本固件不使用Wi-Fi、蓝牙和ADC，熵源一直保持开启
+    bootloader_random_enable();
+
+    // 组件之间的关联只设置指针，在初始化之前完成，两个核心上的初始化互不访问对方的对象
+    cardDatabase.setKeyDiversifier(&keyDiversifier, DIVERSIFY_NEW_CARDS);
+    cardDatabase.setRevocationList(&revocationList);
+    cardManager.setRevocationList(&revocationList);
+    cardManager.setAccessPolicy(&accessPolicy);
+    systemCoordinator.setPresenceTracker(&presenceTracker);
+    systemCoordinator.setAuditLog(&auditLog);
+    systemCoordinator.setAccessPolicy(&accessPolicy);
+
+    // 存储初始化在核心0上运行（Arduino主循环在核心1），同时在这里初始化读卡器和执行器
+    bootTaskHandle = xTaskGetCurrentTaskHandle();
+    if (xTaskCreatePinnedToCore(storageInitTask, "BootStorage", 8192, nullptr, 1, nullptr, 0) != pdPASS) {
+        Serial.println("Failed to start storage initialization task");
+        return false;
+    }
 
     // 初始化NFC管理器
-    if (!nfcManager.initialize()) {
-        Serial.println("Failed to initialize NFC manager");
-        return false;
+    {
+        BootTimeline::Phase phase("reader: entry");
+        if (!nfcManager.initialize()) {
+            Serial.println("Failed to initialize NFC manager");
+            return false;
+        }
+        Serial.println("NFC manager initialized");
     }
-    Serial.println("NFC manager initialized");
 
-    // 初始化文件系统
-    if (!fileSystemManager.initialize()) {
-        Serial.println("Failed to initialize file system");
-        return false;
+#if defined(EXIT_READER) || defined(SECOND_DOOR)
+    SPI.begin();
+#endif
+#ifdef EXIT_READER
+    {
+        BootTimeline::Phase phase("reader: exit");
+        if (!exitNfcManager.initialize()) {
+            Serial.println("Failed to initialize exit NFC manager");
+            return false;
+        }
+    }
+#endif
+#ifdef SECOND_DOOR
+    {
+        BootTimeline::Phase phase("reader: side");
+        if (!sideNfcManager.initialize()) {
+            Serial.println("Failed to initialize side door NFC manager");
+            return false;
+        }
+    }
+#endif
+
+    // 加载密钥分散主密钥
+    {
+        BootTimeline::Phase phase("key diversifier");
+        if (!keyDiversifier.initialize()) {
+            Serial.println("Failed to initialize key diversifier");
+#ifdef KEY_DIVERSIFICATION
+            return false;
+#else
+            // 新卡不使用分散密钥时只影响已迁移的卡片，不阻止启动
+            Serial.println("WARNING: Cards using diversified keys will be rejected");
+#endif
+        }
+    }
+
+    // 恢复墙上时间（访问策略的时间窗口依赖它）
+    switch (Clock::restoreWallTime()) {
+        case Clock::WALL_TIME_UNSET:
+            Serial.println("*****************************************************************");
+            Serial.println("WARNING: Wall time unknown - cards restricted to time windows");
+            Serial.println("         are DENIED (only always-open groups) until time:set");
+            Serial.println("*****************************************************************");
+            break;
+        case Clock::WALL_TIME_RESTORED:
+            Serial.println("*****************************************************************");
+            Serial.println("WARNING: Wall time restored from last save before power loss and");
+            Serial.println("         behind by the outage - cards restricted to time windows");
+            Serial.println("         are DENIED (only always-open groups) until time:set");
+            Serial.println("*****************************************************************");
+            break;
+        default:
+            break;
     }
-    Serial.println("File system initialized");
 
     // 为卡片管理器添加反馈执行器（只需要LED和蜂鸣器，不需要舵机）
     cardManager.addFeedbackExecutor(&ledExecutor);
     cardManager.addFeedbackExecutor(&buzzerExecutor);
 
     // 添加认证器到系统协调器
+#ifdef EXIT_READER
+    // 有出门读卡器时启用防反传：入口读卡器记录进入，出门读卡器记录离开
+    systemCoordinator.addAuthenticator(&nfcAuth, nullptr, PresenceTracker::DIRECTION_IN);
+    systemCoordinator.addAuthenticator(&exitNfcAuth, &exitDoorExecutor, PresenceTracker::DIRECTION_OUT);
+#else
     systemCoordinator.addAuthenticator(&nfcAuth);
+#endif
     systemCoordinator.addAuthenticator(&manualAuth);
+#ifdef SECOND_DOOR
+    sideDoor.addAuthenticator(&sideNfcAuth);
+    systemCoordinator.addDoor(&sideDoor);
+#endif
 
     // 添加管理操作
     systemCoordinator.addManagementOperation("card", &cardManager);
 
-    // 初始化系统协调器
-    if (!systemCoordinator.initialize()) {
-        Serial.println("Failed to initialize system coordinator");
+    // 初始化系统协调器（各门的执行器和认证器），主循环开始前不会刷卡
+    {
+        BootTimeline::Phase phase("doors + executors");
+        if (!systemCoordinator.initialize()) {
+            Serial.println("Failed to initialize system coordinator");
+            return false;
+        }
+    }
+
+    // 等待卡片数据库就绪
+    {
+        BootTimeline::Phase phase("wait for storage");
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    if (!storageInitResult) {
         return false;
     }
+    BootTimeline::milestone("storage ready");
+
+    // 以下只有注册卡片时需要，放在读卡器上线之后
+    // 后台预生成注册用的随机密钥
+    {
+        BootTimeline::Phase phase("key pool");
+        if (!keyPool.initialize()) {
+            Serial.println("Failed to start key pool");
+            return false;
+        }
+        cardManager.setKeyPool(&keyPool);
+    }
 
     Serial.println("System initialization completed successfully");
     return true;
@@ -151,14 +542,13 @@ bool initializeSystem() {
 // 主函数
 // =============================================================================
 void setup() {
+    // 导入数据块最长约1KB，加大接收缓冲，主循环轮询读卡器期间不丢数据（须在begin之前设置）
+    Serial.setRxBufferSize(1024);
     Serial.begin(115200);
 
-    // 启动指示
+    // 启动指示：初始化期间LED常亮（不再延时闪烁，缩短到第一次开门的时间）
     pinMode(LED_PIN, OUTPUT);
     digitalWrite(LED_PIN, HIGH);
-    delay(500);
-    digitalWrite(LED_PIN, LOW);
-    delay(100);
 
     // 初始化系统
     if (!initializeSystem()) {
@@ -170,7 +560,9 @@ void setup() {
             delay(500);
         }
     }
+    digitalWrite(LED_PIN, LOW);
 
+    BootTimeline::print();
     printWelcomeMessage();
 }
 
@@ -181,8 +573,19 @@ void loop() {
     }
 
     // 主循环由系统协调器处理（状态机）
+    static bool polling = false;
+    if (!polling) {
+        BootTimeline::milestone("reader polling");
+        polling = true;
+    }
     systemCoordinator.handleLoop();
 
+    // 审计查询每次循环处理一个扇区，不阻塞认证
+    auditLog.processQuery();
+
+    // 定期保存墙上时间，断电后从保存的时间继续
+    Clock::saveWallTimeIfDue();
+
     // 小延迟防止CPU过度使用
     delay(50);
 }
@@ -1,53 +1,62 @@
 #include "NFCManager.h"
+#include "../utils/TokenLog.h"
 
-NFCManager::NFCManager(int irq, int reset)
-    : nfc(nullptr), irqPin(irq), resetPin(reset), currentState(STATE_IDLE),
-      irqCurr(HIGH), irqPrev(HIGH), lastDetectionTime(0) {
+NFCManager::NFCManager(int irq, int reset, TwoWire* wire, const char* name)
+    : nfc(nullptr), name(name), busType(BUS_I2C), irqPin(irq), resetPin(reset), ssPin(-1),
+      wire(wire), spi(nullptr), currentState(STATE_IDLE), irqCurr(HIGH), irqPrev(HIGH),
+      lastDetectionTime(0), cardUIDLength(0), targetPending(false),
+      lastPresenceCheck(0), removalStartTime(0) {
+}
+
+NFCManager::NFCManager(int ss, int irq, SPIClass* spi, const char* name)
+    : nfc(nullptr), name(name), busType(BUS_SPI), irqPin(irq), resetPin(-1), ssPin(ss),
+      wire(nullptr), spi(spi), currentState(STATE_IDLE), irqCurr(HIGH), irqPrev(HIGH),
+      lastDetectionTime(0), cardUIDLength(0), targetPending(false),
+      lastPresenceCheck(0), removalStartTime(0) {
 }
 
 bool NFCManager::initialize() {
-    nfc = new Adafruit_PN532(irqPin, resetPin);
+    if (busType == BUS_SPI) {
+        nfc = new Adafruit_PN532(ssPin, spi);
+    } else {
+        nfc = new Adafruit_PN532(irqPin, resetPin, wire);
+    }
 
     pinMode(irqPin, INPUT_PULLUP);
     
-    Serial.println("NFC Manager: Initializing...");
+    Serial.printf("NFC Manager (%s): Initializing on %s...\n", name, busType == BUS_SPI ? "SPI" : "I2C");
     
     // 初始化PN532
     nfc->begin();
     
     uint32_t versionData = nfc->getFirmwareVersion();
     if (!versionData) {
-        Serial.println("NFC Manager: PN532 not found");
+        Serial.printf("NFC Manager (%s): PN532 not found\n", name);
         return false;
     }
     
-    Serial.print("NFC Manager: Found chip PN5");
-    Serial.println((versionData >> 24) & 0xFF, HEX);
+    Serial.printf("NFC Manager (%s): Found chip PN5%X\n", name, (unsigned)((versionData >> 24) & 0xFF));
     
     // 配置PN532为读取RFID标签
     nfc->SAMConfig();
     
-    Serial.println("NFC Manager: Initialized successfully");
+    Serial.printf("NFC Manager (%s): Initialized successfully\n", name);
     return true;
 }
 
 NFCManager::CardDetectionResult NFCManager::detectCard() {
     switch (currentState) {
         case STATE_IDLE:
-        case STATE_CARD_PRESENT:
             // 启动被动检测
             if (startPassiveDetection()) {
-                // 立即检测到卡片，立即读走卡片UID
-                uint8_t uid[7] = {0};
-                uint8_t uidLength = 0;
-                readCardUID(uid, &uidLength);
+                // 开始检测时卡片已在场（如一直放在读卡器上），记录但不触发认证
+                bool sameCard;
+                targetPending = true;
+                readTargetUID(sameCard);
 
-                Serial.println("NFC Manager: Card detected immediately");
+                LOGF("NFC Manager (%s): Card detected immediately", name);
                 currentState = STATE_CARD_PRESENT;
-                lastDetectionTime = millis();
-                
-                // 延迟一段时间，避免立即重复检测
-                delay(CARD_PERSISTENCE_DELAY);
+                lastDetectionTime = lastPresenceCheck = millis();
                 return CARD_PERSISTENT;
             } else {
                 // 进入检测模式，等待IRQ
@@ -58,26 +67,146 @@ NFCManager::CardDetectionResult NFCManager::detectCard() {
         case STATE_DETECTING:
             // 检查IRQ引脚下降沿
             if (checkIRQFallingEdge()) {
-                Serial.println("NFC Manager: Card detected via IRQ");
+                LOGF("NFC Manager (%s): Card detected via IRQ", name);
                 currentState = STATE_CARD_PRESENT;
-                lastDetectionTime = millis();
+                cardUIDLength = 0;
+                targetPending = true;
+                lastDetectionTime = lastPresenceCheck = millis();
                 return CARD_DETECTED;
             }
             return NO_CARD;
 
+        case STATE_CARD_PRESENT:
+            return checkPresence();
+
+        case STATE_REMOVAL_PENDING:
+            return checkRemoval();
+
         default:
             return NO_CARD;
     }
 }
 
+NFCManager::CardDetectionResult NFCManager::checkPresence() {
+    unsigned long now = millis();
+    if (now - lastPresenceCheck < PRESENCE_CHECK_INTERVAL_MS) {
+        return CARD_PERSISTENT;
+    }
+    lastPresenceCheck = now;
+
+    // 检测到的目标还没有被读取时先读走，否则重新选卡会覆盖它
+    bool sameCard;
+    if (targetPending) {
+        readTargetUID(sameCard);
+    }
+
+    if (startPassiveDetection()) {
+        targetPending = true;
+        if (readTargetUID(sameCard) && !sameCard) {
+            // 两次检查之间换了一张卡
+            LOGF("NFC Manager (%s): Different card detected", name);
+            lastDetectionTime = now;
+            return CARD_DETECTED;
+        }
+        return CARD_PERSISTENT;
+    }
+
+    // 选卡失败，PN532已进入等待目标状态（IRQ布防），确认卡片是否真的离开
+    currentState = STATE_REMOVAL_PENDING;
+    removalStartTime = now;
+    return CARD_PERSISTENT;
+}
+
+NFCManager::CardDetectionResult NFCManager::checkRemoval() {
+    if (checkIRQFallingEdge()) {
+        bool sameCard;
+        targetPending = true;
+        currentState = STATE_CARD_PRESENT;
+        lastPresenceCheck = millis();
+
+        if (readTargetUID(sameCard) && sameCard) {
+            // 卡片在场边缘抖动，不算离开
+            return CARD_PERSISTENT;
+        }
+
+        LOGF("NFC Manager (%s): Card detected via IRQ", name);
+        lastDetectionTime = lastPresenceCheck;
+        return CARD_DETECTED;
+    }
+
+    if (millis() - removalStartTime >= REMOVAL_CONFIRM_MS) {
+        // IRQ仍处于布防状态，下一张卡到来时直接进入检测流程
+        LOGF("NFC Manager (%s): Card removed", name);
+        currentState = STATE_DETECTING;
+        return CARD_REMOVED;
+    }
+
+    return CARD_PERSISTENT;
+}
+
+bool NFCManager::readTargetUID(bool& sameCard) {
+    uint8_t uid[7] = {0};
+    uint8_t uidLength = 0;
+    targetPending = false;
+    sameCard = false;
+
+    if (!nfc->readDetectedPassiveTargetID(uid, &uidLength) || uidLength == 0 || uidLength > sizeof(cardUID)) {
+        cardUIDLength = 0;
+        return false;
+    }
+
+    sameCard = cardUIDLength == 0 || (uidLength == cardUIDLength && memcmp(uid, cardUID, uidLength) == 0);
+    memcpy(cardUID, uid, uidLength);
+    cardUIDLength = uidLength;
+    return true;
+}
+
 bool NFCManager::readCardUID(uint8_t* uid, uint8_t* uidLength) {
+    bool sameCard;
+    if (targetPending && !readTargetUID(sameCard)) {
+        return false;
+    }
+
+    if (cardUIDLength > 0 && isCardPresent()) {
+        memcpy(uid, cardUID, cardUIDLength);
+        *uidLength = cardUIDLength;
+        return true;
+    }
+
     return nfc->readDetectedPassiveTargetID(uid, uidLength);
 }
 
+bool NFCManager::getLastCardUID(uint8_t* uid, uint8_t* uidLength) const {
+    if (cardUIDLength == 0) {
+        return false;
+    }
+    memcpy(uid, cardUID, cardUIDLength);
+    *uidLength = cardUIDLength;
+    return true;
+}
+
+bool NFCManager::isCardPresent() const {
+    return currentState == STATE_CARD_PRESENT || currentState == STATE_REMOVAL_PENDING;
+}
+
 bool NFCManager::authenticateBlock(uint8_t* uid, uint8_t uidLength, uint8_t blockNumber, uint8_t* key) {
     return nfc->mifareclassic_AuthenticateBlock(uid, uidLength, blockNumber, 0, key);
 }
 
+bool NFCManager::reselectCard() {
+    // 检测到的目标还没有被读取时先读走，与在场检查相同
+    bool sameCard;
+    if (targetPending) {
+        readTargetUID(sameCard);
+    }
+    if (!startPassiveDetection()) {
+        // 选不到卡，PN532已布防IRQ，由在场检查确认卡片是否离开
+        return false;
+    }
+    targetPending = true;
+    return readTargetUID(sameCard) && sameCard;
+}
+
 bool NFCManager::writeDataBlock(uint8_t blockNumber, uint8_t* data) {
     return nfc->mifareclassic_WriteDataBlock(blockNumber, data);
 }
@@ -86,7 +215,13 @@ void NFCManager::reset() {
     currentState = STATE_IDLE;
     irqCurr = irqPrev = HIGH;
     lastDetectionTime = 0;
-    Serial.println("NFC Manager: Reset completed");
+    cardUIDLength = 0;
+    targetPending = false;
+    Serial.printf("NFC Manager (%s): Reset completed\n", name);
+}
+
+const char* NFCManager::getName() const {
+    return name;
 }
 
 bool NFCManager::getIRQState() const {
@@ -3,11 +3,22 @@
 
 #include <Adafruit_PN532.h>
 #include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
 
 /**
  * NFC管理器
  * 封装PN532的底层操作，处理IRQ逻辑和卡片检测
  * 解决startPassiveDetection()和IRQ引脚逻辑混合的问题
+ *
+ * 在场跟踪：卡片在场期间每 PRESENCE_CHECK_INTERVAL_MS 重新选卡一次，
+ * 选不到卡后进入确认阶段，REMOVAL_CONFIRM_MS 内没有同一张卡重新出现则报告CARD_REMOVED
+ * 因此留在读卡器上的卡片只触发一次CARD_DETECTED，移开后再刷立即再次触发
+ *
+ * 多读卡器：每个实例对应一个PN532，各自有独立的IRQ引脚和检测状态，detectCard()不阻塞，
+ * 协调器轮流轮询即可交错服务多个读卡器
+ * - I2C：PN532地址固定（0x24），同一条I2C总线只能接一个，多个读卡器需使用不同总线（Wire/Wire1）
+ * - SPI：多个读卡器共享SPI总线，各自使用独立的片选引脚
  */
 class NFCManager {
 public:
@@ -15,35 +26,71 @@ public:
     enum CardDetectionResult {
         NO_CARD,           // 没有检测到卡片
         CARD_DETECTED,     // 检测到新卡片
-        CARD_PERSISTENT    // 卡片持续在场
+        CARD_PERSISTENT,   // 卡片持续在场
+        CARD_REMOVED       // 卡片已离开
     };
 
 private:
+    // 总线类型
+    enum BusType {
+        BUS_I2C,
+        BUS_SPI
+    };
+
     Adafruit_PN532* nfc;
+    const char* name;
+    BusType busType;
     int irqPin;
     int resetPin;
+    int ssPin;
+    TwoWire* wire;
+    SPIClass* spi;
     
     // 卡片检测状态
     enum DetectionState {
         STATE_IDLE,        // 空闲状态
         STATE_DETECTING,   // 检测中（等待IRQ）
-        STATE_CARD_PRESENT // 卡片在场
+        STATE_CARD_PRESENT,   // 卡片在场
+        STATE_REMOVAL_PENDING // 重新选卡失败，等待确认卡片离开
     };
     
     DetectionState currentState;
     int irqCurr, irqPrev;
     unsigned long lastDetectionTime;
+
+    // 在场卡片
+    uint8_t cardUID[7];
+    uint8_t cardUIDLength;     // 0表示尚未读取
+    bool targetPending;        // PN532检测到目标但UID尚未读取
+
+    // 在场检查时间
+    unsigned long lastPresenceCheck;
+    unsigned long removalStartTime;
     
-    // 卡片持续在场的延迟时间（毫秒）
-    static const unsigned long CARD_PERSISTENCE_DELAY = 500;
+    // 卡片在场期间的重新选卡间隔（毫秒）
+    static const unsigned long PRESENCE_CHECK_INTERVAL_MS = 100;
+
+    // 选卡失败后确认卡片离开的时间（毫秒），过滤卡片在场边缘的抖动
+    static const unsigned long REMOVAL_CONFIRM_MS = 150;
 
 public:
     /**
-     * 构造函数
+     * 构造函数（I2C读卡器）
      * @param irq IRQ引脚
      * @param reset 复位引脚
+     * @param wire I2C总线
+     * @param name 读卡器名称
+     */
+    NFCManager(int irq, int reset, TwoWire* wire = &Wire, const char* name = "NFC");
+
+    /**
+     * 构造函数（SPI读卡器）
+     * @param ss 片选引脚
+     * @param irq IRQ引脚
+     * @param spi SPI总线
+     * @param name 读卡器名称
      */
-    NFCManager(int irq, int reset);
+    NFCManager(int ss, int irq, SPIClass* spi, const char* name);
     
     /**
      * 初始化NFC管理器
@@ -60,11 +107,26 @@ public:
     
     /**
      * 读取卡片UID
+     * 卡片在场且UID已读取过时直接返回缓存的UID
      * @param uid 输出UID缓冲区
      * @param uidLength 输出UID长度
      * @return 读取是否成功
      */
     bool readCardUID(uint8_t* uid, uint8_t* uidLength);
+
+    /**
+     * 获取最近一张卡片的UID（在场或刚离开）
+     * @param uid 输出UID缓冲区（至少7字节）
+     * @param uidLength 输出UID长度
+     * @return 是否有记录
+     */
+    bool getLastCardUID(uint8_t* uid, uint8_t* uidLength) const;
+
+    /**
+     * 检查是否有卡片在场
+     * @return 是否在场
+     */
+    bool isCardPresent() const;
     
     /**
      * 认证卡片块
@@ -75,6 +137,12 @@ public:
      * @return 认证是否成功
      */
     bool authenticateBlock(uint8_t* uid, uint8_t uidLength, uint8_t blockNumber, uint8_t* key);
+
+    /**
+     * 重新选择在场的卡片（认证失败后卡片回到空闲状态，重新选择后才能用其他密钥认证）
+     * @return 是否重新选到同一张卡片
+     */
+    bool reselectCard();
     
     /**
      * 写入数据块
@@ -95,6 +163,12 @@ public:
      */
     bool getIRQState() const;
 
+    /**
+     * 获取读卡器名称
+     * @return 读卡器名称
+     */
+    const char* getName() const;
+
 private:
     /**
      * 启动被动目标检测
@@ -107,6 +181,25 @@ private:
      * @return 是否检测到下降沿
      */
     bool checkIRQFallingEdge();
+
+    /**
+     * 读取PN532已检测到的目标UID并更新在场卡片
+     * @param sameCard 输出：是否与之前的在场卡片相同（之前未读取过UID时视为相同）
+     * @return 读取是否成功
+     */
+    bool readTargetUID(bool& sameCard);
+
+    /**
+     * 卡片在场时定期重新选卡
+     * @return 卡片检测结果
+     */
+    CardDetectionResult checkPresence();
+
+    /**
+     * 等待确认卡片离开
+     * @return 卡片检测结果
+     */
+    CardDetectionResult checkRemoval();
 };
 
 #endif // NFCMANAGER_H
@@ -0,0 +1,321 @@
+#include "AccessPolicy.h"
+#include "../data/CardDatabase.h"
+#include <algorithm>
+
+AccessPolicy::AccessPolicy() {
+    clear();
+}
+
+void AccessPolicy::clear() {
+    for (size_t i = 0; i < MAX_GROUPS; i++) {
+        groupNames[i] = "";
+    }
+    memset(hourMasks, 0, sizeof(hourMasks));
+    groupCount = 0;
+    alwaysOpenGroups = 0;
+    anyDoorGroups = 0;
+    for (size_t i = 0; i < MAX_DOORS; i++) {
+        doorRules[i].name = "";
+        doorRules[i].groups = 0;
+    }
+    doorCount = 0;
+    cards.clear();
+}
+
+bool AccessPolicy::compile(const JsonDocument& policy, CardDatabase* db) {
+    unsigned long start = micros();
+    bool success = true;
+    clear();
+
+    // 组和时间窗口
+    JsonArrayConst groups = policy["groups"];
+    for (JsonObjectConst groupObj : groups) {
+        String name = groupObj["name"] | "";
+        if (name.length() == 0) {
+            Serial.println("Access Policy: Group without name ignored");
+            success = false;
+            continue;
+        }
+        int group = addGroup(name);
+        if (group < 0) {
+            Serial.println("Access Policy: Too many groups, ignored: " + name);
+            success = false;
+            continue;
+        }
+
+        JsonArrayConst windows = groupObj["windows"];
+        if (windows.isNull()) {
+            for (int day = 0; day < 7; day++) {
+                addWindow(group, day, 0, 24);
+            }
+        }
+        for (JsonObjectConst window : windows) {
+            int from = window["from"] | 0;
+            int to = window["to"] | 24;
+            JsonArrayConst days = window["days"];
+            if (days.isNull()) {
+                for (int day = 0; day < 7; day++) {
+                    addWindow(group, day, from, to);
+                }
+            }
+            for (int day : days) {
+                if (day < 1 || day > 7) {
+                    Serial.println("Access Policy: Invalid day in group " + name);
+                    success = false;
+                    continue;
+                }
+                addWindow(group, day - 1, from, to);
+            }
+        }
+
+        JsonArrayConst doors = groupObj["doors"];
+        for (const char* door : doors) {
+            if (door == nullptr || !addDoor(group, door)) {
+                Serial.println("Access Policy: Too many doors, ignored rule in group " + name);
+                success = false;
+            }
+        }
+    }
+
+    // 卡片的组分配，一次性排序
+    if (db != nullptr) {
+        db->forEachCard([this](JsonObjectConst card) {
+            JsonArrayConst names = card["groups"];
+            if (names.isNull()) {
+                return true;
+            }
+            String uid = card["uid"] | "";
+            CardEntry entry;
+            if (makeEntry(uid, entry)) {
+                entry.groups = resolveGroups(names, uid);
+                cards.push_back(entry);
+            }
+            return true;
+        });
+        std::sort(cards.begin(), cards.end(), cardLess);
+    }
+
+    Serial.printf("Access Policy: Compiled %u groups, %u restricted cards in %lu us\n",
+                  (unsigned)groupCount, (unsigned)cards.size(), micros() - start);
+    return success;
+}
+
+int AccessPolicy::addGroup(const String& name) {
+    for (size_t i = 0; i < groupCount; i++) {
+        if (groupNames[i] == name) {
+            return i;
+        }
+    }
+    if (groupCount >= MAX_GROUPS) {
+        return -1;
+    }
+    groupNames[groupCount] = name;
+    memset(&hourMasks[groupCount], 0, sizeof(HourMask));
+    anyDoorGroups |= (GroupMask)1 << groupCount;
+    return groupCount++;
+}
+
+void AccessPolicy::addWindow(int group, int day, int fromHour, int toHour) {
+    if (group < 0 || (size_t)group >= groupCount || day < 0 || day > 6 ||
+        fromHour < 0 || fromHour > 23 || toHour < 0 || toHour > 24) {
+        return;
+    }
+
+    // to不大于from表示跨越午夜，周日晚上的窗口延续到周一早上
+    int span = toHour > fromHour ? toHour - fromHour : toHour + 24 - fromHour;
+    HourMask& mask = hourMasks[group];
+    for (int i = 0; i < span; i++) {
+        int hour = (day * 24 + fromHour + i) % HOURS_PER_WEEK;
+        mask.bits[hour >> 5] |= 1u << (hour & 31);
+    }
+
+    bool full = true;
+    for (int hour = 0; hour < HOURS_PER_WEEK && full; hour++) {
+        full = (mask.bits[hour >> 5] >> (hour & 31)) & 1;
+    }
+    if (full) {
+        alwaysOpenGroups |= (GroupMask)1 << group;
+    }
+}
+
+bool AccessPolicy::addDoor(int group, const String& door) {
+    if (group < 0 || (size_t)group >= groupCount) {
+        return false;
+    }
+    // 指定了门的组不再对所有门有效
+    anyDoorGroups &= ~((GroupMask)1 << group);
+    for (size_t i = 0; i < doorCount; i++) {
+        if (doorRules[i].name == door) {
+            doorRules[i].groups |= (GroupMask)1 << group;
+            return true;
+        }
+    }
+    if (doorCount >= MAX_DOORS) {
+        return false;
+    }
+    doorRules[doorCount].name = door;
+    doorRules[doorCount].groups = (GroupMask)1 << group;
+    doorCount++;
+    return true;
+}
+
+bool AccessPolicy::cardLess(const CardEntry& a, const CardEntry& b) {
+    if (a.uidLength != b.uidLength) {
+        return a.uidLength < b.uidLength;
+    }
+    return memcmp(a.uid, b.uid, a.uidLength) < 0;
+}
+
+bool AccessPolicy::makeEntry(const String& uid, CardEntry& entry) {
+    memset(&entry, 0, sizeof(entry));
+    return Utils::stringToUid(uid, entry.uid, &entry.uidLength) && entry.uidLength > 0;
+}
+
+AccessPolicy::GroupMask AccessPolicy::resolveGroups(JsonArrayConst names, const String& uid) const {
+    GroupMask mask = 0;
+    for (const char* name : names) {
+        bool found = false;
+        for (size_t i = 0; i < groupCount && !found; i++) {
+            if (name != nullptr && groupNames[i] == name) {
+                mask |= (GroupMask)1 << i;
+                found = true;
+            }
+        }
+        if (!found) {
+            Serial.print("Access Policy: Unknown group for card ");
+            Serial.print(uid);
+            Serial.print(": ");
+            Serial.println(name ? name : "(null)");
+        }
+    }
+    return mask;
+}
+
+const AccessPolicy::CardEntry* AccessPolicy::findCard(const uint8_t* uid, uint8_t uidLength) const {
+    if (cards.empty() || uidLength == 0 || uidLength > Utils::MAX_UID_SIZE) {
+        return nullptr;
+    }
+    CardEntry key;
+    memset(&key, 0, sizeof(key));
+    memcpy(key.uid, uid, uidLength);
+    key.uidLength = uidLength;
+
+    auto it = std::lower_bound(cards.begin(), cards.end(), key, cardLess);
+    if (it == cards.end() || cardLess(key, *it)) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+void AccessPolicy::setCardGroups(const uint8_t* uid, uint8_t uidLength, GroupMask groups) {
+    if (uidLength == 0 || uidLength > Utils::MAX_UID_SIZE) {
+        return;
+    }
+    CardEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.uid, uid, uidLength);
+    entry.uidLength = uidLength;
+    entry.groups = groups;
+
+    auto it = std::lower_bound(cards.begin(), cards.end(), entry, cardLess);
+    if (it != cards.end() && !cardLess(entry, *it)) {
+        it->groups = groups;
+    } else {
+        cards.insert(it, entry);
+    }
+}
+
+bool AccessPolicy::updateCard(const String& uid, JsonArrayConst groups) {
+    CardEntry entry;
+    if (!makeEntry(uid, entry)) {
+        return false;
+    }
+
+    if (groups.isNull()) {
+        auto it = std::lower_bound(cards.begin(), cards.end(), entry, cardLess);
+        if (it != cards.end() && !cardLess(entry, *it)) {
+            cards.erase(it);
+        }
+        return true;
+    }
+
+    setCardGroups(entry.uid, entry.uidLength, resolveGroups(groups, uid));
+    return true;
+}
+
+AccessPolicy::GroupMask AccessPolicy::doorGroups(const char* door) const {
+    GroupMask mask = anyDoorGroups;
+    for (size_t i = 0; i < doorCount; i++) {
+        if (doorRules[i].name == door) {
+            mask |= doorRules[i].groups;
+            break;
+        }
+    }
+    return mask;
+}
+
+AccessPolicy::Decision AccessPolicy::evaluate(const uint8_t* uid, uint8_t uidLength, const char* door,
+                                              int hourOfWeek) const {
+    const CardEntry* entry = findCard(uid, uidLength);
+    if (entry == nullptr) {
+        // 没有组分配的卡片不受限制
+        return DECISION_ALLOW;
+    }
+
+    GroupMask groups = entry->groups & doorGroups(door);
+    if (groups == 0) {
+        return DECISION_DENY_DOOR;
+    }
+
+    if (hourOfWeek < 0 || hourOfWeek >= HOURS_PER_WEEK) {
+        return (groups & alwaysOpenGroups) ? DECISION_ALLOW : DECISION_DENY_SCHEDULE;
+    }
+
+    // 依次检查卡片可用组在当前小时的位
+    uint32_t word = hourOfWeek >> 5;
+    uint32_t bit = 1u << (hourOfWeek & 31);
+    for (GroupMask remaining = groups; remaining != 0; remaining &= remaining - 1) {
+        if (hourMasks[__builtin_ctz(remaining)].bits[word] & bit) {
+            return DECISION_ALLOW;
+        }
+    }
+    return DECISION_DENY_SCHEDULE;
+}
+
+size_t AccessPolicy::getGroupCount() const {
+    return groupCount;
+}
+
+size_t AccessPolicy::getRestrictedCardCount() const {
+    return cards.size();
+}
+
+void AccessPolicy::printSummary() const {
+    Serial.println("=== Access Policy ===");
+    Serial.printf("Groups: %u, restricted cards: %u\n", (unsigned)groupCount, (unsigned)cards.size());
+    for (size_t i = 0; i < groupCount; i++) {
+        int hours = 0;
+        for (size_t w = 0; w < sizeof(hourMasks[i].bits) / sizeof(hourMasks[i].bits[0]); w++) {
+            hours += __builtin_popcount(hourMasks[i].bits[w]);
+        }
+        Serial.printf("- %s: %d h/week%s", groupNames[i].c_str(), hours,
+                      (anyDoorGroups >> i) & 1 ? ", all doors" : ", doors:");
+        for (size_t d = 0; d < doorCount; d++) {
+            if ((doorRules[d].groups >> i) & 1) {
+                Serial.print(" ");
+                Serial.print(doorRules[d].name);
+            }
+        }
+        Serial.println();
+    }
+    Serial.println("=====================");
+}
+
+const char* AccessPolicy::decisionName(Decision decision) {
+    switch (decision) {
+        case DECISION_ALLOW: return "allow";
+        case DECISION_DENY_DOOR: return "deny_door";
+        case DECISION_DENY_SCHEDULE: return "deny_schedule";
+    }
+    return "unknown";
+}
@@ -0,0 +1,190 @@
+#ifndef ACCESSPOLICY_H
+#define ACCESSPOLICY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include "../utils/Utils.h"
+
+class CardDatabase;
+
+/**
+ * 访问策略
+ * 按访问组和每周时间窗口限制卡片，加载时编译为位图，刷卡时只做几次位运算：
+ * - 每个组一个168位的小时掩码（周一0点为第0位，每天24位）
+ * - 每张受限卡片一个组位图（按UID排序，二分查找）
+ * - 每扇门一个允许的组位图（未指定门的组在所有门有效）
+ * 卡片条目没有groups字段时不受限制（兼容已有的卡片）；有groups字段但为空时始终拒绝
+ *
+ * 策略文件格式（/policy.json）：
+ *   {"groups": [
+ *     {"name": "staff", "windows": [{"days": [1,2,3,4,5], "from": 8, "to": 18}], "doors": ["Main"]},
+ *     {"name": "admin"}
+ *   ]}
+ * days取1（周一）到7（周日），省略表示每天；from/to为小时，to不大于from表示跨越午夜；
+ * 没有windows的组全周开放
+ */
+class AccessPolicy {
+public:
+    // 最大组数（组位图的位数）
+    static const size_t MAX_GROUPS = 32;
+
+    // 最多可单独限制的门数
+    static const size_t MAX_DOORS = 8;
+
+    // 每周小时数
+    static const int HOURS_PER_WEEK = 168;
+
+    // 时间未知（从未设置时钟或断电后恢复的时间，见Clock::hourOfWeek），此时失败关闭：只有全周开放的组有效
+    static const int HOUR_UNKNOWN = -1;
+
+    typedef uint32_t GroupMask;
+
+    // 决策结果
+    enum Decision {
+        DECISION_ALLOW,         // 允许（包括不受限制的卡片）
+        DECISION_DENY_DOOR,     // 卡片所属的组都不能使用这扇门
+        DECISION_DENY_SCHEDULE  // 当前时间不在任何可用组的时间窗口内
+    };
+
+private:
+    // 168位小时掩码
+    struct HourMask {
+        uint32_t bits[(HOURS_PER_WEEK + 31) / 32];
+    };
+
+    // 受限卡片
+    struct CardEntry {
+        uint8_t uid[Utils::MAX_UID_SIZE];
+        uint8_t uidLength;
+        GroupMask groups;
+    };
+
+    // 限制了门的组
+    struct DoorRule {
+        String name;
+        GroupMask groups;
+    };
+
+    String groupNames[MAX_GROUPS];
+    HourMask hourMasks[MAX_GROUPS];
+    size_t groupCount;
+
+    // 全周开放的组（时间未知时仍然有效）
+    GroupMask alwaysOpenGroups;
+
+    // 未限制门的组
+    GroupMask anyDoorGroups;
+
+    DoorRule doorRules[MAX_DOORS];
+    size_t doorCount;
+
+    std::vector<CardEntry> cards;
+
+    static bool cardLess(const CardEntry& a, const CardEntry& b);
+    static bool makeEntry(const String& uid, CardEntry& entry);
+    const CardEntry* findCard(const uint8_t* uid, uint8_t uidLength) const;
+    GroupMask resolveGroups(JsonArrayConst names, const String& uid) const;
+
+public:
+    /**
+     * 构造函数
+     */
+    AccessPolicy();
+
+    /**
+     * 清空策略（所有卡片不受限制）
+     */
+    void clear();
+
+    /**
+     * 编译策略文件和卡片数据库中的组分配
+     * @param policy 策略JSON（可以为空文档）
+     * @param db 卡片数据库
+     * @return 是否成功（组数超限等错误时返回false，已解析的部分仍然生效）
+     */
+    bool compile(const JsonDocument& policy, CardDatabase* db);
+
+    /**
+     * 添加一个组（初始没有时间窗口，对所有门有效）
+     * @param name 组名称
+     * @return 组序号，超过MAX_GROUPS时为-1
+     */
+    int addGroup(const String& name);
+
+    /**
+     * 为组添加时间窗口
+     * @param group 组序号
+     * @param day 星期（0为周一，6为周日）
+     * @param fromHour 开始小时
+     * @param toHour 结束小时（不大于开始小时表示跨越午夜）
+     */
+    void addWindow(int group, int day, int fromHour, int toHour);
+
+    /**
+     * 限制组只能使用指定的门
+     * @param group 组序号
+     * @param door 门名称
+     * @return 是否成功（门数超限时返回false）
+     */
+    bool addDoor(int group, const String& door);
+
+    /**
+     * 设置卡片的组位图（加入受限卡片）
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @param groups 组位图
+     */
+    void setCardGroups(const uint8_t* uid, uint8_t uidLength, GroupMask groups);
+
+    /**
+     * 根据卡片数据库条目更新单张卡片
+     * @param uid 卡片UID字符串
+     * @param groups 组名称数组，为null时卡片不受限制
+     * @return 是否成功
+     */
+    bool updateCard(const String& uid, JsonArrayConst groups);
+
+    /**
+     * 获取门可用的组位图
+     * @param door 门名称
+     * @return 组位图
+     */
+    GroupMask doorGroups(const char* door) const;
+
+    /**
+     * 对一次刷卡做出决策
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @param door 门名称
+     * @param hourOfWeek 周内小时（0-167），HOUR_UNKNOWN表示时间未知，只有全周开放的组有效
+     * @return 决策结果
+     */
+    Decision evaluate(const uint8_t* uid, uint8_t uidLength, const char* door, int hourOfWeek) const;
+
+    /**
+     * 获取组数
+     * @return 组数
+     */
+    size_t getGroupCount() const;
+
+    /**
+     * 获取受限卡片数
+     * @return 受限卡片数
+     */
+    size_t getRestrictedCardCount() const;
+
+    /**
+     * 打印组、时间窗口覆盖的小时数和门限制
+     */
+    void printSummary() const;
+
+    /**
+     * 获取决策结果名称
+     * @param decision 决策结果
+     * @return 名称
+     */
+    static const char* decisionName(Decision decision);
+};
+
+#endif // ACCESSPOLICY_H
@@ -0,0 +1,70 @@
+#include "KeyDiversifier.h"
+#include <Preferences.h>
+#include <esp_random.h>
+#include "mbedtls/cmac.h"
+
+const char* KeyDiversifier::NVS_NAMESPACE = "keydiv";
+const char* KeyDiversifier::NVS_MASTER_KEY = "master";
+
+KeyDiversifier::KeyDiversifier() : ready(false) {
+    memset(masterKey, 0, sizeof(masterKey));
+}
+
+KeyDiversifier::~KeyDiversifier() {
+    memset(masterKey, 0, sizeof(masterKey));
+}
+
+bool KeyDiversifier::initialize() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("Key Diversifier: Failed to open NVS");
+        return false;
+    }
+
+    if (prefs.getBytesLength(NVS_MASTER_KEY) == MASTER_KEY_SIZE) {
+        prefs.getBytes(NVS_MASTER_KEY, masterKey, MASTER_KEY_SIZE);
+        Serial.println("Key Diversifier: Master key loaded");
+    } else {
+        // 首次启动，由硬件随机数生成主密钥（熵源在initializeSystem中开启）
+        esp_fill_random(masterKey, MASTER_KEY_SIZE);
+        if (prefs.putBytes(NVS_MASTER_KEY, masterKey, MASTER_KEY_SIZE) != MASTER_KEY_SIZE) {
+            Serial.println("Key Diversifier: Failed to store master key");
+            prefs.end();
+            return false;
+        }
+        Serial.println("Key Diversifier: New master key generated");
+    }
+
+    prefs.end();
+    ready = true;
+    return true;
+}
+
+bool KeyDiversifier::isReady() const {
+    return ready;
+}
+
+bool KeyDiversifier::deriveKey(const uint8_t* uid, uint8_t uidLength, uint8_t sector, uint8_t* key) const {
+    if (!ready || uidLength == 0 || uidLength > 10) {
+        return false;
+    }
+
+    // 派生数据：常量 | UID | 扇区号
+    uint8_t input[12];
+    size_t inputLength = 0;
+    input[inputLength++] = DERIVATION_CONSTANT;
+    memcpy(input + inputLength, uid, uidLength);
+    inputLength += uidLength;
+    input[inputLength++] = sector;
+
+    const mbedtls_cipher_info_t* cipherInfo = mbedtls_cipher_info_from_type(MBEDTLS_CIPHER_AES_128_ECB);
+    uint8_t mac[16];
+    if (cipherInfo == nullptr ||
+        mbedtls_cipher_cmac(cipherInfo, masterKey, MASTER_KEY_SIZE * 8, input, inputLength, mac) != 0) {
+        return false;
+    }
+
+    memcpy(key, mac, Utils::KEY_SIZE);
+    memset(mac, 0, sizeof(mac));
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef KEYDIVERSIFIER_H
+#define KEYDIVERSIFIER_H
+
+#include <Arduino.h>
+#include "../utils/Utils.h"
+
+/**
+ * 密钥分散器
+ * 由设备主密钥和卡片UID派生扇区密钥：key = AES-CMAC(master, 0x01 | UID | sector)[0..5]
+ * mbedtls在ESP32上使用AES硬件加速器
+ * 主密钥首次启动时由硬件随机数生成并保存在NVS中，不会被打印或导出
+ */
+class KeyDiversifier {
+public:
+    // 主密钥长度（AES-128）
+    static const size_t MASTER_KEY_SIZE = 16;
+
+private:
+    uint8_t masterKey[MASTER_KEY_SIZE];
+    bool ready;
+
+    // NVS存储位置
+    static const char* NVS_NAMESPACE;
+    static const char* NVS_MASTER_KEY;
+
+    // 派生数据中的域分隔常量
+    static const uint8_t DERIVATION_CONSTANT = 0x01;
+
+public:
+    /**
+     * 构造函数
+     */
+    KeyDiversifier();
+
+    /**
+     * 析构函数，清除内存中的主密钥
+     */
+    ~KeyDiversifier();
+
+    /**
+     * 加载主密钥，不存在时生成并保存
+     * @return 初始化是否成功
+     */
+    bool initialize();
+
+    /**
+     * 主密钥是否已加载
+     * @return 是否可用
+     */
+    bool isReady() const;
+
+    /**
+     * 派生卡片扇区密钥
+     * @param uid 卡片UID
+     * @param uidLength UID长度
+     * @param sector 扇区号
+     * @param key 输出的密钥（Utils::KEY_SIZE字节）
+     * @return 派生是否成功
+     */
+    bool deriveKey(const uint8_t* uid, uint8_t uidLength, uint8_t sector, uint8_t* key) const;
+};
+
+#endif // KEYDIVERSIFIER_H
@@ -0,0 +1,151 @@
+#include "KeyPool.h"
+#include <esp_random.h>
+
+KeyPool::KeyPool()
+    : head(0), count(0), refillTaskHandle(nullptr),
+      generatedCount(0), servedCount(0), fallbackCount(0),
+      lowWatermark(POOL_CAPACITY), refillWallMicros(0) {
+    poolMux = portMUX_INITIALIZER_UNLOCKED;
+}
+
+KeyPool::~KeyPool() {
+    if (refillTaskHandle != nullptr) {
+        vTaskDelete(refillTaskHandle);
+        refillTaskHandle = nullptr;
+    }
+    memset(keys, 0, sizeof(keys));
+}
+
+bool KeyPool::initialize() {
+    if (refillTaskHandle != nullptr) {
+        return true;
+    }
+
+    // 低优先级（高于空闲任务，不与空闲任务争抢CPU和看门狗喂狗），每生成一个密钥让出CPU
+    BaseType_t result = xTaskCreate(
+        refillTaskFunction,
+        "KeyPoolRefill",
+        2048,
+        this,
+        1,
+        &refillTaskHandle
+    );
+
+    if (result != pdPASS) {
+        Serial.println("Key Pool: Failed to start refill task");
+        refillTaskHandle = nullptr;
+        return false;
+    }
+
+    Serial.println("Key Pool: Refill task started");
+    return true;
+}
+
+bool KeyPool::take(uint8_t* key) {
+    bool fromPool = false;
+
+    portENTER_CRITICAL(&poolMux);
+    if (count > 0) {
+        memcpy(key, keys[head], Utils::KEY_SIZE);
+        memset(keys[head], 0, Utils::KEY_SIZE);
+        head = (head + 1) % POOL_CAPACITY;
+        count--;
+        servedCount++;
+        if (count < lowWatermark) {
+            lowWatermark = count;
+        }
+        fromPool = true;
+    } else {
+        fallbackCount++;
+        lowWatermark = 0;
+    }
+    portEXIT_CRITICAL(&poolMux);
+
+    if (!fromPool) {
+        esp_fill_random(key, Utils::KEY_SIZE);
+    }
+
+    // 唤醒后台任务补充
+    if (refillTaskHandle != nullptr) {
+        xTaskNotifyGive(refillTaskHandle);
+    }
+
+    return fromPool;
+}
+
+bool KeyPool::refillOne() {
+    // 在临界区外生成，避免阻塞取密钥
+    uint8_t key[Utils::KEY_SIZE];
+    esp_fill_random(key, Utils::KEY_SIZE);
+
+    bool stored = false;
+    portENTER_CRITICAL(&poolMux);
+    if (count < POOL_CAPACITY) {
+        memcpy(keys[(head + count) % POOL_CAPACITY], key, Utils::KEY_SIZE);
+        count++;
+        generatedCount++;
+        stored = true;
+    }
+    portEXIT_CRITICAL(&poolMux);
+
+    memset(key, 0, sizeof(key));
+    return stored;
+}
+
+KeyPool::Stats KeyPool::getStats() {
+    Stats stats;
+    portENTER_CRITICAL(&poolMux);
+    stats.depth = count;
+    stats.capacity = POOL_CAPACITY;
+    stats.generated = generatedCount;
+    stats.served = servedCount;
+    stats.fallbacks = fallbackCount;
+    stats.lowWatermark = lowWatermark;
+    stats.refillRate = refillWallMicros > 0 ? generatedCount * 1000000.0f / refillWallMicros : 0.0f;
+    portEXIT_CRITICAL(&poolMux);
+    return stats;
+}
+
+void KeyPool::printStats() {
+    Stats stats = getStats();
+    Serial.println("=== Key Pool ===");
+    Serial.print("Depth: ");
+    Serial.print(stats.depth);
+    Serial.print("/");
+    Serial.println(stats.capacity);
+    Serial.print("Low watermark: ");
+    Serial.println(stats.lowWatermark);
+    Serial.print("Generated: ");
+    Serial.println(stats.generated);
+    Serial.print("Served from pool: ");
+    Serial.println(stats.served);
+    Serial.print("Fallbacks (pool empty): ");
+    Serial.println(stats.fallbacks);
+    Serial.print("Refill rate: ");
+    Serial.print(stats.refillRate, 0);
+    Serial.println(" keys/s");
+    Serial.println("================");
+}
+
+// 静态任务函数 - 后台填充
+void KeyPool::refillTaskFunction(void* parameter) {
+    KeyPool* pool = static_cast<KeyPool*>(parameter);
+
+    while (true) {
+        // 填满后等待取用通知；填充速率按每轮填充实际经过的时间计算（包括让出CPU的时间）
+        unsigned long start = micros();
+        bool refilled = false;
+        while (pool->refillOne()) {
+            refilled = true;
+            // 让出CPU，避免长时间占用
+            vTaskDelay(1);
+        }
+        if (refilled) {
+            unsigned long elapsed = micros() - start;
+            portENTER_CRITICAL(&pool->poolMux);
+            pool->refillWallMicros += elapsed;
+            portEXIT_CRITICAL(&pool->poolMux);
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef KEYPOOL_H
+#define KEYPOOL_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "../utils/Utils.h"
+
+/**
+ * 预生成密钥池
+ * 后台低优先级任务用ESP32硬件随机数（esp_fill_random，熵源在initializeSystem中开启）填充密钥池，
+ * 注册时直接取出现成的密钥，卡片在场期间不再生成随机数
+ * 池为空时退回到直接调用硬件随机数，并计入统计
+ */
+class KeyPool {
+public:
+    // 池容量（密钥个数）
+    static const size_t POOL_CAPACITY = 16;
+
+    /**
+     * 统计信息
+     */
+    struct Stats {
+        size_t depth;             // 当前池中密钥数
+        size_t capacity;          // 池容量
+        unsigned long generated;  // 后台生成的密钥总数
+        unsigned long served;     // 从池中取出的密钥数
+        unsigned long fallbacks;  // 池为空时直接生成的次数
+        size_t lowWatermark;      // 取密钥后池中剩余的最少密钥数
+        float refillRate;         // 后台填充速率（密钥/秒，按填充期间经过的时间计算）
+    };
+
+private:
+    uint8_t keys[POOL_CAPACITY][Utils::KEY_SIZE];
+    size_t head;
+    size_t count;
+    portMUX_TYPE poolMux;
+
+    TaskHandle_t refillTaskHandle;
+
+    // 统计
+    unsigned long generatedCount;
+    unsigned long servedCount;
+    unsigned long fallbackCount;
+    size_t lowWatermark;
+    unsigned long refillWallMicros;  // 后台填充经过的总时间
+
+    // 静态任务函数
+    static void refillTaskFunction(void* parameter);
+
+    /**
+     * 生成一个密钥并放入池中
+     * @return 是否放入（池满时返回false）
+     */
+    bool refillOne();
+
+public:
+    /**
+     * 构造函数
+     */
+    KeyPool();
+
+    /**
+     * 析构函数
+     */
+    ~KeyPool();
+
+    /**
+     * 启动后台填充任务
+     * @return 启动是否成功
+     */
+    bool initialize();
+
+    /**
+     * 取出一个密钥（不阻塞）
+     * @param key 输出的密钥
+     * @return 是否来自预生成的池（false表示池为空，已直接生成）
+     */
+    bool take(uint8_t* key);
+
+    /**
+     * 获取统计信息
+     * @return 统计信息
+     */
+    Stats getStats();
+
+    /**
+     * 打印统计信息
+     */
+    void printStats();
+};
+
+#endif // KEYPOOL_H
@@ -0,0 +1,207 @@
+#include "PresenceTracker.h"
+#include "../data/FileSystemManager.h"
+
+const char* PresenceTracker::PRESENCE_FILE = "/presence.bin";
+
+PresenceTracker::PresenceTracker(const char* file)
+    : presentCount(0), presenceFile(file ? file : PRESENCE_FILE), dirty(false), dirtySince(0) {
+    memset(entries, 0, sizeof(entries));
+    memset(&stats, 0, sizeof(stats));
+}
+
+uint32_t PresenceTracker::hashUID(const uint8_t* uid, uint8_t uidLength) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (uint8_t i = 0; i < uidLength; i++) {
+        hash = (hash ^ uid[i]) * 16777619u;
+    }
+    return hash;
+}
+
+int PresenceTracker::find(const uint8_t* uid, uint8_t uidLength) const {
+    if (uidLength == 0 || uidLength > MAX_UID_LENGTH) {
+        return -1;
+    }
+    // 装载率不超过3/4，线性探测在遇到空槽前很快结束
+    size_t index = hashUID(uid, uidLength) & (CAPACITY - 1);
+    for (size_t i = 0; i < CAPACITY; i++) {
+        const Entry& entry = entries[index];
+        if (entry.uidLength == 0) {
+            return -1;
+        }
+        if (entry.uidLength == uidLength && memcmp(entry.uid, uid, uidLength) == 0) {
+            return index;
+        }
+        index = (index + 1) & (CAPACITY - 1);
+    }
+    return -1;
+}
+
+bool PresenceTracker::insert(const uint8_t* uid, uint8_t uidLength) {
+    if (uidLength == 0 || uidLength > MAX_UID_LENGTH || presentCount >= MAX_PRESENT) {
+        return false;
+    }
+    size_t index = hashUID(uid, uidLength) & (CAPACITY - 1);
+    while (entries[index].uidLength != 0) {
+        index = (index + 1) & (CAPACITY - 1);
+    }
+    memcpy(entries[index].uid, uid, uidLength);
+    entries[index].uidLength = uidLength;
+    presentCount++;
+    return true;
+}
+
+void PresenceTracker::removeAt(size_t index) {
+    // 后移删除：把探测链上后面的条目移回空位，不留墓碑
+    entries[index].uidLength = 0;
+    presentCount--;
+
+    size_t hole = index;
+    size_t next = (index + 1) & (CAPACITY - 1);
+    while (entries[next].uidLength != 0) {
+        size_t home = hashUID(entries[next].uid, entries[next].uidLength) & (CAPACITY - 1);
+        // 条目的理想位置不在(hole, next]之间时可以移到空位
+        bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            entries[hole] = entries[next];
+            entries[next].uidLength = 0;
+            hole = next;
+        }
+        next = (next + 1) & (CAPACITY - 1);
+    }
+}
+
+void PresenceTracker::markDirty(unsigned long now) {
+    if (!dirty) {
+        dirty = true;
+        dirtySince = now;
+    }
+}
+
+bool PresenceTracker::initialize() {
+    fs::FS& fileSystem = FileSystemManager::fileSystem();
+    memset(entries, 0, sizeof(entries));
+    presentCount = 0;
+    dirty = false;
+
+    FileSystemManager::recoverFile(presenceFile);
+    if (!fileSystem.exists(presenceFile)) {
+        return true;
+    }
+    File file = fileSystem.open(presenceFile, FILE_READ);
+    if (!file) {
+        Serial.println("Presence Tracker: Failed to open file");
+        return false;
+    }
+
+    uint8_t record[MAX_UID_LENGTH + 1];
+    while (file.read(record, sizeof(record)) == sizeof(record)) {
+        uint8_t length = record[0];
+        if (length > 0 && length <= MAX_UID_LENGTH && find(record + 1, length) < 0) {
+            insert(record + 1, length);
+        }
+    }
+    file.close();
+
+    Serial.printf("Presence Tracker: Restored %u present cards\n", (unsigned)presentCount);
+    return true;
+}
+
+PresenceTracker::Verdict PresenceTracker::admit(const uint8_t* uid, uint8_t uidLength, Direction direction,
+                                                unsigned long now) {
+    if (direction == DIRECTION_NONE) {
+        return VERDICT_ALLOW;
+    }
+
+    int index = find(uid, uidLength);
+    if (direction == DIRECTION_IN) {
+        if (index >= 0) {
+            stats.passbackDenied++;
+            return VERDICT_PASSBACK;
+        }
+        if (!insert(uid, uidLength)) {
+            // 表满时仍然放行，只是不再跟踪
+            stats.overflows++;
+        }
+        stats.entries++;
+    } else {
+        if (index >= 0) {
+            removeAt(index);
+        } else {
+            stats.unmatchedExits++;
+        }
+        stats.exits++;
+    }
+    markDirty(now);
+    return VERDICT_ALLOW;
+}
+
+bool PresenceTracker::isPresent(const uint8_t* uid, uint8_t uidLength) const {
+    return find(uid, uidLength) >= 0;
+}
+
+void PresenceTracker::persistIfDue(unsigned long now) {
+    if (dirty && now - dirtySince >= PERSIST_INTERVAL_MS) {
+        persist();
+        // 失败时也等待下一个间隔再重试
+        dirtySince = now;
+    }
+}
+
+bool PresenceTracker::persist() {
+    fs::FS& fileSystem = FileSystemManager::fileSystem();
+    String tempFile = FileSystemManager::tempFilePath(presenceFile);
+    File file = fileSystem.open(tempFile, FILE_WRITE);
+    if (!file) {
+        Serial.println("Presence Tracker: Failed to open temporary file");
+        return false;
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < CAPACITY && success; i++) {
+        if (entries[i].uidLength == 0) {
+            continue;
+        }
+        uint8_t record[MAX_UID_LENGTH + 1] = {0};
+        record[0] = entries[i].uidLength;
+        memcpy(record + 1, entries[i].uid, entries[i].uidLength);
+        success = file.write(record, sizeof(record)) == sizeof(record);
+    }
+    file.close();
+
+    if (!success) {
+        Serial.println("Presence Tracker: Failed to save presence state");
+        fileSystem.remove(tempFile);
+        return false;
+    }
+    if (!FileSystemManager::replaceFile(presenceFile)) {
+        Serial.println("Presence Tracker: Failed to replace presence file");
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+void PresenceTracker::clear(unsigned long now) {
+    memset(entries, 0, sizeof(entries));
+    presentCount = 0;
+    markDirty(now);
+}
+
+size_t PresenceTracker::getOccupancy() const {
+    return presentCount;
+}
+
+PresenceTracker::Stats PresenceTracker::getStats() const {
+    return stats;
+}
+
+void PresenceTracker::printOccupancy() const {
+    Serial.println("=== Occupancy ===");
+    Serial.printf("Present: %u (capacity %u)\n", (unsigned)presentCount, (unsigned)MAX_PRESENT);
+    Serial.printf("Entries: %lu, exits: %lu, unmatched exits: %lu\n",
+                  stats.entries, stats.exits, stats.unmatchedExits);
+    Serial.printf("Passback denied: %lu, untracked (table full): %lu\n", stats.passbackDenied, stats.overflows);
+    Serial.printf("Pending save: %s\n", dirty ? "yes" : "no");
+    Serial.println("=================");
+}
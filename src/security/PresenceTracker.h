@@ -0,0 +1,142 @@
+#ifndef PRESENCETRACKER_H
+#define PRESENCETRACKER_H
+
+#include <Arduino.h>
+
+/**
+ * 在场状态跟踪（防反传和实时人数）
+ * 开放寻址哈希表只保存当前在场的卡片，查找、进入、离开均为常数时间，在场人数即表中条目数
+ * - 进入：卡片已在场时拒绝（防反传：没有出门记录不能再次进入）
+ * - 离开：卡片不在场时仍然允许（如尾随进入），只计数
+ * 状态变化后延迟写入/presence.bin（最多每 PERSIST_INTERVAL_MS 一次），重启后恢复在场状态
+ */
+class PresenceTracker {
+public:
+    // 认证器方向
+    enum Direction {
+        DIRECTION_NONE,  // 不参与防反传（如单读卡器的门、按钮）
+        DIRECTION_IN,    // 进入读卡器
+        DIRECTION_OUT    // 出门读卡器
+    };
+
+    // 判断结果
+    enum Verdict {
+        VERDICT_ALLOW,     // 允许，状态已更新
+        VERDICT_PASSBACK   // 已在场的卡片再次进入，拒绝
+    };
+
+    // 表容量（必须是2的幂），最多跟踪的在场人数为其3/4
+    static const size_t CAPACITY = 512;
+    static const size_t MAX_PRESENT = CAPACITY * 3 / 4;
+
+    // UID最大长度
+    static const uint8_t MAX_UID_LENGTH = 7;
+
+    // 延迟持久化间隔
+    static const unsigned long PERSIST_INTERVAL_MS = 30000;
+
+    static const char* PRESENCE_FILE;
+
+    // 统计信息
+    struct Stats {
+        unsigned long entries;         // 进入次数
+        unsigned long exits;           // 离开次数
+        unsigned long passbackDenied;  // 防反传拒绝次数
+        unsigned long unmatchedExits;  // 不在场卡片的离开次数
+        unsigned long overflows;       // 表满无法记录的进入次数
+    };
+
+private:
+    struct Entry {
+        uint8_t uid[MAX_UID_LENGTH];
+        uint8_t uidLength;  // 0表示空槽
+    };
+
+    Entry entries[CAPACITY];
+    size_t presentCount;
+    Stats stats;
+
+    const char* presenceFile;
+    bool dirty;
+    unsigned long dirtySince;
+
+    static uint32_t hashUID(const uint8_t* uid, uint8_t uidLength);
+
+    /**
+     * 查找卡片所在的槽位
+     * @return 槽位序号，不存在时为-1
+     */
+    int find(const uint8_t* uid, uint8_t uidLength) const;
+
+    bool insert(const uint8_t* uid, uint8_t uidLength);
+    void removeAt(size_t index);
+    void markDirty(unsigned long now);
+
+public:
+    /**
+     * 构造函数
+     * @param file 持久化文件路径，默认为/presence.bin
+     */
+    PresenceTracker(const char* file = nullptr);
+
+    /**
+     * 从文件恢复在场状态（文件系统需已挂载）
+     * @return 是否成功（文件不存在也视为成功）
+     */
+    bool initialize();
+
+    /**
+     * 对一次已通过其他检查的通行做出防反传判断，允许时立即更新在场状态
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @param direction 认证器方向
+     * @param now 当前时间（用于延迟持久化）
+     * @return 判断结果
+     */
+    Verdict admit(const uint8_t* uid, uint8_t uidLength, Direction direction, unsigned long now);
+
+    /**
+     * 检查卡片是否在场
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @return 是否在场
+     */
+    bool isPresent(const uint8_t* uid, uint8_t uidLength) const;
+
+    /**
+     * 到期时写入在场状态（在主循环中调用）
+     * @param now 当前时间
+     */
+    void persistIfDue(unsigned long now);
+
+    /**
+     * 立即写入在场状态
+     * @return 是否成功
+     */
+    bool persist();
+
+    /**
+     * 清空在场状态（所有人视为已离开）
+     * @param now 当前时间
+     */
+    void clear(unsigned long now);
+
+    /**
+     * 获取在场人数
+     * @return 在场人数
+     */
+    size_t getOccupancy() const;
+
+    /**
+     * 获取统计信息
+     * @return 统计信息
+     */
+    Stats getStats() const;
+
+    /**
+     * 打印在场人数和统计
+     */
+    void printOccupancy() const;
+};
+
+#endif // PRESENCETRACKER_H
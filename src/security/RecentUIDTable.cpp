@@ -0,0 +1,169 @@
+#include "RecentUIDTable.h"
+
+RecentUIDTable::RecentUIDTable() {
+    clear();
+}
+
+uint32_t RecentUIDTable::hashUID(const uint8_t* uid, uint8_t uidLength) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (uint8_t i = 0; i < uidLength; i++) {
+        hash = (hash ^ uid[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool RecentUIDTable::isLocked(const Entry& entry, unsigned long now) {
+    // 有符号差值，millis()回绕后仍然正确
+    return entry.uidLength > 0 && (long)(entry.lockedUntil - now) > 0;
+}
+
+bool RecentUIDTable::isStale(const Entry& entry, unsigned long now) {
+    return entry.uidLength == 0 || (!isLocked(entry, now) && now - entry.lastSeen > ENTRY_TTL_MS);
+}
+
+RecentUIDTable::Entry* RecentUIDTable::lookup(const uint8_t* uid, uint8_t uidLength, unsigned long now, bool create) {
+    if (uidLength == 0 || uidLength > MAX_UID_SIZE) {
+        return nullptr;
+    }
+
+    size_t start = hashUID(uid, uidLength) & (CAPACITY - 1);
+    Entry* freeSlot = nullptr;
+    Entry* oldest = nullptr;
+
+    for (size_t i = 0; i < MAX_PROBE; i++) {
+        Entry& entry = entries[(start + i) & (CAPACITY - 1)];
+
+        if (entry.uidLength == uidLength && memcmp(entry.uid, uid, uidLength) == 0) {
+            if (isStale(entry, now)) {
+                // 过期条目的历史不再有意义
+                entry.failCount = 0;
+                entry.hasSuccess = false;
+            }
+            return &entry;
+        }
+
+        if (isStale(entry, now)) {
+            if (freeSlot == nullptr) {
+                freeSlot = &entry;
+            }
+        } else if (!isLocked(entry, now) && (oldest == nullptr || now - entry.lastSeen > now - oldest->lastSeen)) {
+            // 锁定中的条目不淘汰，否则攻击者可以通过刷其他卡解除锁定
+            oldest = &entry;
+        }
+    }
+
+    if (!create) {
+        return nullptr;
+    }
+
+    Entry* slot = freeSlot;
+    if (slot == nullptr) {
+        if (oldest == nullptr) {
+            return nullptr;
+        }
+        slot = oldest;
+        stats.evictions++;
+    }
+
+    memcpy(slot->uid, uid, uidLength);
+    slot->uidLength = uidLength;
+    slot->failCount = 0;
+    slot->hasSuccess = false;
+    slot->lastSeen = now;
+    slot->lastSuccess = 0;
+    slot->firstFailure = 0;
+    slot->lockedUntil = now;
+    return slot;
+}
+
+RecentUIDTable::Verdict RecentUIDTable::check(const uint8_t* uid, uint8_t uidLength, unsigned long now) {
+    Entry* entry = lookup(uid, uidLength, now, true);
+    if (entry == nullptr) {
+        if (uidLength == 0 || uidLength > MAX_UID_SIZE) {
+            return VERDICT_OK;
+        }
+        // 探测范围内全部锁定：无法跟踪这张卡。不能直接拒绝，否则攻击者用随机UID
+        // 锁定目标卡所在的探测范围就能锁死合法卡片；由调用者只放行已注册的卡片
+        stats.saturatedHits++;
+        return VERDICT_UNTRACKED;
+    }
+
+    entry->lastSeen = now;
+
+    if (isLocked(*entry, now)) {
+        stats.lockedHits++;
+        return VERDICT_LOCKED;
+    }
+
+    if (entry->hasSuccess && now - entry->lastSuccess < CARD_COOLDOWN_MS) {
+        stats.cooldownHits++;
+        return VERDICT_COOLDOWN;
+    }
+
+    return VERDICT_OK;
+}
+
+void RecentUIDTable::recordSuccess(const uint8_t* uid, uint8_t uidLength, unsigned long now) {
+    Entry* entry = lookup(uid, uidLength, now, true);
+    if (entry == nullptr) {
+        return;
+    }
+    entry->lastSeen = now;
+    entry->lastSuccess = now;
+    entry->hasSuccess = true;
+    entry->failCount = 0;
+}
+
+bool RecentUIDTable::recordFailure(const uint8_t* uid, uint8_t uidLength, unsigned long now) {
+    Entry* entry = lookup(uid, uidLength, now, true);
+    if (entry == nullptr) {
+        return false;
+    }
+    entry->lastSeen = now;
+
+    if (entry->failCount == 0 || now - entry->firstFailure > FAIL_WINDOW_MS) {
+        entry->failCount = 0;
+        entry->firstFailure = now;
+    }
+    entry->failCount++;
+
+    if (entry->failCount >= MAX_FAILED_ATTEMPTS) {
+        entry->failCount = 0;
+        entry->lockedUntil = now + LOCKOUT_MS;
+        stats.lockouts++;
+        return true;
+    }
+    return false;
+}
+
+void RecentUIDTable::clearCooldown(const uint8_t* uid, uint8_t uidLength, unsigned long now) {
+    Entry* entry = lookup(uid, uidLength, now, false);
+    if (entry != nullptr) {
+        entry->hasSuccess = false;
+    }
+}
+
+unsigned long RecentUIDTable::getLockRemaining(const uint8_t* uid, uint8_t uidLength, unsigned long now) {
+    Entry* entry = lookup(uid, uidLength, now, false);
+    if (entry == nullptr || !isLocked(*entry, now)) {
+        return 0;
+    }
+    return entry->lockedUntil - now;
+}
+
+void RecentUIDTable::clear() {
+    memset(entries, 0, sizeof(entries));
+    memset(&stats, 0, sizeof(stats));
+}
+
+RecentUIDTable::Stats RecentUIDTable::getStats(unsigned long now) const {
+    Stats result = stats;
+    result.occupied = 0;
+    for (size_t i = 0; i < CAPACITY; i++) {
+        if (!isStale(entries[i], now)) {
+            result.occupied++;
+        }
+    }
+    return result;
+}
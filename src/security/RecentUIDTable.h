@@ -0,0 +1,150 @@
+#ifndef RECENTUIDTABLE_H
+#define RECENTUIDTABLE_H
+
+#include <Arduino.h>
+
+/**
+ * 最近刷卡UID表
+ * 固定容量的开放寻址哈希表，记录最近出现过的卡片，用于：
+ * - 同卡冷却：同一张卡认证成功后 CARD_COOLDOWN_MS 内再次刷卡被忽略，不影响其他卡片
+ *   （读卡器确认卡片离开后可调用clearCooldown，移开再刷立即生效）
+ * - 暴力破解锁定：FAIL_WINDOW_MS 内失败 MAX_FAILED_ATTEMPTS 次后锁定 LOCKOUT_MS
+ * 每次查找最多探测 MAX_PROBE 个槽位，检查为常数时间
+ * 超过 ENTRY_TTL_MS 未出现且未被锁定的条目视为空闲，表满时淘汰探测范围内最久未出现的条目
+ * 锁定中的条目不淘汰（否则攻击者可以刷其他卡解除锁定）；探测范围内全部锁定时无法记录新卡片，
+ * 返回VERDICT_UNTRACKED，由调用者继续认证：未注册的卡片查数据库时被拒绝（失败关闭），
+ * 已注册的卡片照常开门，攻击者占满探测范围也无法锁死合法卡片
+ */
+class RecentUIDTable {
+public:
+    // 表容量（必须是2的幂）
+    static const size_t CAPACITY = 32;
+
+    // 每次查找的最大探测次数
+    static const size_t MAX_PROBE = 8;
+
+    // 同卡冷却时间（毫秒）
+    static const unsigned long CARD_COOLDOWN_MS = 1000;
+
+    // 失败计数窗口（毫秒）
+    static const unsigned long FAIL_WINDOW_MS = 60000;
+
+    // 窗口内允许的失败次数
+    static const uint8_t MAX_FAILED_ATTEMPTS = 5;
+
+    // 锁定时长（毫秒）
+    static const unsigned long LOCKOUT_MS = 30000;
+
+    // 条目过期时间（毫秒）
+    static const unsigned long ENTRY_TTL_MS = 300000;
+
+    // UID最大长度
+    static const uint8_t MAX_UID_SIZE = 10;
+
+    // 检查结果
+    enum Verdict {
+        VERDICT_OK,       // 允许继续认证
+        VERDICT_COOLDOWN, // 同卡冷却中，忽略
+        VERDICT_LOCKED,   // 失败次数过多，锁定中
+        VERDICT_UNTRACKED // 探测范围内全部锁定，无法记录，只允许已注册的卡片继续认证
+    };
+
+    // 统计信息
+    struct Stats {
+        unsigned long cooldownHits; // 冷却忽略次数
+        unsigned long lockedHits;   // 锁定期间的刷卡次数
+        unsigned long lockouts;     // 触发锁定的次数
+        unsigned long evictions;    // 淘汰的有效条目数
+        unsigned long saturatedHits; // 探测范围内全部锁定而无法记录的次数
+        size_t occupied;            // 当前有效条目数
+    };
+
+private:
+    struct Entry {
+        uint8_t uid[MAX_UID_SIZE];
+        uint8_t uidLength;      // 0表示空槽
+        uint8_t failCount;
+        bool hasSuccess;
+        unsigned long lastSeen;
+        unsigned long lastSuccess;
+        unsigned long firstFailure;
+        unsigned long lockedUntil;
+    };
+
+    Entry entries[CAPACITY];
+    Stats stats;
+
+    static uint32_t hashUID(const uint8_t* uid, uint8_t uidLength);
+    static bool isLocked(const Entry& entry, unsigned long now);
+    static bool isStale(const Entry& entry, unsigned long now);
+
+    /**
+     * 查找条目
+     * @param create 不存在时是否创建
+     * @return 条目指针，不存在且不创建时为nullptr
+     */
+    Entry* lookup(const uint8_t* uid, uint8_t uidLength, unsigned long now, bool create);
+
+public:
+    /**
+     * 构造函数
+     */
+    RecentUIDTable();
+
+    /**
+     * 检查卡片是否可以继续认证，并记录本次出现
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @param now 当前时间
+     * @return 检查结果
+     */
+    Verdict check(const uint8_t* uid, uint8_t uidLength, unsigned long now);
+
+    /**
+     * 记录认证成功（清除失败计数，开始同卡冷却）
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @param now 当前时间
+     */
+    void recordSuccess(const uint8_t* uid, uint8_t uidLength, unsigned long now);
+
+    /**
+     * 记录认证失败（未注册或密钥认证失败）
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @param now 当前时间
+     * @return 本次失败是否触发锁定
+     */
+    bool recordFailure(const uint8_t* uid, uint8_t uidLength, unsigned long now);
+
+    /**
+     * 清除同卡冷却（卡片已确认离开读卡器），不影响失败计数和锁定
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @param now 当前时间
+     */
+    void clearCooldown(const uint8_t* uid, uint8_t uidLength, unsigned long now);
+
+    /**
+     * 获取锁定剩余时间
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @param now 当前时间
+     * @return 剩余时间（毫秒），未锁定时为0
+     */
+    unsigned long getLockRemaining(const uint8_t* uid, uint8_t uidLength, unsigned long now);
+
+    /**
+     * 清空表和统计
+     */
+    void clear();
+
+    /**
+     * 获取统计信息
+     * @param now 当前时间（用于计算有效条目数）
+     * @return 统计信息
+     */
+    Stats getStats(unsigned long now) const;
+};
+
+#endif // RECENTUIDTABLE_H
@@ -0,0 +1,288 @@
+#include "RevocationList.h"
+#include "../utils/Utils.h"
+#include "../data/FileSystemManager.h"
+#include <algorithm>
+
+const char* RevocationList::REVOCATION_FILE = "/revoked.bin";
+
+namespace {
+// 加载时每次读取的记录数
+const size_t LOAD_BATCH = 64;
+}
+
+RevocationList::RevocationList(const char* file)
+    : revocationFile(file ? file : REVOCATION_FILE), fileRecords(0) {
+    memset(filter, 0, sizeof(filter));
+}
+
+bool RevocationList::makeKey(const uint8_t* uid, uint8_t uidLength, uint64_t& key) {
+    if (uidLength == 0 || uidLength > MAX_UID_LENGTH) {
+        return false;
+    }
+    // 高8位为长度，低56位为UID字节（大端），长度不同的UID不会冲突
+    key = (uint64_t)uidLength << 56;
+    for (uint8_t i = 0; i < uidLength; i++) {
+        key |= (uint64_t)uid[i] << (8 * (MAX_UID_LENGTH - 1 - i));
+    }
+    return true;
+}
+
+uint32_t RevocationList::filterIndex(uint64_t key) {
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (FILTER_BITS - 1);
+}
+
+void RevocationList::encodeRecord(uint64_t key, uint8_t flags, uint8_t* record) {
+    record[0] = flags | (uint8_t)(key >> 56);
+    for (size_t i = 1; i < RECORD_SIZE; i++) {
+        record[i] = (uint8_t)(key >> (8 * (RECORD_SIZE - 1 - i)));
+    }
+}
+
+void RevocationList::rebuildFilter() {
+    memset(filter, 0, sizeof(filter));
+    for (uint64_t key : keys) {
+        uint32_t index = filterIndex(key);
+        filter[index >> 5] |= 1u << (index & 31);
+    }
+}
+
+void RevocationList::sortKeys() {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+bool RevocationList::initialize() {
+    fs::FS& fileSystem = FileSystemManager::fileSystem();
+    keys.clear();
+    fileRecords = 0;
+
+    // 压缩重写在删除旧文件之后、改名之前复位时，从临时文件恢复，否则已吊销的卡片会重新生效
+    FileSystemManager::recoverFile(revocationFile);
+
+    bool tornTail = false;
+    if (fileSystem.exists(revocationFile)) {
+        File file = fileSystem.open(revocationFile, FILE_READ);
+        if (!file) {
+            Serial.println("Revocation List: Failed to open file");
+            return false;
+        }
+
+        // 追加期间复位会在末尾留下半条记录，之后追加的记录全部错位，加载后必须重写
+        tornTail = file.size() % RECORD_SIZE != 0;
+
+        // 按顺序重放；恢复记录很少，遇到时才排序并删除
+        uint8_t buffer[LOAD_BATCH * RECORD_SIZE];
+        bool sorted = true;
+        size_t bytes;
+        while ((bytes = file.read(buffer, sizeof(buffer))) >= RECORD_SIZE) {
+            for (size_t offset = 0; offset + RECORD_SIZE <= bytes; offset += RECORD_SIZE) {
+                const uint8_t* record = buffer + offset;
+                uint8_t length = record[0] & ~RECORD_RESTORE;
+                if (length == 0 || length > MAX_UID_LENGTH) {
+                    continue;
+                }
+                uint64_t key = (uint64_t)length << 56;
+                for (size_t i = 1; i < RECORD_SIZE; i++) {
+                    key |= (uint64_t)record[i] << (8 * (RECORD_SIZE - 1 - i));
+                }
+                fileRecords++;
+
+                if (record[0] & RECORD_RESTORE) {
+                    if (!sorted) {
+                        sortKeys();
+                        sorted = true;
+                    }
+                    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+                    if (it != keys.end() && *it == key) {
+                        keys.erase(it);
+                    }
+                } else {
+                    keys.push_back(key);
+                    sorted = false;
+                }
+            }
+        }
+        file.close();
+        sortKeys();
+    }
+
+    rebuildFilter();
+    Serial.printf("Revocation List: %u revoked UIDs loaded (%u records)\n",
+                  (unsigned)keys.size(), (unsigned)fileRecords);
+
+    // 末尾有半条记录，或重复和已恢复的记录超过一半时重写文件
+    if (tornTail) {
+        Serial.println("Revocation List: Partial record at end of file, rewriting");
+        rewriteFile();
+    } else if (fileRecords > 2 * keys.size() + LOAD_BATCH) {
+        rewriteFile();
+    }
+    return true;
+}
+
+bool RevocationList::isRevoked(const uint8_t* uid, uint8_t uidLength) const {
+    uint64_t key;
+    if (keys.empty() || !makeKey(uid, uidLength, key)) {
+        return false;
+    }
+    uint32_t index = filterIndex(key);
+    if ((filter[index >> 5] & (1u << (index & 31))) == 0) {
+        return false;
+    }
+    return std::binary_search(keys.begin(), keys.end(), key);
+}
+
+bool RevocationList::isRevoked(const String& uid) const {
+    uint8_t bytes[Utils::MAX_UID_SIZE];
+    uint8_t length = 0;
+    return Utils::stringToUid(uid, bytes, &length) && isRevoked(bytes, length);
+}
+
+bool RevocationList::appendRecords(const uint8_t* records, size_t count) {
+    File file = FileSystemManager::fileSystem().open(revocationFile, FILE_APPEND);
+    if (!file) {
+        Serial.println("Revocation List: Failed to open file for append");
+        return false;
+    }
+    // 加载时的重写失败，末尾仍有半条记录：先重写再追加，不能写在半条记录之后
+    if (file.size() % RECORD_SIZE != 0) {
+        file.close();
+        if (!rewriteFile()) {
+            return false;
+        }
+        file = FileSystemManager::fileSystem().open(revocationFile, FILE_APPEND);
+        if (!file) {
+            Serial.println("Revocation List: Failed to open file for append");
+            return false;
+        }
+    }
+    size_t bytes = count * RECORD_SIZE;
+    bool success = file.write(records, bytes) == bytes;
+    file.close();
+    if (success) {
+        fileRecords += count;
+    }
+    return success;
+}
+
+bool RevocationList::rewriteFile() {
+    fs::FS& fileSystem = FileSystemManager::fileSystem();
+    String tempFile = FileSystemManager::tempFilePath(revocationFile);
+    File file = fileSystem.open(tempFile, FILE_WRITE);
+    if (!file) {
+        Serial.println("Revocation List: Failed to open temporary file");
+        return false;
+    }
+
+    uint8_t buffer[LOAD_BATCH * RECORD_SIZE];
+    size_t used = 0;
+    bool success = true;
+    for (size_t i = 0; i < keys.size() && success; i++) {
+        encodeRecord(keys[i], 0, buffer + used);
+        used += RECORD_SIZE;
+        if (used == sizeof(buffer) || i + 1 == keys.size()) {
+            success = file.write(buffer, used) == used;
+            used = 0;
+        }
+    }
+    file.close();
+
+    if (!success) {
+        Serial.println("Revocation List: Failed to rewrite file");
+        fileSystem.remove(tempFile);
+        return false;
+    }
+    if (!FileSystemManager::replaceFile(revocationFile)) {
+        Serial.println("Revocation List: Failed to replace file");
+        return false;
+    }
+    fileRecords = keys.size();
+    Serial.println("Revocation List: File compacted");
+    return true;
+}
+
+bool RevocationList::revoke(const std::vector<String>& uids, size_t& added, size_t& invalid) {
+    std::vector<uint64_t> newKeys;
+    added = 0;
+    invalid = 0;
+
+    for (const String& uid : uids) {
+        uint8_t bytes[Utils::MAX_UID_SIZE];
+        uint8_t length = 0;
+        uint64_t key;
+        if (!Utils::stringToUid(uid, bytes, &length) || !makeKey(bytes, length, key)) {
+            invalid++;
+            continue;
+        }
+        if (!std::binary_search(keys.begin(), keys.end(), key)) {
+            newKeys.push_back(key);
+        }
+    }
+    std::sort(newKeys.begin(), newKeys.end());
+    newKeys.erase(std::unique(newKeys.begin(), newKeys.end()), newKeys.end());
+    if (newKeys.empty()) {
+        return true;
+    }
+
+    // 整批编码后一次追加
+    std::vector<uint8_t> records(newKeys.size() * RECORD_SIZE);
+    for (size_t i = 0; i < newKeys.size(); i++) {
+        encodeRecord(newKeys[i], 0, &records[i * RECORD_SIZE]);
+    }
+    if (!appendRecords(records.data(), newKeys.size())) {
+        return false;
+    }
+
+    // 两个有序数组合并
+    size_t oldSize = keys.size();
+    keys.insert(keys.end(), newKeys.begin(), newKeys.end());
+    std::inplace_merge(keys.begin(), keys.begin() + oldSize, keys.end());
+    for (uint64_t key : newKeys) {
+        uint32_t index = filterIndex(key);
+        filter[index >> 5] |= 1u << (index & 31);
+    }
+    added = newKeys.size();
+    return true;
+}
+
+bool RevocationList::restore(const String& uid) {
+    uint8_t bytes[Utils::MAX_UID_SIZE];
+    uint8_t length = 0;
+    uint64_t key;
+    if (!Utils::stringToUid(uid, bytes, &length) || !makeKey(bytes, length, key)) {
+        return false;
+    }
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key) {
+        return false;
+    }
+
+    uint8_t record[RECORD_SIZE];
+    encodeRecord(key, RECORD_RESTORE, record);
+    if (!appendRecords(record, 1)) {
+        return false;
+    }
+    keys.erase(it);
+    rebuildFilter();
+    return true;
+}
+
+size_t RevocationList::getCount() const {
+    return keys.size();
+}
+
+void RevocationList::printList() const {
+    Serial.println("=== Revoked Cards ===");
+    for (size_t i = 0; i < keys.size(); i++) {
+        uint8_t length = (uint8_t)(keys[i] >> 56);
+        uint8_t uid[MAX_UID_LENGTH];
+        for (uint8_t j = 0; j < length; j++) {
+            uid[j] = (uint8_t)(keys[i] >> (8 * (MAX_UID_LENGTH - 1 - j)));
+        }
+        Serial.print(i + 1);
+        Serial.print(". ");
+        Serial.println(Utils::uidToString(uid, length));
+    }
+    Serial.printf("Total: %u revoked, %u file records\n", (unsigned)keys.size(), (unsigned)fileRecords);
+    Serial.println("=====================");
+}
@@ -0,0 +1,112 @@
+#ifndef REVOCATIONLIST_H
+#define REVOCATIONLIST_H
+
+#include <Arduino.h>
+#include <vector>
+
+/**
+ * 吊销列表
+ * 记录丢失或停用的卡片UID，认证时在查找卡片数据库之前检查
+ * 吊销不修改/cards.json，也不需要卡片在场
+ *
+ * 存储：/revoked.bin，只追加的定长记录（8字节：标志和UID长度 + 7字节UID）
+ * 一次吊销多张卡片只追加一次；撤销吊销追加一条恢复记录，加载时按顺序重放，
+ * 无效记录过多时重写文件
+ *
+ * 内存：按UID排序的64位键数组（每张卡8字节）加一个4096位的过滤位图，
+ * 未吊销的卡片（绝大多数刷卡）只需计算一次哈希并检查一位，命中过滤位图时再二分查找
+ */
+class RevocationList {
+public:
+    static const char* REVOCATION_FILE;
+
+    // 记录大小
+    static const size_t RECORD_SIZE = 8;
+
+    // 支持的最大UID长度（MIFARE Classic为4或7字节）
+    static const uint8_t MAX_UID_LENGTH = 7;
+
+    // 过滤位图位数（必须是2的幂）
+    static const size_t FILTER_BITS = 4096;
+
+    // 记录标志：恢复（撤销吊销）
+    static const uint8_t RECORD_RESTORE = 0x80;
+
+private:
+    const char* revocationFile;
+
+    // 排序的吊销键
+    std::vector<uint64_t> keys;
+
+    // 过滤位图
+    uint32_t filter[FILTER_BITS / 32];
+
+    // 文件中的记录数（用于判断是否需要重写）
+    size_t fileRecords;
+
+    static bool makeKey(const uint8_t* uid, uint8_t uidLength, uint64_t& key);
+    static uint32_t filterIndex(uint64_t key);
+    static void encodeRecord(uint64_t key, uint8_t flags, uint8_t* record);
+
+    void rebuildFilter();
+    void sortKeys();
+    bool appendRecords(const uint8_t* records, size_t count);
+    bool rewriteFile();
+
+public:
+    /**
+     * 构造函数
+     * @param file 吊销列表文件路径，默认为/revoked.bin
+     */
+    RevocationList(const char* file = nullptr);
+
+    /**
+     * 从文件加载吊销列表（文件系统需已挂载）
+     * @return 是否成功（文件不存在也视为成功）
+     */
+    bool initialize();
+
+    /**
+     * 检查UID是否已吊销
+     * @param uid UID字节
+     * @param uidLength UID长度
+     * @return 是否已吊销
+     */
+    bool isRevoked(const uint8_t* uid, uint8_t uidLength) const;
+
+    /**
+     * 检查UID字符串是否已吊销
+     * @param uid UID十六进制字符串
+     * @return 是否已吊销
+     */
+    bool isRevoked(const String& uid) const;
+
+    /**
+     * 吊销一批UID（一次追加写入）
+     * @param uids UID十六进制字符串
+     * @param added 输出：新吊销的数量（已吊销的UID不重复写入）
+     * @param invalid 输出：无法解析的UID数量
+     * @return 是否成功写入
+     */
+    bool revoke(const std::vector<String>& uids, size_t& added, size_t& invalid);
+
+    /**
+     * 撤销吊销
+     * @param uid UID十六进制字符串
+     * @return 是否成功（未吊销时返回false）
+     */
+    bool restore(const String& uid);
+
+    /**
+     * 获取已吊销的UID数量
+     * @return 数量
+     */
+    size_t getCount() const;
+
+    /**
+     * 打印已吊销的UID
+     */
+    void printList() const;
+};
+
+#endif // REVOCATIONLIST_H
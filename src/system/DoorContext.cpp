@@ -0,0 +1,299 @@
+#include "DoorContext.h"
+#include "../utils/TokenLog.h"
+#include "../utils/Clock.h"
+#include "../utils/AllocTracker.h"
+#include "../utils/BootTimeline.h"
+
+DoorContext::DoorContext(const char* name, IActionExecutor* executor)
+    : name(name), currentState(DOOR_IDLE), doorExecutor(executor), pollStart(0),
+      accessPolicy(nullptr), presenceTracker(nullptr), auditLog(nullptr), doorId(0), stats() {
+}
+
+void DoorContext::addAuthenticator(IAuthenticator* authenticator, IActionExecutor* executor,
+                                   PresenceTracker::Direction direction) {
+    if (authenticator != nullptr) {
+        authenticators.push_back(authenticator);
+        authenticatorExecutors.push_back(executor ? executor : doorExecutor);
+        authenticatorDirections.push_back(direction);
+        Serial.print("Door ");
+        Serial.print(name);
+        Serial.print(": Added authenticator: ");
+        Serial.print(authenticator->getName());
+        if (executor != nullptr && executor != doorExecutor) {
+            Serial.print(" -> ");
+            Serial.print(executor->getName());
+        }
+        if (direction != PresenceTracker::DIRECTION_NONE) {
+            Serial.print(direction == PresenceTracker::DIRECTION_IN ? " (in)" : " (out)");
+        }
+        Serial.println();
+    }
+}
+
+void DoorContext::setAccessPolicy(const AccessPolicy* policy) {
+    accessPolicy = policy;
+}
+
+void DoorContext::setPresenceTracker(PresenceTracker* tracker) {
+    presenceTracker = tracker;
+}
+
+void DoorContext::setAuditLog(AuditLog* log, uint8_t id) {
+    auditLog = log;
+    doorId = id;
+}
+
+bool DoorContext::initialize() {
+    bool allSuccess = true;
+
+    // 初始化门禁执行器
+    if (doorExecutor && !doorExecutor->initialize()) {
+        Serial.print("Door ");
+        Serial.print(name);
+        Serial.println(": Failed to initialize door executor");
+        allSuccess = false;
+    }
+
+    // 初始化其他执行器组（每个执行器只初始化一次）
+    for (size_t i = 0; i < authenticatorExecutors.size(); i++) {
+        IActionExecutor* executor = authenticatorExecutors[i];
+        bool seen = executor == doorExecutor;
+        for (size_t j = 0; j < i && !seen; j++) {
+            seen = authenticatorExecutors[j] == executor;
+        }
+        if (!seen && executor && !executor->initialize()) {
+            Serial.print("Door ");
+            Serial.print(name);
+            Serial.print(": Failed to initialize executor: ");
+            Serial.println(executor->getName());
+            allSuccess = false;
+        }
+    }
+
+    // 初始化所有认证器
+    for (auto* auth : authenticators) {
+        Serial.print("Door ");
+        Serial.print(name);
+        if (!auth->initialize()) {
+            Serial.print(": Failed to initialize: ");
+            Serial.println(auth->getName());
+            allSuccess = false;
+        } else {
+            Serial.print(": Initialized: ");
+            Serial.println(auth->getName());
+        }
+    }
+
+    currentState = allSuccess ? DOOR_AUTHENTICATION : DOOR_IDLE;
+    return allSuccess;
+}
+
+void DoorContext::handleAuthentication() {
+    if (currentState != DOOR_AUTHENTICATION) {
+        return;
+    }
+
+    // 处理支持异步操作的认证器
+    for (auto* auth : authenticators) {
+        if (auth->supportsAsyncOperations() && auth->hasCompletedOperation()) {
+            bool success = auth->getOperationResult();
+            LOGF("Door %s: Async operation completed from %s: %s",
+                 name, auth->getName(), success ? "Success" : "Failed");
+            auth->clearOperationFlag();
+        }
+    }
+
+    // 从上次处理的认证器之后开始轮询，多个读卡器交错服务
+    // 每个执行器组每轮最多处理一个认证请求，不同组在同一轮中处理
+    IActionExecutor* servedExecutors[MAX_EXECUTOR_GROUPS];
+    size_t servedCount = 0;
+    size_t count = authenticators.size();
+    size_t start = pollStart;
+    size_t nextStart = pollStart;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t index = (start + i) % count;
+        IAuthenticator* auth = authenticators[index];
+        IActionExecutor* executor = authenticatorExecutors[index];
+
+        // 本门读卡器被管理操作租用时，跳过共享读卡器的认证器
+        if (readerArbiter.isLeased() && auth->usesSharedReader()) {
+            continue;
+        }
+
+        // 该执行器组本轮已处理过请求，留到下一轮
+        bool served = false;
+        for (size_t j = 0; j < servedCount && !served; j++) {
+            served = servedExecutors[j] == executor;
+        }
+        if (served) {
+            continue;
+        }
+
+        if (auth->hasAuthenticationRequest()) {
+            processAuthentication(index);
+            if (servedCount < MAX_EXECUTOR_GROUPS) {
+                servedExecutors[servedCount++] = executor;
+            }
+            nextStart = (index + 1) % count;
+        }
+    }
+
+    // 本轮结束后才更新起点，轮询过程中起点不变，每个认证器每轮只检查一次
+    pollStart = nextStart;
+}
+
+void DoorContext::processAuthentication(size_t index) {
+    ALLOC_SCOPE("tap", AllocTracker::TAP_BUDGET);
+    IAuthenticator* auth = authenticators[index];
+    IActionExecutor* executor = authenticatorExecutors[index];
+    LOGF("Door %s: Authentication request from: %s", name, auth->getName());
+
+    // 先做出决策，执行动作之后再记录审计日志，日志不影响开门时延
+    unsigned long start = micros();
+    AuditLog::Decision decision = decide(auth, authenticatorDirections[index]);
+    unsigned long latencyMs = (micros() - start) / 1000;
+
+    switch (decision) {
+        case AuditLog::DECISION_GRANTED:
+            LOGF("Door %s: Authentication successful - OPENING DOOR", name);
+            {
+                ALLOC_SCOPE("door_open", AllocTracker::ACTION_BUDGET);
+                executor->executeSuccessAction();
+            }
+            // 启动后第一次开门（只记录第一次）
+            BootTimeline::milestone("first unlock");
+            stats.granted++;
+            break;
+        case AuditLog::DECISION_COOLDOWN:
+            LOGF("Door %s: Authentication successful but in cooldown - IGNORED", name);
+            stats.cooldownSuppressed++;
+            break;
+        default:
+            if (decision == AuditLog::DECISION_DENIED) {
+                LOGF("Door %s: Authentication failed - ACCESS DENIED", name);
+            }
+            {
+                ALLOC_SCOPE("door_deny", AllocTracker::ACTION_BUDGET);
+                executor->executeFailureAction();
+            }
+            if (decision == AuditLog::DECISION_POLICY) {
+                stats.policyDenied++;
+            } else if (decision == AuditLog::DECISION_PASSBACK) {
+                stats.passbackDenied++;
+            } else {
+                stats.denied++;
+            }
+            break;
+    }
+
+    if (auditLog != nullptr) {
+        uint8_t id[Utils::MAX_UID_SIZE];
+        uint8_t length = 0;
+        bool hasId = auth->getLastCredentialId(id, &length);
+        auditLog->append(hasId ? id : nullptr, hasId ? length : 0, doorId, (uint8_t)index,
+                         decision, latencyMs);
+    }
+}
+
+AuditLog::Decision DoorContext::decide(IAuthenticator* auth, PresenceTracker::Direction direction) {
+    if (!auth->authenticate()) {
+        return AuditLog::DECISION_DENIED;
+    }
+
+    // 检查冷却期（按认证器区分；按凭证处理冷却的认证器由其自身负责）
+    if (!auth->hasCredentialCooldown()) {
+        unsigned long currentTime = Clock::now();
+        auto last = lastSuccessTimes.find(auth);
+        bool inCooldown = last != lastSuccessTimes.end() && currentTime - last->second < AUTH_COOLDOWN_MS;
+        lastSuccessTimes[auth] = currentTime;
+        if (inCooldown) {
+            return AuditLog::DECISION_COOLDOWN;
+        }
+    }
+
+    if (!checkPolicy(auth)) {
+        return AuditLog::DECISION_POLICY;
+    }
+
+    if (!checkPresence(auth, direction)) {
+        return AuditLog::DECISION_PASSBACK;
+    }
+
+    return AuditLog::DECISION_GRANTED;
+}
+
+bool DoorContext::checkPolicy(IAuthenticator* auth) {
+    uint8_t id[Utils::MAX_UID_SIZE];
+    uint8_t length = 0;
+    if (accessPolicy == nullptr || !auth->getLastCredentialId(id, &length)) {
+        return true;
+    }
+
+    AccessPolicy::Decision decision = accessPolicy->evaluate(id, length, name, Clock::hourOfWeek());
+    if (decision != AccessPolicy::DECISION_ALLOW) {
+        LOGF("Door %s: Access denied by policy (%s)", name, AccessPolicy::decisionName(decision));
+        return false;
+    }
+    return true;
+}
+
+bool DoorContext::checkPresence(IAuthenticator* auth, PresenceTracker::Direction direction) {
+    uint8_t id[Utils::MAX_UID_SIZE];
+    uint8_t length = 0;
+    if (presenceTracker == nullptr || direction == PresenceTracker::DIRECTION_NONE ||
+        !auth->getLastCredentialId(id, &length)) {
+        return true;
+    }
+
+    if (presenceTracker->admit(id, length, direction, Clock::now()) == PresenceTracker::VERDICT_PASSBACK) {
+        LOGF("Door %s: Access denied - anti-passback (already inside)", name);
+        return false;
+    }
+    return true;
+}
+
+ReaderArbiter& DoorContext::getReaderArbiter() {
+    return readerArbiter;
+}
+
+void DoorContext::reset() {
+    for (auto* auth : authenticators) {
+        auth->reset();
+    }
+    lastSuccessTimes.clear();
+    readerArbiter.release(Clock::now());
+}
+
+const char* DoorContext::getName() const {
+    return name;
+}
+
+DoorContext::DoorState DoorContext::getState() const {
+    return currentState;
+}
+
+DoorContext::Stats DoorContext::getStats() const {
+    return stats;
+}
+
+void DoorContext::printStatus() {
+    Serial.print("--- Door ");
+    Serial.print(name);
+    Serial.println(" ---");
+    Serial.print("State: ");
+    Serial.println(currentState == DOOR_AUTHENTICATION ? "AUTHENTICATION" : "IDLE");
+    Serial.print("Authenticators: ");
+    Serial.println(authenticators.size());
+    Serial.print("Access granted: ");
+    Serial.println(stats.granted);
+    Serial.print("Access denied: ");
+    Serial.println(stats.denied);
+    Serial.print("Cooldown suppressed: ");
+    Serial.println(stats.cooldownSuppressed);
+    Serial.print("Policy denied: ");
+    Serial.println(stats.policyDenied);
+    Serial.print("Passback denied: ");
+    Serial.println(stats.passbackDenied);
+    readerArbiter.printStats(Clock::now());
+}
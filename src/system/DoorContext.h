@@ -0,0 +1,186 @@
+#ifndef DOORCONTEXT_H
+#define DOORCONTEXT_H
+
+#include <Arduino.h>
+#include <vector>
+#include <map>
+#include "../interfaces/IAuthenticator.h"
+#include "../interfaces/IActionExecutor.h"
+#include "ReaderArbiter.h"
+#include "../security/AccessPolicy.h"
+#include "../security/PresenceTracker.h"
+#include "../data/AuditLog.h"
+
+/**
+ * 门上下文
+ * 一扇门的全部运行状态：认证器、执行器组、冷却、读卡器租约和决策统计
+ * 多个门由SystemCoordinator在同一个主循环中轮流处理，不创建额外的轮询任务；
+ * 所有门共享同一个卡片数据库，每增加一扇门只增加本对象和其认证器/执行器的内存
+ */
+class DoorContext {
+public:
+    // 门状态
+    enum DoorState {
+        DOOR_IDLE,           // 未初始化或初始化失败，不处理认证
+        DOOR_AUTHENTICATION  // 正常处理认证
+    };
+
+    // 认证决策统计
+    struct Stats {
+        unsigned long granted;            // 开门次数
+        unsigned long denied;             // 拒绝次数
+        unsigned long cooldownSuppressed; // 认证成功但处于认证器冷却期被忽略的次数
+        unsigned long policyDenied;       // 认证成功但被访问策略拒绝的次数
+        unsigned long passbackDenied;     // 认证成功但被防反传拒绝的次数
+    };
+
+    // 每轮最多记录的执行器组数
+    static const size_t MAX_EXECUTOR_GROUPS = 8;
+
+    // 认证冷却时间（不按凭证处理冷却的认证器，如按钮）
+    static const unsigned long AUTH_COOLDOWN_MS = 2000; // 2秒
+
+private:
+    const char* name;
+    DoorState currentState;
+
+    // 门禁执行器及各认证器对应的执行器组
+    IActionExecutor* doorExecutor;
+    std::vector<IAuthenticator*> authenticators;
+    std::vector<IActionExecutor*> authenticatorExecutors;
+    std::vector<PresenceTracker::Direction> authenticatorDirections;
+
+    // 交错轮询的起始认证器
+    size_t pollStart;
+
+    // 每个认证器最近一次成功的时间
+    std::map<IAuthenticator*, unsigned long> lastSuccessTimes;
+
+    // 本门读卡器的管理租约
+    ReaderArbiter readerArbiter;
+
+    // 访问策略（nullptr表示不限制）
+    const AccessPolicy* accessPolicy;
+
+    // 在场状态（nullptr表示不做防反传）
+    PresenceTracker* presenceTracker;
+
+    // 审计日志（nullptr表示不记录）及本门在日志中的序号
+    AuditLog* auditLog;
+    uint8_t doorId;
+
+    Stats stats;
+
+    /**
+     * 处理一个认证请求，驱动对应的执行器组并记录审计日志
+     * @param index 有认证请求的认证器序号
+     */
+    void processAuthentication(size_t index);
+
+    /**
+     * 对一个认证请求做出决策（认证、冷却、访问策略、防反传）
+     * @param auth 有认证请求的认证器
+     * @param direction 该认证器的方向
+     * @return 决策结果
+     */
+    AuditLog::Decision decide(IAuthenticator* auth, PresenceTracker::Direction direction);
+
+    /**
+     * 按访问策略检查认证成功的凭证
+     * @param auth 认证成功的认证器
+     * @return 是否允许开门（没有凭证或没有策略时允许）
+     */
+    bool checkPolicy(IAuthenticator* auth);
+
+    /**
+     * 防反传检查，允许时更新在场状态
+     * @param auth 认证成功的认证器
+     * @param direction 认证器方向
+     * @return 是否允许开门（没有凭证、没有方向或没有跟踪器时允许）
+     */
+    bool checkPresence(IAuthenticator* auth, PresenceTracker::Direction direction);
+
+public:
+    /**
+     * 构造函数
+     * @param name 门名称
+     * @param executor 门禁执行器
+     */
+    DoorContext(const char* name, IActionExecutor* executor);
+
+    /**
+     * 添加认证器
+     * @param authenticator 认证器指针
+     * @param executor 认证结果的执行器组，nullptr表示使用本门的门禁执行器
+     * @param direction 认证器方向（进入/离开），用于防反传和在场人数
+     */
+    void addAuthenticator(IAuthenticator* authenticator, IActionExecutor* executor = nullptr,
+                          PresenceTracker::Direction direction = PresenceTracker::DIRECTION_NONE);
+
+    /**
+     * 设置访问策略
+     * @param policy 访问策略，nullptr表示不限制
+     */
+    void setAccessPolicy(const AccessPolicy* policy);
+
+    /**
+     * 设置在场状态跟踪器
+     * @param tracker 跟踪器，nullptr表示不做防反传
+     */
+    void setPresenceTracker(PresenceTracker* tracker);
+
+    /**
+     * 设置审计日志
+     * @param log 审计日志，nullptr表示不记录
+     * @param id 本门在日志记录中的序号
+     */
+    void setAuditLog(AuditLog* log, uint8_t id);
+
+    /**
+     * 初始化本门的执行器和认证器
+     * 失败时本门保持DOOR_IDLE，不影响其他门
+     * @return 初始化是否成功
+     */
+    bool initialize();
+
+    /**
+     * 处理一轮认证（每个执行器组最多处理一个请求）
+     */
+    void handleAuthentication();
+
+    /**
+     * 获取本门的读卡器仲裁器
+     * @return 读卡器仲裁器
+     */
+    ReaderArbiter& getReaderArbiter();
+
+    /**
+     * 重置认证器、冷却和租约
+     */
+    void reset();
+
+    /**
+     * 获取门名称
+     * @return 门名称
+     */
+    const char* getName() const;
+
+    /**
+     * 获取门状态
+     * @return 门状态
+     */
+    DoorState getState() const;
+
+    /**
+     * 获取认证决策统计
+     * @return 统计信息
+     */
+    Stats getStats() const;
+
+    /**
+     * 打印本门状态和租约统计
+     */
+    void printStatus();
+};
+
+#endif // DOORCONTEXT_H
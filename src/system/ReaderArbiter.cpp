@@ -0,0 +1,85 @@
+#include "ReaderArbiter.h"
+
+ReaderArbiter::ReaderArbiter()
+    : holder(nullptr), leaseStartTime(0), lastReleaseTime(0), hasReleased(false),
+      leaseCount(0), expiredCount(0), totalBlockedMs(0), longestBlockMs(0) {
+}
+
+bool ReaderArbiter::canGrant(unsigned long now) const {
+    if (holder != nullptr) {
+        return false;
+    }
+    // 上一个租约刚结束时先让认证使用读卡器
+    return !hasReleased || now - lastReleaseTime >= AUTH_WINDOW_MS;
+}
+
+void ReaderArbiter::acquire(IManagementOperation* operation, unsigned long now) {
+    holder = operation;
+    leaseStartTime = now;
+    leaseCount++;
+
+    Serial.print("Reader Arbiter: Reader leased to ");
+    Serial.println(operation->getName());
+}
+
+void ReaderArbiter::release(unsigned long now, bool expired) {
+    if (holder == nullptr) {
+        return;
+    }
+
+    unsigned long blocked = now - leaseStartTime;
+    totalBlockedMs += blocked;
+    if (blocked > longestBlockMs) {
+        longestBlockMs = blocked;
+    }
+    if (expired) {
+        expiredCount++;
+    }
+
+    Serial.print("Reader Arbiter: Reader returned to authentication after ");
+    Serial.print(blocked);
+    Serial.println(expired ? " ms (lease expired)" : " ms");
+
+    holder = nullptr;
+    lastReleaseTime = now;
+    hasReleased = true;
+}
+
+bool ReaderArbiter::isLeased() const {
+    return holder != nullptr;
+}
+
+IManagementOperation* ReaderArbiter::getHolder() const {
+    return holder;
+}
+
+bool ReaderArbiter::isExpired(unsigned long now, unsigned long timeout) const {
+    if (timeout == 0) {
+        timeout = MAX_LEASE_MS;
+    }
+    return holder != nullptr && now - leaseStartTime > timeout;
+}
+
+unsigned long ReaderArbiter::getBlockedTime(unsigned long now) const {
+    if (holder != nullptr) {
+        return totalBlockedMs + (now - leaseStartTime);
+    }
+    return totalBlockedMs;
+}
+
+void ReaderArbiter::printStats(unsigned long now) const {
+    Serial.println("=== Reader Arbiter ===");
+    Serial.print("Leased to: ");
+    Serial.println(holder ? holder->getName() : "(authentication)");
+    Serial.print("Leases granted: ");
+    Serial.println(leaseCount);
+    Serial.print("Leases expired: ");
+    Serial.println(expiredCount);
+    Serial.print("Door blocked time: ");
+    Serial.print(getBlockedTime(now));
+    Serial.println(" ms");
+    Serial.print("Longest block: ");
+    Serial.print(longestBlockMs);
+    Serial.println(" ms");
+    Serial.println("======================");
+}
@@ -0,0 +1,97 @@
+#ifndef READERARBITER_H
+#define READERARBITER_H
+
+#include <Arduino.h>
+#include "../interfaces/IManagementOperation.h"
+
+/**
+ * 读卡器仲裁器
+ * 管理操作需要独占PN532时向仲裁器申请租约，租约期间NFC认证暂停
+ * 公平策略：
+ * - 同一时刻只有一个租约
+ * - 租约结束后认证至少独占读卡器 AUTH_WINDOW_MS，之后才授予下一个租约
+ * - 单个租约默认最长 MAX_LEASE_MS（管理操作可声明更长的会话租约），超时由协调器收回
+ * 同时统计门禁被阻塞（NFC认证暂停）的累计时间
+ */
+class ReaderArbiter {
+public:
+    // 租约最长持续时间（毫秒）
+    static const unsigned long MAX_LEASE_MS = 10000;
+
+    // 两次租约之间保证给认证的时间窗口（毫秒）
+    static const unsigned long AUTH_WINDOW_MS = 1500;
+
+private:
+    IManagementOperation* holder;
+    unsigned long leaseStartTime;
+    unsigned long lastReleaseTime;
+    bool hasReleased;
+
+    // 统计信息
+    unsigned long leaseCount;
+    unsigned long expiredCount;
+    unsigned long totalBlockedMs;
+    unsigned long longestBlockMs;
+
+public:
+    /**
+     * 构造函数
+     */
+    ReaderArbiter();
+
+    /**
+     * 检查当前是否可以授予租约（空闲且认证窗口已满足）
+     * @param now 当前时间
+     * @return 是否可以授予
+     */
+    bool canGrant(unsigned long now) const;
+
+    /**
+     * 授予租约
+     * @param operation 持有租约的管理操作
+     * @param now 当前时间
+     */
+    void acquire(IManagementOperation* operation, unsigned long now);
+
+    /**
+     * 释放租约
+     * @param now 当前时间
+     * @param expired 是否因超时被收回
+     */
+    void release(unsigned long now, bool expired = false);
+
+    /**
+     * 检查读卡器是否被租用
+     * @return 是否被租用
+     */
+    bool isLeased() const;
+
+    /**
+     * 获取租约持有者
+     * @return 管理操作指针，未租用时为nullptr
+     */
+    IManagementOperation* getHolder() const;
+
+    /**
+     * 检查当前租约是否超时
+     * @param now 当前时间
+     * @param timeout 租约时长（毫秒），0表示使用 MAX_LEASE_MS
+     * @return 是否超时
+     */
+    bool isExpired(unsigned long now, unsigned long timeout = 0) const;
+
+    /**
+     * 获取门禁被阻塞的累计时间（包括当前租约）
+     * @param now 当前时间
+     * @return 累计阻塞时间（毫秒）
+     */
+    unsigned long getBlockedTime(unsigned long now) const;
+
+    /**
+     * 打印统计信息
+     * @param now 当前时间
+     */
+    void printStats(unsigned long now) const;
+};
+
+#endif // READERARBITER_H
@@ -1,28 +1,68 @@
 #include "SystemCoordinator.h"
+#include "../utils/Clock.h"
+#include "../utils/AllocTracker.h"
 
-SystemCoordinator::SystemCoordinator(DoorAccessExecutor* executor)
-    : currentState(STATE_IDLE), stateStartTime(0), doorExecutor(executor), lastSuccessTime(0) {
+SystemCoordinator::SystemCoordinator(IActionExecutor* executor)
+    : currentState(STATE_IDLE), stateStartTime(0), defaultDoor("Main", executor),
+      accessPolicy(nullptr), presenceTracker(nullptr), auditLog(nullptr) {
+    doors.push_back(&defaultDoor);
 }
 
 SystemCoordinator::~SystemCoordinator() {
     // 注意：不要在这里删除认证器和管理操作，因为它们可能在其他地方管理
 }
 
-void SystemCoordinator::addAuthenticator(IAuthenticator* authenticator) {
-    if (authenticator != nullptr) {
-        authenticators.push_back(authenticator);
-        Serial.print("System Coordinator: Added authenticator: ");
-        Serial.println(authenticator->getName());
+void SystemCoordinator::addDoor(DoorContext* door) {
+    if (door != nullptr) {
+        door->setAccessPolicy(accessPolicy);
+        door->setPresenceTracker(presenceTracker);
+        door->setAuditLog(auditLog, (uint8_t)doors.size());
+        doors.push_back(door);
+        Serial.print("System Coordinator: Added door: ");
+        Serial.println(door->getName());
     }
 }
 
-void SystemCoordinator::addManagementOperation(const String& type, IManagementOperation* operation) {
+DoorContext* SystemCoordinator::getDefaultDoor() {
+    return &defaultDoor;
+}
+
+void SystemCoordinator::addAuthenticator(IAuthenticator* authenticator, IActionExecutor* executor,
+                                         PresenceTracker::Direction direction) {
+    defaultDoor.addAuthenticator(authenticator, executor, direction);
+}
+
+void SystemCoordinator::setAccessPolicy(const AccessPolicy* policy) {
+    accessPolicy = policy;
+    for (auto* door : doors) {
+        door->setAccessPolicy(policy);
+    }
+}
+
+void SystemCoordinator::setPresenceTracker(PresenceTracker* tracker) {
+    presenceTracker = tracker;
+    for (auto* door : doors) {
+        door->setPresenceTracker(tracker);
+    }
+}
+
+void SystemCoordinator::setAuditLog(AuditLog* log) {
+    auditLog = log;
+    for (size_t i = 0; i < doors.size(); i++) {
+        doors[i]->setAuditLog(log, (uint8_t)i);
+    }
+}
+
+void SystemCoordinator::addManagementOperation(const String& type, IManagementOperation* operation, DoorContext* door) {
     if (operation != nullptr) {
         managementOperations[type] = operation;
+        operationDoors[operation] = door ? door : &defaultDoor;
         Serial.print("System Coordinator: Added management operation: ");
         Serial.print(type);
         Serial.print(" (");
         Serial.print(operation->getName());
+        Serial.print(", door ");
+        Serial.print(operationDoors[operation]->getName());
         Serial.println(")");
     }
 }
@@ -30,28 +70,22 @@ void SystemCoordinator::addManagementOperation(const String& type, IManagementOp
 bool SystemCoordinator::initialize() {
     Serial.println("System Coordinator: Initializing...");
     
-    bool allSuccess = true;
-    
-    // 初始化门禁执行器
-    if (doorExecutor && !doorExecutor->initialize()) {
-        Serial.println("System Coordinator: Failed to initialize door executor");
-        allSuccess = false;
-    }
-    
-    // 初始化所有认证器
-    for (auto* auth : authenticators) {
-        if (!auth->initialize()) {
-            Serial.print("System Coordinator: Failed to initialize: ");
-            Serial.println(auth->getName());
-            allSuccess = false;
+    // 各门独立初始化，一扇门失败不影响其他门
+    size_t readyDoors = 0;
+    for (auto* door : doors) {
+        if (door->initialize()) {
+            readyDoors++;
         } else {
-            Serial.print("System Coordinator: Initialized: ");
-            Serial.println(auth->getName());
+            Serial.print("System Coordinator: Door failed to initialize: ");
+            Serial.println(door->getName());
         }
     }
     
+    bool allSuccess = readyDoors == doors.size();
     if (allSuccess) {
         Serial.println("System Coordinator: All components initialized successfully");
+    }
+    if (readyDoors > 0) {
         transitionToState(STATE_AUTHENTICATION); // 默认进入认证状态
     }
     
@@ -65,13 +99,15 @@ void SystemCoordinator::handleLoop() {
             break;
             
         case STATE_AUTHENTICATION:
+            handleManagementOperations();
+            checkReaderLease();
             handleAuthenticationState();
             break;
-            
-        case STATE_MANAGEMENT:
-            handleManagementState();
-            checkManagementTimeout();
-            break;
+    }
+
+    // 在场状态延迟写入
+    if (presenceTracker != nullptr) {
+        presenceTracker->persistIfDue(Clock::now());
     }
 
     // 重构后不再需要处理门禁执行器的时序
@@ -79,10 +115,18 @@ void SystemCoordinator::handleLoop() {
 }
 
 bool SystemCoordinator::handleCommand(const String& command) {
+    ALLOC_SCOPE("command", AllocTracker::COMMAND_BUDGET);
     if (command.equalsIgnoreCase("reset")) {
         resetAll();
         return true;
     }
+    if (command.equalsIgnoreCase("status")) {
+        printStatus();
+        return true;
+    }
+    if (command.equalsIgnoreCase("occupancy") || command.startsWith("occupancy:")) {
+        return handleOccupancyCommand(command);
+    }
     if (command.indexOf(':') != -1) {
         return executeManagementCommand(command);
     }
@@ -90,9 +134,15 @@ bool SystemCoordinator::handleCommand(const String& command) {
 }
 
 void SystemCoordinator::exitManagementState() {
-    if (currentState == STATE_MANAGEMENT) {
-        Serial.println("System Coordinator: Exiting management state");
-        transitionToState(STATE_AUTHENTICATION);
+    for (auto* door : doors) {
+        ReaderArbiter& arbiter = door->getReaderArbiter();
+        IManagementOperation* holder = arbiter.getHolder();
+        if (holder != nullptr) {
+            Serial.print("System Coordinator: Ending reader lease on door ");
+            Serial.println(door->getName());
+            holder->reset();
+            arbiter.release(Clock::now());
+        }
     }
 }
 
@@ -100,17 +150,31 @@ SystemCoordinator::SystemState SystemCoordinator::getCurrentState() const {
     return currentState;
 }
 
-void SystemCoordinator::resetAll() {
-    for (auto* auth : authenticators) {
-        auth->reset();
+SystemCoordinator::Stats SystemCoordinator::getStats() const {
+    Stats total = {};
+    for (auto* door : doors) {
+        Stats stats = door->getStats();
+        total.granted += stats.granted;
+        total.denied += stats.denied;
+        total.cooldownSuppressed += stats.cooldownSuppressed;
+        total.policyDenied += stats.policyDenied;
+        total.passbackDenied += stats.passbackDenied;
     }
-    
+    return total;
+}
+
+void SystemCoordinator::resetAll() {
     for (auto& pair : managementOperations) {
         if (pair.second) {
             pair.second->reset();
         }
     }
-    
+
+    pendingReaderCommands.clear();
+    for (auto* door : doors) {
+        door->reset();
+    }
+
     transitionToState(STATE_AUTHENTICATION);
     Serial.println("System Coordinator: All components reset");
 }
@@ -126,49 +190,26 @@ void SystemCoordinator::listAvailableManagementTypes() {
     }
 }
 
-void SystemCoordinator::handleAuthenticationState() {
-    // 处理支持异步操作的认证器
-    for (auto* auth : authenticators) {
-        if (auth->supportsAsyncOperations() && auth->hasCompletedOperation()) {
-            bool success = auth->getOperationResult();
-            Serial.print("System Coordinator: Async operation completed from ");
-            Serial.print(auth->getName());
-            Serial.print(": ");
-            Serial.println(success ? "Success" : "Failed");
-            auth->clearOperationFlag();
-        }
+void SystemCoordinator::printStatus() {
+    Serial.print("System state: ");
+    Serial.println(currentState == STATE_AUTHENTICATION ? "AUTHENTICATION" : "IDLE");
+    Serial.print("Doors: ");
+    Serial.println(doors.size());
+    Serial.print("Pending reader commands: ");
+    Serial.println(pendingReaderCommands.size());
+    for (auto* door : doors) {
+        door->printStatus();
     }
+}
 
-    // 遍历所有认证器，检查是否有认证请求
-    for (auto* auth : authenticators) {
-        if (auth->hasAuthenticationRequest()) {
-            Serial.print("System Coordinator: Authentication request from: ");
-            Serial.println(auth->getName());
-
-            if (auth->authenticate()) {
-                // 检查冷却期
-                unsigned long currentTime = millis();
-                if (currentTime - lastSuccessTime < AUTH_COOLDOWN_MS) {
-                    Serial.println("System Coordinator: Authentication successful but in cooldown - IGNORED");
-                    lastSuccessTime = currentTime;
-                    return;
-                }
-
-                Serial.println("System Coordinator: Authentication successful - OPENING DOOR");
-                doorExecutor->executeSuccessAction();
-                lastSuccessTime = currentTime;
-            } else {
-                Serial.println("System Coordinator: Authentication failed - ACCESS DENIED");
-                doorExecutor->executeFailureAction();
-            }
-
-            // 处理完一个认证请求后就返回，避免同时处理多个
-            return;
-        }
+void SystemCoordinator::handleAuthenticationState() {
+    // 各门在同一轮中依次处理，不需要额外的轮询任务
+    for (auto* door : doors) {
+        door->handleAuthentication();
     }
 }
 
-void SystemCoordinator::handleManagementState() {
+void SystemCoordinator::handleManagementOperations() {
     // 处理所有管理操作
     for (auto& pair : managementOperations) {
         IManagementOperation* operation = pair.second;
@@ -177,9 +218,12 @@ void SystemCoordinator::handleManagementState() {
 
             // 检查操作是否刚刚完成
             if (operation->hasCompletedOperation()) {
-                Serial.println("System Coordinator: Management operation completed, returning to authentication state");
-                transitionToState(STATE_AUTHENTICATION);
-                return; // 立即退出，避免处理其他操作
+                Serial.print("System Coordinator: Management operation completed: ");
+                Serial.println(operation->getName());
+                ReaderArbiter& arbiter = doorFor(operation)->getReaderArbiter();
+                if (arbiter.getHolder() == operation) {
+                    arbiter.release(Clock::now());
+                }
             }
         }
     }
@@ -190,13 +234,71 @@ void SystemCoordinator::handleIdleState() {
     // 可以在这里添加系统监控或维护任务
 }
 
-void SystemCoordinator::checkManagementTimeout() {
-    if (millis() - stateStartTime > MANAGEMENT_TIMEOUT_MS) {
-        Serial.println("System Coordinator: Management state timeout, returning to authentication state");
-        transitionToState(STATE_AUTHENTICATION);
+bool SystemCoordinator::handleOccupancyCommand(const String& command) {
+    if (presenceTracker == nullptr) {
+        Serial.println("System Coordinator: Occupancy tracking not configured");
+        return false;
+    }
+    if (command.equalsIgnoreCase("occupancy")) {
+        presenceTracker->printOccupancy();
+        return true;
+    }
+    if (command.equalsIgnoreCase("occupancy:reset")) {
+        // 例如疏散后统一清零，所有卡片可以重新进入
+        presenceTracker->clear(Clock::now());
+        presenceTracker->persist();
+        Serial.println("System Coordinator: Occupancy cleared");
+        return true;
+    }
+    if (command.equalsIgnoreCase("occupancy:save")) {
+        return presenceTracker->persist();
+    }
+    Serial.println("Usage: occupancy | occupancy:reset | occupancy:save");
+    return false;
+}
+
+void SystemCoordinator::checkReaderLease() {
+    unsigned long now = Clock::now();
+
+    for (auto* door : doors) {
+        ReaderArbiter& arbiter = door->getReaderArbiter();
+        IManagementOperation* holder = arbiter.getHolder();
+        if (holder == nullptr) {
+            continue;
+        }
+
+        if (!holder->hasOngoingOperation()) {
+            // 操作已结束（包括操作自身超时），归还读卡器
+            arbiter.release(now);
+        } else if (arbiter.isExpired(now, holder->getReaderLeaseTimeout())) {
+            Serial.print("System Coordinator: Reader lease timeout, returning reader to authentication on door ");
+            Serial.println(door->getName());
+            holder->reset();
+            arbiter.release(now, true);
+        }
+    }
+
+    // 按先后顺序授予等待中的租约（每轮最多启动一个）
+    if (!pendingReaderCommands.empty()) {
+        String type, action, param;
+        String command = pendingReaderCommands.front();
+        parseManagementCommand(command, type, action, param);
+        auto it = managementOperations.find(type);
+        if (it == managementOperations.end()) {
+            pendingReaderCommands.erase(pendingReaderCommands.begin());
+        } else if (doorFor(it->second)->getReaderArbiter().canGrant(now)) {
+            pendingReaderCommands.erase(pendingReaderCommands.begin());
+            Serial.println("System Coordinator: Starting queued command: " + command);
+            executeManagementCommand(command);
+        }
     }
 }
 
+DoorContext* SystemCoordinator::doorFor(IManagementOperation* operation) {
+    auto it = operationDoors.find(operation);
+    return it != operationDoors.end() ? it->second : &defaultDoor;
+}
+
 bool SystemCoordinator::executeManagementCommand(const String& command) {
     String type, action, param;
 
@@ -206,15 +308,6 @@ bool SystemCoordinator::executeManagementCommand(const String& command) {
         return false;
     }
 
-    if (currentState == STATE_MANAGEMENT) {
-        Serial.println("System Coordinator: Already in management state");
-    }
-
-    if (action != "list") {
-        Serial.println("System Coordinator: Entering management state");
-        transitionToState(STATE_MANAGEMENT);
-    }
-
     // 查找对应的管理操作
     auto it = managementOperations.find(type);
     if (it == managementOperations.end()) {
@@ -225,7 +318,37 @@ bool SystemCoordinator::executeManagementCommand(const String& command) {
 
     IManagementOperation* operation = it->second;
 
-    // 执行对应的动作
+    // 不需要读卡器的动作直接执行，认证不受影响
+    if (!operation->requiresReader(action)) {
+        return dispatchManagementAction(operation, type, action, param);
+    }
+
+    ReaderArbiter& readerArbiter = doorFor(operation)->getReaderArbiter();
+    unsigned long now = Clock::now();
+    if (!readerArbiter.canGrant(now)) {
+        if (readerArbiter.getHolder() == operation) {
+            Serial.println("System Coordinator: Operation already in progress");
+            return false;
+        }
+        if (pendingReaderCommands.size() >= MAX_PENDING_COMMANDS) {
+            Serial.println("System Coordinator: Reader busy and queue full, command rejected");
+            return false;
+        }
+        pendingReaderCommands.push_back(command);
+        Serial.println("System Coordinator: Reader busy, command queued");
+        return true;
+    }
+
+    readerArbiter.acquire(operation, now);
+    bool success = dispatchManagementAction(operation, type, action, param);
+    if (!success || !operation->hasOngoingOperation()) {
+        readerArbiter.release(Clock::now());
+    }
+    return success;
+}
+
+bool SystemCoordinator::dispatchManagementAction(IManagementOperation* operation, const String& type,
+                                                 const String& action, const String& param) {
     if (action == "register") {
         return operation->registerNew();
     } else if (action == "delete") {
@@ -241,11 +364,13 @@ bool SystemCoordinator::executeManagementCommand(const String& command) {
         }
         return operation->eraseAndDeleteItem(param);
     } else if (action == "list") {
-        operation->listRegisteredItems();
+        operation->listRegisteredItems(param);
         return true;
     } else if (action == "reset") {
         operation->reset();
         return true;
+    } else if (operation->hasCustomAction(action)) {
+        return operation->executeCustomAction(action, param);
     } else {
         Serial.println("System Coordinator: Unknown action: " + action);
         Serial.println("Available actions: register, delete, erase, list, reset");
@@ -285,7 +410,6 @@ void SystemCoordinator::transitionToState(SystemState newState) {
         switch (currentState) {
             case STATE_IDLE: Serial.print("IDLE"); break;
             case STATE_AUTHENTICATION: Serial.print("AUTHENTICATION"); break;
-            case STATE_MANAGEMENT: Serial.print("MANAGEMENT"); break;
         }
 
         Serial.print(" -> ");
@@ -294,10 +418,9 @@ void SystemCoordinator::transitionToState(SystemState newState) {
         switch (newState) {
             case STATE_IDLE: Serial.println("IDLE"); break;
             case STATE_AUTHENTICATION: Serial.println("AUTHENTICATION"); break;
-            case STATE_MANAGEMENT: Serial.println("MANAGEMENT"); break;
         }
 
         currentState = newState;
-        stateStartTime = millis();
+        stateStartTime = Clock::now();
     }
 }
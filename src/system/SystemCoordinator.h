@@ -6,45 +6,59 @@
 #include <map>
 #include "../interfaces/IAuthenticator.h"
 #include "../interfaces/IManagementOperation.h"
-#include "../execution/DoorAccessExecutor.h"
+#include "../interfaces/IActionExecutor.h"
+#include "DoorContext.h"
 
 /**
  * 系统协调器
- * 实现状态机，确保认证状态和管理状态互斥
- * 作为主循环的核心协调器
+ * 作为主循环的核心协调器，承载一个或多个相互独立的门（DoorContext）
+ * 每扇门有自己的认证器、执行器组、冷却和读卡器租约，在同一个主循环中轮流处理
+ * 管理操作与认证并发执行，只有需要读卡器的管理操作通过所属门的ReaderArbiter租用PN532，
+ * 租约期间仅暂停该门使用共享读卡器的认证器，其他门和其他认证方式不受影响
  */
 class SystemCoordinator {
 public:
     // 系统状态枚举
     enum SystemState {
         STATE_IDLE,           // 空闲状态
-        STATE_AUTHENTICATION, // 认证状态
-        STATE_MANAGEMENT      // 管理状态
+        STATE_AUTHENTICATION  // 认证状态（管理操作在此状态下并发处理）
     };
 
+    // 认证决策统计（所有门的合计）
+    typedef DoorContext::Stats Stats;
+
 private:
     // 系统状态
     SystemState currentState;
     unsigned long stateStartTime;
     
-    // 组件引用
-    std::vector<IAuthenticator*> authenticators;
+    // 门（第一个为默认门）
+    DoorContext defaultDoor;
+    std::vector<DoorContext*> doors;
+
+    // 访问策略
+    const AccessPolicy* accessPolicy;
+
+    // 在场状态
+    PresenceTracker* presenceTracker;
+
+    // 审计日志
+    AuditLog* auditLog;
+
+    // 管理操作及其所属的门（决定租用哪扇门的读卡器）
     std::map<String, IManagementOperation*> managementOperations;
-    DoorAccessExecutor* doorExecutor;
-    
-    // 管理状态超时设置
-    static const unsigned long MANAGEMENT_TIMEOUT_MS = 10000; // 10秒
-    
-    // 认证冷却机制
-    unsigned long lastSuccessTime;
-    static const unsigned long AUTH_COOLDOWN_MS = 2000; // 2秒
+    std::map<IManagementOperation*, DoorContext*> operationDoors;
+
+    // 等待读卡器租约的管理命令
+    std::vector<String> pendingReaderCommands;
+    static const size_t MAX_PENDING_COMMANDS = 4;
 
 public:
     /**
      * 构造函数
-     * @param executor 门禁执行器
+     * @param executor 默认门的门禁执行器（通常为DoorAccessExecutor）
      */
-    SystemCoordinator(DoorAccessExecutor* executor);
+    SystemCoordinator(IActionExecutor* executor);
     
     /**
      * 析构函数
@@ -52,17 +66,51 @@ public:
     ~SystemCoordinator();
     
     /**
-     * 添加认证器
+     * 添加一扇门
+     * @param door 门上下文（由调用者管理生命周期）
+     */
+    void addDoor(DoorContext* door);
+
+    /**
+     * 获取默认门
+     * @return 默认门
+     */
+    DoorContext* getDefaultDoor();
+
+    /**
+     * 向默认门添加认证器
      * @param authenticator 认证器指针
+     * @param executor 认证结果的执行器组，nullptr表示使用默认门的门禁执行器
+     * @param direction 认证器方向（进入/离开），用于防反传和在场人数
+     */
+    void addAuthenticator(IAuthenticator* authenticator, IActionExecutor* executor = nullptr,
+                          PresenceTracker::Direction direction = PresenceTracker::DIRECTION_NONE);
+
+    /**
+     * 为所有门（包括之后添加的门）设置访问策略
+     * @param policy 访问策略，nullptr表示不限制
      */
-    void addAuthenticator(IAuthenticator* authenticator);
+    void setAccessPolicy(const AccessPolicy* policy);
+
+    /**
+     * 为所有门（包括之后添加的门）设置在场状态跟踪器（防反传和 occupancy 命令）
+     * @param tracker 跟踪器，nullptr表示不做防反传
+     */
+    void setPresenceTracker(PresenceTracker* tracker);
+
+    /**
+     * 为所有门（包括之后添加的门）设置审计日志，门序号按添加顺序（默认门为0）
+     * @param log 审计日志，nullptr表示不记录
+     */
+    void setAuditLog(AuditLog* log);
     
     /**
      * 添加管理操作
      * @param type 操作类型
      * @param operation 管理操作指针
+     * @param door 管理操作使用的读卡器所属的门，nullptr表示默认门
      */
-    void addManagementOperation(const String& type, IManagementOperation* operation);
+    void addManagementOperation(const String& type, IManagementOperation* operation, DoorContext* door = nullptr);
 
     /**
      * 处理串口命令
@@ -84,7 +132,7 @@ public:
     void handleLoop();
 
     /**
-     * 强制退出管理状态
+     * 强制结束所有门当前的读卡器租约，读卡器立即归还给认证
      */
     void exitManagementState();
     
@@ -93,6 +141,12 @@ public:
      * @return 当前状态
      */
     SystemState getCurrentState() const;
+
+    /**
+     * 获取认证决策统计（所有门的合计）
+     * @return 统计信息
+     */
+    Stats getStats() const;
     
     /**
      * 重置所有组件
@@ -111,6 +165,11 @@ public:
      */
     void listAvailableManagementTypes();
 
+    /**
+     * 打印系统状态以及每扇门的决策和读卡器租约统计
+     */
+    void printStatus();
+
 private:
     /**
      * 处理认证状态
@@ -118,19 +177,44 @@ private:
     void handleAuthenticationState();
     
     /**
-     * 处理管理状态
+     * 获取管理操作所属的门
+     * @param operation 管理操作
+     * @return 所属的门
+     */
+    DoorContext* doorFor(IManagementOperation* operation);
+
+    /**
+     * 处理所有管理操作（与认证并发）
      */
-    void handleManagementState();
+    void handleManagementOperations();
     
     /**
      * 处理空闲状态
      */
     void handleIdleState();
+
+    /**
+     * 处理occupancy命令
+     * @param command 命令字符串
+     * @return 是否成功
+     */
+    bool handleOccupancyCommand(const String& command);
     
     /**
-     * 检查管理状态超时
+     * 检查读卡器租约：释放已结束的租约、收回超时租约、授予等待中的租约
+     */
+    void checkReaderLease();
+
+    /**
+     * 分派管理动作到对应的管理操作
+     * @param operation 管理操作
+     * @param type 操作类型
+     * @param action 动作
+     * @param param 参数
+     * @return 执行是否成功
      */
-    void checkManagementTimeout();
+    bool dispatchManagementAction(IManagementOperation* operation, const String& type,
+                                  const String& action, const String& param);
     
     /**
      * 解析管理命令
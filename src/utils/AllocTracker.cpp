@@ -0,0 +1,238 @@
+#ifdef ALLOC_TRACKING
+
+#include "AllocTracker.h"
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+AllocTracker::OperationStats AllocTracker::operations[AllocTracker::MAX_OPERATIONS];
+size_t AllocTracker::operationCount = 0;
+AllocTracker::Scope* volatile AllocTracker::current = nullptr;
+void* volatile AllocTracker::ownerTask = nullptr;
+volatile bool AllocTracker::paused = false;
+
+// =============================================================================
+// 链接包装函数（-Wl,--wrap=<符号>）
+// =============================================================================
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+void* __real_pvPortMalloc(size_t size);
+void __real_vPortFree(void* ptr);
+
+void* __wrap_malloc(size_t size) {
+    void* ptr = __real_malloc(size);
+    AllocTracker::recordAlloc(ptr, size);
+    return ptr;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    void* ptr = __real_calloc(count, size);
+    AllocTracker::recordAlloc(ptr, count * size);
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    size_t oldSize = ptr ? heap_caps_get_allocated_size(ptr) : 0;
+    void* newPtr = __real_realloc(ptr, size);
+    AllocTracker::recordRealloc(ptr, oldSize, newPtr, size);
+    return newPtr;
+}
+
+void __wrap_free(void* ptr) {
+    AllocTracker::recordFree(ptr);
+    __real_free(ptr);
+}
+
+void* __wrap_pvPortMalloc(size_t size) {
+    void* ptr = __real_pvPortMalloc(size);
+    AllocTracker::recordAlloc(ptr, size);
+    return ptr;
+}
+
+void __wrap_vPortFree(void* ptr) {
+    AllocTracker::recordFree(ptr);
+    __real_vPortFree(ptr);
+}
+}
+
+// =============================================================================
+// 作用域
+// =============================================================================
+AllocTracker::Scope::Scope(const char* name, unsigned long budget)
+    : name(name), budget(budget), parent(nullptr), active(false),
+      allocs(0), frees(0), reallocs(0), bytesAllocated(0), bytesFreed(0) {
+    AllocTracker::enter(this);
+}
+
+AllocTracker::Scope::~Scope() {
+    AllocTracker::leave(this);
+}
+
+bool AllocTracker::isTracking() {
+    return current != nullptr && !paused && ownerTask == xTaskGetCurrentTaskHandle();
+}
+
+void AllocTracker::enter(Scope* scope) {
+    void* task = xTaskGetCurrentTaskHandle();
+    if (current != nullptr && ownerTask != task) {
+        // 其他任务已在统计中，本作用域不生效
+        return;
+    }
+    scope->parent = current;
+    scope->active = true;
+    ownerTask = task;
+    current = scope;
+}
+
+void AllocTracker::leave(Scope* scope) {
+    if (!scope->active) {
+        return;
+    }
+    current = scope->parent;
+    if (current == nullptr) {
+        ownerTask = nullptr;
+    }
+
+    paused = true;
+
+    OperationStats* op = findOperation(scope->name, scope->budget);
+    if (op != nullptr) {
+        long retained = (long)scope->bytesAllocated - (long)scope->bytesFreed;
+        op->calls++;
+        op->totalAllocs += scope->allocs;
+        op->totalFrees += scope->frees;
+        op->totalReallocs += scope->reallocs;
+        op->totalBytes += scope->bytesAllocated;
+        if (scope->allocs > op->maxAllocs) {
+            op->maxAllocs = scope->allocs;
+        }
+        if (scope->bytesAllocated > op->maxBytes) {
+            op->maxBytes = scope->bytesAllocated;
+        }
+        if (retained > op->maxRetained) {
+            op->maxRetained = retained;
+        }
+        if (scope->budget > 0 && scope->allocs > scope->budget) {
+            op->overBudget++;
+        }
+    }
+
+    if (scope->budget > 0 && scope->allocs > scope->budget) {
+        Serial.printf("Alloc Tracker: BUDGET EXCEEDED %s: %lu allocs (budget %lu), %u bytes\n",
+                      scope->name, scope->allocs, scope->budget, (unsigned)scope->bytesAllocated);
+    }
+
+    paused = false;
+}
+
+// =============================================================================
+// 统计
+// =============================================================================
+void AllocTracker::recordAlloc(void* ptr, size_t size) {
+    if (ptr == nullptr || !isTracking()) {
+        return;
+    }
+    for (Scope* scope = current; scope != nullptr; scope = scope->parent) {
+        scope->allocs++;
+        scope->bytesAllocated += size;
+    }
+}
+
+void AllocTracker::recordFree(void* ptr) {
+    if (ptr == nullptr || !isTracking()) {
+        return;
+    }
+    size_t size = heap_caps_get_allocated_size(ptr);
+    for (Scope* scope = current; scope != nullptr; scope = scope->parent) {
+        scope->frees++;
+        scope->bytesFreed += size;
+    }
+}
+
+void AllocTracker::recordRealloc(void* oldPtr, size_t oldSize, void* newPtr, size_t newSize) {
+    if (newPtr == nullptr || !isTracking()) {
+        return;
+    }
+    // String增长时的realloc按一次释放加一次分配计算，同时单独计数
+    for (Scope* scope = current; scope != nullptr; scope = scope->parent) {
+        scope->reallocs++;
+        scope->allocs++;
+        scope->bytesAllocated += newSize;
+        if (oldPtr != nullptr) {
+            scope->frees++;
+            scope->bytesFreed += oldSize;
+        }
+    }
+}
+
+AllocTracker::OperationStats* AllocTracker::findOperation(const char* name, unsigned long budget) {
+    for (size_t i = 0; i < operationCount; i++) {
+        if (strcmp(operations[i].name, name) == 0) {
+            return &operations[i];
+        }
+    }
+    if (operationCount >= MAX_OPERATIONS) {
+        return nullptr;
+    }
+
+    OperationStats* op = &operations[operationCount++];
+    memset(op, 0, sizeof(OperationStats));
+    op->name = name;
+    op->budget = budget;
+    return op;
+}
+
+void AllocTracker::printReport() {
+    paused = true;
+
+    Serial.println("=== Allocation Tracker ===");
+    Serial.println("operation      calls  allocs/op  max  budget  over  frees/op  reallocs/op  bytes/op  max bytes  max retained");
+    for (size_t i = 0; i < operationCount; i++) {
+        const OperationStats& op = operations[i];
+        unsigned long calls = op.calls > 0 ? op.calls : 1;
+        Serial.printf("%-13s %6lu %10lu %4lu %7lu %5lu %9lu %12lu %9lu %10u %13ld\n",
+                      op.name, op.calls, op.totalAllocs / calls, op.maxAllocs, op.budget, op.overBudget,
+                      op.totalFrees / calls, op.totalReallocs / calls,
+                      (unsigned long)(op.totalBytes / calls), (unsigned)op.maxBytes, op.maxRetained);
+    }
+    Serial.print("Free heap: ");
+    Serial.print(ESP.getFreeHeap());
+    Serial.print(" bytes, largest block: ");
+    Serial.print(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    Serial.print(" bytes, minimum ever: ");
+    Serial.println(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    Serial.println("==========================");
+
+    paused = false;
+}
+
+void AllocTracker::resetStats() {
+    operationCount = 0;
+    Serial.println("Alloc Tracker: Statistics cleared");
+}
+
+const AllocTracker::OperationStats* AllocTracker::getOperationStats(const char* name) {
+    for (size_t i = 0; i < operationCount; i++) {
+        if (strcmp(operations[i].name, name) == 0) {
+            return &operations[i];
+        }
+    }
+    return nullptr;
+}
+
+bool AllocTracker::handleCommand(const String& command) {
+    if (command.equalsIgnoreCase("alloc")) {
+        printReport();
+        return true;
+    }
+    if (command.equalsIgnoreCase("alloc:reset")) {
+        resetStats();
+        return true;
+    }
+    return false;
+}
+
+#endif // ALLOC_TRACKING
@@ -0,0 +1,148 @@
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+
+#include <Arduino.h>
+
+/**
+ * 内存分配统计
+ * 按逻辑操作（一次刷卡、一条管理命令、一次执行器动作）统计分配次数、释放次数和字节数，
+ * 用于定位String反复分配导致的堆碎片
+ *
+ * 定义ALLOC_TRACKING后启用（见platformio.ini中的alloc环境），
+ * 链接时通过 -Wl,--wrap 截获 malloc/calloc/realloc/free 以及FreeRTOS的 pvPortMalloc/vPortFree
+ * （operator new 最终调用malloc，因此同样被统计）
+ * 只统计打开作用域的任务中的分配，其他任务（执行器任务、密钥池补充任务）不计入
+ *
+ * 每个操作有分配次数预算，超出时立即打印警告，并在 alloc 命令的汇总表中标出
+ * 未定义ALLOC_TRACKING时ALLOC_SCOPE为空，不产生任何开销
+ */
+class AllocTracker {
+public:
+    // 热路径分配预算（每次操作的分配次数）
+    static const unsigned long TAP_BUDGET = 48;       // 一次刷卡（读卡、查库、决策）
+    static const unsigned long COMMAND_BUDGET = 96;   // 一条串口管理命令
+    static const unsigned long ACTION_BUDGET = 12;    // 一次执行器动作（主要是任务创建）
+
+    // 汇总表最多记录的操作种类
+    static const size_t MAX_OPERATIONS = 16;
+
+    // 每种操作的汇总
+    struct OperationStats {
+        const char* name;
+        unsigned long budget;
+        unsigned long calls;
+        unsigned long overBudget;
+        unsigned long totalAllocs;
+        unsigned long maxAllocs;
+        unsigned long totalFrees;
+        unsigned long totalReallocs;
+        uint64_t totalBytes;
+        size_t maxBytes;
+        long maxRetained; // 单次操作结束时仍未释放的最大字节数
+    };
+
+    /**
+     * 统计作用域
+     * 构造时开始统计，析构时把结果计入同名操作的汇总并检查预算
+     * 嵌套作用域的分配同时计入外层作用域
+     */
+    class Scope {
+    public:
+        /**
+         * 构造函数
+         * @param name 操作名（必须是静态字符串）
+         * @param budget 分配次数预算，0表示不检查
+         */
+        Scope(const char* name, unsigned long budget);
+        ~Scope();
+
+    private:
+        friend class AllocTracker;
+
+        const char* name;
+        unsigned long budget;
+        Scope* parent;
+        bool active;
+
+        unsigned long allocs;
+        unsigned long frees;
+        unsigned long reallocs;
+        size_t bytesAllocated;
+        size_t bytesFreed;
+    };
+
+    /**
+     * 记录一次分配（由链接包装函数调用）
+     * @param ptr 分配得到的指针
+     * @param size 请求的字节数
+     */
+    static void recordAlloc(void* ptr, size_t size);
+
+    /**
+     * 记录一次释放（由链接包装函数在真正释放前调用）
+     * @param ptr 将被释放的指针
+     */
+    static void recordFree(void* ptr);
+
+    /**
+     * 记录一次重新分配
+     * @param oldPtr 原指针
+     * @param oldSize 原块大小
+     * @param newPtr 新指针
+     * @param newSize 新大小
+     */
+    static void recordRealloc(void* oldPtr, size_t oldSize, void* newPtr, size_t newSize);
+
+    /**
+     * 打印各操作的汇总表
+     */
+    static void printReport();
+
+    /**
+     * 清空汇总
+     */
+    static void resetStats();
+
+    /**
+     * 处理统计命令
+     * alloc       - 打印汇总表
+     * alloc:reset - 清空汇总
+     * @param command 命令字符串
+     * @return 是否为统计命令
+     */
+    static bool handleCommand(const String& command);
+
+    /**
+     * 查找操作的汇总（测试中检查预算）
+     * @param name 操作名
+     * @return 汇总，该操作还没有记录时为nullptr
+     */
+    static const OperationStats* getOperationStats(const char* name);
+
+private:
+    static OperationStats operations[MAX_OPERATIONS];
+    static size_t operationCount;
+
+    // 当前最内层的作用域及其所属任务
+    static Scope* volatile current;
+    static void* volatile ownerTask;
+
+    // 打印期间暂停统计，避免把自身输出计入外层作用域
+    static volatile bool paused;
+
+    static bool isTracking();
+    static void enter(Scope* scope);
+    static void leave(Scope* scope);
+    static OperationStats* findOperation(const char* name, unsigned long budget);
+};
+
+#ifdef ALLOC_TRACKING
+#define ALLOC_SCOPE_CONCAT_(a, b) a##b
+#define ALLOC_SCOPE_CONCAT(a, b) ALLOC_SCOPE_CONCAT_(a, b)
+#define ALLOC_SCOPE(name, budget) \
+    AllocTracker::Scope ALLOC_SCOPE_CONCAT(allocScope, __LINE__)(name, budget)
+#else
+#define ALLOC_SCOPE(name, budget) do {} while (0)
+#endif
+
+#endif // ALLOCTRACKER_H
@@ -0,0 +1,85 @@
+#include "BootTimeline.h"
+#include "freertos/task.h"
+
+BootTimeline::PhaseRecord BootTimeline::phases[MAX_PHASES];
+size_t BootTimeline::phaseCount = 0;
+BootTimeline::Milestone BootTimeline::milestones[MAX_MILESTONES];
+size_t BootTimeline::milestoneCount = 0;
+portMUX_TYPE BootTimeline::mux = portMUX_INITIALIZER_UNLOCKED;
+
+BootTimeline::Phase::Phase(const char* name) : index(BootTimeline::begin(name)) {
+}
+
+BootTimeline::Phase::~Phase() {
+    BootTimeline::end(index);
+}
+
+int BootTimeline::begin(const char* name) {
+    unsigned long now = millis();
+    int index = -1;
+    portENTER_CRITICAL(&mux);
+    if (phaseCount < MAX_PHASES) {
+        index = phaseCount++;
+        phases[index].name = name;
+        phases[index].start = now;
+        phases[index].end = 0;
+        phases[index].core = xPortGetCoreID();
+    }
+    portEXIT_CRITICAL(&mux);
+    return index;
+}
+
+void BootTimeline::end(int index) {
+    unsigned long now = millis();
+    portENTER_CRITICAL(&mux);
+    if (index >= 0 && (size_t)index < phaseCount) {
+        // 结束时间为0表示未结束，复位后第0毫秒结束的阶段记为1
+        phases[index].end = now > 0 ? now : 1;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+void BootTimeline::milestone(const char* name) {
+    unsigned long now = millis();
+    portENTER_CRITICAL(&mux);
+    bool recorded = false;
+    for (size_t i = 0; i < milestoneCount; i++) {
+        if (strcmp(milestones[i].name, name) == 0) {
+            recorded = true;
+            break;
+        }
+    }
+    if (!recorded && milestoneCount < MAX_MILESTONES) {
+        milestones[milestoneCount].name = name;
+        milestones[milestoneCount].time = now;
+        milestoneCount++;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+void BootTimeline::print() {
+    // 复制后打印，避免在临界区内输出
+    PhaseRecord phaseCopy[MAX_PHASES];
+    Milestone milestoneCopy[MAX_MILESTONES];
+    portENTER_CRITICAL(&mux);
+    size_t phaseTotal = phaseCount;
+    size_t milestoneTotal = milestoneCount;
+    memcpy(phaseCopy, phases, sizeof(PhaseRecord) * phaseTotal);
+    memcpy(milestoneCopy, milestones, sizeof(Milestone) * milestoneTotal);
+    portEXIT_CRITICAL(&mux);
+
+    Serial.println("=== Boot Timeline ===");
+    Serial.println("  start(ms)  time(ms)  core  phase");
+    for (size_t i = 0; i < phaseTotal; i++) {
+        const PhaseRecord& phase = phaseCopy[i];
+        if (phase.end == 0) {
+            Serial.printf("  %9lu   running  %4d  %s\n", phase.start, phase.core, phase.name);
+        } else {
+            Serial.printf("  %9lu  %8lu  %4d  %s\n", phase.start, phase.end - phase.start, phase.core, phase.name);
+        }
+    }
+    for (size_t i = 0; i < milestoneTotal; i++) {
+        Serial.printf("  %s at %lu ms\n", milestoneCopy[i].name, milestoneCopy[i].time);
+    }
+    Serial.println("=====================");
+}
@@ -0,0 +1,76 @@
+#ifndef BOOTTIMELINE_H
+#define BOOTTIMELINE_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+
+/**
+ * 启动时间线
+ * 记录启动各阶段的开始时间、耗时和所在核心（两个核心上的初始化并行进行），
+ * 以及关键时刻（读卡器上线、第一次开门），用于测量断电后到第一次开门的时间
+ * 时间为复位后的毫秒数（millis()，不含ROM和二级引导程序的时间）
+ * 可以在多个任务中同时记录
+ */
+class BootTimeline {
+public:
+    // 阶段和关键时刻的最大数量
+    static const size_t MAX_PHASES = 24;
+    static const size_t MAX_MILESTONES = 4;
+
+    /**
+     * 阶段作用域：构造时开始，析构时结束
+     */
+    class Phase {
+    private:
+        int index;
+
+    public:
+        explicit Phase(const char* name);
+        ~Phase();
+    };
+
+    /**
+     * 开始一个阶段
+     * @param name 阶段名称（必须是静态字符串）
+     * @return 阶段编号，记录已满时为-1
+     */
+    static int begin(const char* name);
+
+    /**
+     * 结束一个阶段
+     * @param index begin()返回的编号
+     */
+    static void end(int index);
+
+    /**
+     * 记录关键时刻（同名的只记录第一次）
+     * @param name 名称（必须是静态字符串）
+     */
+    static void milestone(const char* name);
+
+    /**
+     * 打印时间线
+     */
+    static void print();
+
+private:
+    struct PhaseRecord {
+        const char* name;
+        unsigned long start;
+        unsigned long end;   // 0表示未结束
+        int core;
+    };
+
+    struct Milestone {
+        const char* name;
+        unsigned long time;
+    };
+
+    static PhaseRecord phases[MAX_PHASES];
+    static size_t phaseCount;
+    static Milestone milestones[MAX_MILESTONES];
+    static size_t milestoneCount;
+    static portMUX_TYPE mux;
+};
+
+#endif // BOOTTIMELINE_H
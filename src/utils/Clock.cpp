@@ -0,0 +1,113 @@
+#include "Clock.h"
+#include <time.h>
+#include <sys/time.h>
+#include <Preferences.h>
+
+bool Clock::virtualMode = false;
+unsigned long Clock::virtualNow = 0;
+Clock::WallTimeSource Clock::wallTimeSource = Clock::WALL_TIME_UNSET;
+unsigned long Clock::lastWallTimeSave = 0;
+
+const char* Clock::NVS_NAMESPACE = "clock";
+const char* Clock::NVS_EPOCH = "epoch";
+
+unsigned long Clock::now() {
+    return virtualMode ? virtualNow : millis();
+}
+
+void Clock::useVirtualTime(unsigned long start) {
+    virtualNow = start;
+    virtualMode = true;
+}
+
+void Clock::useRealTime() {
+    virtualMode = false;
+}
+
+void Clock::setVirtualTime(unsigned long time) {
+    virtualNow = time;
+}
+
+bool Clock::isVirtual() {
+    return virtualMode;
+}
+
+bool Clock::setWallTime(long epoch) {
+    struct timeval tv;
+    tv.tv_sec = epoch;
+    tv.tv_usec = 0;
+    if (settimeofday(&tv, nullptr) != 0) {
+        return false;
+    }
+    wallTimeSource = WALL_TIME_SET;
+    saveWallTime();
+    return true;
+}
+
+Clock::WallTimeSource Clock::restoreWallTime() {
+    // 第一次保存提前，短于保存间隔的断电不会让恢复的时间停在同一个值
+    lastWallTimeSave = millis() - (WALL_TIME_SAVE_INTERVAL_MS - WALL_TIME_FIRST_SAVE_MS);
+
+    if (wallTime() != 0) {
+        // 软件复位后RTC继续计时
+        wallTimeSource = WALL_TIME_SET;
+        return wallTimeSource;
+    }
+
+    Preferences prefs;
+    long saved = 0;
+    if (prefs.begin(NVS_NAMESPACE, true)) {
+        saved = (long)prefs.getLong64(NVS_EPOCH, 0);
+        prefs.end();
+    }
+    if (saved < MIN_VALID_EPOCH) {
+        wallTimeSource = WALL_TIME_UNSET;
+        return wallTimeSource;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = saved;
+    tv.tv_usec = 0;
+    wallTimeSource = settimeofday(&tv, nullptr) == 0 ? WALL_TIME_RESTORED : WALL_TIME_UNSET;
+    return wallTimeSource;
+}
+
+void Clock::saveWallTime() {
+    long epoch = wallTime();
+    if (epoch == 0) {
+        return;
+    }
+    Preferences prefs;
+    if (prefs.begin(NVS_NAMESPACE, false)) {
+        prefs.putLong64(NVS_EPOCH, epoch);
+        prefs.end();
+    }
+    lastWallTimeSave = millis();
+}
+
+void Clock::saveWallTimeIfDue() {
+    if (wallTimeSource != WALL_TIME_UNSET && millis() - lastWallTimeSave >= WALL_TIME_SAVE_INTERVAL_MS) {
+        saveWallTime();
+    }
+}
+
+Clock::WallTimeSource Clock::getWallTimeSource() {
+    return wallTimeSource;
+}
+
+long Clock::wallTime() {
+    time_t t = time(nullptr);
+    return t < MIN_VALID_EPOCH ? 0 : (long)t;
+}
+
+int Clock::hourOfWeek() {
+    // 恢复的时间落后断电时长，星期和小时都不可信，按时间窗口判断会失败开放
+    time_t t = wallTime();
+    if (t == 0 || wallTimeSource == WALL_TIME_RESTORED) {
+        return -1;
+    }
+    // 时间戳按本地时间设置，直接按UTC分解
+    struct tm parts;
+    gmtime_r(&t, &parts);
+    return ((parts.tm_wday + 6) % 7) * 24 + parts.tm_hour;
+}
@@ -0,0 +1,116 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <Arduino.h>
+
+/**
+ * 系统时钟
+ * 协调器的时序判断（冷却、租约）通过Clock获取时间
+ * 正常运行时等价于millis()，仿真时切换为可手动推进的虚拟时间
+ * 另外提供墙上时间（按本地时间设置的Unix时间戳），用于访问策略的每周时间窗口
+ *
+ * 墙上时间只能通过 time:set 设置，设置后定期保存到NVS：
+ * - 软件复位后RTC继续计时，时间保持有效
+ * - 断电后启动时从最后保存的时间继续（WALL_TIME_RESTORED），比实际时间慢断电时长，
+ *   只用于审计日志的时间戳；星期和小时可能完全错误（周五傍晚断电、周六凌晨来电），
+ *   hourOfWeek()返回-1，直到重新 time:set
+ * - 从未设置过时为未知（WALL_TIME_UNSET），hourOfWeek()同样返回-1
+ * hourOfWeek()为-1时访问策略只允许全天开放的访问组（失败关闭），启动时打印警告
+ */
+class Clock {
+public:
+    // 早于此时间戳视为墙上时间未设置（2020-01-01）
+    static const long MIN_VALID_EPOCH = 1577836800L;
+
+    // 墙上时间保存到NVS的间隔（毫秒）
+    static const unsigned long WALL_TIME_SAVE_INTERVAL_MS = 600000;
+
+    // 启动后第一次保存的延迟（毫秒），频繁短暂断电时恢复的时间仍然前进
+    static const unsigned long WALL_TIME_FIRST_SAVE_MS = 60000;
+
+    // 墙上时间来源
+    enum WallTimeSource {
+        WALL_TIME_UNSET,    // 未设置，时间未知
+        WALL_TIME_SET,      // 通过time:set设置（或软件复位后RTC保持）
+        WALL_TIME_RESTORED  // 断电后从NVS中最后保存的时间恢复，比实际时间慢
+    };
+
+private:
+    static bool virtualMode;
+    static unsigned long virtualNow;
+    static WallTimeSource wallTimeSource;
+    static unsigned long lastWallTimeSave;
+
+    static const char* NVS_NAMESPACE;
+    static const char* NVS_EPOCH;
+
+    static void saveWallTime();
+
+public:
+    /**
+     * 获取当前时间（毫秒）
+     * @return 当前时间
+     */
+    static unsigned long now();
+
+    /**
+     * 切换到虚拟时间
+     * @param start 虚拟起始时间
+     */
+    static void useVirtualTime(unsigned long start);
+
+    /**
+     * 恢复为真实时间
+     */
+    static void useRealTime();
+
+    /**
+     * 设置虚拟时间（仅虚拟模式有效）
+     * @param time 新的时间
+     */
+    static void setVirtualTime(unsigned long time);
+
+    /**
+     * 是否处于虚拟时间模式
+     * @return 是否虚拟
+     */
+    static bool isVirtual();
+
+    /**
+     * 设置墙上时间并保存到NVS
+     * @param epoch 本地时间的Unix时间戳（秒）
+     * @return 是否成功
+     */
+    static bool setWallTime(long epoch);
+
+    /**
+     * 启动时恢复墙上时间：RTC时间有效时直接使用，否则从NVS中最后保存的时间继续
+     * @return 墙上时间来源
+     */
+    static WallTimeSource restoreWallTime();
+
+    /**
+     * 距上次保存超过WALL_TIME_SAVE_INTERVAL_MS时把墙上时间保存到NVS（主循环调用）
+     */
+    static void saveWallTimeIfDue();
+
+    /**
+     * 获取墙上时间来源
+     * @return 来源
+     */
+    static WallTimeSource getWallTimeSource();
+
+    /**
+     * 获取墙上时间
+     * @return Unix时间戳（秒），未设置时为0
+     */
+    static long wallTime();
+
+    /**
+     * 获取周内小时（周一0点为0，周日23点为167）
+     * @return 周内小时，墙上时间未设置或从断电前恢复（不可信）时为-1
+     */
+    static int hourOfWeek();
+};
+
+#endif // CLOCK_H
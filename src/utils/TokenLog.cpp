@@ -0,0 +1,88 @@
+#include "TokenLog.h"
+
+void TokenLog::Record::begin(uint32_t token, unsigned long timestamp) {
+    length = 0;
+    truncated = false;
+
+    buffer[length++] = FRAME_START;
+    buffer[length++] = 0; // 长度占位，提交时回填
+
+    for (int i = 0; i < 4; i++) {
+        buffer[length++] = static_cast<uint8_t>(token >> (8 * i));
+    }
+
+    putVarint(timestamp);
+}
+
+void TokenLog::Record::putVarint(uint64_t value) {
+    uint8_t encoded[10];
+    size_t count = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if (value) {
+            byte |= 0x80;
+        }
+        encoded[count++] = byte;
+    } while (value);
+
+    putBytes(encoded, count);
+}
+
+void TokenLog::Record::putSigned(int64_t value) {
+    // zigzag编码，使小的负数同样只占少量字节
+    putVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void TokenLog::Record::putBytes(const uint8_t* data, size_t len) {
+    // 末尾预留1字节校验和
+    if (truncated || length + len + 1 > MAX_RECORD_SIZE) {
+        // 参数不能被部分写入，否则解码器无法对齐
+        truncated = true;
+        return;
+    }
+    memcpy(buffer + length, data, len);
+    length += len;
+}
+
+void TokenLog::Record::putString(const char* str) {
+    if (str == nullptr) {
+        str = "";
+    }
+    size_t len = strlen(str);
+
+    // 长字符串截断到剩余空间（扣除长度前缀和校验和），保持长度前缀与内容一致
+    if (length + 2 > MAX_RECORD_SIZE) {
+        truncated = true;
+        return;
+    }
+    size_t room = MAX_RECORD_SIZE - length - 2;
+    if (len > room) {
+        len = room;
+    }
+    if (len > 0x7F) {
+        len = 0x7F;
+    }
+
+    putVarint(len);
+    putBytes(reinterpret_cast<const uint8_t*>(str), len);
+}
+
+void TokenLog::Record::putFloat(float value) {
+    uint8_t raw[sizeof(float)];
+    memcpy(raw, &value, sizeof(float));
+    putBytes(raw, sizeof(float));
+}
+
+void TokenLog::Record::commit() {
+    // 长度字段不包括帧头和长度字节本身
+    buffer[1] = static_cast<uint8_t>(length - 2);
+
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < length; i++) {
+        checksum ^= buffer[i];
+    }
+    buffer[length++] = checksum;
+
+    Serial.write(buffer, length);
+}
@@ -0,0 +1,122 @@
+#ifndef TOKENLOG_H
+#define TOKENLOG_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+/**
+ * 令牌化日志
+ * 默认模式下LOGF等价于Serial.printf，输出完整文本
+ * 定义LOG_TOKENIZED后进入延迟格式化模式：
+ * - 格式字符串在编译期哈希为32位令牌，原文只保留在ELF的.tokenlog段（不烧录到flash）
+ * - 设备只输出 {令牌, 时间戳, 原始参数} 组成的二进制记录
+ * - 主机端 tools/tokenlog_decode.py 读取ELF还原文本
+ *
+ * 记录格式（小端）：
+ *   0x00 | 长度 | 令牌(4字节) | 时间戳(varint, ms) | 参数... | 校验和(异或)
+ * 整数参数统一为zigzag varint，字符串为 varint长度+字节，浮点为4字节float
+ * 帧以0x00开头，文本输出中不会出现该字节，因此两种输出可以混合在同一串口上
+ */
+class TokenLog {
+public:
+    // 单条记录最大长度（超出部分的参数会被截断）
+    static const size_t MAX_RECORD_SIZE = 64;
+
+    // 帧起始字节
+    static const uint8_t FRAME_START = 0x00;
+
+    /**
+     * 计算格式字符串令牌（FNV-1a，编译期求值）
+     * 主机端解码器使用相同算法
+     * @param str 格式字符串
+     * @param hash 当前哈希值
+     * @return 32位令牌
+     */
+    static constexpr uint32_t tokenize(const char* str, uint32_t hash = 2166136261u) {
+        return *str ? tokenize(str + 1, (hash ^ static_cast<uint8_t>(*str)) * 16777619u) : hash;
+    }
+
+    /**
+     * 输出一条令牌化记录
+     * @param token 格式字符串令牌
+     * @param args 原始参数
+     */
+    template <typename... Args>
+    static void write(uint32_t token, const Args&... args) {
+        Record record;
+        record.begin(token, millis());
+        encodeAll(record, args...);
+        record.commit();
+    }
+
+private:
+    /**
+     * 单条记录的编码缓冲区
+     */
+    class Record {
+    public:
+        void begin(uint32_t token, unsigned long timestamp);
+        void putVarint(uint64_t value);
+        void putSigned(int64_t value);
+        void putBytes(const uint8_t* data, size_t len);
+        void putString(const char* str);
+        void putFloat(float value);
+        void commit();
+
+    private:
+        uint8_t buffer[MAX_RECORD_SIZE];
+        size_t length;
+        bool truncated;
+    };
+
+    static void encodeAll(Record&) {}
+
+    template <typename T, typename... Rest>
+    static void encodeAll(Record& record, const T& first, const Rest&... rest) {
+        encode(record, first);
+        encodeAll(record, rest...);
+    }
+
+    // 整数（含bool、char）统一按有符号zigzag编码，解码器根据格式说明符还原
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value>::type encode(Record& record, const T& value) {
+        record.putSigned(static_cast<int64_t>(value));
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_enum<T>::value>::type encode(Record& record, const T& value) {
+        record.putSigned(static_cast<int64_t>(value));
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type encode(Record& record, const T& value) {
+        record.putFloat(static_cast<float>(value));
+    }
+
+    static void encode(Record& record, const char* value) {
+        record.putString(value);
+    }
+
+    static void encode(Record& record, char* value) {
+        record.putString(value);
+    }
+
+    static void encode(Record& record, const String& value) {
+        record.putString(value.c_str());
+    }
+};
+
+#ifdef LOG_TOKENIZED
+// 格式字符串放入非加载段.tokenlog，由tools/tokenlog.ld保留在ELF中供解码器使用
+#define LOGF(fmt, ...)                                                                  \
+    do {                                                                                \
+        __attribute__((section(".tokenlog"), used)) static const char tokenlogFmt[] = fmt; \
+        static constexpr uint32_t tokenlogToken = TokenLog::tokenize(fmt);              \
+        TokenLog::write(tokenlogToken, ##__VA_ARGS__);                                  \
+    } while (0)
+#else
+// 文本模式：%s参数需传入const char*（String请使用c_str()）
+#define LOGF(fmt, ...) Serial.printf(fmt "\n", ##__VA_ARGS__)
+#endif
+
+#endif // TOKENLOG_H
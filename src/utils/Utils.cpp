@@ -1,4 +1,5 @@
 #include "Utils.h"
+#include <esp_random.h>
 
 String Utils::uidToString(uint8_t* uid, uint8_t len) {
     String result;
@@ -11,9 +12,8 @@ String Utils::uidToString(uint8_t* uid, uint8_t len) {
 }
 
 void Utils::generateRandomKey(uint8_t* key) {
-    for (int i = 0; i < KEY_SIZE; i++) {
-        key[i] = random(0, 256);
-    }
+    // 硬件随机数，一次填充整个密钥
+    esp_fill_random(key, KEY_SIZE);
 }
 
 String Utils::keyToHexString(uint8_t* key) {
@@ -29,3 +29,41 @@ void Utils::hexStringToKey(const String& hexString, uint8_t* key) {
         key[i] = strtoul(hexString.substring(i * 2, i * 2 + 2).c_str(), NULL, 16);
     }
 }
+
+bool Utils::stringToUid(const String& uidString, uint8_t* uid, uint8_t* len) {
+    size_t byteCount = uidString.length() / 2;
+    if (uidString.length() % 2 != 0 || byteCount == 0 || byteCount > MAX_UID_SIZE) {
+        return false;
+    }
+    for (size_t i = 0; i < byteCount; i++) {
+        char* end = nullptr;
+        String byteHex = uidString.substring(i * 2, i * 2 + 2);
+        uid[i] = strtoul(byteHex.c_str(), &end, 16);
+        if (end == nullptr || *end != '\0') {
+            return false;
+        }
+    }
+    *len = byteCount;
+    return true;
+}
+
+uint16_t Utils::crc16(const uint8_t* data, size_t length, uint16_t crc) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+uint32_t Utils::crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
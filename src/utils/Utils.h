@@ -36,8 +36,36 @@ public:
      */
     static void hexStringToKey(const String& hexString, uint8_t* key);
     
+    /**
+     * 将UID字符串转换为字节数组
+     * @param uidString UID十六进制字符串
+     * @param uid 输出的UID字节数组（至少MAX_UID_SIZE字节）
+     * @param len 输出的UID长度
+     * @return 转换是否成功
+     */
+    static bool stringToUid(const String& uidString, uint8_t* uid, uint8_t* len);
+
+    /**
+     * 计算CRC-16/CCITT-FALSE校验（多项式0x1021，初值0xFFFF）
+     * @param data 数据
+     * @param length 数据长度
+     * @param crc 初值（分段计算时传入上一段的结果）
+     * @return 校验值
+     */
+    static uint16_t crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+
+    /**
+     * 计算CRC-32校验（与zlib相同，多项式0xEDB88320）
+     * @param data 数据
+     * @param length 数据长度
+     * @param crc 初值（分段计算时传入上一段的结果）
+     * @return 校验值
+     */
+    static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
     // 常量定义
     static const int KEY_SIZE = 6;
+    static const int MAX_UID_SIZE = 10;
 };
 
 #endif // UTILS_H
@@ -0,0 +1,119 @@
+/**
+ * 热路径内存分配预算测试
+ * 用仿真认证器和真实的门禁执行器（LED、蜂鸣器、舵机）驱动DoorContext，
+ * 检查每次刷卡（tap）、开门（door_open）和拒绝（door_deny）的分配次数不超过AllocTracker的预算
+ *
+ * 在开发板上运行：pio test -e esp32doit-devkit-v1-alloc-test
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include "system/DoorContext.h"
+#include "data/CardDatabase.h"
+#include "execution/DoorAccessExecutor.h"
+#include "execution/LEDExecutor.h"
+#include "execution/BuzzerExecutor.h"
+#include "execution/ServoExecutor.h"
+#include "benchmark/Benchmark.h"
+#include "benchmark/CardBenchmarks.h"
+#include "benchmark/SimulatedAuthenticator.h"
+#include "utils/AllocTracker.h"
+#include "utils/Clock.h"
+
+// 与main.cpp中入口门的引脚相同
+static const int LED_PIN = 2;
+static const int BUZZER_PIN = 16;
+static const int SERVO_PIN = 14;
+
+// 数据库中的卡片数和每个用例的刷卡次数
+static const size_t CARD_COUNT = 100;
+static const size_t TAPS = 10;
+
+// 相邻两次刷卡的虚拟时间间隔，超过冷却期和锁定时间
+static const unsigned long TAP_INTERVAL_MS = 60000;
+
+// 等待执行器动作结束的最长时间
+static const unsigned long EXECUTOR_TIMEOUT_MS = 10000;
+
+static CardDatabase cardDatabase;
+static LEDExecutor ledExecutor(LED_PIN);
+static BuzzerExecutor buzzerExecutor(BUZZER_PIN);
+static ServoExecutor servoExecutor(SERVO_PIN);
+static DoorAccessExecutor doorExecutor(&ledExecutor, &buzzerExecutor, &servoExecutor);
+static SimulatedAuthenticator reader(SimulatedAuthenticator::KIND_CARD_READER, &cardDatabase, "Simulated Reader");
+static DoorContext door("Test", &doorExecutor);
+static unsigned long virtualTime = 0;
+
+/**
+ * 刷一张卡，处理一轮认证，并等待执行器动作结束（执行器任务中的分配不计入）
+ */
+static void tap(const String& uid) {
+    virtualTime += TAP_INTERVAL_MS;
+    Clock::setVirtualTime(virtualTime);
+    TEST_ASSERT_TRUE(reader.offer(uid));
+    door.handleAuthentication();
+    TEST_ASSERT_FALSE(reader.hasAuthenticationRequest());
+
+    unsigned long start = millis();
+    while (doorExecutor.isExecuting() && millis() - start < EXECUTOR_TIMEOUT_MS) {
+        delay(10);
+    }
+}
+
+/**
+ * 检查操作的调用次数和分配预算
+ */
+static void assertWithinBudget(const char* name, unsigned long budget, unsigned long calls) {
+    const AllocTracker::OperationStats* stats = AllocTracker::getOperationStats(name);
+    TEST_ASSERT_NOT_NULL_MESSAGE(stats, name);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(calls, stats->calls, name);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, stats->overBudget, name);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(budget, stats->maxAllocs, name);
+}
+
+void setUp() {
+    AllocTracker::resetStats();
+}
+
+void tearDown() {
+}
+
+void test_granted_tap_within_budget() {
+    for (size_t i = 0; i < TAPS; i++) {
+        tap(Benchmark::syntheticUID(i * 7));
+    }
+    assertWithinBudget("tap", AllocTracker::TAP_BUDGET, TAPS);
+    assertWithinBudget("door_open", AllocTracker::ACTION_BUDGET, TAPS);
+    TEST_ASSERT_NULL(AllocTracker::getOperationStats("door_deny"));
+}
+
+void test_denied_tap_within_budget() {
+    for (size_t i = 0; i < TAPS; i++) {
+        tap(Benchmark::syntheticUID(CARD_COUNT + i));
+    }
+    assertWithinBudget("tap", AllocTracker::TAP_BUDGET, TAPS);
+    assertWithinBudget("door_deny", AllocTracker::ACTION_BUDGET, TAPS);
+    TEST_ASSERT_NULL(AllocTracker::getOperationStats("door_open"));
+}
+
+void setup() {
+    // 等待串口监视器连接
+    delay(2000);
+
+    TEST_ASSERT_TRUE(CardBenchmarks::populate(cardDatabase, CARD_COUNT));
+    door.addAuthenticator(&reader);
+    TEST_ASSERT_TRUE(door.initialize());
+
+    // 延迟统计的容量预先分配，不计入刷卡
+    reader.getLatencies().reserve(4 * TAPS);
+    Clock::useVirtualTime(virtualTime);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_granted_tap_within_budget);
+    RUN_TEST(test_denied_tap_within_budget);
+    UNITY_END();
+
+    Clock::useRealTime();
+}
+
+void loop() {
+}
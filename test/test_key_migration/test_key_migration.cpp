@@ -0,0 +1,97 @@
+/**
+ * 分散密钥迁移恢复测试
+ * 迁移写入分散密钥之后、校验之前中断（卡片被拿开、应答丢失）时，卡片已经是分散密钥而数据库仍保存旧密钥；
+ * 检查CardDatabase::adoptDiversifiedKey（刷卡认证和card:migrate共用）改用分散密钥并删除保存的密钥
+ * 卡片用内存中的扇区密钥模拟，回调只在密钥与卡片上的密钥相同时认证成功
+ *
+ * 在开发板上运行：pio test -e esp32doit-devkit-v1-test（需要连接开发板，主密钥保存在NVS中）
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include "data/CardDatabase.h"
+#include "security/KeyDiversifier.h"
+#include "utils/Utils.h"
+
+static const char* CARD_UID = "04A1B2C3";
+static const char* STORED_KEY = "A0A1A2A3A4A5";
+
+static CardDatabase cardDatabase;
+static KeyDiversifier keyDiversifier;
+
+// 模拟卡片上的扇区密钥和认证次数
+static uint8_t cardKey[Utils::KEY_SIZE];
+static int probeCount = 0;
+
+static bool probeCard(const uint8_t* key) {
+    probeCount++;
+    return memcmp(key, cardKey, sizeof(cardKey)) == 0;
+}
+
+void setUp() {
+    cardDatabase.initialize();
+    cardDatabase.setKeyDiversifier(&keyDiversifier, false);
+    TEST_ASSERT_TRUE(cardDatabase.addCard(CARD_UID, STORED_KEY));
+    probeCount = 0;
+}
+
+void tearDown() {
+}
+
+void test_verify_failure_adopts_diversified_key() {
+    // 分散密钥已写入卡片，校验失败，数据库保留旧密钥
+    TEST_ASSERT_TRUE(cardDatabase.deriveCardKey(CARD_UID, cardKey));
+    TEST_ASSERT_TRUE(cardDatabase.hasStoredKey(CARD_UID));
+
+    // 保存的密钥被卡片拒绝
+    uint8_t key[Utils::KEY_SIZE];
+    TEST_ASSERT_TRUE(cardDatabase.getCardKey(CARD_UID, key));
+    TEST_ASSERT_FALSE(probeCard(key));
+
+    TEST_ASSERT_TRUE(cardDatabase.adoptDiversifiedKey(CARD_UID, probeCard));
+    TEST_ASSERT_FALSE(cardDatabase.hasStoredKey(CARD_UID));
+
+    // 之后直接使用分散密钥
+    TEST_ASSERT_TRUE(cardDatabase.getCardKey(CARD_UID, key));
+    TEST_ASSERT_TRUE(probeCard(key));
+}
+
+void test_stored_key_kept_when_card_rejects_diversified_key() {
+    // 卡片仍是旧密钥（写入没有发生），或是UID相同的伪造卡片
+    Utils::hexStringToKey("B0B1B2B3B4B5", cardKey);
+
+    TEST_ASSERT_FALSE(cardDatabase.adoptDiversifiedKey(CARD_UID, probeCard));
+    TEST_ASSERT_EQUAL(1, probeCount);
+    TEST_ASSERT_TRUE(cardDatabase.hasStoredKey(CARD_UID));
+}
+
+void test_no_fallback_without_stored_key() {
+    TEST_ASSERT_TRUE(cardDatabase.clearStoredKey(CARD_UID));
+
+    TEST_ASSERT_FALSE(cardDatabase.adoptDiversifiedKey(CARD_UID, probeCard));
+    TEST_ASSERT_EQUAL(0, probeCount);
+}
+
+void test_no_fallback_without_diversifier() {
+    cardDatabase.setKeyDiversifier(nullptr, false);
+
+    TEST_ASSERT_FALSE(cardDatabase.adoptDiversifiedKey(CARD_UID, probeCard));
+    TEST_ASSERT_EQUAL(0, probeCount);
+    TEST_ASSERT_TRUE(cardDatabase.hasStoredKey(CARD_UID));
+}
+
+void setup() {
+    // 等待串口监视器连接
+    delay(2000);
+
+    TEST_ASSERT_TRUE(keyDiversifier.initialize());
+
+    UNITY_BEGIN();
+    RUN_TEST(test_verify_failure_adopts_diversified_key);
+    RUN_TEST(test_stored_key_kept_when_card_rejects_diversified_key);
+    RUN_TEST(test_no_fallback_without_stored_key);
+    RUN_TEST(test_no_fallback_without_diversifier);
+    UNITY_END();
+}
+
+void loop() {
+}
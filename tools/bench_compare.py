@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""基准测试结果比较
+
+从串口日志中提取 "BENCH {...}" 行（见 src/benchmark/Benchmark.h），
+比较两次运行的 ns_per_op，超过阈值的变慢项以非零退出码报告。
+
+用法:
+    python tools/bench_compare.py baseline.log current.log [--threshold 0.10]
+    python tools/bench_compare.py current.log            # 只打印结果表
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path, "r", encoding="utf-8", errors="replace") as f:
+        for line in f:
+            marker = line.find("BENCH {")
+            if marker < 0:
+                continue
+            try:
+                record = json.loads(line[marker + len("BENCH "):])
+            except json.JSONDecodeError:
+                continue
+            key = (record["suite"], record["op"], record["n"])
+            results[key] = record
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare door-access benchmark logs")
+    parser.add_argument("logs", nargs="+", help="baseline log and/or current log")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown that counts as a regression (default 0.10)")
+    args = parser.parse_args()
+
+    if len(args.logs) > 2:
+        parser.error("expected one or two log files")
+
+    current = load(args.logs[-1])
+    baseline = load(args.logs[0]) if len(args.logs) == 2 else {}
+
+    regressions = 0
+    print(f"{'suite':<10} {'op':<18} {'n':>7} {'ns/op':>12} {'baseline':>12} {'change':>8}")
+    for key in sorted(current):
+        record = current[key]
+        suite, op, n = key
+        if "skipped" in record:
+            print(f"{suite:<10} {op:<18} {n:>7} {'skipped: ' + record['skipped']:>34}")
+            continue
+
+        now = record["ns_per_op"]
+        before = baseline.get(key, {}).get("ns_per_op")
+        if before:
+            change = (now - before) / before
+            flag = " REGRESSION" if change > args.threshold else ""
+            regressions += bool(flag)
+            print(f"{suite:<10} {op:<18} {n:>7} {now:>12} {before:>12} {change:>+7.1%}{flag}")
+        else:
+            print(f"{suite:<10} {op:<18} {n:>7} {now:>12} {'-':>12} {'':>8}")
+
+    if regressions:
+        print(f"{regressions} regression(s) above {args.threshold:.0%}", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
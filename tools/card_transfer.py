@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""卡片批量导入/导出
+
+通过串口与设备的 card:import / card:export 命令交换卡片（见 NFCCardManager::handleImport），
+数据分块发送，每块带CRC-32，收到设备应答后再发下一块，校验失败时重发。
+导入结束时设备一次保存，并报告吞吐量。
+
+CSV格式与 tools/cardindex.cpp 相同：uid,key,groups，第一行含"uid"时作为表头；
+key为空表示使用分散密钥；groups为空表示不受限制，"-"表示不属于任何组（所有门都拒绝），
+多个组用分号或竖线分隔。导出的CSV可以直接用于cardindex生成映像。
+
+用法:
+    python tools/card_transfer.py --port /dev/ttyUSB0 import cards.csv
+    python tools/card_transfer.py --port /dev/ttyUSB0 export cards.csv
+"""
+
+import argparse
+import csv
+import sys
+import time
+import zlib
+
+MAX_CHUNK_RECORDS = 32   # 与 NFCCardManager::IMPORT_MAX_RECORDS 一致
+MAX_LINE_BYTES = 900     # 设备串口接收缓冲为1024字节
+RETRIES = 3
+
+
+def open_port(path, baud):
+    import serial  # pyserial随PlatformIO一起安装
+
+    port = serial.Serial()
+    port.port = path
+    port.baudrate = baud
+    port.timeout = 0.5
+    # 不拉DTR/RTS，避免打开串口时复位ESP32
+    port.dtr = False
+    port.rts = False
+    port.open()
+    port.reset_input_buffer()
+    return port
+
+
+def send(port, line):
+    port.write((line + "\n").encode("utf-8"))
+    port.flush()
+
+
+def wait_for(port, prefixes, timeout):
+    """读取设备输出直到出现以prefixes之一开头的行，返回该行；超时返回None"""
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        raw = port.readline()
+        if not raw:
+            continue
+        line = raw.decode("utf-8", errors="replace").strip()
+        for prefix in prefixes:
+            if line.startswith(prefix):
+                return line
+    return None
+
+
+def read_csv(path):
+    records = []
+    with open(path, newline="", encoding="utf-8-sig") as f:
+        rows = [row for row in csv.reader(f) if row and not row[0].lstrip().startswith("#")]
+    columns = {"uid": 0, "key": 1, "groups": 2}
+    if rows and "uid" in [field.strip().lower() for field in rows[0]]:
+        header = [field.strip().lower() for field in rows.pop(0)]
+        columns = {name: header.index(name) if name in header else None for name in columns}
+
+    for number, row in enumerate(rows, 1):
+        def field(name):
+            index = columns[name]
+            return row[index].strip() if index is not None and index < len(row) else ""
+
+        uid = field("uid").replace(":", "").replace("-", "").replace(" ", "")
+        key = field("key").replace(":", "").replace("-", "").replace(" ", "")
+        groups = field("groups")
+        if groups == "-":
+            wire_groups = ""
+        else:
+            names = [name.strip() for name in groups.replace("|", ";").replace(",", ";").split(";")]
+            wire_groups = ";".join(name for name in names if name) or "*"
+        record = f"{uid},{key},{wire_groups}"
+        if not uid or "|" in record or record.count(",") != 2:
+            raise ValueError(f"{path}: row {number}: invalid record {row}")
+        records.append(record)
+    return records
+
+
+def chunks(records, size):
+    chunk = []
+    length = 0
+    for record in records:
+        record_bytes = len(record.encode("utf-8")) + 1
+        if chunk and (len(chunk) >= size or length + record_bytes > MAX_LINE_BYTES):
+            yield chunk
+            chunk = []
+            length = 0
+        chunk.append(record)
+        length += record_bytes
+    if chunk:
+        yield chunk
+
+
+def import_cards(port, args):
+    records = read_csv(args.csv)
+    start = time.monotonic()
+    send(port, "card:import:begin")
+    if wait_for(port, ["IMPORT READY"], 5) is None:
+        sys.exit("device did not start the import (another import in progress?)")
+
+    sent = 0
+    for sequence, chunk in enumerate(chunks(records, args.chunk)):
+        payload = "|".join(chunk)
+        crc = zlib.crc32(payload.encode("utf-8")) & 0xFFFFFFFF
+        for attempt in range(RETRIES + 1):
+            send(port, f"card:import:{sequence}:{crc:08X}:{payload}")
+            reply = wait_for(port, [f"IMPORT OK {sequence} ", f"IMPORT ERR {sequence} "], 10)
+            if reply and reply.startswith("IMPORT OK"):
+                _, _, _, applied, invalid = reply.split()
+                if int(invalid):
+                    print(f"chunk {sequence}: {invalid} invalid records (see device log)", file=sys.stderr)
+                break
+            if reply and "checksum" not in reply:
+                sys.exit(f"chunk {sequence} rejected: {reply}")
+            print(f"chunk {sequence}: {reply or 'no reply'}, retrying", file=sys.stderr)
+        else:
+            send(port, "card:import:end")
+            sys.exit(f"chunk {sequence} failed after {RETRIES} retries, imported chunks were saved")
+        sent += len(chunk)
+        print(f"\r{sent}/{len(records)} records", end="", file=sys.stderr)
+    print(file=sys.stderr)
+
+    send(port, "card:import:end")
+    done = wait_for(port, ["IMPORT DONE"], 120)
+    elapsed = time.monotonic() - start
+    if done is None or not done.endswith("saved"):
+        sys.exit(f"import failed: {done or 'no reply'}")
+    print(f"Imported {done.split()[2]} records in {elapsed:.1f} s ({len(records) / elapsed:.0f} records/s)")
+
+
+def export_cards(port, args):
+    start = time.monotonic()
+    send(port, f"card:export:{args.chunk}")
+    begin = wait_for(port, ["EXPORT BEGIN"], 5)
+    if begin is None:
+        sys.exit("device did not start the export")
+
+    rows = []
+    expected = 0
+    while True:
+        line = wait_for(port, ["EXPORT "], 10)
+        if line is None:
+            sys.exit("export timed out")
+        if line.startswith("EXPORT END"):
+            _, _, chunk_count, total = line.split()
+            if int(chunk_count) != expected or int(total) != len(rows):
+                sys.exit(f"export incomplete: got {expected} chunks/{len(rows)} records, device sent {line}")
+            break
+        sequence, crc, payload = line[len("EXPORT "):].split(":", 2)
+        if int(sequence) != expected or zlib.crc32(payload.encode("utf-8")) & 0xFFFFFFFF != int(crc, 16):
+            sys.exit(f"chunk {sequence}: sequence or checksum mismatch, run the export again")
+        expected += 1
+        for record in payload.split("|"):
+            uid, key, groups = record.split(",", 2)
+            rows.append([uid, key, "" if groups == "*" else (groups or "-")])
+
+    with open(args.csv, "w", newline="", encoding="utf-8") as f:
+        writer = csv.writer(f)
+        writer.writerow(["uid", "key", "groups"])
+        writer.writerows(rows)
+    elapsed = time.monotonic() - start
+    print(f"Exported {len(rows)} records to {args.csv} in {elapsed:.1f} s ({len(rows) / elapsed:.0f} records/s)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Bulk import/export door-access cards over serial")
+    parser.add_argument("command", choices=["import", "export"])
+    parser.add_argument("csv", help="card list to import from / export to")
+    parser.add_argument("--port", required=True, help="serial port of the device")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--chunk", type=int, default=16,
+                        help=f"records per chunk (1-{MAX_CHUNK_RECORDS}, default 16)")
+    args = parser.parse_args()
+
+    if not 1 <= args.chunk <= MAX_CHUNK_RECORDS:
+        parser.error(f"--chunk must be between 1 and {MAX_CHUNK_RECORDS}")
+
+    with open_port(args.port, args.baud) as port:
+        if args.command == "import":
+            import_cards(port, args)
+        else:
+            export_cards(port, args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,781 @@
+/**
+ * 卡片数据库映像生成工具（主机端）
+ *
+ * 把HR导出的CSV或JSON卡片列表离线转换为可以直接烧录的映像，不需要逐张通过串口注册：
+ * - index：cardidx分区映像（FlashCardIndex使用，格式见src/data/CardIndexFormat.h，与固件共用）
+ * - fs：卡片文件槽cards.json.a（FileStorageBackend使用，格式见src/data/CardFileFormat.h，与固件共用），
+ *   放入data目录后由PlatformIO生成SPIFFS/LittleFS映像
+ * - verify：检查分区映像（文件头、CRC、排序）并打印统计
+ *
+ * 输入格式：
+ * - CSV：每行 uid[,key[,groups]]，第一行含"uid"时作为表头按列名取值；
+ *   groups为空表示不受限制，"-"表示不属于任何组，多个组用逗号（需加引号）、分号或竖线分隔；以#开头的行忽略
+ * - JSON：与设备卡片文件相同的数组 [{"uid":"04A1B2C3","key":"...","groups":["staff"]}, ...]
+ * UID和密钥中的冒号、短横线和空格会被去掉；重复的UID以最后一次出现为准
+ *
+ * 编译：
+ *   g++ -std=c++11 -O2 -o cardindex tools/cardindex.cpp
+ *
+ * 用法：
+ *   cardindex index cards.csv cardidx.bin --partitions partitions_index.csv
+ *   esptool.py --chip esp32 write_flash 0x380000 cardidx.bin
+ *
+ *   cardindex fs cards.csv data
+ *   pio run -e esp32doit-devkit-v1 -t uploadfs      # 注意：会替换整个文件系统（审计日志等）
+ *
+ *   cardindex verify cardidx.bin
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/data/CardIndexFormat.h"
+#include "../src/data/CardFileFormat.h"
+
+using namespace CardIndexFormat;
+using CardFileFormat::MAX_UID_SIZE;
+using CardFileFormat::SLOT_MAGIC;
+using CardFileFormat::SlotHeader;
+
+namespace {
+
+// 默认分区大小（partitions_index.csv中的cardidx）
+const uint32_t DEFAULT_PARTITION_SIZE = 0x80000;
+
+struct Card {
+    std::string uid;        // 大写十六进制
+    bool hasKey;
+    std::string key;        // 大写十六进制，12个字符
+    bool hasGroups;
+    std::string groups;     // 逗号分隔的组名称
+    size_t line;            // 输入中的位置（用于错误信息）
+};
+
+struct Options {
+    std::string command;
+    std::string input;
+    std::string output;
+    std::string format;     // csv或json，默认按扩展名
+    std::string partitions; // 分区表，用于确定cardidx的大小和偏移
+    uint32_t size;
+    long offset;            // 分区偏移，-1表示未知
+    bool skipInvalid;
+};
+
+void usage() {
+    fprintf(stderr,
+            "usage:\n"
+            "  cardindex index <cards.csv|cards.json> <cardidx.bin> [--partitions partitions_index.csv | --size 0x80000]\n"
+            "  cardindex fs <cards.csv|cards.json> <data_dir>\n"
+            "  cardindex verify <cardidx.bin>\n"
+            "options:\n"
+            "  --format csv|json   input format (default: by file extension)\n"
+            "  --skip-invalid      drop invalid rows instead of failing\n");
+}
+
+bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+bool writeFile(const std::string& path, const void* data, size_t length) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool success = fwrite(data, 1, length, file) == length;
+    return fclose(file) == 0 && success;
+}
+
+std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+std::string lower(std::string text) {
+    for (size_t i = 0; i < text.size(); i++) {
+        text[i] = tolower((unsigned char)text[i]);
+    }
+    return text;
+}
+
+/**
+ * 规范化十六进制字段：去掉分隔符并转为大写
+ * @return 是否只包含十六进制字符
+ */
+bool normalizeHex(const std::string& text, std::string& hex) {
+    hex.clear();
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c == ':' || c == '-' || c == ' ' || c == '\t') {
+            continue;
+        }
+        if (!isxdigit((unsigned char)c)) {
+            return false;
+        }
+        hex += (char)toupper((unsigned char)c);
+    }
+    return true;
+}
+
+/**
+ * 规范化组列表：按逗号、分号或竖线拆分，去掉空白和空名称，用逗号连接
+ */
+std::string normalizeGroups(const std::string& text) {
+    std::string result;
+    std::string name;
+    for (size_t i = 0; i <= text.size(); i++) {
+        char c = i < text.size() ? text[i] : ',';
+        if (c == ',' || c == ';' || c == '|') {
+            name = trim(name);
+            if (!name.empty()) {
+                if (!result.empty()) {
+                    result += ',';
+                }
+                result += name;
+            }
+            name.clear();
+        } else {
+            name += c;
+        }
+    }
+    return result;
+}
+
+/**
+ * 检查并添加一张卡片
+ * @return 是否有效
+ */
+bool addCard(std::vector<Card>& cards, const std::string& uidText, const std::string& keyText,
+             bool hasGroups, const std::string& groups, size_t line) {
+    Card card;
+    card.line = line;
+    card.hasGroups = hasGroups;
+    card.groups = groups;
+    if (!normalizeHex(uidText, card.uid) || card.uid.empty() || card.uid.size() % 2 != 0 ||
+        card.uid.size() / 2 > MAX_UID_SIZE) {
+        fprintf(stderr, "entry %zu: invalid UID '%s'\n", line, uidText.c_str());
+        return false;
+    }
+    card.hasKey = !trim(keyText).empty();
+    if (card.hasKey && (!normalizeHex(keyText, card.key) || card.key.size() != KEY_SIZE * 2)) {
+        fprintf(stderr, "entry %zu: invalid key for %s (expected %zu hex digits)\n", line, card.uid.c_str(),
+                KEY_SIZE * 2);
+        return false;
+    }
+    cards.push_back(card);
+    return true;
+}
+
+/**
+ * 按RFC 4180拆分CSV（支持引号内的逗号和""转义，不支持引号内换行）
+ */
+std::vector<std::string> splitCsvLine(const std::string& line) {
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(trim(field));
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.push_back(trim(field));
+    return fields;
+}
+
+/**
+ * 解析CSV输入
+ * @return 无效行数
+ */
+size_t parseCsv(const std::string& content, std::vector<Card>& cards) {
+    size_t invalid = 0;
+    int uidColumn = 0;
+    int keyColumn = 1;
+    int groupsColumn = 2;
+    bool firstRecord = true;
+    size_t lineNumber = 0;
+    size_t position = 0;
+    // 去掉UTF-8 BOM
+    if (content.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        position = 3;
+    }
+
+    while (position < content.size()) {
+        size_t end = content.find('\n', position);
+        if (end == std::string::npos) {
+            end = content.size();
+        }
+        std::string line = trim(content.substr(position, end - position));
+        position = end + 1;
+        lineNumber++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::vector<std::string> fields = splitCsvLine(line);
+        if (firstRecord) {
+            firstRecord = false;
+            bool header = false;
+            for (size_t i = 0; i < fields.size(); i++) {
+                header = header || lower(fields[i]) == "uid";
+            }
+            if (header) {
+                uidColumn = keyColumn = groupsColumn = -1;
+                for (size_t i = 0; i < fields.size(); i++) {
+                    std::string name = lower(fields[i]);
+                    if (name == "uid") {
+                        uidColumn = i;
+                    } else if (name == "key") {
+                        keyColumn = i;
+                    } else if (name == "groups") {
+                        groupsColumn = i;
+                    }
+                }
+                continue;
+            }
+        }
+
+        std::string uid = (size_t)uidColumn < fields.size() ? fields[uidColumn] : "";
+        std::string key = keyColumn >= 0 && (size_t)keyColumn < fields.size() ? fields[keyColumn] : "";
+        std::string groupsField = groupsColumn >= 0 && (size_t)groupsColumn < fields.size() ? fields[groupsColumn] : "";
+        // "-"表示受限但不属于任何组（与card:export的CSV一致）
+        std::string groups = groupsField == "-" ? "" : normalizeGroups(groupsField);
+        if (!addCard(cards, uid, key, groupsField == "-" || !groups.empty(), groups, lineNumber)) {
+            invalid++;
+        }
+    }
+    return invalid;
+}
+
+/**
+ * 最小的JSON解析器，只支持卡片文件需要的部分（任意值都能跳过）
+ */
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text) : text(text), position(0), failed(false) {}
+
+    bool ok() const {
+        return !failed;
+    }
+
+    size_t offset() const {
+        return position;
+    }
+
+    void skipSpace() {
+        while (position < text.size() && isspace((unsigned char)text[position])) {
+            position++;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (position < text.size() && text[position] == c) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            failed = true;
+        }
+    }
+
+    char peek() {
+        skipSpace();
+        return position < text.size() ? text[position] : '\0';
+    }
+
+    std::string readString() {
+        std::string result;
+        expect('"');
+        while (!failed && position < text.size() && text[position] != '"') {
+            char c = text[position++];
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (position >= text.size()) {
+                break;
+            }
+            char escape = text[position++];
+            switch (escape) {
+                case 'n': result += '\n'; break;
+                case 't': result += '\t'; break;
+                case 'r': result += '\r'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'u': {
+                    // 只用于组名称，按UTF-8编码基本平面字符
+                    unsigned code = position + 4 <= text.size()
+                                        ? strtoul(text.substr(position, 4).c_str(), nullptr, 16) : 0;
+                    position += 4;
+                    if (code < 0x80) {
+                        result += (char)code;
+                    } else if (code < 0x800) {
+                        result += (char)(0xC0 | (code >> 6));
+                        result += (char)(0x80 | (code & 0x3F));
+                    } else {
+                        result += (char)(0xE0 | (code >> 12));
+                        result += (char)(0x80 | ((code >> 6) & 0x3F));
+                        result += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: result += escape; break;
+            }
+        }
+        expect('"');
+        return result;
+    }
+
+    void skipValue() {
+        char c = peek();
+        if (c == '"') {
+            readString();
+        } else if (c == '{' || c == '[') {
+            char close = c == '{' ? '}' : ']';
+            position++;
+            if (consume(close)) {
+                return;
+            }
+            do {
+                if (c == '{') {
+                    readString();
+                    expect(':');
+                }
+                skipValue();
+            } while (!failed && consume(','));
+            expect(close);
+        } else if (c != '\0' && strchr("-0123456789tfn", c) != nullptr) {
+            while (position < text.size() && strchr(",]} \t\r\n", text[position]) == nullptr) {
+                position++;
+            }
+        } else {
+            failed = true;
+        }
+    }
+
+private:
+    const std::string& text;
+    size_t position;
+    bool failed;
+};
+
+/**
+ * 解析JSON输入
+ * @return 无效条目数，格式错误时返回SIZE_MAX
+ */
+size_t parseJson(const std::string& content, std::vector<Card>& cards) {
+    JsonReader reader(content);
+    size_t invalid = 0;
+    size_t index = 0;
+    reader.expect('[');
+    if (reader.ok() && !reader.consume(']')) {
+        do {
+            index++;
+            std::string uid;
+            std::string key;
+            bool hasGroups = false;
+            std::string groups;
+            reader.expect('{');
+            if (reader.ok() && !reader.consume('}')) {
+                do {
+                    std::string field = reader.readString();
+                    reader.expect(':');
+                    if (field == "uid" && reader.peek() == '"') {
+                        uid = reader.readString();
+                    } else if (field == "key" && reader.peek() == '"') {
+                        key = reader.readString();
+                    } else if (field == "groups" && reader.peek() == '[') {
+                        // 空数组表示受限但没有任何组（与设备一致），与不受限制不同
+                        hasGroups = true;
+                        reader.expect('[');
+                        if (!reader.consume(']')) {
+                            do {
+                                std::string name = trim(reader.readString());
+                                if (!name.empty()) {
+                                    groups += groups.empty() ? "" : ",";
+                                    groups += name;
+                                }
+                            } while (reader.ok() && reader.consume(','));
+                            reader.expect(']');
+                        }
+                    } else {
+                        reader.skipValue();
+                    }
+                } while (reader.ok() && reader.consume(','));
+                reader.expect('}');
+            }
+            if (!reader.ok()) {
+                break;
+            }
+            if (!addCard(cards, uid, key, hasGroups, groups, index)) {
+                invalid++;
+            }
+        } while (reader.consume(','));
+        reader.expect(']');
+    }
+    if (!reader.ok()) {
+        fprintf(stderr, "JSON syntax error near offset %zu\n", reader.offset());
+        return SIZE_MAX;
+    }
+    return invalid;
+}
+
+/**
+ * 去掉重复的UID（保留最后一次出现），结果按UID排序
+ * 十六进制字符串的字典序与CardIndexFormat::compareUid一致
+ */
+void sortAndDeduplicate(std::vector<Card>& cards) {
+    std::stable_sort(cards.begin(), cards.end(), [](const Card& a, const Card& b) {
+        return a.uid < b.uid;
+    });
+    std::vector<Card> unique;
+    unique.reserve(cards.size());
+    for (size_t i = 0; i < cards.size(); i++) {
+        if (i + 1 < cards.size() && cards[i + 1].uid == cards[i].uid) {
+            fprintf(stderr, "warning: duplicate UID %s (entry %zu replaced by entry %zu)\n", cards[i].uid.c_str(),
+                    cards[i].line, cards[i + 1].line);
+            continue;
+        }
+        unique.push_back(cards[i]);
+    }
+    cards.swap(unique);
+}
+
+/**
+ * 从分区表中读取cardidx分区的偏移和大小
+ */
+bool readPartitionTable(const std::string& path, Options& options) {
+    std::string content;
+    if (!readFile(path, content)) {
+        fprintf(stderr, "cannot read %s\n", path.c_str());
+        return false;
+    }
+    std::istringstream lines(content);
+    std::string line;
+    while (std::getline(lines, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields = splitCsvLine(line);
+        if (fields.size() >= 5 && fields[0] == PARTITION_LABEL) {
+            options.offset = strtol(fields[3].c_str(), nullptr, 0);
+            options.size = strtoul(fields[4].c_str(), nullptr, 0);
+            return options.size > 0;
+        }
+    }
+    fprintf(stderr, "%s: no '%s' partition\n", path.c_str(), PARTITION_LABEL);
+    return false;
+}
+
+int buildIndex(const std::vector<Card>& cards, const Options& options) {
+    // 转换为索引记录（已排序，UID的字节序与字符串序一致）
+    std::vector<IndexRecord> records(cards.size());
+    uint32_t stringsSize = 0;
+    for (size_t i = 0; i < cards.size(); i++) {
+        IndexRecord& record = records[i];
+        if (!parseUid(cards[i].uid.c_str(), cards[i].uid.size(), record)) {
+            fprintf(stderr, "entry %zu: UID %s longer than %zu bytes, not supported by the index\n", cards[i].line,
+                    cards[i].uid.c_str(), MAX_UID_LENGTH);
+            return 1;
+        }
+        if (cards[i].hasKey) {
+            for (size_t k = 0; k < KEY_SIZE; k++) {
+                record.key[k] = strtoul(cards[i].key.substr(k * 2, 2).c_str(), nullptr, 16);
+            }
+            record.flags |= FLAG_HAS_KEY;
+        }
+        // 与设备重写映像时相同，每张卡片单独保存组名称（不合并相同的字符串），
+        // 这样映像大小与设备上重写后的大小一致
+        record.groupsOffset = NO_GROUPS;
+        if (cards[i].hasGroups) {
+            record.groupsOffset = stringsSize;
+            stringsSize += cards[i].groups.size() + 1;
+        }
+    }
+
+    ImageHeader header;
+    memset(&header, 0, sizeof(header));
+    uint32_t imageSize = layoutImage(header, records.size(), stringsSize);
+    uint32_t slot = slotSize(options.size);
+    if (imageSize > slot) {
+        uint32_t needed = DELTA_REGION_SIZE + 2 * ((imageSize + SECTOR_SIZE - 1) & ~(SECTOR_SIZE - 1));
+        fprintf(stderr, "image is %u bytes but a slot of a 0x%X partition holds %u; the partition needs at least 0x%X\n",
+                (unsigned)imageSize, (unsigned)options.size, (unsigned)slot, (unsigned)needed);
+        return 1;
+    }
+
+    // 整个分区：变更日志和槽B为擦除状态，映像写入槽A
+    std::vector<uint8_t> partition(options.size, 0xFF);
+    uint8_t* base = &partition[slotOffset(0, options.size)];
+    memcpy(base + header.recordsOffset, records.data(), records.size() * sizeof(IndexRecord));
+    uint8_t* strings = base + header.stringsOffset;
+    for (size_t i = 0; i < cards.size(); i++) {
+        if (cards[i].hasGroups) {
+            memcpy(strings + records[i].groupsOffset, cards[i].groups.c_str(), cards[i].groups.size() + 1);
+        }
+    }
+    header.recordsCrc = crc32(base + header.recordsOffset, records.size() * sizeof(IndexRecord));
+    header.stringsCrc = crc32(strings, stringsSize);
+    sealHeader(header, 1);
+    memcpy(base, &header, sizeof(header));
+
+    if (!writeFile(options.output, partition.data(), partition.size())) {
+        fprintf(stderr, "cannot write %s\n", options.output.c_str());
+        return 1;
+    }
+    printf("Wrote %s: %zu cards, image %u bytes (%u%% of slot)\n", options.output.c_str(), cards.size(),
+           (unsigned)imageSize, (unsigned)((uint64_t)imageSize * 100 / slot));
+    if (options.offset >= 0) {
+        printf("Flash with: esptool.py --chip esp32 write_flash 0x%lX %s\n", options.offset, options.output.c_str());
+    }
+    return 0;
+}
+
+void appendJsonString(std::string& out, const std::string& text) {
+    out += '"';
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = text[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04X", c);
+            out += escape;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+int buildFileSystemCards(const std::vector<Card>& cards, const Options& options) {
+    // 与设备保存时相同的紧凑JSON（字段顺序uid、key、groups）
+    std::string body = "[";
+    for (size_t i = 0; i < cards.size(); i++) {
+        const Card& card = cards[i];
+        body += i > 0 ? ",{\"uid\":" : "{\"uid\":";
+        appendJsonString(body, card.uid);
+        if (card.hasKey) {
+            body += ",\"key\":";
+            appendJsonString(body, card.key);
+        }
+        if (card.hasGroups) {
+            body += ",\"groups\":[";
+            std::string name;
+            bool first = true;
+            for (size_t k = 0; k <= card.groups.size(); k++) {
+                if (k == card.groups.size() || card.groups[k] == ',') {
+                    if (!name.empty()) {
+                        body += first ? "" : ",";
+                        appendJsonString(body, name);
+                        first = false;
+                    }
+                    name.clear();
+                } else {
+                    name += card.groups[k];
+                }
+            }
+            body += "]";
+        }
+        body += "}";
+    }
+    body += "]";
+
+    SlotHeader header;
+    header.magic = SLOT_MAGIC;
+    header.sequence = 1;
+    header.length = body.size();
+    header.crc = crc32(body.data(), body.size());
+    std::string file((const char*)&header, sizeof(header));
+    file += body;
+
+    std::string path = options.output + CardFileFormat::CARD_FILE_PATH + CardFileFormat::slotSuffix(0);
+    if (!writeFile(path, file.data(), file.size())) {
+        fprintf(stderr, "cannot write %s (does the directory exist?)\n", path.c_str());
+        return 1;
+    }
+    // 旧的B槽序号可能更大，会覆盖新生成的A槽
+    std::string stale = options.output + CardFileFormat::CARD_FILE_PATH + CardFileFormat::slotSuffix(1);
+    remove(stale.c_str());
+    printf("Wrote %s: %zu cards, %zu bytes\n", path.c_str(), cards.size(), file.size());
+    printf("The whole card file is loaded into RAM on the device; use the index image for large card sets\n");
+    return 0;
+}
+
+int verifyIndex(const Options& options) {
+    std::string image;
+    if (!readFile(options.input, image)) {
+        fprintf(stderr, "cannot read %s\n", options.input.c_str());
+        return 1;
+    }
+    uint32_t size = image.size();
+    uint32_t slot = slotSize(size);
+    if (slot == 0) {
+        fprintf(stderr, "%s: too small for a card index partition\n", options.input.c_str());
+        return 1;
+    }
+
+    int result = 1;
+    for (int i = 0; i < 2; i++) {
+        const uint8_t* base = (const uint8_t*)image.data() + slotOffset(i, size);
+        ImageHeader header;
+        memcpy(&header, base, sizeof(header));
+        if (!isValidHeader(header, slot)) {
+            printf("slot %d: no valid image\n", i);
+            continue;
+        }
+        const IndexRecord* records = (const IndexRecord*)(base + header.recordsOffset);
+        bool crcOk = crc32(records, header.recordCount * sizeof(IndexRecord)) == header.recordsCrc &&
+                     crc32(base + header.stringsOffset, header.stringsSize) == header.stringsCrc;
+        bool sorted = true;
+        for (uint32_t k = 1; k < header.recordCount && sorted; k++) {
+            sorted = compareUid(records[k - 1].uid, records[k - 1].uidLength, records[k].uid,
+                                records[k].uidLength) < 0;
+        }
+        printf("slot %d: sequence %u, %u cards, %u bytes, CRC %s, %s\n", i, (unsigned)header.sequence,
+               (unsigned)header.recordCount, (unsigned)(header.stringsOffset + header.stringsSize),
+               crcOk ? "ok" : "BAD", sorted ? "sorted" : "NOT SORTED");
+        if (crcOk && sorted) {
+            result = 0;
+        }
+    }
+
+    size_t deltas = 0;
+    for (size_t i = 0; i < DELTA_CAPACITY; i++) {
+        DeltaRecord delta;
+        memcpy(&delta, image.data() + i * sizeof(DeltaRecord), sizeof(delta));
+        if (delta.magic != DELTA_MAGIC) {
+            break;
+        }
+        deltas++;
+    }
+    printf("change log: %zu records\n", deltas);
+    return result;
+}
+
+bool parseArguments(int argc, char** argv, Options& options) {
+    options.size = DEFAULT_PARTITION_SIZE;
+    options.offset = -1;
+    options.skipInvalid = false;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            options.format = argv[++i];
+        } else if (arg == "--size" && i + 1 < argc) {
+            options.size = strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--partitions" && i + 1 < argc) {
+            options.partitions = argv[++i];
+        } else if (arg == "--skip-invalid") {
+            options.skipInvalid = true;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.empty()) {
+        return false;
+    }
+    options.command = positional[0];
+    if (options.command == "verify") {
+        if (positional.size() != 2) {
+            return false;
+        }
+        options.input = positional[1];
+        return true;
+    }
+    if ((options.command != "index" && options.command != "fs") || positional.size() != 3) {
+        return false;
+    }
+    options.input = positional[1];
+    options.output = positional[2];
+    if (options.format.empty()) {
+        std::string path = lower(options.input);
+        options.format = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0 ? "json" : "csv";
+    }
+    return options.format == "csv" || options.format == "json";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    if (options.command == "verify") {
+        return verifyIndex(options);
+    }
+    if (!options.partitions.empty() && !readPartitionTable(options.partitions, options)) {
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string content;
+    if (!readFile(options.input, content)) {
+        fprintf(stderr, "cannot read %s\n", options.input.c_str());
+        return 1;
+    }
+    std::vector<Card> cards;
+    size_t invalid = options.format == "json" ? parseJson(content, cards) : parseCsv(content, cards);
+    if (invalid == SIZE_MAX) {
+        return 1;
+    }
+    if (invalid > 0) {
+        fprintf(stderr, "%zu invalid entries%s\n", invalid, options.skipInvalid ? " skipped" : "");
+        if (!options.skipInvalid) {
+            return 1;
+        }
+    }
+    sortAndDeduplicate(cards);
+
+    int result = options.command == "index" ? buildIndex(cards, options) : buildFileSystemCards(cards, options);
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)
+                       .count();
+    if (result == 0) {
+        printf("Done in %ld ms\n", elapsed);
+    }
+    return result;
+}
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""令牌化日志解码器
+
+从固件ELF的 .tokenlog 段读取格式字符串，解码设备串口输出中的二进制日志记录
+（见 src/utils/TokenLog.h），普通文本输出原样透传。
+
+用法:
+    python tools/tokenlog_decode.py .pio/build/esp32doit-devkit-v1-tokenlog/firmware.elf --port /dev/ttyUSB0
+    python tools/tokenlog_decode.py firmware.elf --input capture.bin
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FRAME_START = 0x00
+SPEC_RE = re.compile(r"%(?:%|[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z|j|t)?([diouxXcsfFeEgGp]))")
+
+
+def tokenize(fmt: bytes) -> int:
+    """FNV-1a，与 TokenLog::tokenize 一致"""
+    h = 2166136261
+    for b in fmt:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def read_tokenlog_section(elf_path: str) -> bytes:
+    """读取ELF中的 .tokenlog 段（仅支持小端ELF32/ELF64）"""
+    with open(elf_path, "rb") as f:
+        data = f.read()
+
+    if data[:4] != b"\x7fELF":
+        raise ValueError(f"{elf_path}: not an ELF file")
+    is64 = data[4] == 2
+    if data[5] != 1:
+        raise ValueError(f"{elf_path}: big-endian ELF not supported")
+
+    if is64:
+        shoff, = struct.unpack_from("<Q", data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x3A)
+    else:
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+    def section(index):
+        base = shoff + index * shentsize
+        if is64:
+            name, _, _, _, offset, size = struct.unpack_from("<IIQQQQ", data, base)
+        else:
+            name, _, _, _, offset, size = struct.unpack_from("<IIIIII", data, base)
+        return name, offset, size
+
+    _, strtab_off, _ = section(shstrndx)
+    for i in range(shnum):
+        name_off, offset, size = section(i)
+        end = data.index(b"\x00", strtab_off + name_off)
+        if data[strtab_off + name_off:end] == b".tokenlog":
+            return data[offset:offset + size]
+
+    raise ValueError(f"{elf_path}: no .tokenlog section (was it built with LOG_TOKENIZED?)")
+
+
+def load_database(elf_path: str) -> dict:
+    database = {}
+    for fmt in read_tokenlog_section(elf_path).split(b"\x00"):
+        if fmt:
+            database[tokenize(fmt)] = fmt.decode("utf-8", errors="replace")
+    return database
+
+
+def read_varint(buf: bytes, pos: int):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(buf):
+            raise IndexError("truncated varint")
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def read_signed(buf: bytes, pos: int):
+    raw, pos = read_varint(buf, pos)
+    return (raw >> 1) ^ -(raw & 1), pos
+
+
+def format_record(database: dict, body: bytes) -> str:
+    token, = struct.unpack_from("<I", body, 0)
+    timestamp, pos = read_varint(body, 4)
+
+    fmt = database.get(token)
+    if fmt is None:
+        return f"[{timestamp:>10} ms] <unknown token 0x{token:08X}: {body[pos:].hex()}>"
+
+    out = []
+    last = 0
+    for match in SPEC_RE.finditer(fmt):
+        out.append(fmt[last:match.start()])
+        last = match.end()
+        conv = match.group(1)
+        if conv is None:
+            out.append("%")
+            continue
+        if pos >= len(body):
+            out.append("<truncated>")
+            break
+        spec = match.group(0)
+        if conv == "s":
+            length, pos = read_varint(body, pos)
+            out.append(spec % body[pos:pos + length].decode("utf-8", errors="replace"))
+            pos += length
+        elif conv in "fFeEgG":
+            value, = struct.unpack_from("<f", body, pos)
+            pos += 4
+            out.append(spec % value)
+        else:
+            value, pos = read_signed(body, pos)
+            if conv in "ouxX":
+                value &= 0xFFFFFFFF
+            elif conv == "c":
+                value = chr(value & 0xFF)
+            elif conv == "p":
+                spec = "0x%08x"
+                value &= 0xFFFFFFFF
+            # 去掉C长度修饰符，Python格式化不支持
+            spec = re.sub(r"(hh|h|ll|l|z|j|t)(?=[diouxXc])", "", spec).replace("i", "d").replace("u", "d")
+            out.append(spec % value)
+    else:
+        out.append(fmt[last:])
+
+    return f"[{timestamp:>10} ms] " + "".join(out)
+
+
+def decode_stream(database: dict, stream, out):
+    """逐字节扫描：0x00起始的帧按记录解码，其余字节原样输出"""
+    pending = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        if chunk[0] != FRAME_START:
+            pending += chunk
+            if chunk == b"\n":
+                out.write(pending.decode("utf-8", errors="replace"))
+                out.flush()
+                pending.clear()
+            continue
+
+        if pending:
+            out.write(pending.decode("utf-8", errors="replace"))
+            pending.clear()
+
+        header = stream.read(1)
+        if not header:
+            break
+        length = header[0]
+        body = stream.read(length)
+        checksum = stream.read(1)
+        if len(body) != length or not checksum:
+            break
+
+        expected = 0
+        for b in body:
+            expected ^= b
+        if length < 5 or expected != checksum[0]:
+            out.write(f"<corrupt record, {length} bytes>\n")
+            continue
+
+        try:
+            out.write(format_record(database, bytes(body)) + "\n")
+        except (IndexError, struct.error, TypeError, ValueError) as err:
+            out.write(f"<undecodable record: {err}>\n")
+        out.flush()
+
+    if pending:
+        out.write(pending.decode("utf-8", errors="replace"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode tokenized door-access logs")
+    parser.add_argument("elf", help="firmware ELF built with LOG_TOKENIZED")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port to read from")
+    source.add_argument("--input", help="captured raw log file ('-' for stdin)")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    database = load_database(args.elf)
+    print(f"Loaded {len(database)} format strings from {args.elf}", file=sys.stderr)
+
+    if args.port:
+        import serial  # pyserial随PlatformIO一起安装
+
+        with serial.Serial(args.port, args.baud) as port:
+            decode_stream(database, port, sys.stdout)
+    elif args.input == "-":
+        decode_stream(database, sys.stdin.buffer, sys.stdout)
+    else:
+        with open(args.input, "rb") as f:
+            decode_stream(database, f, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()